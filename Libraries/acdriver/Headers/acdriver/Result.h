@@ -11,6 +11,7 @@
 #define __acdriver_Result_h
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -63,6 +64,7 @@ private:
     };
 
 private:
+    std::mutex                                                  _mutex;
     std::unordered_map<std::string, std::vector<NormalEntry>>   _normalEntries;
     std::unordered_map<std::string, std::vector<DocumentEntry>> _documentEntries;
 
@@ -78,7 +80,7 @@ public:
 
 public:
     /*
-     * Log a normal message.
+     * Log a normal message. Messages can be logged from any thread.
      */
     void normal(
         Severity severity,
@@ -20,7 +20,9 @@
 
 #include <algorithm>
 #include <fstream>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
 
 #include <png.h>
@@ -44,6 +46,43 @@ png_user_read_data(png_structp png_ptr, png_bytep data, png_size_t length)
     *contents_ptr += length;
 }
 
+/*
+ * The signature, then the IHDR chunk: its length, type, data, and CRC.
+ */
+static size_t const PNGHeaderLength = 8 + 4 + 4 + 13 + 4;
+
+static bool
+ReadPNGHeader(
+    std::vector<unsigned char> const &contents,
+    std::string const &filename,
+    size_t *width_out,
+    size_t *height_out,
+    size_t *channels_out,
+    Result *result)
+{
+    /* The signature, then the IHDR chunk's length, type, size, bit depth, and color type. */
+    if (contents.size() < 26 || png_sig_cmp(static_cast<png_const_bytep>(contents.data()), 0, 8) || memcmp(contents.data() + 12, "IHDR", 4) != 0) {
+        result->normal(
+            Result::Severity::Error,
+            "file is not a PNG file",
+            filename);
+        return false;
+    }
+
+    *width_out = png_get_uint_32(contents.data() + 16);
+    *height_out = png_get_uint_32(contents.data() + 20);
+
+    /* Matches the transforms in ReadPNGFile(). */
+    uint8_t color_type = contents[25];
+    if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
+        *channels_out = 2;
+    } else {
+        *channels_out = 4;
+    }
+
+    return true;
+}
+
 static bool
 ReadPNGFile(
     std::vector<unsigned char> &contents,
@@ -398,8 +437,9 @@ CompileAsset(
     car::Rendition::Data::Format format;
 
     if (FSUtil::IsFileExtension(filename, "png", true)) {
+        /* Only read the size now; the pixels are decoded when writing. */
         std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, filename)) {
+        if (!filesystem->readPrefix(&contents, filename, PNGHeaderLength)) {
             result->normal(
                 Result::Severity::Error,
                 "unable to read PNG file",
@@ -407,7 +447,7 @@ CompileAsset(
             return false;
         }
 
-        if (!ReadPNGFile(contents, filename, &pixels, &width, &height, &channels, result)) {
+        if (!ReadPNGHeader(contents, filename, &width, &height, &channels, result)) {
             return false;
         }
 
@@ -462,9 +502,48 @@ CompileAsset(
         { car_attribute_identifier_identifier, facetIdentifier },
     });
 
-    auto data = ext::optional<car::Rendition::Data>(car::Rendition::Data(std::move(pixels), format));
+    std::function<ext::optional<car::Rendition::Data>(car::Rendition const *)> data;
+    if (format == car::Rendition::Data::Format::JPEG) {
+        auto contents = std::make_shared<car::Rendition::Data>(std::move(pixels), format);
+        data = [contents](car::Rendition const *rendition) -> ext::optional<car::Rendition::Data> {
+            return *contents;
+        };
+    } else {
+        /*
+         * Decoding is deferred until the archive is written, where renditions
+         * are encoded on multiple threads. The filesystem and result must
+         * outlive the compile output, and both are used from those threads.
+         */
+        data = [filesystem, filename, width, height, format, result](car::Rendition const *rendition) -> ext::optional<car::Rendition::Data> {
+            std::vector<uint8_t> contents;
+            if (!filesystem->read(&contents, filename)) {
+                result->normal(
+                    Result::Severity::Error,
+                    "unable to read PNG file",
+                    filename);
+                return ext::nullopt;
+            }
+
+            std::vector<uint8_t> pixels;
+            size_t decodedWidth = 0;
+            size_t decodedHeight = 0;
+            if (!ReadPNGFile(contents, filename, &pixels, &decodedWidth, &decodedHeight, NULL, result)) {
+                return ext::nullopt;
+            }
+
+            if (decodedWidth != width || decodedHeight != height || pixels.size() != width * height * car::Rendition::Data::FormatSize(format)) {
+                result->normal(
+                    Result::Severity::Error,
+                    "PNG file changed while compiling",
+                    filename);
+                return ext::nullopt;
+            }
+
+            return car::Rendition::Data(std::move(pixels), format);
+        };
+    }
 
-    car::Rendition rendition = car::Rendition::Create(attributes, std::move(data));
+    car::Rendition rendition = car::Rendition::Create(attributes, data);
     rendition.width() = width;
     rendition.height() = height;
     rendition.scale() = scale;
@@ -60,6 +60,11 @@ using acdriver::Result;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
+/*
+ * The most decoded image data held at once while writing the archive.
+ */
+static size_t const ImageMemoryBudget = 256 * 1024 * 1024;
+
 CompileAction::
 CompileAction()
 {
@@ -240,13 +245,16 @@ run(Filesystem *filesystem, Options const &options, Output *output, Result *resu
             return;
         }
 
-        auto bom = car::Writer::unique_ptr_bom(bom_alloc_empty(memory), bom_free);
+        auto bom = car::Writer::unique_ptr_bom(bom_alloc_builder(memory), bom_free);
         if (bom == nullptr) {
             result->normal(Result::Severity::Error, "unable to create output structure");
             return;
         }
 
         compileOutput.car() = car::Writer::Create(std::move(bom));
+
+        /* Images are decoded in parallel while writing; bound the memory used. */
+        compileOutput.car()->memoryBudget() = ImageMemoryBudget;
     }
 
     /*
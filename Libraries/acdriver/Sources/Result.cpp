@@ -71,6 +71,8 @@ normal(
     entry.message = message;
     entry.reason = reason;
     entry.file = file;
+
+    std::lock_guard<std::mutex> lock(_mutex);
     _normalEntries[NormalSeverityKey(severity)].push_back(entry);
 }
 
@@ -88,6 +90,8 @@ document(
     entry.items = items;
     entry.type = type;
     entry.message = message;
+
+    std::lock_guard<std::mutex> lock(_mutex);
     _documentEntries[DocumentSeverityKey(severity)].push_back(entry);
 }
 
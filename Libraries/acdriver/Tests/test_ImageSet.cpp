@@ -0,0 +1,169 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <acdriver/Compile/ImageSet.h>
+#include <acdriver/CompileOutput.h>
+#include <acdriver/Result.h>
+#include <xcassets/Asset/Catalog.h>
+#include <xcassets/Asset/ImageSet.h>
+#include <car/Facet.h>
+#include <car/Reader.h>
+#include <car/Rendition.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <atomic>
+
+#include <png.h>
+#include <unistd.h>
+
+using acdriver::CompileOutput;
+using acdriver::Result;
+using libutil::MemoryFilesystem;
+
+/*
+ * Counts whole and partial reads, which can happen on writer threads.
+ */
+class CountingFilesystem : public MemoryFilesystem {
+public:
+    mutable std::atomic<int> reads;
+    mutable std::atomic<int> prefixReads;
+
+public:
+    explicit CountingFilesystem(std::vector<Entry> const &entries) :
+        MemoryFilesystem(entries),
+        reads           (0),
+        prefixReads     (0)
+    {
+    }
+
+public:
+    virtual bool read(std::vector<uint8_t> *contents, std::string const &path) const
+    {
+        reads++;
+        return MemoryFilesystem::read(contents, path);
+    }
+
+    virtual bool readPrefix(std::vector<uint8_t> *contents, std::string const &path, size_t length) const
+    {
+        prefixReads++;
+        if (!MemoryFilesystem::read(contents, path)) {
+            return false;
+        }
+
+        contents->resize(std::min(contents->size(), length));
+        return true;
+    }
+};
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static void
+png_user_write_data(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+    std::vector<uint8_t> *contents = static_cast<std::vector<uint8_t> *>(png_get_io_ptr(png_ptr));
+    contents->insert(contents->end(), data, data + length);
+}
+
+/*
+ * Encodes an opaque 2x2 RGBA image, with some channels set to `value`. Only
+ * fully on or off channels are used, as decoding converts to linear gamma.
+ */
+static std::vector<uint8_t>
+EncodePNG(uint8_t value)
+{
+    std::vector<uint8_t> contents;
+
+    png_struct *png_struct_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_info *info_struct_ptr = png_create_info_struct(png_struct_ptr);
+    png_set_write_fn(png_struct_ptr, &contents, png_user_write_data, NULL);
+    png_set_IHDR(png_struct_ptr, info_struct_ptr, 2, 2, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png_struct_ptr, info_struct_ptr);
+
+    uint8_t row0[] = { value, 0, 0xff, 0xff, 0xff, value, 0, 0xff };
+    uint8_t row1[] = { 0, 0xff, value, 0xff, value, value, value, 0xff };
+    png_write_row(png_struct_ptr, row0);
+    png_write_row(png_struct_ptr, row1);
+
+    png_write_end(png_struct_ptr, NULL);
+    png_destroy_write_struct(&png_struct_ptr, &info_struct_ptr);
+    return contents;
+}
+
+/*
+ * The pixels of EncodePNG(), as decoded into a rendition.
+ */
+static std::vector<uint8_t>
+DecodedPixels(uint8_t value)
+{
+    return { 0xff, 0, value, 0xff, 0, value, 0xff, 0xff, value, 0xff, 0, 0xff, value, value, value, 0xff };
+}
+
+TEST(ImageSet, DeferredDecoding)
+{
+    CountingFilesystem filesystem({
+        MemoryFilesystem::Entry::Directory("Images.xcassets", {
+            MemoryFilesystem::Entry::File("Contents.json", Contents("{ \"info\": { \"version\": 1, \"author\": \"xcode\" } }")),
+            MemoryFilesystem::Entry::Directory("Image.imageset", {
+                MemoryFilesystem::Entry::File("Contents.json", Contents("{ \"images\": [ { \"idiom\": \"universal\", \"filename\": \"image.png\", \"scale\": \"1x\" } ], \"info\": { \"version\": 1, \"author\": \"xcode\" } }")),
+                MemoryFilesystem::Entry::File("image.png", EncodePNG(0)),
+            }),
+        }),
+    });
+
+    std::shared_ptr<xcassets::Asset::Catalog> catalog = xcassets::Asset::Catalog::Load(&filesystem, "/Images.xcassets");
+    ASSERT_NE(nullptr, catalog);
+    ASSERT_EQ(1, catalog->children().size());
+    ASSERT_EQ(xcassets::Asset::AssetType::ImageSet, catalog->children().front()->type());
+    auto imageSet = std::static_pointer_cast<xcassets::Asset::ImageSet>(catalog->children().front());
+
+    char path[] = "/tmp/test_acdriver_ImageSet.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+
+    CompileOutput output = CompileOutput("/", CompileOutput::Format::Compiled);
+    output.car() = car::Writer::Create(car::Writer::unique_ptr_bom(bom_alloc_builder(bom_context_memory_file(path, true, 0)), bom_free));
+    ASSERT_NE(ext::nullopt, output.car());
+
+    /* Compiling only reads the header. Loading the catalog read its contents. */
+    Result result;
+    filesystem.reads = 0;
+    EXPECT_TRUE(acdriver::Compile::ImageSet::Compile(imageSet, &filesystem, &output, &result));
+    EXPECT_TRUE(result.success());
+    EXPECT_EQ(0, filesystem.reads);
+    EXPECT_EQ(1, filesystem.prefixReads);
+
+    /* The image is decoded when the archive is written, so sees this change. */
+    ASSERT_TRUE(filesystem.write(EncodePNG(0xff), "/Images.xcassets/Image.imageset/image.png"));
+    output.car()->write();
+    EXPECT_TRUE(result.success());
+    EXPECT_EQ(1, filesystem.reads);
+
+    ext::optional<car::Reader> reader = car::Reader::Open(path);
+    ASSERT_NE(ext::nullopt, reader);
+
+    ext::optional<car::Facet> facet = reader->lookupFacet("Image");
+    ASSERT_NE(ext::nullopt, facet);
+
+    std::vector<car::Rendition> renditions = reader->lookupRenditions(*facet);
+    ASSERT_EQ(1, renditions.size());
+    EXPECT_EQ(2, renditions.front().width());
+    EXPECT_EQ(2, renditions.front().height());
+
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(2 * 2 * 4);
+    EXPECT_EQ(car::Rendition::Data::Format::PremultipliedBGRA8, renditions.front().decode(pixels.data(), pixels.size()));
+    EXPECT_EQ(DecodedPixels(0xff), pixels);
+
+    unlink(path);
+}
@@ -44,6 +44,17 @@ bom_alloc_empty(struct bom_context_memory memory);
 struct bom_context *
 bom_alloc_load(struct bom_context_memory memory);
 
+/*
+ * Creates an empty BOM that is laid out only once it is finished, which
+ * makes adding many indexes take linear time. Until then, the memory
+ * holds only index data. Finishing happens automatically when freed.
+ */
+struct bom_context *
+bom_alloc_builder(struct bom_context_memory memory);
+
+void
+bom_builder_finish(struct bom_context *context);
+
 struct bom_context_memory const *
 bom_memory(struct bom_context const *context);
 
@@ -64,6 +75,10 @@ bom_index_get(struct bom_context *context, uint32_t index, size_t *data_len);
 uint32_t
 bom_index_add(struct bom_context *context, const void *data, size_t data_len);
 
+/* Adds `count` indexes at once. Returns the first; the rest follow it. */
+uint32_t
+bom_index_add_many(struct bom_context *context, size_t count, const void *const *data, const size_t *data_len);
+
 void
 bom_index_append(struct bom_context *context, uint32_t index, size_t data_len);
 
@@ -109,6 +124,9 @@ typedef void (*bom_tree_iterator)(struct bom_tree_context *tree, void *key, size
 void
 bom_tree_iterate(struct bom_tree_context *tree, bom_tree_iterator iterator, void *ctx);
 
+void *
+bom_tree_find(struct bom_tree_context *tree, const void *key, size_t key_len, size_t *value_len);
+
 void
 bom_tree_add(struct bom_tree_context *tree, const void *key, size_t key_len, const void *value, size_t value_len);
 
@@ -18,9 +18,28 @@
 #include <assert.h>
 #include <stdint.h>
 
+struct _bom_build_variable {
+    char *name;
+    uint32_t index;
+};
+
 struct bom_context {
     struct bom_context_memory memory;
     unsigned int iteration_count;
+
+    /*
+     * While building, memory holds only the data for each index, in the
+     * order it was added. The indexes (in host byte order) and variables
+     * are kept separately, and everything is laid out in the final format
+     * once when building finishes.
+     */
+    bool building;
+    struct bom_index *build_indexes;
+    size_t build_index_count;
+    size_t build_index_capacity;
+    struct _bom_build_variable *build_variables;
+    size_t build_variable_count;
+    size_t build_variable_capacity;
 };
 
 struct bom_context *
@@ -34,9 +53,34 @@ _bom_alloc(struct bom_context_memory memory)
     context->memory = memory;
     context->iteration_count = 0;
 
+    context->building = false;
+    context->build_indexes = NULL;
+    context->build_index_count = 0;
+    context->build_index_capacity = 0;
+    context->build_variables = NULL;
+    context->build_variable_count = 0;
+    context->build_variable_capacity = 0;
+
     return context;
 }
 
+static void
+_bom_reserve(void **array, size_t *capacity, size_t count, size_t element_size)
+{
+    if (count <= *capacity) {
+        return;
+    }
+
+    size_t new_capacity = (*capacity < 16 ? 16 : *capacity);
+    while (new_capacity < count) {
+        new_capacity *= 2;
+    }
+
+    *array = realloc(*array, new_capacity * element_size);
+    assert(*array != NULL);
+    *capacity = new_capacity;
+}
+
 struct bom_context *
 bom_alloc_empty(struct bom_context_memory memory)
 {
@@ -50,6 +94,7 @@ bom_alloc_empty(struct bom_context_memory memory)
     size_t freelist_size = sizeof(struct bom_index_header) + sizeof(struct bom_index) * 2;
     size_t variables_size = sizeof(struct bom_variables);
     context->memory.resize(&context->memory, header_size + index_size + freelist_size + variables_size);
+    memset(context->memory.data, 0, context->memory.size);
 
     struct bom_header *header = (struct bom_header *)context->memory.data;
     strncpy(header->magic, "BOMStore", 8);
@@ -79,6 +124,102 @@ bom_alloc_empty(struct bom_context_memory memory)
     return context;
 }
 
+struct bom_context *
+bom_alloc_builder(struct bom_context_memory memory)
+{
+    struct bom_context *context = _bom_alloc(memory);
+    if (context == NULL) {
+        return NULL;
+    }
+
+    context->building = true;
+    context->memory.resize(&context->memory, 0);
+
+    return context;
+}
+
+void
+bom_builder_finish(struct bom_context *context)
+{
+    assert(context != NULL);
+    assert(context->iteration_count == 0 && "cannot mutate while iterating");
+
+    if (!context->building) {
+        return;
+    }
+
+    /* Same layout as bom_alloc_empty followed by each add. */
+    size_t header_size = sizeof(struct bom_header);
+    size_t index_size = sizeof(struct bom_index_header) + sizeof(struct bom_index) * context->build_index_count;
+    size_t freelist_size = sizeof(struct bom_index_header) + sizeof(struct bom_index) * 2;
+    size_t variables_size = sizeof(struct bom_variables);
+    for (size_t i = 0; i < context->build_variable_count; i++) {
+        size_t variable_delta = sizeof(struct bom_variable) + strlen(context->build_variables[i].name);
+        variable_delta += 4 - (variable_delta % 4);
+        variables_size += variable_delta;
+    }
+
+    size_t data_size = 0;
+    for (size_t i = 0; i < context->build_index_count; i++) {
+        data_size += context->build_indexes[i].length;
+    }
+
+    /* Move the data aside, as it will be laid out over where it is now. */
+    void *data = malloc(context->memory.size);
+    assert(data != NULL || context->memory.size == 0);
+    memcpy(data, context->memory.data, context->memory.size);
+
+    size_t data_point = header_size + index_size + freelist_size + variables_size;
+    context->memory.resize(&context->memory, data_point + data_size);
+    memset(context->memory.data, 0, data_point);
+
+    struct bom_header *header = (struct bom_header *)context->memory.data;
+    strncpy(header->magic, "BOMStore", 8);
+    header->version = htonl(1);
+    /* Matches bom_index_add, which counts blocks without byte swapping. */
+    header->block_count = (uint32_t)context->build_index_count;
+    header->index_offset = htonl(header_size);
+    header->index_length = htonl(index_size + freelist_size);
+    header->variables_offset = htonl(header_size + index_size + freelist_size);
+    header->trailer_len = htonl(variables_size);
+
+    struct bom_index_header *index_header = (struct bom_index_header *)((void *)header + header_size);
+    index_header->count = htonl(context->build_index_count);
+    for (size_t i = 0; i < context->build_index_count; i++) {
+        struct bom_index *build_index = &context->build_indexes[i];
+        index_header->index[i].address = htonl(data_point);
+        index_header->index[i].length = htonl(build_index->length);
+
+        memcpy((void *)header + data_point, data + build_index->address, build_index->length);
+        data_point += build_index->length;
+    }
+
+    /* Variables are packed, with the padding for each all at the end. */
+    struct bom_variables *vars = (struct bom_variables *)((void *)header + ntohl(header->variables_offset));
+    vars->count = htonl(context->build_variable_count);
+    ptrdiff_t var_offset = 0;
+    for (size_t i = 0; i < context->build_variable_count; i++) {
+        struct bom_variable *var = (struct bom_variable *)((void *)vars->first + var_offset);
+        var->index = htonl(context->build_variables[i].index);
+        var->length = strlen(context->build_variables[i].name);
+        strncpy(var->name, context->build_variables[i].name, var->length);
+        var_offset += (sizeof(struct bom_variable) + var->length);
+
+        free(context->build_variables[i].name);
+    }
+
+    free(data);
+    free(context->build_indexes);
+    free(context->build_variables);
+    context->build_indexes = NULL;
+    context->build_index_count = 0;
+    context->build_index_capacity = 0;
+    context->build_variables = NULL;
+    context->build_variable_count = 0;
+    context->build_variable_capacity = 0;
+    context->building = false;
+}
+
 struct bom_context *
 bom_alloc_load(struct bom_context_memory memory)
 {
@@ -140,6 +281,9 @@ bom_free(struct bom_context *context)
         return;
     }
 
+    /* Lay out anything still being built, as the memory may be a file. */
+    bom_builder_finish(context);
+
     context->memory.free(&context->memory);
     free(context);
 }
@@ -178,6 +322,23 @@ _bom_address_resize(struct bom_context *context, uint32_t point, ptrdiff_t delta
 
     context->memory.resize(&context->memory, context->memory.size + delta);
     memmove(context->memory.data + point + delta, context->memory.data + point, context->memory.size - point - delta);
+
+    /* Clear inserted space so output does not depend on earlier contents. */
+    if (delta > 0) {
+        memset(context->memory.data + point, 0, delta);
+    }
+}
+
+static size_t
+_bom_index_count(struct bom_context *context)
+{
+    if (context->building) {
+        return context->build_index_count;
+    }
+
+    struct bom_header *header = (struct bom_header *)context->memory.data;
+    struct bom_index_header *index_header = (struct bom_index_header *)((void *)header + ntohl(header->index_offset));
+    return ntohl(index_header->count);
 }
 
 
@@ -189,10 +350,8 @@ bom_index_iterate(struct bom_context *context, bom_index_iterator iterator, void
 
     context->iteration_count++;
 
-    struct bom_header *header = (struct bom_header *)context->memory.data;
-    struct bom_index_header *index_header = (struct bom_index_header *)((void *)header + ntohl(header->index_offset));
-
-    for (size_t i = 0; i < ntohl(index_header->count); i++) {
+    size_t count = _bom_index_count(context);
+    for (size_t i = 0; i < count; i++) {
         size_t data_len;
         void *data = bom_index_get(context, i, &data_len);
         if (data == NULL) {
@@ -212,6 +371,19 @@ bom_index_get(struct bom_context *context, uint32_t index, size_t *data_len)
 {
     assert(context != NULL);
 
+    if (context->building) {
+        if (index >= context->build_index_count) {
+            return NULL;
+        }
+
+        struct bom_index *build_index = &context->build_indexes[index];
+        if (data_len != NULL) {
+            *data_len = build_index->length;
+        }
+
+        return context->memory.data + build_index->address;
+    }
+
     struct bom_header *header = (struct bom_header *)context->memory.data;
     struct bom_index_header *index_header = (struct bom_index_header *)((void *)header + ntohl(header->index_offset));
 
@@ -236,42 +408,79 @@ bom_index_get(struct bom_context *context, uint32_t index, size_t *data_len)
 
 uint32_t
 bom_index_add(struct bom_context *context, const void *data, size_t data_len)
+{
+    return bom_index_add_many(context, 1, &data, &data_len);
+}
+
+uint32_t
+bom_index_add_many(struct bom_context *context, size_t count, const void *const *data, const size_t *data_len)
 {
     assert(context != NULL);
     assert(data != NULL);
+    assert(data_len != NULL);
     assert(context->iteration_count == 0 && "cannot mutate while iterating");
 
+    size_t total_len = 0;
+    for (size_t i = 0; i < count; i++) {
+        assert(data[i] != NULL);
+        total_len += data_len[i];
+    }
+
+    if (context->building) {
+        uint32_t first_index = context->build_index_count;
+
+        _bom_reserve((void **)&context->build_indexes, &context->build_index_capacity, context->build_index_count + count, sizeof(struct bom_index));
+
+        uint32_t data_point = context->memory.size;
+        context->memory.resize(&context->memory, context->memory.size + total_len);
+
+        for (size_t i = 0; i < count; i++) {
+            struct bom_index *index = &context->build_indexes[context->build_index_count++];
+            index->address = data_point;
+            index->length = data_len[i];
+
+            memcpy(context->memory.data + data_point, data[i], data_len[i]);
+            data_point += data_len[i];
+        }
+
+        return first_index;
+    }
+
     struct bom_header *header = (struct bom_header *)context->memory.data;
     struct bom_index_header *index_header = (struct bom_index_header *)((void *)header + ntohl(header->index_offset));
 
-    /* Insert index at the end of the list. */
+    /* Insert indexes at the end of the list. */
     uint32_t index_point = ntohl(header->index_offset) + sizeof(struct bom_index_header) + sizeof(struct bom_index) * ntohl(index_header->count);
-    ptrdiff_t index_delta = sizeof(struct bom_index);
+    ptrdiff_t index_delta = sizeof(struct bom_index) * count;
     _bom_address_resize(context, index_point, index_delta);
 
     /* Insert data at the very end. */
     uint32_t data_point = context->memory.size;
-    _bom_address_resize(context, data_point, data_len);
+    _bom_address_resize(context, data_point, total_len);
 
     /* Re-fetch, invalidated by resize. */
     header = (struct bom_header *)context->memory.data;
     index_header = (struct bom_index_header *)((void *)header + ntohl(header->index_offset));
 
-    /* Update values in newly inserted index. */
-    size_t added_index = ntohl(index_header->count);
-    struct bom_index *index = &index_header->index[added_index];
-    index->address = htonl(data_point);
-    index->length = htonl(data_len);
+    uint32_t first_index = ntohl(index_header->count);
+    for (size_t i = 0; i < count; i++) {
+        /* Update values in newly inserted index. */
+        struct bom_index *index = &index_header->index[first_index + i];
+        index->address = htonl(data_point);
+        index->length = htonl(data_len[i]);
 
-    /* Copy data into new data area. */
-    memcpy((void *)header + data_point, data, data_len);
+        /* Copy data into new data area. */
+        memcpy((void *)header + data_point, data[i], data_len[i]);
+        data_point += data_len[i];
 
-    /* Update length for newly added index. */
-    index_header->count = htonl(ntohl(index_header->count) + 1);
-    header->index_length = htonl(ntohl(header->index_length) + sizeof(struct bom_index));
-    header->block_count++;
+        header->block_count++;
+    }
 
-    return added_index;
+    /* Update length for newly added indexes. */
+    index_header->count = htonl(ntohl(index_header->count) + count);
+    header->index_length = htonl(ntohl(header->index_length) + sizeof(struct bom_index) * count);
+
+    return first_index;
 }
 
 void
@@ -280,9 +489,28 @@ bom_index_append(struct bom_context *context, uint32_t idx, size_t data_len)
     assert(context != NULL);
     assert(context->iteration_count == 0 && "cannot mutate while iterating");
 
+    if (context->building) {
+        assert(idx < context->build_index_count);
+        struct bom_index *build_index = &context->build_indexes[idx];
+
+        /* Grow in place at the end; otherwise, move the data to the end. */
+        uint32_t data_point = context->memory.size;
+        if (build_index->address + build_index->length == data_point) {
+            context->memory.resize(&context->memory, data_point + data_len);
+        } else {
+            context->memory.resize(&context->memory, data_point + build_index->length + data_len);
+            memcpy(context->memory.data + data_point, context->memory.data + build_index->address, build_index->length);
+            build_index->address = data_point;
+        }
+
+        memset(context->memory.data + build_index->address + build_index->length, 0, data_len);
+        build_index->length += data_len;
+        return;
+    }
+
     struct bom_header *header = (struct bom_header *)context->memory.data;
     struct bom_index_header *index_header = (struct bom_index_header *)((void *)header + ntohl(header->index_offset));
-    assert(idx < index_header->count);
+    assert(idx < ntohl(index_header->count));
     struct bom_index *index = &index_header->index[idx];
 
     /* Make room for the data at the end of the exisiting data. */
@@ -307,6 +535,18 @@ bom_variable_iterate(struct bom_context *context, bom_variable_iterator iterator
 
     context->iteration_count++;
 
+    if (context->building) {
+        for (size_t i = 0; i < context->build_variable_count; i++) {
+            struct _bom_build_variable *var = &context->build_variables[i];
+            if (!iterator(context, var->name, var->index, ctx)) {
+                break;
+            }
+        }
+
+        context->iteration_count--;
+        return;
+    }
+
     struct bom_header *header = (struct bom_header *)context->memory.data;
     struct bom_variables *vars = (struct bom_variables *)((void *)header + ntohl(header->variables_offset));
 
@@ -323,10 +563,11 @@ bom_variable_iterate(struct bom_context *context, bom_variable_iterator iterator
 
         strncpy(var_name, var->name, var->length);
         var_name[var->length] = 0;
-        if (!iterator(context, var_name, ntohl(var->index), ctx)) {
+        bool more = iterator(context, var_name, ntohl(var->index), ctx);
+        free(var_name);
+        if (!more) {
             break;
         }
-        free(var_name);
     }
 
     context->iteration_count--;
@@ -367,6 +608,18 @@ bom_variable_add(struct bom_context *context, const char *name, int data_index)
     assert(name != NULL);
     assert(context->iteration_count == 0 && "cannot mutate while iterating");
 
+    if (context->building) {
+        _bom_reserve((void **)&context->build_variables, &context->build_variable_capacity, context->build_variable_count + 1, sizeof(struct _bom_build_variable));
+
+        struct _bom_build_variable *var = &context->build_variables[context->build_variable_count++];
+        size_t name_len = strlen(name);
+        var->name = malloc(name_len + 1);
+        assert(var->name != NULL);
+        memcpy(var->name, name, name_len + 1);
+        var->index = data_index;
+        return;
+    }
+
     struct bom_header *header = (struct bom_header *)context->memory.data;
     struct bom_variables *vars = (struct bom_variables *)((void *)header + ntohl(header->variables_offset));
 
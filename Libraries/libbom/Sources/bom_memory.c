@@ -20,22 +20,56 @@
 #include <unistd.h>
 #include <assert.h>
 
+/*
+ * Memory grows geometrically so that repeatedly growing by small amounts
+ * takes amortized constant time. The size is what is in use, while the
+ * capacity is what has been allocated.
+ */
+static size_t
+_bom_context_memory_capacity(size_t capacity, size_t size)
+{
+    if (capacity < 4096) {
+        capacity = 4096;
+    }
+
+    while (capacity < size) {
+        capacity *= 2;
+    }
+
+    return capacity;
+}
+
+struct _bom_context_memory_realloc_context {
+    size_t capacity;
+};
+
 static void
 _bom_context_memory_realloc(struct bom_context_memory *memory, size_t size)
 {
+    struct _bom_context_memory_realloc_context *context = memory->ctx;
+
+    if (size > context->capacity) {
+        context->capacity = _bom_context_memory_capacity(context->capacity, size);
+        memory->data = realloc(memory->data, context->capacity);
+        assert(memory->data != NULL);
+    }
+
     memory->size = size;
-    memory->data = realloc(memory->data, memory->size);
 }
 
 static void
 _bom_context_memory_free(struct bom_context_memory *memory)
 {
     free(memory->data);
+    free(memory->ctx);
 }
 
 struct bom_context_memory
 bom_context_memory(void const *data, size_t size)
 {
+    struct _bom_context_memory_realloc_context *context = malloc(sizeof(*context));
+    context->capacity = size;
+
     void *new = malloc(size);
 
     if (data != NULL) {
@@ -49,13 +83,14 @@ bom_context_memory(void const *data, size_t size)
         .size = size,
         .resize = _bom_context_memory_realloc,
         .free = _bom_context_memory_free,
-        .ctx = NULL,
+        .ctx = context,
     };
 }
 
 struct _bom_context_memory_mmap_context {
     int fd;
     bool writeable;
+    size_t capacity;
 };
 
 static void
@@ -63,18 +98,21 @@ _bom_context_memory_mremap(struct bom_context_memory *memory, size_t size)
 {
     struct _bom_context_memory_mmap_context *context = memory->ctx;
 
-    munmap(memory->data, memory->size);
-    if (size > memory->size) {
-        int ret = ftruncate(context->fd, size);
+    /* Only extend and remap the file when it runs out of room. */
+    if (size > context->capacity) {
+        munmap(memory->data, context->capacity);
+
+        context->capacity = _bom_context_memory_capacity(context->capacity, size);
+        int ret = ftruncate(context->fd, context->capacity);
         assert(ret == 0);
         (void)ret;
+
+        int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
+        memory->data = mmap(NULL, context->capacity, prot, MAP_SHARED, context->fd, 0);
+        assert((intptr_t)memory->data != -1);
     }
 
     memory->size = size;
-
-    int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
-    memory->data = mmap(NULL, size, prot, MAP_SHARED, context->fd, 0);
-    assert((intptr_t)memory->data != -1);
 }
 
 static void
@@ -82,7 +120,15 @@ _bom_context_memory_munmap(struct bom_context_memory *memory)
 {
     struct _bom_context_memory_mmap_context *context = memory->ctx;
 
-    munmap(memory->data, memory->size);
+    munmap(memory->data, context->capacity);
+
+    /* Trim any unused capacity, so the file is exactly the size in use. */
+    if (context->writeable && context->capacity != memory->size) {
+        int ret = ftruncate(context->fd, memory->size);
+        assert(ret == 0);
+        (void)ret;
+    }
+
     close(context->fd);
     free(context);
 }
@@ -120,12 +166,14 @@ bom_context_memory_file(const char *fn, bool writeable, size_t minimum_size)
         }
     }
 
+    size_t size = st.st_size < (off_t)minimum_size ? minimum_size : st.st_size;
+
     struct _bom_context_memory_mmap_context *context = malloc(sizeof(*context));
     context->fd = fd;
     context->writeable = writeable;
+    context->capacity = size;
 
     int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
-    size_t size = st.st_size < (off_t)minimum_size ? minimum_size : st.st_size;
     void *data = mmap(NULL, size, prot, (writeable ? MAP_SHARED : MAP_PRIVATE), context->fd, 0);
 
     return (struct bom_context_memory) {
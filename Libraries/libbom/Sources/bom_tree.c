@@ -25,6 +25,169 @@ struct bom_tree_context {
     int tree_iterating;
 };
 
+/* Size of each node in newly created trees. */
+#define BOM_TREE_NODE_SIZE 4096
+
+/* Deep enough for any tree that fits in a 32-bit BOM. */
+#define BOM_TREE_MAX_DEPTH 32
+
+static struct bom_tree *
+_bom_tree_get(struct bom_tree_context *tree_context)
+{
+    int tree_index = bom_variable_get(tree_context->context, tree_context->variable_name);
+    return (struct bom_tree *)bom_index_get(tree_context->context, tree_index, NULL);
+}
+
+static size_t
+_bom_tree_node_capacity(struct bom_tree *tree)
+{
+    size_t node_size = ntohl(tree->node_size);
+    if (node_size < sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * 2) {
+        /* Too small to split; use the default size for new nodes. */
+        node_size = BOM_TREE_NODE_SIZE;
+    }
+
+    return (node_size - sizeof(struct bom_tree_entry)) / sizeof(struct bom_tree_entry_indexes);
+}
+
+/*
+ * Keys are ordered by their bytes, then by length.
+ */
+static int
+_bom_tree_compare(const void *a, size_t a_len, const void *b, size_t b_len)
+{
+    int result = memcmp(a, b, (a_len < b_len ? a_len : b_len));
+    if (result != 0) {
+        return result;
+    }
+
+    return (a_len > b_len) - (a_len < b_len);
+}
+
+static int
+_bom_tree_compare_index(struct bom_context *context, uint32_t key_index, const void *key, size_t key_len)
+{
+    size_t index_key_len;
+    void *index_key = bom_index_get(context, key_index, &index_key_len);
+    return _bom_tree_compare(index_key, index_key_len, key, key_len);
+}
+
+/*
+ * Finds the first entry in a node with a key greater than `key`, or, if
+ * `inclusive`, greater than or equal to `key`. For branches, the key of
+ * each entry is the last key in that child.
+ */
+static unsigned int
+_bom_tree_node_search(struct bom_context *context, struct bom_tree_entry *node, const void *key, size_t key_len, bool inclusive)
+{
+    unsigned int low = 0;
+    unsigned int high = ntohs(node->count);
+
+    while (low < high) {
+        unsigned int middle = low + (high - low) / 2;
+        int result = _bom_tree_compare_index(context, ntohl(node->indexes[middle].key_index), key, key_len);
+        if (result < 0 || (result == 0 && !inclusive)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/*
+ * Adds an empty node. Nodes are allocated at their full size so entries
+ * can be inserted without moving the node.
+ */
+static uint32_t
+_bom_tree_node_add(struct bom_context *context, size_t node_size, bool is_leaf)
+{
+    struct bom_tree_entry *node = calloc(1, node_size);
+    if (node == NULL) {
+        return 0;
+    }
+
+    node->is_leaf = htons(is_leaf ? 1 : 0);
+    node->count = htons(0);
+    node->forward = htonl(0);
+    node->backward = htonl(0);
+    uint32_t node_index = bom_index_add(context, node, node_size);
+    free(node);
+
+    return node_index;
+}
+
+/*
+ * Inserts an entry into a node, growing nodes created at a smaller size.
+ */
+static struct bom_tree_entry *
+_bom_tree_node_insert(struct bom_context *context, uint32_t node_index, unsigned int position, uint32_t key_index, uint32_t value_index)
+{
+    size_t node_len;
+    struct bom_tree_entry *node = (struct bom_tree_entry *)bom_index_get(context, node_index, &node_len);
+
+    unsigned int count = ntohs(node->count);
+    size_t needed_len = sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * (count + 1);
+    if (node_len < needed_len) {
+        bom_index_append(context, node_index, needed_len - node_len);
+
+        /* Re-fetch after append invalidation. */
+        node = (struct bom_tree_entry *)bom_index_get(context, node_index, NULL);
+    }
+
+    memmove(&node->indexes[position + 1], &node->indexes[position], sizeof(struct bom_tree_entry_indexes) * (count - position));
+    node->indexes[position].key_index = htonl(key_index);
+    node->indexes[position].value_index = htonl(value_index);
+    node->count = htons(count + 1);
+
+    return node;
+}
+
+/*
+ * Moves the upper half of a node into a new node following it. Returns the
+ * index of the new node.
+ */
+static uint32_t
+_bom_tree_node_split(struct bom_context *context, uint32_t node_index, size_t node_size)
+{
+    struct bom_tree_entry *node = (struct bom_tree_entry *)bom_index_get(context, node_index, NULL);
+    unsigned int count = ntohs(node->count);
+    unsigned int left_count = count / 2;
+    unsigned int right_count = count - left_count;
+
+    size_t right_size = sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * right_count;
+    if (right_size < node_size) {
+        right_size = node_size;
+    }
+
+    struct bom_tree_entry *right = calloc(1, right_size);
+    if (right == NULL) {
+        return 0;
+    }
+
+    right->is_leaf = node->is_leaf;
+    right->count = htons(right_count);
+    right->forward = node->forward;
+    right->backward = htonl(node_index);
+    memcpy(&right->indexes[0], &node->indexes[left_count], sizeof(struct bom_tree_entry_indexes) * right_count);
+    uint32_t right_index = bom_index_add(context, right, right_size);
+    free(right);
+
+    /* Re-fetch after add invalidation. */
+    node = (struct bom_tree_entry *)bom_index_get(context, node_index, NULL);
+    if (node->forward != htonl(0)) {
+        struct bom_tree_entry *forward = (struct bom_tree_entry *)bom_index_get(context, ntohl(node->forward), NULL);
+        forward->backward = htonl(right_index);
+    }
+
+    node->forward = htonl(right_index);
+    node->count = htons(left_count);
+    memset(&node->indexes[left_count], 0, sizeof(struct bom_tree_entry_indexes) * right_count);
+
+    return right_index;
+}
+
 
 static struct bom_tree_context *
 _bom_tree_alloc(struct bom_context *context, const char *variable_name)
@@ -40,7 +203,7 @@ _bom_tree_alloc(struct bom_context *context, const char *variable_name)
     tree_context->context = context;
     tree_context->tree_iterating = 0;
 
-    tree_context->variable_name = malloc(strlen(variable_name));
+    tree_context->variable_name = malloc(strlen(variable_name) + 1);
     if (tree_context->variable_name == NULL) {
         bom_tree_free(tree_context);
         return NULL;
@@ -58,30 +221,32 @@ bom_tree_alloc_empty(struct bom_context *context, const char *variable_name)
         return NULL;
     }
 
-    struct bom_tree_entry *entry = malloc(sizeof(*entry));
-    if (entry == NULL) {
-        bom_tree_free(tree_context);
-        return NULL;
+    /*
+     * A zero index marks a missing sibling, so no node can be at index zero.
+     * Reserve it with an empty block if nothing else is there yet.
+     */
+    if (bom_index_get(tree_context->context, 0, NULL) == NULL) {
+        char empty = 0;
+        bom_index_add(tree_context->context, &empty, 0);
     }
 
     struct bom_tree *tree = malloc(sizeof(*tree));
     if (tree == NULL) {
-        free(entry);
         bom_tree_free(tree_context);
         return NULL;
     }
 
-    entry->is_leaf = htons(1); // todo
-    entry->count = htons(0);
-    entry->forward = htonl(0);
-    entry->backward = htonl(0);
-    int entry_index = bom_index_add(tree_context->context, entry, sizeof(*entry));
-    free(entry);
+    uint32_t entry_index = _bom_tree_node_add(tree_context->context, BOM_TREE_NODE_SIZE, true);
+    if (entry_index == 0) {
+        free(tree);
+        bom_tree_free(tree_context);
+        return NULL;
+    }
 
     strncpy(tree->magic, "tree", 4);
     tree->version = htonl(1);
     tree->child = htonl(entry_index);
-    tree->node_size = htonl(4096); // todo
+    tree->node_size = htonl(BOM_TREE_NODE_SIZE);
     tree->path_count = htonl(0);
     tree->unknown3 = 0;
     int tree_index = bom_index_add(tree_context->context, tree, sizeof(*tree));
@@ -154,12 +319,17 @@ bom_tree_iterate(struct bom_tree_context *tree_context, bom_tree_iterator iterat
 
     tree_context->tree_iterating++;
 
-    int tree_index = bom_variable_get(tree_context->context, tree_context->variable_name);
-    struct bom_tree *tree = (struct bom_tree *)bom_index_get(tree_context->context, tree_index, NULL);
+    struct bom_tree *tree = _bom_tree_get(tree_context);
 
     struct bom_tree_entry *paths = (struct bom_tree_entry *)bom_index_get(tree_context->context, ntohl(tree->child), NULL);
     if (paths != NULL) {
-        if (!paths->is_leaf) {
+        /* Start at the first leaf; leaves are linked in order. */
+        while (paths != NULL && !paths->is_leaf) {
+            if (paths->count == htons(0)) {
+                paths = NULL;
+                break;
+            }
+
             struct bom_tree_entry_indexes *indexes = &paths->indexes[0];
             paths = (struct bom_tree_entry *)bom_index_get(tree_context->context, ntohl(indexes->value_index), NULL);
         }
@@ -188,6 +358,59 @@ bom_tree_iterate(struct bom_tree_context *tree_context, bom_tree_iterator iterat
     tree_context->tree_iterating--;
 }
 
+void *
+bom_tree_find(struct bom_tree_context *tree_context, const void *key, size_t key_len, size_t *value_len)
+{
+    assert(tree_context != NULL);
+    assert(key != NULL);
+
+    struct bom_context *context = tree_context->context;
+    struct bom_tree *tree = _bom_tree_get(tree_context);
+    if (tree == NULL) {
+        return NULL;
+    }
+
+    /*
+     * Descend to the child before the first one whose key is not less than
+     * the key being found. That child is at or before the key regardless of
+     * whether branches hold the first or last key of each child, so this
+     * also finds keys in trees not written by bom_tree_add.
+     */
+    struct bom_tree_entry *node = (struct bom_tree_entry *)bom_index_get(context, ntohl(tree->child), NULL);
+    while (node != NULL && !node->is_leaf) {
+        if (node->count == htons(0)) {
+            return NULL;
+        }
+
+        unsigned int position = _bom_tree_node_search(context, node, key, key_len, true);
+        if (position > 0) {
+            position--;
+        }
+
+        node = (struct bom_tree_entry *)bom_index_get(context, ntohl(node->indexes[position].value_index), NULL);
+    }
+
+    /* Walk forward through the leaves until reaching the key's position. */
+    while (node != NULL) {
+        unsigned int position = _bom_tree_node_search(context, node, key, key_len, true);
+        if (position < ntohs(node->count)) {
+            struct bom_tree_entry_indexes *indexes = &node->indexes[position];
+            if (_bom_tree_compare_index(context, ntohl(indexes->key_index), key, key_len) != 0) {
+                return NULL;
+            }
+
+            return bom_index_get(context, ntohl(indexes->value_index), value_len);
+        }
+
+        if (node->forward == htonl(0)) {
+            break;
+        }
+        node = (struct bom_tree_entry *)bom_index_get(context, ntohl(node->forward), NULL);
+    }
+
+    return NULL;
+}
+
 void
 bom_tree_add(struct bom_tree_context *tree_context, const void *key, size_t key_len, const void *value, size_t value_len)
 {
@@ -196,33 +419,88 @@ bom_tree_add(struct bom_tree_context *tree_context, const void *key, size_t key_
     assert(value != NULL);
     assert(tree_context->tree_iterating == 0);
 
-    int key_index = bom_index_add(tree_context->context, key, key_len);
-    int value_index = bom_index_add(tree_context->context, value, value_len);
+    struct bom_context *context = tree_context->context;
 
-    int tree_index = bom_variable_get(tree_context->context, tree_context->variable_name);
-    struct bom_tree *tree = (struct bom_tree *)bom_index_get(tree_context->context, tree_index, NULL);
+    const void *entry_data[] = { key, value };
+    size_t entry_data_len[] = { key_len, value_len };
+    uint32_t key_index = bom_index_add_many(context, 2, entry_data, entry_data_len);
+    uint32_t value_index = key_index + 1;
 
-    /* Make room for the new index, extending the size as necessary. */
-    int paths_index = ntohl(tree->child);
-    bom_index_append(tree_context->context, paths_index, sizeof(struct bom_tree_entry_indexes));
+    /* Fetch after adding, as adding invalidates. */
+    struct bom_tree *tree = _bom_tree_get(tree_context);
+    size_t capacity = _bom_tree_node_capacity(tree);
+    size_t node_size = ntohl(tree->node_size);
+    if (node_size < sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * capacity) {
+        node_size = sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * capacity;
+    }
 
-    /* Re-fetch after append invalidation. */
-    tree = (struct bom_tree *)bom_index_get(tree_context->context, tree_index, NULL);
-    size_t paths_length;
-    struct bom_tree_entry *paths = (struct bom_tree_entry *)bom_index_get(tree_context->context, paths_index, &paths_length);
+    /*
+     * Descend to the leaf holding the key's position, remembering the path.
+     * Each branch entry's key is the last key in that child, so take the
+     * first child whose last key is greater. Past the end, the key becomes
+     * the new last key of the last child.
+     */
+    uint32_t path[BOM_TREE_MAX_DEPTH];
+    unsigned int positions[BOM_TREE_MAX_DEPTH];
+    size_t depth = 0;
+
+    path[0] = ntohl(tree->child);
+    struct bom_tree_entry *node = (struct bom_tree_entry *)bom_index_get(context, path[0], NULL);
+    while (!node->is_leaf) {
+        assert(depth + 1 < BOM_TREE_MAX_DEPTH);
+        assert(node->count != htons(0));
+
+        unsigned int position = _bom_tree_node_search(context, node, key, key_len, false);
+        if (position == ntohs(node->count)) {
+            position--;
+            node->indexes[position].key_index = htonl(key_index);
+        }
 
-    /* Push back existing data after insertion point. */
-    int entry_index = ntohs(paths->count);
-    ptrdiff_t entry_point = sizeof(struct bom_tree_entry) + sizeof(struct bom_tree_entry_indexes) * entry_index;
-    memmove((void *)paths + entry_point + sizeof(struct bom_tree_entry_indexes), (void *)paths + entry_point, paths_length - entry_point);
+        positions[depth] = position;
+        path[++depth] = ntohl(node->indexes[position].value_index);
+        node = (struct bom_tree_entry *)bom_index_get(context, path[depth], NULL);
+    }
 
-    /* Set the indexes for the inserted entry. */
-    struct bom_tree_entry_indexes *indexes = &paths->indexes[entry_index];
-    indexes->key_index = htonl(key_index);
-    indexes->value_index = htonl(value_index);
+    /* Insert after any equal keys to keep insertion order for duplicates. */
+    unsigned int position = _bom_tree_node_search(context, node, key, key_len, false);
+    node = _bom_tree_node_insert(context, path[depth], position, key_index, value_index);
+
+    /*
+     * Split full nodes from the leaf upwards. The entry for the new right node
+     * goes after the entry for the node split, with that node's key updated
+     * to its new last key.
+     */
+    while (ntohs(node->count) > capacity) {
+        uint32_t right_index = _bom_tree_node_split(context, path[depth], node_size);
+        assert(right_index != 0);
+
+        /* Re-fetch after split invalidation. */
+        node = (struct bom_tree_entry *)bom_index_get(context, path[depth], NULL);
+        uint32_t left_key_index = ntohl(node->indexes[ntohs(node->count) - 1].key_index);
+        struct bom_tree_entry *right = (struct bom_tree_entry *)bom_index_get(context, right_index, NULL);
+        uint32_t right_key_index = ntohl(right->indexes[ntohs(right->count) - 1].key_index);
+
+        if (depth == 0) {
+            /* Splitting the root: add a new root above both halves. */
+            uint32_t root_index = _bom_tree_node_add(context, node_size, false);
+            assert(root_index != 0);
+
+            _bom_tree_node_insert(context, root_index, 0, left_key_index, path[0]);
+            _bom_tree_node_insert(context, root_index, 1, right_key_index, right_index);
+
+            /* Re-fetch after add invalidation. */
+            tree = _bom_tree_get(tree_context);
+            tree->child = htonl(root_index);
+            break;
+        }
 
-    /* Update counts for inserted entry. */
+        depth--;
+        struct bom_tree_entry *parent = (struct bom_tree_entry *)bom_index_get(context, path[depth], NULL);
+        parent->indexes[positions[depth]].key_index = htonl(left_key_index);
+        node = _bom_tree_node_insert(context, path[depth], positions[depth] + 1, right_key_index, right_index);
+    }
+
+    /* Re-fetch after split invalidation. */
+    tree = _bom_tree_get(tree_context);
     tree->path_count = htonl(ntohl(tree->path_count) + 1);
-    paths->count = htons(ntohs(paths->count) + 1);
 }
-
@@ -0,0 +1,86 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <bom/bom.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void
+Populate(struct bom_context *bom)
+{
+    char const first[] = "first";
+    uint32_t first_index = bom_index_add(bom, first, sizeof(first));
+    bom_variable_add(bom, "First", first_index);
+
+    char const *many[] = { "a", "bb", "ccc" };
+    size_t many_len[] = { 1, 2, 3 };
+    uint32_t many_index = bom_index_add_many(bom, 3, reinterpret_cast<void const *const *>(many), many_len);
+    bom_variable_add(bom, "Many", many_index);
+
+    /* Grow a block that is not the last one. */
+    bom_index_append(bom, first_index, 8);
+
+    struct bom_tree_context *tree = bom_tree_alloc_empty(bom, "Tree");
+    for (int i = 0; i < 2000; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%06d", (i * 7919) % 2000);
+        bom_tree_add(tree, key, strlen(key), &i, sizeof(i));
+    }
+    bom_tree_free(tree);
+}
+
+TEST(bom, AddMany)
+{
+    struct bom_context *bom = bom_alloc_empty(bom_context_memory(NULL, 0));
+    ASSERT_NE(nullptr, bom);
+
+    char const *data[] = { "one", "two", "three" };
+    size_t data_len[] = { 3, 3, 5 };
+    uint32_t index = bom_index_add_many(bom, 3, reinterpret_cast<void const *const *>(data), data_len);
+
+    for (size_t i = 0; i < 3; i++) {
+        size_t len = 0;
+        void *value = bom_index_get(bom, index + i, &len);
+        ASSERT_NE(nullptr, value);
+        EXPECT_EQ(std::string(data[i]), std::string(static_cast<char *>(value), len));
+    }
+
+    bom_free(bom);
+}
+
+TEST(bom, BuilderMatchesImmediate)
+{
+    struct bom_context *immediate = bom_alloc_empty(bom_context_memory(NULL, 0));
+    ASSERT_NE(nullptr, immediate);
+    Populate(immediate);
+
+    struct bom_context *builder = bom_alloc_builder(bom_context_memory(NULL, 0));
+    ASSERT_NE(nullptr, builder);
+    Populate(builder);
+
+    /* Readable while building. */
+    size_t len = 0;
+    void *value = bom_index_get(builder, bom_variable_get(builder, "Many") + 1, &len);
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ("bb", std::string(static_cast<char *>(value), len));
+
+    bom_builder_finish(builder);
+
+    struct bom_context_memory const *immediate_memory = bom_memory(immediate);
+    struct bom_context_memory const *builder_memory = bom_memory(builder);
+    ASSERT_EQ(immediate_memory->size, builder_memory->size);
+    EXPECT_EQ(0, memcmp(immediate_memory->data, builder_memory->data, immediate_memory->size));
+
+    bom_free(builder);
+    bom_free(immediate);
+}
@@ -0,0 +1,133 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <bom/bom_format.h>
+#include <bom/bom.h>
+
+#include <arpa/inet.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static std::string
+TestKey(int n)
+{
+    char key[16];
+    snprintf(key, sizeof(key), "key%06d", n);
+    return key;
+}
+
+static void
+AddKeys(struct bom_tree_context *tree, int count)
+{
+    /* Add in a scrambled order to exercise splits anywhere in the tree. */
+    for (int i = 0; i < count; i++) {
+        int n = (i * 7919) % count;
+        std::string key = TestKey(n);
+        bom_tree_add(tree, key.data(), key.size(), &n, sizeof(n));
+    }
+}
+
+TEST(bom_tree, SortedIteration)
+{
+    struct bom_context *bom = bom_alloc_empty(bom_context_memory(NULL, 0));
+    ASSERT_NE(nullptr, bom);
+    struct bom_tree_context *tree = bom_tree_alloc_empty(bom, "Test");
+    ASSERT_NE(nullptr, tree);
+
+    int count = 5000;
+    AddKeys(tree, count);
+
+    std::vector<std::string> keys;
+    bom_tree_iterate(tree, [](struct bom_tree_context *tree, void *key, size_t key_len, void *value, size_t value_len, void *ctx) {
+        static_cast<std::vector<std::string> *>(ctx)->push_back(std::string(static_cast<char *>(key), key_len));
+    }, &keys);
+
+    ASSERT_EQ(count, keys.size());
+    for (int n = 0; n < count; n++) {
+        EXPECT_EQ(TestKey(n), keys[n]);
+    }
+
+    bom_tree_free(tree);
+    bom_free(bom);
+}
+
+TEST(bom_tree, SplitNodes)
+{
+    struct bom_context *bom = bom_alloc_empty(bom_context_memory(NULL, 0));
+    struct bom_tree_context *tree = bom_tree_alloc_empty(bom, "Test");
+    AddKeys(tree, 5000);
+
+    int tree_index = bom_variable_get(bom, "Test");
+    struct bom_tree *header = (struct bom_tree *)bom_index_get(bom, tree_index, NULL);
+    EXPECT_EQ(5000, ntohl(header->path_count));
+
+    /* Every node fits in the node size, and the root is a branch. */
+    size_t root_len;
+    struct bom_tree_entry *root = (struct bom_tree_entry *)bom_index_get(bom, ntohl(header->child), &root_len);
+    EXPECT_EQ(ntohl(header->node_size), root_len);
+    EXPECT_EQ(0, ntohs(root->is_leaf));
+
+    /* Leaves are linked in both directions. */
+    struct bom_tree_entry *leaf = root;
+    while (!leaf->is_leaf) {
+        leaf = (struct bom_tree_entry *)bom_index_get(bom, ntohl(leaf->indexes[0].value_index), NULL);
+    }
+    EXPECT_EQ(0, ntohl(leaf->backward));
+
+    size_t leaves = 0;
+    uint32_t previous = 0;
+    uint32_t current = ntohl(root->indexes[0].value_index);
+    while (true) {
+        struct bom_tree_entry *node = (struct bom_tree_entry *)bom_index_get(bom, current, NULL);
+        if (!node->is_leaf) {
+            current = ntohl(node->indexes[0].value_index);
+            continue;
+        }
+
+        EXPECT_EQ(previous, ntohl(node->backward));
+        leaves++;
+
+        if (node->forward == 0) {
+            break;
+        }
+        previous = current;
+        current = ntohl(node->forward);
+    }
+    EXPECT_LT(1, leaves);
+
+    bom_tree_free(tree);
+    bom_free(bom);
+}
+
+TEST(bom_tree, Find)
+{
+    struct bom_context *bom = bom_alloc_empty(bom_context_memory(NULL, 0));
+    struct bom_tree_context *tree = bom_tree_alloc_empty(bom, "Test");
+    AddKeys(tree, 5000);
+
+    for (int n = 0; n < 5000; n += 37) {
+        std::string key = TestKey(n);
+        size_t value_len = 0;
+        int *value = (int *)bom_tree_find(tree, key.data(), key.size(), &value_len);
+        ASSERT_NE(nullptr, value);
+        EXPECT_EQ(sizeof(int), value_len);
+        EXPECT_EQ(n, *value);
+    }
+
+    std::string missing = "missing";
+    EXPECT_EQ(nullptr, bom_tree_find(tree, missing.data(), missing.size(), NULL));
+    std::string after = "zzz";
+    EXPECT_EQ(nullptr, bom_tree_find(tree, after.data(), after.size(), NULL));
+
+    bom_tree_free(tree);
+    bom_free(bom);
+}
@@ -18,7 +18,6 @@
 #include <memory>
 #include <string>
 #include <vector>
-#include <unordered_map>
 
 namespace car {
 
@@ -26,7 +25,8 @@ class Facet;
 class Rendition;
 
 /*
- * An archive within a BOM file holding facets and their renditions.
+ * An archive within a BOM file holding facets and their renditions. Facets
+ * and renditions are read in place from the BOM, so it must outlive them.
  */
 class Reader {
 public:
@@ -35,14 +35,22 @@ public:
 
 private:
     typedef struct {
-        void *key; size_t key_len; void *value; size_t value_len;
+        uint16_t identifier; void *key; size_t key_len; void *value; size_t value_len;
     } KeyValuePair;
 
 private:
     unique_ptr_bom _bom;
     ext::optional<struct car_key_format*> _keyfmt;
-    std::unordered_map<std::string, void*> _facetValues;
-    std::unordered_multimap<uint16_t, KeyValuePair> _renditionValues;
+    size_t _identifierIndex;
+    unique_ptr_bom_tree _facetTree;
+    bool _facetsSorted;
+
+private:
+    /*
+     * Renditions sorted by facet identifier, built on load so lookups
+     * don't modify the reader.
+     */
+    std::vector<KeyValuePair> _renditionValues;
 
 private:
     Reader(unique_ptr_bom bom);
@@ -95,6 +103,11 @@ public:
      * Load an existing archive from a BOM.
      */
     static ext::optional<Reader> Load(unique_ptr_bom bom);
+
+    /*
+     * Load an existing archive from a file, mapping it into memory.
+     */
+    static ext::optional<Reader> Open(std::string const &path);
 };
 
 }
@@ -100,6 +100,7 @@ private:
 private:
     std::function<ext::optional<Data>(Rendition const *)> _deferredData;
     ext::optional<Data> _data;
+    struct car_rendition_value *_value;
 
 private:
     std::string                     _fileName;
@@ -223,11 +224,25 @@ public:
      */
     ext::optional<Data> data() const;
 
+    /*
+     * The length of the pixel data in bytes. For loaded renditions, this
+     * does not decode the data.
+     */
+    ext::optional<size_t> dataLength() const;
+
+    /*
+     * Decode the pixel data into a buffer of at least dataLength() bytes,
+     * without allocating. Returns the format of the decoded data.
+     */
+    ext::optional<Data::Format> decode(void *buffer, size_t length) const;
+
 public:
     /*
-     * Serialize the rendition for writing to a file.
+     * Serialize the rendition for writing to a file. The compression level
+     * is a zlib level, where -1 is the default. A non-zero chunk size splits
+     * pixel data into independently compressed chunks of that many bytes.
      */
-    std::vector<uint8_t> write() const;
+    std::vector<uint8_t> write(int compressionLevel = -1, size_t chunkSize = 0) const;
 
 public:
     /*
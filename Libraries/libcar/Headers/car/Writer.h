@@ -39,6 +39,12 @@ private:
     std::unordered_map<std::string, Facet> _facets;
     std::unordered_multimap<uint16_t, Rendition> _renditions;
 
+private:
+    int    _compressionLevel;
+    size_t _chunkSize;
+    size_t _jobs;
+    size_t _memoryBudget;
+
 private:
     Writer(unique_ptr_bom bom);
 
@@ -49,6 +55,44 @@ public:
     struct bom_context *bom() const
     { return _bom.get(); }
 
+public:
+    /*
+     * The zlib compression level for rendition pixel data. Defaults to
+     * -1, the zlib default.
+     */
+    int compressionLevel() const
+    { return _compressionLevel; }
+    int &compressionLevel()
+    { return _compressionLevel; }
+
+    /*
+     * If non-zero, pixel data is compressed in independent chunks of this
+     * many bytes. Defaults to zero, a single chunk.
+     */
+    size_t chunkSize() const
+    { return _chunkSize; }
+    size_t &chunkSize()
+    { return _chunkSize; }
+
+    /*
+     * The number of threads used to encode renditions. Zero, the default,
+     * uses one per processor. The output does not depend on this value.
+     */
+    size_t jobs() const
+    { return _jobs; }
+    size_t &jobs()
+    { return _jobs; }
+
+    /*
+     * If non-zero, limits the pixel data of renditions being encoded at
+     * once to about this many bytes. Useful when renditions decode their
+     * data lazily; a rendition larger than the budget is encoded alone.
+     */
+    size_t memoryBudget() const
+    { return _memoryBudget; }
+    size_t &memoryBudget()
+    { return _memoryBudget; }
+
 public:
     /*
      * Add a facet to the archive.
@@ -68,7 +112,8 @@ public:
 
 public:
     /*
-     * Serialize and write to BOM.
+     * Serialize and write to BOM. For a BOM from bom_alloc_builder(),
+     * the BOM is finished after writing.
      */
      void write() const;
 };
@@ -12,6 +12,7 @@
 #include <car/Rendition.h>
 #include <car/car_format.h>
 
+#include <algorithm>
 #include <limits>
 #include <random>
 
@@ -24,8 +25,9 @@ Reader::
 Reader(unique_ptr_bom bom) :
     _bom(std::move(bom)),
     _keyfmt(ext::nullopt),
-    _facetValues({}),
-    _renditionValues({})
+    _identifierIndex(0),
+    _facetTree(nullptr, bom_tree_free),
+    _facetsSorted(false)
 {
 }
 
@@ -56,10 +58,10 @@ _car_tree_iterator(Reader const *reader, const char *tree_variable, bom_tree_ite
 void Reader::
 facetIterate(std::function<void(Facet const &)> const &iterator) const
 {
-    for( const auto& item : _facetValues ) {
-        car::Facet facet = car::Facet::Load(item.first, (struct car_facet_value *)item.second);
+    facetFastIterate([&iterator](void *key, size_t key_len, void *value, size_t value_len) {
+        car::Facet facet = car::Facet::Load(std::string((char *)key, key_len), (struct car_facet_value *)value);
         iterator(facet);
-    }
+    });
 }
 
 static void
@@ -78,14 +80,13 @@ void Reader::
 renditionIterate(std::function<void(Rendition const &)> const &iterator) const
 {
     auto keyfmt = *_keyfmt;
-    for( const auto& it : _renditionValues ) {
-        KeyValuePair kv = (KeyValuePair)it.second;
-        car_rendition_key *rendition_key = (car_rendition_key *)kv.key;
-        struct car_rendition_value *rendition_value = (struct car_rendition_value *)kv.value;
+    renditionFastIterate([&iterator, keyfmt](void *key, size_t key_len, void *value, size_t value_len) {
+        car_rendition_key *rendition_key = (car_rendition_key *)key;
+        struct car_rendition_value *rendition_value = (struct car_rendition_value *)value;
         car::AttributeList attributes = car::AttributeList::Load(keyfmt->num_identifiers, keyfmt->identifier_list, rendition_key);
         car::Rendition rendition = car::Rendition::Load(attributes, rendition_value);
         iterator(rendition);
-    }
+    });
 }
 
 static void
@@ -163,23 +164,20 @@ dump() const
 ext::optional<Reader> Reader::
 Load(unique_ptr_bom bom)
 {
+    if (bom == nullptr) {
+        return ext::nullopt;
+    }
+
     int header_index = bom_variable_get(bom.get(), car_header_variable);
 
     size_t header_len;
     struct car_header *header = (struct car_header *)bom_index_get(bom.get(), header_index, &header_len);
-    if (header_len < sizeof(struct car_header) || strncmp(header->magic, "RATC", 4) || header->storage_version < 8) {
+    if (header == NULL || header_len < sizeof(struct car_header) || strncmp(header->magic, "RATC", 4) || header->storage_version < 8) {
         return ext::nullopt;
     }
 
     auto reader = Reader(std::move(bom));
 
-    // Iterate through the facets as fast as possible
-    // just save the name and value pointer for lookups later
-    reader.facetFastIterate([&reader](void *key, size_t key_len, void *value, size_t value_len) {
-        auto name = std::string((char *)key, key_len);
-        reader._facetValues.insert ( {name, value} );
-    });
-
     // Load the key format from the BOM
     int key_format_index = bom_variable_get(reader.bom(), car_key_format_variable);
     struct car_key_format *keyfmt = (struct car_key_format*)bom_index_get(reader.bom(), key_format_index, NULL);
@@ -191,43 +189,82 @@ Load(unique_ptr_bom bom)
 
     // The index into the attribute list for the identifer for the matching facet.
     // The attribute list is a list of uint16_t in the key portion of the entry for the rendition
-    size_t identifier_index = 0;
-
-    // Scan the key format for the facet identifier index
     for (size_t i = 0; i < keyfmt->num_identifiers; i++) {
         if (keyfmt->identifier_list[i] == car_attribute_identifier_identifier) {
-            identifier_index = i;
+            reader._identifierIndex = i;
             break;
         }
     }
 
-    // Iterate through the renditions as fast as possible. Save the key and value pointers, indexed by the Facet identifier
-    reader.renditionFastIterate([identifier_index,&reader](void *key, size_t key_len, void *value, size_t value_len) {
+    // Facets are looked up in place, by searching the facet tree. Older archives
+    // stored facets unsorted, so those can only be searched linearly.
+    reader._facetTree = unique_ptr_bom_tree(bom_tree_alloc_load(reader.bom(), car_facet_keys_variable), bom_tree_free);
+
+    bool sorted = true;
+    ext::optional<std::string> previous;
+    reader.facetFastIterate([&sorted, &previous](void *key, size_t key_len, void *value, size_t value_len) {
+        std::string name = std::string((char *)key, key_len);
+        if (previous && !(*previous < name)) {
+            sorted = false;
+        }
+        previous = std::move(name);
+    });
+    reader._facetsSorted = sorted;
+
+    // Renditions are keyed by all attributes, so group them by identifier once.
+    size_t identifier_index = reader._identifierIndex;
+    std::vector<KeyValuePair> *values = &reader._renditionValues;
+    reader.renditionFastIterate([identifier_index, values](void *key, size_t key_len, void *value, size_t value_len) {
         KeyValuePair kv;
+        kv.identifier = ((car_rendition_key *)key)[identifier_index];
         kv.key = key;
         kv.key_len = key_len;
         kv.value = value;
         kv.value_len = value_len;
-        car_rendition_key *rendition_key = (car_rendition_key *)key;
-        reader._renditionValues.insert( {rendition_key[identifier_index], kv} );
+        values->push_back(kv);
+    });
 
+    std::stable_sort(reader._renditionValues.begin(), reader._renditionValues.end(), [](KeyValuePair const &lhs, KeyValuePair const &rhs) {
+        return lhs.identifier < rhs.identifier;
     });
 
     return std::move(reader);
 }
 
+ext::optional<Reader> Reader::
+Open(std::string const &path)
+{
+    struct bom_context_memory memory = bom_context_memory_file(path.c_str(), false, 0);
+    if (memory.data == NULL) {
+        return ext::nullopt;
+    }
+
+    return Load(unique_ptr_bom(bom_alloc_load(memory), bom_free));
+}
+
 ext::optional<car::Facet>
 Reader::lookupFacet(std::string name) const
 {
     ext::optional<car::Facet> result;
 
-    auto lookup = _facetValues.find(name);
+    if (_facetTree == nullptr) {
+        return result;
+    }
 
-    if ( lookup == _facetValues.end() ) {
+    struct car_facet_value *facet_value = NULL;
+    if (_facetsSorted) {
+        facet_value = (struct car_facet_value *)bom_tree_find(_facetTree.get(), name.data(), name.size(), NULL);
+    } else {
+        facetFastIterate([&name, &facet_value](void *key, size_t key_len, void *value, size_t value_len) {
+            if (facet_value == NULL && key_len == name.size() && memcmp(key, name.data(), key_len) == 0) {
+                facet_value = (struct car_facet_value *)value;
+            }
+        });
+    }
+    if (facet_value == NULL) {
         return result;
     }
 
-    struct car_facet_value *facet_value = (struct car_facet_value *)lookup->second;
     AttributeList attributes = car::AttributeList::Load(facet_value->attributes_count, facet_value->attributes);
     result = car::Facet::Create(name, attributes);
 
@@ -249,15 +286,15 @@ std::vector<car::Rendition> Reader::lookupRenditions(car::Facet const &facet) co
     }
 
     auto keyfmt = *_keyfmt;
-    auto lookupRendition = _renditionValues.equal_range(*facet_identifier);
+    auto lookupRendition = std::equal_range(_renditionValues.begin(), _renditionValues.end(), KeyValuePair { *facet_identifier }, [](KeyValuePair const &lhs, KeyValuePair const &rhs) {
+        return lhs.identifier < rhs.identifier;
+    });
     for (auto it = lookupRendition.first; it != lookupRendition.second; ++it) {
-        KeyValuePair value = (KeyValuePair)it->second;
-        car_rendition_key *rendition_key = (car_rendition_key *)value.key;
-        struct car_rendition_value *rendition_value = (struct car_rendition_value *)value.value;
+        car_rendition_key *rendition_key = (car_rendition_key *)it->key;
+        struct car_rendition_value *rendition_value = (struct car_rendition_value *)it->value;
         car::AttributeList attributes = car::AttributeList::Load(keyfmt->num_identifiers, keyfmt->identifier_list, rendition_key);
         car::Rendition rendition = car::Rendition::Load(attributes, rendition_value);
         result.push_back(rendition);
     }
     return result;
 }
-
@@ -11,6 +11,7 @@
 #include <car/Reader.h>
 #include <car/car_format.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <cstdio>
@@ -59,6 +60,7 @@ Rendition::
 Rendition(AttributeList const &attributes, std::function<ext::optional<Data>(Rendition const *)> const &data) :
     _attributes  (attributes),
     _deferredData(data),
+    _value       (nullptr),
     _width       (0),
     _height      (0),
     _scale       (1.0),
@@ -72,6 +74,7 @@ Rendition::
 Rendition(AttributeList const &attributes, ext::optional<Data> const &data) :
     _attributes (attributes),
     _data       (data),
+    _value      (nullptr),
     _width      (0),
     _height     (0),
     _scale      (1.0),
@@ -123,8 +126,11 @@ dump() const
     _attributes.dump();
 }
 
+static ext::optional<Rendition::Data::Format> DecodeFormat(struct car_rendition_value const *value);
+static ext::optional<size_t> DecodeLength(struct car_rendition_value *value, Rendition::Data::Format format);
+static bool DecodeInto(struct car_rendition_value *value, Rendition::Data::Format format, void *uncompressed_data, size_t uncompressed_length);
 static ext::optional<Rendition::Data> Decode(struct car_rendition_value *value);
-static ext::optional<std::vector<uint8_t>> Encode(Rendition const *rendition, ext::optional<Rendition::Data> data);
+static ext::optional<std::vector<uint8_t>> Encode(Rendition const *rendition, ext::optional<Rendition::Data> data, int compression_level, size_t chunk_size);
 
 
 static Rendition::ResizeMode
@@ -171,6 +177,7 @@ Load(
     Rendition rendition = Rendition(attributes, [value](Rendition const *rendition) -> ext::optional<Data> {
         return Decode(value);
     });
+    rendition._value = value;
 
     for (struct car_rendition_info_header *info_header = (struct car_rendition_info_header *)value->info;
         ((uintptr_t)info_header - (uintptr_t)value->info) < value->info_len;
@@ -274,52 +281,124 @@ data() const
     return ext::nullopt;
 }
 
-static ext::optional<Rendition::Data>
-Decode(struct car_rendition_value *value)
+ext::optional<size_t> Rendition::
+dataLength() const
+{
+    if (_value != nullptr) {
+        ext::optional<Data::Format> format = DecodeFormat(_value);
+        if (!format) {
+            return ext::nullopt;
+        }
+
+        return DecodeLength(_value, *format);
+    }
+
+    ext::optional<Data> data = this->data();
+    if (!data) {
+        return ext::nullopt;
+    }
+
+    return data->data().size();
+}
+
+ext::optional<Rendition::Data::Format> Rendition::
+decode(void *buffer, size_t length) const
+{
+    if (_value != nullptr) {
+        ext::optional<Data::Format> format = DecodeFormat(_value);
+        if (!format) {
+            return ext::nullopt;
+        }
+
+        ext::optional<size_t> dataLength = DecodeLength(_value, *format);
+        if (!dataLength || *dataLength > length) {
+            return ext::nullopt;
+        }
+
+        if (!DecodeInto(_value, *format, buffer, *dataLength)) {
+            return ext::nullopt;
+        }
+
+        return format;
+    }
+
+    ext::optional<Data> data = this->data();
+    if (!data || data->data().size() > length) {
+        return ext::nullopt;
+    }
+
+    memcpy(buffer, data->data().data(), data->data().size());
+    return data->format();
+}
+
+static ext::optional<Rendition::Data::Format>
+DecodeFormat(struct car_rendition_value const *value)
 {
     if (strncmp(value->magic, "ISTC", 4) != 0) {
         return ext::nullopt;
     }
 
-    Rendition::Data::Format format;
     if (value->pixel_format == car_rendition_value_pixel_format_argb) {
-        format = Rendition::Data::Format::PremultipliedBGRA8;
+        return Rendition::Data::Format::PremultipliedBGRA8;
     } else if (value->pixel_format == car_rendition_value_pixel_format_ga8) {
-        format = Rendition::Data::Format::PremultipliedGA8;
+        return Rendition::Data::Format::PremultipliedGA8;
     } else if (value->pixel_format == car_rendition_value_pixel_format_raw_data) {
-        format = Rendition::Data::Format::Data;
+        return Rendition::Data::Format::Data;
     } else if (value->pixel_format == car_rendition_value_pixel_format_jpeg) {
-        format = Rendition::Data::Format::JPEG;
+        return Rendition::Data::Format::JPEG;
     } else {
-        format = Rendition::Data::Format::Data;
         fprintf(stderr, "error: unsupported pixel format %.4s\n", (char const *)&value->pixel_format);
         return ext::nullopt;
     }
+}
 
+static struct car_rendition_data_header_raw *
+DecodeRawHeader(struct car_rendition_value *value)
+{
     /* JPEG format embeds the file within another header. */
+    struct car_rendition_data_header_raw *header_raw = (struct car_rendition_data_header_raw *)((uintptr_t)value + sizeof(struct car_rendition_value) + value->info_len);
+    if (strncmp(header_raw->magic, "DWAR", sizeof(header_raw->magic)) != 0) {
+        fprintf(stderr, "error: raw data header magic is wrong, can't possibly decode\n");
+        return NULL;
+    }
+
+    return header_raw;
+}
+
+static ext::optional<size_t>
+DecodeLength(struct car_rendition_value *value, Rendition::Data::Format format)
+{
     if (format == Rendition::Data::Format::JPEG || format == Rendition::Data::Format::Data) {
-        struct car_rendition_data_header_raw *header_raw = (struct car_rendition_data_header_raw *)((uintptr_t)value + sizeof(struct car_rendition_value) + value->info_len);
-        if (strncmp(header_raw->magic, "DWAR", sizeof(header_raw->magic)) != 0) {
-            fprintf(stderr, "error: raw data header magic is wrong, can't possibly decode\n");
+        struct car_rendition_data_header_raw *header_raw = DecodeRawHeader(value);
+        if (header_raw == NULL) {
             return ext::nullopt;
         }
 
-        std::vector<uint8_t> contents = std::vector<uint8_t>(header_raw->data, header_raw->data + header_raw->length);
-        Rendition::Data data = Rendition::Data(contents, format);
-        return data;
+        return static_cast<size_t>(header_raw->length);
     }
 
-    size_t bytes_per_pixel = Rendition::Data::FormatSize(format);
-    size_t uncompressed_length = value->width * value->height * bytes_per_pixel;
-    Rendition::Data data = Rendition::Data(std::vector<uint8_t>(uncompressed_length), format);
-    void *uncompressed_data = static_cast<void *>(data.data().data());
+    return static_cast<size_t>(value->width) * value->height * Rendition::Data::FormatSize(format);
+}
+
+static bool
+DecodeInto(struct car_rendition_value *value, Rendition::Data::Format format, void *uncompressed_data, size_t uncompressed_length)
+{
+    if (format == Rendition::Data::Format::JPEG || format == Rendition::Data::Format::Data) {
+        struct car_rendition_data_header_raw *header_raw = DecodeRawHeader(value);
+        if (header_raw == NULL || header_raw->length != uncompressed_length) {
+            return false;
+        }
+
+        memcpy(uncompressed_data, header_raw->data, header_raw->length);
+        return true;
+    }
 
     /* Advance past the header and the info section. We just want the data. */
     struct car_rendition_data_header1 *header1 = (struct car_rendition_data_header1 *)((uintptr_t)value + sizeof(struct car_rendition_value) + value->info_len);
 
     if (strncmp(header1->magic, "MLEC", sizeof(header1->magic)) != 0) {
         fprintf(stderr, "error: header1 magic is wrong, can't possibly decode\n");
-        return ext::nullopt;
+        return false;
     }
 
     void *compressed_data = &header1->data;
@@ -352,30 +431,37 @@ Decode(struct car_rendition_value *value)
 
             int ret = inflateInit2(&strm, 16+MAX_WBITS);
             if (ret != Z_OK) {
-               return ext::nullopt;
+               return false;
             }
 
-            strm.avail_out = uncompressed_length;
-            strm.next_out = (Bytef *)uncompressed_data;
+            strm.avail_out = uncompressed_length - offset;
+            strm.next_out = (Bytef *)uncompressed_data + offset;
 
             ret = inflate(&strm, Z_NO_FLUSH);
             if (ret != Z_OK && ret != Z_STREAM_END) {
                 printf("error: decompression failure: %x.\n", ret);
-                return ext::nullopt;
+                return false;
             }
 
             ret = inflateEnd(&strm);
             if (ret != Z_OK) {
-                return ext::nullopt;
+                return false;
             }
 
-            offset += (uncompressed_length - strm.avail_out);
+            size_t produced = (uncompressed_length - offset) - strm.avail_out;
+            if (produced == 0) {
+                fprintf(stderr, "error: decompression made no progress\n");
+                return false;
+            }
+
+            offset += produced;
+            compressed_data = (void *)((uintptr_t)compressed_data + compressed_length);
         } else if (header1->compression == car_rendition_data_compression_magic_rle) {
             fprintf(stderr, "error: unable to handle RLE\n");
-            return ext::nullopt;
+            return false;
         } else if (header1->compression == car_rendition_data_compression_magic_unk1) {
             fprintf(stderr, "error: unable to handle UNKNOWN\n");
-            return ext::nullopt;
+            return false;
         } else if (header1->compression == car_rendition_data_compression_magic_lzvn || header1->compression == car_rendition_data_compression_magic_jpeg_lzfse) {
 #if HAVE_LIBCOMPRESSION
             compression_algorithm algorithm;
@@ -393,33 +479,86 @@ Decode(struct car_rendition_value *value)
                 compressed_data = (void *)((uintptr_t)compressed_data + compressed_length);
             } else {
                 fprintf(stderr, "error: decompression failure\n");
-                return ext::nullopt;
+                return false;
             }
 #else
             if (header1->compression == car_rendition_data_compression_magic_lzvn) {
                 fprintf(stderr, "error: unable to handle LZVN\n");
-                return ext::nullopt;
+                return false;
             } else if (header1->compression == car_rendition_data_compression_magic_jpeg_lzfse) {
                 fprintf(stderr, "error: unable to handle LZFSE\n");
-                return ext::nullopt;
+                return false;
             } else {
                 assert(false);
             }
 #endif
         } else if (header1->compression == car_rendition_data_compression_magic_blurredimage) {
             fprintf(stderr, "error: unable to handle BlurredImage\n");
-            return ext::nullopt;
+            return false;
         } else {
             fprintf(stderr, "error: unknown compression algorithm %x\n", header1->compression);
-            return ext::nullopt;
+            return false;
         }
     }
 
+    return true;
+}
+
+static ext::optional<Rendition::Data>
+Decode(struct car_rendition_value *value)
+{
+    ext::optional<Rendition::Data::Format> format = DecodeFormat(value);
+    if (!format) {
+        return ext::nullopt;
+    }
+
+    ext::optional<size_t> length = DecodeLength(value, *format);
+    if (!length) {
+        return ext::nullopt;
+    }
+
+    Rendition::Data data = Rendition::Data(std::vector<uint8_t>(*length), *format);
+    if (!DecodeInto(value, *format, data.data().data(), data.data().size())) {
+        return ext::nullopt;
+    }
+
     return data;
 }
 
+static bool
+EncodeZlib(void const *uncompressed_data, size_t uncompressed_length, int compression_level, std::vector<uint8_t> *compressed_vector)
+{
+    int windowSize = 16+MAX_WBITS;
+    z_stream zlibStream;
+    memset(&zlibStream, 0, sizeof(zlibStream));
+    zlibStream.next_in = (Bytef*)uncompressed_data;
+    zlibStream.avail_in = (uInt)uncompressed_length;
+    int err = deflateInit2(&zlibStream, compression_level, Z_DEFLATED, windowSize, 8, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK) {
+        return false;
+    }
+    while (true) {
+        uint8_t tmp[4096];
+        zlibStream.next_out = (Bytef*)&tmp;
+        zlibStream.avail_out = (uInt)sizeof(tmp);
+        err = deflate(&zlibStream, Z_FINISH);
+        size_t block_size = sizeof(tmp) - zlibStream.avail_out;
+        compressed_vector->insert(compressed_vector->end(), &tmp[0], &tmp[block_size]);
+        if (err == Z_STREAM_END) {  /* Done */
+            break;
+        }
+        if (err != Z_OK) {  /* Z_OK -> Made progress, else err */
+            deflateEnd(&zlibStream);
+            fprintf(stderr, "Zlib error %d", err);
+            return false;
+        }
+    }
+    deflateEnd(&zlibStream);
+    return true;
+}
+
 static ext::optional<std::vector<uint8_t>>
-Encode(Rendition const *rendition, ext::optional<Rendition::Data> data)
+Encode(Rendition const *rendition, ext::optional<Rendition::Data> data, int compression_level, size_t chunk_size)
 {
     if (!data || data->data().size() == 0) {
         return ext::nullopt;
@@ -437,38 +576,37 @@ Encode(Rendition const *rendition, ext::optional<Rendition::Data> data)
     size_t bytes_per_pixel = Rendition::Data::FormatSize(data->format());
 
     size_t uncompressed_length = rendition->width() * rendition->height() * bytes_per_pixel;
-    void *uncompressed_data = static_cast<void *>(data->data().data());
+    uint8_t const *uncompressed_data = data->data().data();
+
+    /*
+     * Chunks are compressed independently, each after a KCBC header. Without
+     * chunking, the data is compressed as a single stream with no header.
+     */
+    bool chunked = (chunk_size != 0 && chunk_size < uncompressed_length);
+    if (!chunked) {
+        chunk_size = uncompressed_length;
+    }
 
     std::vector<uint8_t> compressed_vector;
     if (compression_magic == car_rendition_data_compression_magic_zlib) {
-        int deflateLevel = Z_DEFAULT_COMPRESSION;
-        int windowSize = 16+MAX_WBITS;
-        z_stream zlibStream;
-        memset(&zlibStream, 0, sizeof(zlibStream));
-        zlibStream.next_in = (Bytef*)uncompressed_data;
-        zlibStream.avail_in = (uInt)uncompressed_length;
-        int err = deflateInit2(&zlibStream, deflateLevel, Z_DEFLATED, windowSize, 8, Z_DEFAULT_STRATEGY);
-        if (err != Z_OK) {
-            return ext::nullopt;
-        }
-        while (true) {
-            uint8_t tmp[4096];
-            zlibStream.next_out = (Bytef*)&tmp;
-            zlibStream.avail_out = (uInt)sizeof(tmp);
-            err = deflate(&zlibStream, Z_FINISH);
-            size_t block_size = sizeof(tmp) - zlibStream.avail_out;
-            compressed_vector.resize(compressed_vector.size() + block_size);
-            memcpy(&compressed_vector[compressed_vector.size() - block_size], &tmp[0], block_size);
-            if (err == Z_STREAM_END) {  /* Done */
-                break;
+        for (size_t offset = 0; offset < uncompressed_length; offset += chunk_size) {
+            size_t chunk_length = std::min(chunk_size, uncompressed_length - offset);
+
+            size_t header2_offset = compressed_vector.size();
+            if (chunked) {
+                compressed_vector.resize(compressed_vector.size() + sizeof(struct car_rendition_data_header2));
             }
-            if (err != Z_OK) {  /* Z_OK -> Made progress, else err */
-                deflateEnd(&zlibStream);
-                fprintf(stderr, "Zlib error %d", err);
+
+            if (!EncodeZlib(uncompressed_data + offset, chunk_length, compression_level, &compressed_vector)) {
                 return ext::nullopt;
             }
+
+            if (chunked) {
+                struct car_rendition_data_header2 *header2 = reinterpret_cast<struct car_rendition_data_header2 *>(&compressed_vector[header2_offset]);
+                memcpy(header2->magic, "KCBC", sizeof(header2->magic));
+                header2->length = compressed_vector.size() - header2_offset - sizeof(struct car_rendition_data_header2);
+            }
         }
-        deflateEnd(&zlibStream);
     }
 
     std::vector<uint8_t> output = std::vector<uint8_t>(sizeof(struct car_rendition_data_header1));
@@ -499,7 +637,7 @@ Create(
 }
 
 std::vector<uint8_t> Rendition::
-write() const
+write(int compressionLevel, size_t chunkSize) const
 {
     // Create header
     struct car_rendition_value header;
@@ -574,8 +712,9 @@ write() const
     info_bitmap_info.exif_orientation = 1; // XXX FIXME
 
     size_t bytes_per_pixel = 0;
+    /* Without data (such as when lazy decoding failed), write empty raw data. */
     auto renditionData = this->data();
-    switch (renditionData->format()) {
+    switch (renditionData ? renditionData->format() : Rendition::Data::Format::Data) {
         case Rendition::Data::Format::PremultipliedBGRA8:
             bytes_per_pixel = 4;
             header.pixel_format = car_rendition_value_pixel_format_argb;
@@ -598,7 +737,7 @@ write() const
     info_bytes_per_row.bytes_per_row = _width * bytes_per_pixel;
 
     // Write bitmap data
-    ext::optional<std::vector<uint8_t>> data = Encode(this, renditionData);
+    ext::optional<std::vector<uint8_t>> data = Encode(this, renditionData, compressionLevel, chunkSize);
     if (!data) {
         printf("Error: no bitmap data for %s\n", this->fileName().c_str());
         data = ext::optional<std::vector<uint8_t>>(std::vector<uint8_t>());
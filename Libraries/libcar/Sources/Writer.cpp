@@ -10,8 +10,13 @@
 #include <car/Writer.h>
 #include <car/car_format.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <random>
 #include <set>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -23,7 +28,11 @@ using car::Rendition;
 
 Writer::
 Writer(unique_ptr_bom bom) :
-    _bom(std::move(bom))
+    _bom             (std::move(bom)),
+    _compressionLevel(-1),
+    _chunkSize       (0),
+    _jobs            (0),
+    _memoryBudget    (0)
 {
 }
 
@@ -118,37 +127,98 @@ write() const
     int key_format_index = bom_index_add(_bom.get(), keyfmt, keyfmt_size);
     bom_variable_add(_bom.get(), car_key_format_variable, key_format_index);
 
-    /* Write facets. */
+    /* Write facets, sorted by name. */
+    std::vector<Facet const *> facets;
+    for (auto const &item : _facets) {
+        facets.push_back(&item.second);
+    }
+    std::sort(facets.begin(), facets.end(), [](Facet const *lhs, Facet const *rhs) {
+        return lhs->name() < rhs->name();
+    });
+
     struct bom_tree_context *facets_tree_context = bom_tree_alloc_empty(_bom.get(), car_facet_keys_variable);
     if (facets_tree_context != NULL) {
-        for (auto const &item : _facets) {
-            auto facet_value = item.second.write();
+        for (Facet const *facet : facets) {
+            auto facet_value = facet->write();
             bom_tree_add(
                 facets_tree_context,
-                reinterpret_cast<void const *>(item.first.c_str()),
-                item.first.size(),
+                reinterpret_cast<void const *>(facet->name().c_str()),
+                facet->name().size(),
                 reinterpret_cast<void const *>(facet_value.data()),
                 facet_value.size());
         }
         bom_tree_free(facets_tree_context);
     }
 
-    /* Write renditions. */
+    /* Encode renditions. Compression is slow, so spread it across threads. */
+    std::vector<Rendition const *> renditions;
+    for (auto const &item : _renditions) {
+        renditions.push_back(&item.second);
+    }
+
+    std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>> encoded = std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>>(renditions.size());
+    std::atomic<size_t> next = ATOMIC_VAR_INIT(0);
+    std::mutex budgetMutex;
+    std::condition_variable budgetCondition;
+    size_t budgetUsed = 0;
+    auto encode = [&]() {
+        for (size_t i = next++; i < renditions.size(); i = next++) {
+            /* Wait for enough budget for the decoded pixels, or for nothing else to be in progress. */
+            size_t cost = 0;
+            if (_memoryBudget != 0) {
+                cost = static_cast<size_t>(renditions[i]->width()) * renditions[i]->height() * Rendition::Data::FormatSize(Rendition::Data::Format::PremultipliedBGRA8);
+
+                std::unique_lock<std::mutex> lock(budgetMutex);
+                budgetCondition.wait(lock, [&] { return budgetUsed == 0 || budgetUsed + cost <= _memoryBudget; });
+                budgetUsed += cost;
+            }
+
+            encoded[i].first = renditions[i]->attributes().write(keyfmt->num_identifiers, keyfmt->identifier_list);
+            encoded[i].second = renditions[i]->write(_compressionLevel, _chunkSize);
+
+            if (_memoryBudget != 0) {
+                std::lock_guard<std::mutex> lock(budgetMutex);
+                budgetUsed -= cost;
+                budgetCondition.notify_all();
+            }
+        }
+    };
+
+    size_t jobs = (_jobs != 0 ? _jobs : std::max<size_t>(1, std::thread::hardware_concurrency()));
+    jobs = std::min(jobs, renditions.size());
+    if (jobs <= 1) {
+        encode();
+    } else {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < jobs; i++) {
+            threads.emplace_back(encode);
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    /* Write renditions in key order, so output is the same for any number of jobs. */
+    std::stable_sort(encoded.begin(), encoded.end(), [](std::pair<std::vector<uint8_t>, std::vector<uint8_t>> const &lhs, std::pair<std::vector<uint8_t>, std::vector<uint8_t>> const &rhs) {
+        return lhs.first < rhs.first;
+    });
+
     struct bom_tree_context *renditions_tree_context = bom_tree_alloc_empty(_bom.get(), car_renditions_variable);
     if (renditions_tree_context != NULL) {
-        for (auto const &item : _renditions) {
-            auto attributes_value = item.second.attributes().write(keyfmt->num_identifiers, keyfmt->identifier_list);
-            auto rendition_value = item.second.write();
+        for (auto const &item : encoded) {
             bom_tree_add(
                 renditions_tree_context,
-                reinterpret_cast<void const *>(attributes_value.data()),
-                attributes_value.size(),
-                reinterpret_cast<void const *>(rendition_value.data()),
-                rendition_value.size());
+                reinterpret_cast<void const *>(item.first.data()),
+                item.first.size(),
+                reinterpret_cast<void const *>(item.second.data()),
+                item.second.size());
         }
         bom_tree_free(renditions_tree_context);
     }
 
     free(keyfmt);
+
+    /* Lay out the BOM, if it was created to be built. */
+    bom_builder_finish(_bom.get());
 }
 
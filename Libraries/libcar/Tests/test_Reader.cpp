@@ -0,0 +1,165 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <bom/bom.h>
+#include <bom/bom_format.h>
+#include <car/car_format.h>
+#include <car/AttributeList.h>
+#include <car/Facet.h>
+#include <car/Rendition.h>
+#include <car/Writer.h>
+#include <car/Reader.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <unistd.h>
+
+static std::vector<uint8_t>
+TestPixels(int width, int height, uint8_t seed)
+{
+    std::vector<uint8_t> pixels;
+    for (int i = 0; i < width * height * 4; i++) {
+        pixels.push_back(static_cast<uint8_t>(seed + i));
+    }
+    return pixels;
+}
+
+static void
+WriteArchive(struct bom_context *bom, int facets)
+{
+    auto writer = car::Writer::Create(car::Writer::unique_ptr_bom(bom, bom_free));
+    ASSERT_NE(ext::nullopt, writer);
+
+    for (int i = 0; i < facets; i++) {
+        car::AttributeList attributes = car::AttributeList({
+            { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+            { car_attribute_identifier_identifier, static_cast<uint16_t>(i + 1) },
+        });
+        writer->addFacet(car::Facet::Create("facet" + std::to_string(i), attributes));
+
+        for (uint16_t scale = 1; scale <= 2; scale++) {
+            car::AttributeList rendition_attributes = car::AttributeList({
+                { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+                { car_attribute_identifier_scale, scale },
+                { car_attribute_identifier_identifier, static_cast<uint16_t>(i + 1) },
+            });
+
+            auto data = car::Rendition::Data(TestPixels(4, 4, i + scale), car::Rendition::Data::Format::PremultipliedBGRA8);
+            car::Rendition rendition = car::Rendition::Create(rendition_attributes, data);
+            rendition.width() = 4;
+            rendition.height() = 4;
+            rendition.scale() = scale;
+            rendition.fileName() = "facet" + std::to_string(i) + ".png";
+            rendition.layout() = car_rendition_value_layout_one_part_scale;
+            writer->addRendition(rendition);
+        }
+    }
+
+    writer->write();
+}
+
+TEST(Reader, OpenFile)
+{
+    char path[] = "/tmp/test_car_Reader.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+
+    int facets = 100;
+    struct bom_context *bom = bom_alloc_builder(bom_context_memory_file(path, true, 0));
+    ASSERT_NE(nullptr, bom);
+    WriteArchive(bom, facets);
+
+    ext::optional<car::Reader> reader = car::Reader::Open(path);
+    ASSERT_NE(ext::nullopt, reader);
+
+    int facet_count = 0;
+    reader->facetIterate([&facet_count](car::Facet const &facet) {
+        facet_count++;
+    });
+    EXPECT_EQ(facets, facet_count);
+
+    EXPECT_EQ(ext::nullopt, reader->lookupFacet("missing"));
+
+    for (int i = 0; i < facets; i++) {
+        ext::optional<car::Facet> facet = reader->lookupFacet("facet" + std::to_string(i));
+        ASSERT_NE(ext::nullopt, facet);
+        EXPECT_EQ(i + 1, *facet->attributes().get(car_attribute_identifier_identifier));
+
+        std::vector<car::Rendition> renditions = reader->lookupRenditions(*facet);
+        ASSERT_EQ(2, renditions.size());
+
+        for (car::Rendition const &rendition : renditions) {
+            uint16_t scale = *rendition.attributes().get(car_attribute_identifier_scale);
+
+            ext::optional<size_t> length = rendition.dataLength();
+            ASSERT_NE(ext::nullopt, length);
+            ASSERT_EQ(4 * 4 * 4, *length);
+
+            std::vector<uint8_t> buffer = std::vector<uint8_t>(*length);
+            ext::optional<car::Rendition::Data::Format> format = rendition.decode(buffer.data(), buffer.size());
+            ASSERT_NE(ext::nullopt, format);
+            EXPECT_EQ(car::Rendition::Data::Format::PremultipliedBGRA8, *format);
+            EXPECT_EQ(TestPixels(4, 4, i + scale), buffer);
+
+            /* Too small a buffer is not written to. */
+            EXPECT_EQ(ext::nullopt, rendition.decode(buffer.data(), buffer.size() - 1));
+        }
+    }
+
+    unlink(path);
+}
+
+TEST(Reader, UnsortedFacets)
+{
+    char path[] = "/tmp/test_car_Reader.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+
+    int facets = 5;
+    struct bom_context *bom = bom_alloc_builder(bom_context_memory_file(path, true, 0));
+    ASSERT_NE(nullptr, bom);
+    WriteArchive(bom, facets);
+
+    /*
+     * Older archives stored facets in hash table order. Reverse the facets
+     * in place so the facet tree is no longer sorted.
+     */
+    bom = bom_alloc_load(bom_context_memory_file(path, true, 0));
+    ASSERT_NE(nullptr, bom);
+
+    struct bom_tree *tree = (struct bom_tree *)bom_index_get(bom, bom_variable_get(bom, car_facet_keys_variable), NULL);
+    ASSERT_NE(nullptr, tree);
+    struct bom_tree_entry *leaf = (struct bom_tree_entry *)bom_index_get(bom, ntohl(tree->child), NULL);
+    ASSERT_NE(nullptr, leaf);
+    ASSERT_TRUE(leaf->is_leaf);
+    ASSERT_EQ(facets, ntohs(leaf->count));
+    std::reverse(&leaf->indexes[0], &leaf->indexes[facets]);
+
+    ext::optional<car::Reader> reader = car::Reader::Load(car::Reader::unique_ptr_bom(bom, bom_free));
+    ASSERT_NE(ext::nullopt, reader);
+
+    EXPECT_EQ(ext::nullopt, reader->lookupFacet("missing"));
+
+    for (int i = 0; i < facets; i++) {
+        ext::optional<car::Facet> facet = reader->lookupFacet("facet" + std::to_string(i));
+        ASSERT_NE(ext::nullopt, facet);
+        EXPECT_EQ(i + 1, *facet->attributes().get(car_attribute_identifier_identifier));
+        EXPECT_EQ(2, reader->lookupRenditions(*facet).size());
+    }
+
+    unlink(path);
+}
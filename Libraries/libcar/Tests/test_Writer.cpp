@@ -98,3 +98,68 @@ TEST(Writer, TestWriter)
     EXPECT_EQ(rendition_count, 1);
 }
 
+static std::vector<uint8_t>
+WriteRenditions(size_t jobs, size_t chunkSize)
+{
+    auto writer = car::Writer::Create(car::Writer::unique_ptr_bom(bom_alloc_builder(bom_context_memory(NULL, 0)), bom_free));
+    EXPECT_NE(writer, ext::nullopt);
+    writer->jobs() = jobs;
+    writer->chunkSize() = chunkSize;
+    writer->compressionLevel() = 9;
+
+    for (uint16_t identifier = 1; identifier <= 20; identifier++) {
+        car::AttributeList attributes = car::AttributeList({
+            { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+            { car_attribute_identifier_scale, 2 },
+            { car_attribute_identifier_identifier, identifier },
+        });
+        writer->addFacet(car::Facet::Create("testpattern" + std::to_string(identifier), attributes));
+
+        car::Rendition rendition = car::Rendition::Create(attributes, car::Rendition::Data(test_pixels, car::Rendition::Data::Format::PremultipliedBGRA8));
+        rendition.width() = 8;
+        rendition.height() = 8;
+        rendition.scale() = 2;
+        rendition.fileName() = "testpattern" + std::to_string(identifier) + ".png";
+        rendition.layout() = car_rendition_value_layout_one_part_scale;
+        writer->addRendition(rendition);
+    }
+
+    writer->write();
+
+    struct bom_context_memory const *memory = bom_memory(writer->bom());
+    return std::vector<uint8_t>(static_cast<uint8_t const *>(memory->data), static_cast<uint8_t const *>(memory->data) + memory->size);
+}
+
+static std::vector<uint8_t>
+WithoutHeader(std::vector<uint8_t> contents)
+{
+    /* The header has a creation time and a random UUID. */
+    auto bom = car::Writer::unique_ptr_bom(bom_alloc_load(bom_context_memory(contents.data(), contents.size())), bom_free);
+    size_t header_len = 0;
+    void *header = bom_index_get(bom.get(), bom_variable_get(bom.get(), car_header_variable), &header_len);
+    memset(header, 0, header_len);
+
+    struct bom_context_memory const *memory = bom_memory(bom.get());
+    return std::vector<uint8_t>(static_cast<uint8_t const *>(memory->data), static_cast<uint8_t const *>(memory->data) + memory->size);
+}
+
+TEST(Writer, ParallelMatchesSerial)
+{
+    EXPECT_EQ(WithoutHeader(WriteRenditions(1, 0)), WithoutHeader(WriteRenditions(4, 0)));
+    EXPECT_EQ(WithoutHeader(WriteRenditions(1, 64)), WithoutHeader(WriteRenditions(4, 64)));
+}
+
+TEST(Writer, Chunked)
+{
+    std::vector<uint8_t> contents = WriteRenditions(2, 60);
+    auto reader_bom = car::Reader::unique_ptr_bom(bom_alloc_load(bom_context_memory(contents.data(), contents.size())), bom_free);
+    ext::optional<car::Reader> reader = car::Reader::Load(std::move(reader_bom));
+    ASSERT_NE(reader, ext::nullopt);
+
+    int rendition_count = 0;
+    reader->renditionIterate([&rendition_count](car::Rendition const &rendition) {
+        rendition_count++;
+        EXPECT_EQ(test_pixels, rendition.data()->data());
+    });
+    EXPECT_EQ(20, rendition_count);
+}
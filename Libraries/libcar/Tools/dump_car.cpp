@@ -151,13 +151,15 @@ png_encode(uint32_t width, uint32_t height, int depth, std::vector<uint8_t> cons
 static void
 rendition_dump(car::Rendition const &rendition, std::string const &path)
 {
-    ext::optional<car::Rendition::Data> data = rendition.data();
-    if (data) {
-        uint32_t depth = car::Rendition::Data::FormatSize(data->format());
-        std::vector<uint8_t> buffer = data->data();
+    /* Decode directly into the buffer to be written. */
+    ext::optional<size_t> length = rendition.dataLength();
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(length ? *length : 0);
+    ext::optional<car::Rendition::Data::Format> format = (length ? rendition.decode(buffer.data(), buffer.size()) : ext::nullopt);
+    if (format) {
+        uint32_t depth = car::Rendition::Data::FormatSize(*format);
 
         /* Unpremultiply alpha. */
-        switch (data->format()) {
+        switch (*format) {
             case car::Rendition::Data::Format::PremultipliedBGRA8:
                 for (size_t j = 0; j < buffer.size(); j += depth) {
                     /* Swizzle byte order to match PNG expectation. */
@@ -227,14 +229,13 @@ main(int argc, char **argv)
         output = argv[2];
     }
 
-    struct bom_context_memory memory = bom_context_memory_file(argv[1], false, 0);
-    auto bom = std::unique_ptr<struct bom_context, decltype(&bom_free)>(bom_alloc_load(memory), bom_free);
-    if (bom == nullptr) {
-        fprintf(stderr, "error: unable to load BOM\n");
+    ext::optional<car::Reader> car = car::Reader::Open(argv[1]);
+    if (!car) {
+        fprintf(stderr, "error: unable to load car archive\n");
         return 1;
     }
 
-    bom_variable_iterate(bom.get(), [](struct bom_context *context, const char *name, int data_index, void *ctx) {
+    bom_variable_iterate(car->bom(), [](struct bom_context *context, const char *name, int data_index, void *ctx) {
         size_t data_len;
         void *data = bom_index_get(context, data_index, &data_len);
         (void)data;
@@ -244,12 +245,6 @@ main(int argc, char **argv)
     }, NULL);
     printf("\n");
 
-    ext::optional<car::Reader> car = car::Reader::Load(std::move(bom));
-    if (!car) {
-        fprintf(stderr, "error: unable to load car archive\n");
-        return 1;
-    }
-
     car->dump();
     printf("\n");
 
@@ -34,11 +34,15 @@ public:
 public:
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual std::unique_ptr<FileView> map(std::string const &path) const;
+    virtual bool readPrefix(std::vector<uint8_t> *contents, std::string const &path, size_t length) const;
+    virtual bool fileStatus(std::string const &path, uint64_t *modified, uint64_t *size) const;
     virtual ext::optional<std::string> readSymbolicLink(std::string const &path) const;
     virtual bool writeSymbolicLink(std::string const &target, std::string const &path);
 
 public:
     virtual bool removeFile(std::string const &path);
+    virtual bool removeDirectory(std::string const &path, bool recursive);
 
 public:
     virtual std::string resolvePath(std::string const &path) const;
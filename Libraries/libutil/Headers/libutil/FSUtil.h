@@ -55,6 +55,15 @@ public:
     static bool EnumerateRecursive(std::string const &path,
             std::function <bool(std::string const &)> const &cb);
 
+    /*
+     * Enumerates the directories below a path, parents before children. The
+     * callback returns if a directory should be descended into. Uses the type
+     * from each directory entry, so only symbolic links need a `stat()`; links
+     * are descended into only if `followSymlinks` is set, and at most once.
+     */
+    static bool EnumerateDirectoriesRecursive(std::string const &path, bool followSymlinks,
+            std::function <bool(std::string const &)> const &cb);
+
 public:
     static std::string GetCurrentDirectory();
 
@@ -0,0 +1,69 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_FileView_h
+#define __libutil_FileView_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace libutil {
+
+/*
+ * A read-only view of the contents of a file. The contents are either mapped
+ * into memory, or held in a buffer for small files and filesystems that can't
+ * map files. Either way, the contents are valid for the lifetime of the view.
+ */
+class FileView {
+private:
+    void                 *_mapping;
+    size_t                _mappingSize;
+    std::vector<uint8_t>  _buffer;
+
+public:
+    /*
+     * A view of contents read into a buffer.
+     */
+    explicit FileView(std::vector<uint8_t> &&buffer);
+
+    /*
+     * A view of a mapping from `mmap()`. The view unmaps it when destroyed.
+     */
+    FileView(void *mapping, size_t size);
+
+    ~FileView();
+
+public:
+    FileView(FileView const &) = delete;
+    FileView &operator=(FileView const &) = delete;
+
+public:
+    /*
+     * The contents of the file.
+     */
+    uint8_t const *data() const
+    { return (_mapping != nullptr ? static_cast<uint8_t const *>(_mapping) : _buffer.data()); }
+
+    /*
+     * The size of the file, in bytes.
+     */
+    size_t size() const
+    { return (_mapping != nullptr ? _mappingSize : _buffer.size()); }
+
+    /*
+     * If the contents are mapped rather than copied.
+     */
+    bool mapped() const
+    { return _mapping != nullptr; }
+};
+
+}
+
+#endif  // !__libutil_FileView_h
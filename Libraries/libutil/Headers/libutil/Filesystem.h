@@ -10,7 +10,10 @@
 #ifndef __libutil_Filesystem_h
 #define __libutil_Filesystem_h
 
+#include <libutil/FileView.h>
+
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <ext/optional>
@@ -73,6 +76,24 @@ public:
      */
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path) = 0;
 
+    /*
+     * Read from a file into a read-only view. Avoids copying the contents where
+     * the filesystem supports it; by default, the contents are read normally.
+     */
+    virtual std::unique_ptr<FileView> map(std::string const &path) const;
+
+    /*
+     * Read up to `length` bytes from the start of a file. By default, the
+     * whole file is read and then truncated.
+     */
+    virtual bool readPrefix(std::vector<uint8_t> *contents, std::string const &path, size_t length) const;
+
+    /*
+     * The modification time, in nanoseconds since the epoch, and the size of
+     * a file. Fails by default, for filesystems that don't track changes.
+     */
+    virtual bool fileStatus(std::string const &path, uint64_t *modified, uint64_t *size) const;
+
     /*
      * Read the destination of the symbolic link, relative to its containing directory.
      */
@@ -89,6 +110,12 @@ public:
      */
     virtual bool removeFile(std::string const &path) = 0;
 
+    /*
+     * Delete a directory. If recursive, its contents are deleted first;
+     * otherwise, it must already be empty.
+     */
+    virtual bool removeDirectory(std::string const &path, bool recursive) = 0;
+
 public:
     /*
      * Resolves and normalizes a path through symbolic links.
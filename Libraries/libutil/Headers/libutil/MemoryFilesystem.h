@@ -30,6 +30,7 @@ public:
         Type                 _type;
         std::vector<uint8_t> _contents;
         std::vector<Entry>   _children;
+        uint64_t             _modified;
 
     private:
         Entry(std::string const &name, Type type);
@@ -52,6 +53,16 @@ public:
         std::vector<Entry> const &children() const
         { return _children; }
 
+    public:
+        /*
+         * When the entry was last written, counted in writes to the
+         * filesystem. Entries it was created with were written at zero.
+         */
+        uint64_t &modified()
+        { return _modified; }
+        uint64_t modified() const
+        { return _modified; }
+
     public:
         MemoryFilesystem::Entry *child(std::string const &name);
         MemoryFilesystem::Entry const *child(std::string const &name) const;
@@ -62,7 +73,8 @@ public:
     };
 
 private:
-    Entry _root;
+    Entry    _root;
+    uint64_t _writes;
 
 public:
     MemoryFilesystem(std::vector<Entry> const &entries);
@@ -92,11 +104,13 @@ public:
 public:
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool fileStatus(std::string const &path, uint64_t *modified, uint64_t *size) const;
     virtual ext::optional<std::string> readSymbolicLink(std::string const &path) const;
     virtual bool writeSymbolicLink(std::string const &target, std::string const &path);
 
 public:
     virtual bool removeFile(std::string const &path);
+    virtual bool removeDirectory(std::string const &path, bool recursive);
 
 public:
     virtual std::string resolvePath(std::string const &path) const;
@@ -10,23 +10,133 @@
 #ifndef __libutil_Subprocess_h
 #define __libutil_Subprocess_h
 
+#include <ext/optional>
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
 #include <string>
 #include <vector>
 #include <unordered_map>
 
+#include <sys/types.h>
+
 namespace libutil {
 
+/*
+ * Runs an external process. A process can be run synchronously with
+ * `execute()`, or launched with `launch()` and then waited for, alone or
+ * together with other processes. While waiting, standard input is written
+ * and standard output and error are read together, so a process that fills
+ * either pipe cannot block.
+ */
 class Subprocess {
+public:
+    /*
+     * Resources used by an exited process. Times are in seconds; the
+     * maximum resident set size is in bytes.
+     */
+    struct Usage {
+        double   wall;
+        double   user;
+        double   system;
+        uint64_t maximumResidentSize;
+    };
+
+private:
+    int                                   _exitcode;
+    ext::optional<Usage>                  _usage;
+
 private:
-    int _exitcode;
+    pid_t                                 _pid;
+    int                                   _pidfd;
+    bool                                  _launched;
+    bool                                  _reported;
+    std::chrono::steady_clock::time_point _start;
+
+private:
+    int                                   _inputfd;
+    std::istream                         *_input;
+    std::vector<char>                     _inputBuffer;
+    size_t                                _inputOffset;
+
+private:
+    int                                   _outputfd;
+    std::string                           _output;
+    int                                   _errorfd;
+    std::string                           _error;
 
 public:
     Subprocess();
 
+    /*
+     * Waits for the process if it is still running, discarding its output.
+     */
+    ~Subprocess();
+
+public:
+    Subprocess(Subprocess const &) = delete;
+    Subprocess &operator=(Subprocess const &) = delete;
+
 public:
     inline int exitcode() const
     { return _exitcode; }
 
+    /*
+     * Resources used by the process, once it has exited.
+     */
+    inline ext::optional<Usage> const &usage() const
+    { return _usage; }
+
+public:
+    /*
+     * Output captured from the process. Grows while the process is waited
+     * for; complete once it has exited.
+     */
+    inline std::string const &output() const
+    { return _output; }
+    inline std::string const &error() const
+    { return _error; }
+
+public:
+    /*
+     * If the process has been launched and has not yet exited.
+     */
+    inline bool running() const
+    { return _pid > 0; }
+
+public:
+    /*
+     * Starts the process without waiting for it. If `input` is set, it is
+     * streamed to the process's standard input while waiting, and must stay
+     * valid until the process exits; otherwise, standard input is inherited.
+     * Standard output and error are captured into `output()` and `error()`
+     * if requested, and inherited otherwise.
+     */
+    bool launch(std::string const &path,
+                std::vector<std::string> const &arguments,
+                std::unordered_map<std::string, std::string> const &environment,
+                std::string const &directory,
+                std::istream *input = nullptr,
+                bool captureOutput = false,
+                bool captureError = false);
+
+    /*
+     * Waits for the launched process to exit. Returns false if it was not
+     * launched.
+     */
+    bool wait();
+
+public:
+    /*
+     * Waits for any of the launched processes to exit, and returns it. Each
+     * exited process is returned once. Returns null if none are left to
+     * exit, or if `timeout` milliseconds pass first; a negative timeout
+     * waits indefinitely.
+     */
+    static Subprocess *
+    WaitAny(std::vector<Subprocess *> const &processes, int timeout = -1);
+
 public:
     bool execute(std::string const &path,
                  std::istream *input = nullptr,
@@ -66,6 +176,16 @@ public:
                  std::istream *input = nullptr,
                  std::ostream *output = nullptr,
                  std::ostream *error = nullptr);
+
+private:
+    void handleInput();
+    void handleOutput(int *fd, std::string *buffer);
+    bool reap(bool block);
+    void close();
+
+private:
+    static void
+    Poll(std::vector<Subprocess *> const &processes, int timeout);
 };
 
 }
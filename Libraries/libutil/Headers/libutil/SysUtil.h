@@ -12,6 +12,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <ext/optional>
 
 namespace libutil {
 
@@ -29,6 +30,14 @@ public:
     static int32_t GetUserID();
     static int32_t GetGroupID();
 
+public:
+    /*
+     * The directory for caches kept between runs: `XCBUILD_CACHE_DIR`,
+     * or a directory in `XDG_CACHE_HOME` or `HOME`. Caching is disabled,
+     * returning nothing, if `XCBUILD_CACHE_DIR` is set but empty.
+     */
+    static ext::optional<std::string> GetCacheDirectory();
+
 public:
     static void Sleep(uint64_t us, bool interruptible = false);
 };
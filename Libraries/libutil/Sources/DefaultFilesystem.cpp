@@ -10,9 +10,7 @@
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/FSUtil.h>
 
-#include <fstream>
-#include <iterator>
-
+#include <atomic>
 #include <climits>
 #include <cstdlib>
 #include <cstdio>
@@ -22,6 +20,8 @@
 #include <unistd.h>
 #include <libgen.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 using libutil::DefaultFilesystem;
@@ -114,29 +114,215 @@ createDirectory(std::string const &path)
     return true;
 }
 
+/*
+ * Files at least this large are mapped rather than read into a buffer.
+ */
+static size_t const MapThreshold = 64 * 1024;
+
+static bool
+ReadAll(int fd, std::vector<uint8_t> *contents, size_t sizeHint)
+{
+    contents->clear();
+    contents->resize(sizeHint > 0 ? sizeHint : 4096);
+
+    /*
+     * Read until the end of the file, even past the size from `fstat()`:
+     * the file might have grown, or be a pipe or other special file.
+     */
+    size_t offset = 0;
+    for (;;) {
+        if (offset == contents->size()) {
+            contents->resize(contents->size() * 2);
+        }
+
+        ssize_t count = ::read(fd, contents->data() + offset, contents->size() - offset);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        } else if (count == 0) {
+            break;
+        }
+
+        offset += count;
+    }
+
+    contents->resize(offset);
+    return true;
+}
+
+static bool
+WriteAll(int fd, std::vector<uint8_t> const &contents)
+{
+    size_t offset = 0;
+    while (offset < contents.size()) {
+        ssize_t count = ::write(fd, contents.data() + offset, contents.size() - offset);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        offset += count;
+    }
+
+    return true;
+}
+
 bool DefaultFilesystem::
 read(std::vector<uint8_t> *contents, std::string const &path) const
 {
-    std::ifstream input;
-    input.open(path, std::ios::binary);
-    if (input.fail()) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    size_t size = 0;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        /* One extra byte so reaching the end doesn't need to grow the buffer. */
+        size = static_cast<size_t>(st.st_size) + 1;
+    }
+
+    bool result = ReadAll(fd, contents, size);
+    ::close(fd);
+    return result;
+}
+
+std::unique_ptr<libutil::FileView> DefaultFilesystem::
+map(std::string const &path) const
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    bool regular = (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode));
+    if (regular && static_cast<size_t>(st.st_size) >= MapThreshold) {
+        size_t size = static_cast<size_t>(st.st_size);
+        void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            ::close(fd);
+            return std::unique_ptr<FileView>(new FileView(mapping, size));
+        }
+    }
+
+    /* Small or special file, or couldn't map: read it instead. */
+    std::vector<uint8_t> contents;
+    size_t size = (regular ? static_cast<size_t>(st.st_size) + 1 : 0);
+    bool result = ReadAll(fd, &contents, size);
+    ::close(fd);
+
+    if (!result) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<FileView>(new FileView(std::move(contents)));
+}
+
+bool DefaultFilesystem::
+readPrefix(std::vector<uint8_t> *contents, std::string const &path, size_t length) const
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
         return false;
     }
 
-    *contents = std::vector<uint8_t>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    contents->resize(length);
+
+    size_t offset = 0;
+    while (offset < length) {
+        ssize_t count = ::read(fd, contents->data() + offset, length - offset);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            return false;
+        } else if (count == 0) {
+            break;
+        }
+
+        offset += count;
+    }
+
+    ::close(fd);
+    contents->resize(offset);
     return true;
 }
 
+bool DefaultFilesystem::
+fileStatus(std::string const &path, uint64_t *modified, uint64_t *size) const
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+
+#if defined(__APPLE__)
+    struct timespec const &mtime = st.st_mtimespec;
+#else
+    struct timespec const &mtime = st.st_mtim;
+#endif
+
+    *modified = static_cast<uint64_t>(mtime.tv_sec) * 1000000000ull + static_cast<uint64_t>(mtime.tv_nsec);
+    *size = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+static bool
+WriteDirect(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool result = WriteAll(fd, contents);
+    return (::close(fd) == 0 && result);
+}
+
 bool DefaultFilesystem::
 write(std::vector<uint8_t> const &contents, std::string const &path)
 {
-    std::ofstream output;
-    output.open(path, std::ios::binary);
-    if (output.fail()) {
+    /*
+     * Replace symbolic links' targets and special files in place; renaming
+     * over them would replace the link or file itself.
+     */
+    struct stat st;
+    bool exists = (::lstat(path.c_str(), &st) == 0);
+    if (exists && !S_ISREG(st.st_mode)) {
+        return WriteDirect(contents, path);
+    }
+
+    /*
+     * Write into a temporary file next to the destination, then rename it
+     * into place, so readers never see a partially written file.
+     */
+    static std::atomic<unsigned long> counter(0);
+    std::string temporary = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        /* For example, the directory isn't writable but the file is. */
+        return WriteDirect(contents, path);
+    }
+
+    bool result = WriteAll(fd, contents);
+    if (result && exists) {
+        /* Keep the permissions of the file being replaced. */
+        result = (::fchmod(fd, st.st_mode & 07777) == 0);
+    }
+    result = (::close(fd) == 0 && result);
+
+    if (!result || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
         return false;
     }
 
-    std::copy(contents.begin(), contents.end(), std::ostream_iterator<char>(output));
     return true;
 }
 
@@ -174,6 +360,38 @@ removeFile(std::string const &path)
     return true;
 }
 
+bool DefaultFilesystem::
+removeDirectory(std::string const &path, bool recursive)
+{
+    if (recursive) {
+        /* Removing entries while reading the directory can skip some. */
+        std::vector<std::string> names;
+        bool enumerated = enumerateDirectory(path, [&](std::string const &name) {
+            names.push_back(name);
+        });
+        if (!enumerated) {
+            return false;
+        }
+
+        for (std::string const &name : names) {
+            std::string full = path + "/" + name;
+
+            /* Links are removed, not followed. */
+            if (isDirectory(full) && !isSymbolicLink(full)) {
+                if (!removeDirectory(full, true)) {
+                    return false;
+                }
+            } else {
+                if (!removeFile(full)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return (::rmdir(path.c_str()) == 0);
+}
+
 std::string DefaultFilesystem::
 resolvePath(std::string const &path) const
 {
@@ -14,14 +14,10 @@ using libutil::Escape;
 std::string Escape::
 Shell(std::string const &value)
 {
-    static std::string const *escaped = nullptr;
-    if (escaped == nullptr) {
-        std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-        std::string digits = "0123456789";
-        escaped = new std::string(alphabet + digits + "@%_-+=:,./");
-    }
+    /* Initialized once, even when called from multiple threads. */
+    static std::string const escaped = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ" "0123456789" "@%_-+=:,./";
 
-    if (value.find_first_not_of(*escaped) == std::string::npos) {
+    if (value.find_first_not_of(escaped) == std::string::npos) {
         return value;
     } else {
         std::string result;
@@ -9,6 +9,7 @@
 
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
 #include <climits>
 #include <cstdlib>
 #include <cstdio>
@@ -21,6 +22,7 @@
 #include <unistd.h>
 #include <libgen.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 
 using libutil::FSUtil;
@@ -276,6 +278,100 @@ EnumerateRecursive(std::string const &path, std::function <bool(std::string cons
     return true;
 }
 
+static void
+EnumerateDirectoriesRecursive(
+    std::string const &path,
+    bool followSymlinks,
+    std::vector<std::pair<dev_t, ino_t>> *ancestors,
+    std::vector<std::pair<dev_t, ino_t>> *followed,
+    std::function <bool(std::string const &)> const &cb)
+{
+    DIR *dp = opendir(path.c_str());
+    if (dp == NULL) {
+        return;
+    }
+
+    /*
+     * Report all of the directories at this level before descending, like
+     * `EnumerateRecursive()`. Identities are only needed to avoid following
+     * a symlink into a loop, so are only looked up when following symlinks.
+     */
+    std::vector<std::pair<std::string, std::pair<dev_t, ino_t>>> children;
+
+    while (struct dirent *entry = readdir(dp)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        std::string full = path + "/" + entry->d_name;
+        std::pair<dev_t, ino_t> identity = std::make_pair(0, 0);
+        bool symlink = false;
+
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN || (type == DT_DIR && followSymlinks)) {
+            /* A directory's own device, as it may be a mount point. */
+            struct stat st;
+            if (::fstatat(dirfd(dp), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+                continue;
+            }
+            type = (S_ISDIR(st.st_mode) ? DT_DIR : S_ISLNK(st.st_mode) ? DT_LNK : DT_REG);
+            identity = std::make_pair(st.st_dev, st.st_ino);
+        }
+
+        if (type == DT_LNK) {
+            struct stat st;
+            if (::stat(full.c_str(), &st) < 0 || !S_ISDIR(st.st_mode)) {
+                continue;
+            }
+            identity = std::make_pair(st.st_dev, st.st_ino);
+            symlink = true;
+        } else if (type != DT_DIR) {
+            continue;
+        }
+
+        if (!cb(full)) {
+            continue;
+        }
+
+        if (symlink) {
+            if (!followSymlinks) {
+                continue;
+            }
+
+            /* Skip links back into the tree being walked, and links already followed. */
+            if (std::find(ancestors->begin(), ancestors->end(), identity) != ancestors->end() ||
+                std::find(followed->begin(), followed->end(), identity) != followed->end()) {
+                continue;
+            }
+            followed->push_back(identity);
+        }
+
+        children.push_back(std::make_pair(full, identity));
+    }
+
+    closedir(dp);
+
+    for (auto const &child : children) {
+        ancestors->push_back(child.second);
+        EnumerateDirectoriesRecursive(child.first, followSymlinks, ancestors, followed, cb);
+        ancestors->pop_back();
+    }
+}
+
+bool FSUtil::
+EnumerateDirectoriesRecursive(std::string const &path, bool followSymlinks, std::function <bool(std::string const &)> const &cb)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) < 0 || !S_ISDIR(st.st_mode)) {
+        return false;
+    }
+
+    std::vector<std::pair<dev_t, ino_t>> ancestors = { std::make_pair(st.st_dev, st.st_ino) };
+    std::vector<std::pair<dev_t, ino_t>> followed;
+    ::EnumerateDirectoriesRecursive(path, followSymlinks, &ancestors, &followed, cb);
+    return true;
+}
+
 std::vector<std::string> FSUtil::
 GetExecutablePaths()
 {
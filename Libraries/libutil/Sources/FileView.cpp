@@ -0,0 +1,37 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/FileView.h>
+
+#include <sys/mman.h>
+
+using libutil::FileView;
+
+FileView::
+FileView(std::vector<uint8_t> &&buffer) :
+    _mapping    (nullptr),
+    _mappingSize(0),
+    _buffer     (std::move(buffer))
+{
+}
+
+FileView::
+FileView(void *mapping, size_t size) :
+    _mapping    (mapping),
+    _mappingSize(size)
+{
+}
+
+FileView::
+~FileView()
+{
+    if (_mapping != nullptr) {
+        ::munmap(_mapping, _mappingSize);
+    }
+}
@@ -36,6 +36,36 @@ enumerateRecursive(
     return true;
 }
 
+std::unique_ptr<libutil::FileView> Filesystem::
+map(std::string const &path) const
+{
+    std::vector<uint8_t> contents;
+    if (!this->read(&contents, path)) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<FileView>(new FileView(std::move(contents)));
+}
+
+bool Filesystem::
+readPrefix(std::vector<uint8_t> *contents, std::string const &path, size_t length) const
+{
+    if (!this->read(contents, path)) {
+        return false;
+    }
+
+    if (contents->size() > length) {
+        contents->resize(length);
+    }
+    return true;
+}
+
+bool Filesystem::
+fileStatus(std::string const &path, uint64_t *modified, uint64_t *size) const
+{
+    return false;
+}
+
 ext::optional<std::string> Filesystem::
 findFile(std::string const &name, std::vector<std::string> const &paths) const
 {
@@ -19,8 +19,9 @@ using libutil::FSUtil;
 
 MemoryFilesystem::Entry::
 Entry(std::string const &name, Type type) :
-    _name(name),
-    _type(type)
+    _name    (name),
+    _type    (type),
+    _modified(0)
 {
 }
 
@@ -70,7 +71,8 @@ Directory(std::string const &name, std::vector<Entry> const &children)
 
 MemoryFilesystem::
 MemoryFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
-    _root(MemoryFilesystem::Entry::Directory("/", entries))
+    _root  (MemoryFilesystem::Entry::Directory("/", entries)),
+    _writes(0)
 {
 }
 
@@ -174,7 +176,7 @@ isExecutable(std::string const &path) const
 bool MemoryFilesystem::
 createFile(std::string const &path)
 {
-    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [&](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == MemoryFilesystem::Entry::Type::File) {
                 /* Exists as a file. */
@@ -186,6 +188,7 @@ createFile(std::string const &path)
         } else {
             /* Add empty file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, std::vector<uint8_t>());
+            file.modified() = ++_writes;
             std::vector<MemoryFilesystem::Entry> *children = &parent->children();
             children->emplace_back(std::move(file));
             return &children->back();
@@ -236,6 +239,7 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
             if (entry->type() == MemoryFilesystem::Entry::Type::File) {
                 /* Exists as a file, replace contents. */
                 entry->contents() = contents;
+                entry->modified() = ++_writes;
                 return entry;
             } else {
                 /* Exists already, but not as a file. */
@@ -244,6 +248,7 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
         } else {
             /* Add file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, contents);
+            file.modified() = ++_writes;
             std::vector<MemoryFilesystem::Entry> *children = &parent->children();
             children->emplace_back(std::move(file));
             return &children->back();
@@ -251,6 +256,20 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
     });
 }
 
+bool MemoryFilesystem::
+fileStatus(std::string const &path, uint64_t *modified, uint64_t *size) const
+{
+    return WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) -> MemoryFilesystem::Entry const * {
+        if (entry == nullptr) {
+            return nullptr;
+        }
+
+        *modified = entry->modified();
+        *size = entry->contents().size();
+        return entry;
+    });
+}
+
 ext::optional<std::string> MemoryFilesystem::
 readSymbolicLink(std::string const &path) const
 {
@@ -286,6 +305,29 @@ removeFile(std::string const &path)
     });
 }
 
+bool MemoryFilesystem::
+removeDirectory(std::string const &path, bool recursive)
+{
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [&](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+        if (entry != nullptr) {
+            if (entry->type() == MemoryFilesystem::Entry::Type::Directory && (recursive || entry->children().empty()) && entry != parent) {
+                /* Found, remove it along with its contents. */
+                std::vector<MemoryFilesystem::Entry> *children = &parent->children();
+                children->erase(std::remove_if(children->begin(), children->end(), [&](MemoryFilesystem::Entry const &entry) {
+                    return (entry.name() == name);
+                }), children->end());
+                return parent;
+            } else {
+                /* Not a directory, not empty, or the root. */
+                return nullptr;
+            }
+        } else {
+            /* Did not exist. */
+            return nullptr;
+        }
+    });
+}
+
 std::string MemoryFilesystem::
 resolvePath(std::string const &path) const
 {
@@ -10,29 +10,205 @@
 #include <libutil/Subprocess.h>
 #include <libutil/FSUtil.h>
 
-#include <sstream>
+#include <cerrno>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define SUBPROCESS_HAVE_SPAWN_CHDIR 1
+#endif
+
 using libutil::Subprocess;
 
+/*
+ * Size of each read from the output pipes, and of each chunk of input.
+ */
+static size_t const kBufferSize = 16384;
+
+/*
+ * How often to check if a process has exited, when it has no open pipes
+ * and the platform has no way to wait for it alongside other processes.
+ */
+static int const kReapInterval = 10;
+
 Subprocess::Subprocess() :
-    _exitcode(0)
+    _exitcode   (0),
+    _pid        (-1),
+    _pidfd      (-1),
+    _launched   (false),
+    _reported   (false),
+    _inputfd    (-1),
+    _input      (nullptr),
+    _inputOffset(0),
+    _outputfd   (-1),
+    _errorfd    (-1)
 {
 }
 
+Subprocess::~Subprocess()
+{
+    if (running()) {
+        /* Don't leave a zombie behind; output is no longer wanted. */
+        close();
+        reap(true);
+    }
+}
+
+static bool
+CreatePipe(int fds[2])
+{
+#if defined(__linux__)
+    return (::pipe2(fds, O_CLOEXEC) == 0);
+#else
+    /* Not atomic: a process forked meanwhile may inherit these. */
+    if (::pipe(fds) != 0) {
+        return false;
+    }
+
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+static void
+ClosePipe(int fds[2])
+{
+    if (fds[0] != -1) {
+        ::close(fds[0]);
+    }
+    if (fds[1] != -1) {
+        ::close(fds[1]);
+    }
+}
+
+static void
+SetNonBlocking(int fd)
+{
+    int flags = ::fcntl(fd, F_GETFL);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/*
+ * Writes to a pipe, returning EPIPE rather than raising SIGPIPE if the
+ * process has closed its end.
+ */
+static ssize_t
+WriteInput(int fd, char const *data, size_t size)
+{
+    sigset_t pipe;
+    sigemptyset(&pipe);
+    sigaddset(&pipe, SIGPIPE);
+
+    sigset_t previous;
+    ::pthread_sigmask(SIG_BLOCK, &pipe, &previous);
+
+    ssize_t result = ::write(fd, data, size);
+    int error = errno;
+
+    if (result < 0 && error == EPIPE && !sigismember(&previous, SIGPIPE)) {
+        /* Discard the signal raised by the write before unblocking it. */
+        sigset_t pending;
+        if (::sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE)) {
+            int received;
+            ::sigwait(&pipe, &received);
+        }
+    }
+
+    ::pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    errno = error;
+    return result;
+}
+
+/*
+ * Starts the process with its standard streams replaced by the given
+ * descriptors, or inherited where they are -1.
+ */
+static pid_t
+Spawn(
+    char const *path,
+    char *const *arguments,
+    char *const *environment,
+    char const *directory,
+    int input,
+    int output,
+    int error)
+{
+#if !defined(SUBPROCESS_HAVE_SPAWN_CHDIR)
+    if (directory != nullptr) {
+        /* No way to change directory with posix_spawn, so fork instead. */
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            if ((input != -1 && ::dup2(input, 0) == -1) ||
+                (output != -1 && ::dup2(output, 1) == -1) ||
+                (error != -1 && ::dup2(error, 2) == -1)) {
+                ::_exit(-1);
+            }
+
+            if (::chdir(directory) == -1) {
+                ::perror("chdir");
+                ::_exit(1);
+            }
+
+            ::execve(path, arguments, environment);
+            ::_exit(-1);
+        }
+
+        return pid;
+    }
+#endif
+
+    posix_spawn_file_actions_t actions;
+    if (::posix_spawn_file_actions_init(&actions) != 0) {
+        return -1;
+    }
+
+    /* The pipes are close-on-exec; duplicating them clears that. */
+    if (input != -1) {
+        ::posix_spawn_file_actions_adddup2(&actions, input, 0);
+    }
+    if (output != -1) {
+        ::posix_spawn_file_actions_adddup2(&actions, output, 1);
+    }
+    if (error != -1) {
+        ::posix_spawn_file_actions_adddup2(&actions, error, 2);
+    }
+
+#if defined(SUBPROCESS_HAVE_SPAWN_CHDIR)
+    if (directory != nullptr) {
+        ::posix_spawn_file_actions_addchdir_np(&actions, directory);
+    }
+#endif
+
+    pid_t pid;
+    int rc = ::posix_spawn(&pid, path, &actions, nullptr, arguments, environment);
+    ::posix_spawn_file_actions_destroy(&actions);
+
+    return (rc == 0 ? pid : -1);
+}
+
 bool Subprocess::
-execute(
+launch(
     std::string const &path,
     std::vector<std::string> const &arguments,
     std::unordered_map<std::string, std::string> const &environment,
     std::string const &directory,
     std::istream *input,
-    std::ostream *output,
-    std::ostream *error)
+    bool captureOutput,
+    bool captureError)
 {
-    if (!FSUtil::TestForExecute(path)) {
+    if (running() || !FSUtil::TestForExecute(path)) {
         return false;
     }
 
@@ -56,100 +232,351 @@ execute(
 
     char const *work_dir = (!directory.empty() ? directory.c_str() : nullptr);
 
-    pid_t pid;
-    int  ofds[2];
-    int  efds[2];
+    int ifds[2] = { -1, -1 };
+    int ofds[2] = { -1, -1 };
+    int efds[2] = { -1, -1 };
 
-    if (::pipe(ofds) != 0) {
+    if ((input != nullptr && !CreatePipe(ifds)) ||
+        (captureOutput && !CreatePipe(ofds)) ||
+        (captureError && !CreatePipe(efds))) {
+        ClosePipe(ifds);
+        ClosePipe(ofds);
+        ClosePipe(efds);
         return false;
     }
 
-    if (::pipe(efds) != 0) {
-        ::close(ofds[1]);
-        ::close(ofds[0]);
-        return false;
+    _start = std::chrono::steady_clock::now();
+    _pid = Spawn(path.c_str(), (char *const *)exec_args.data(), (char *const *)exec_env.data(), work_dir, ifds[0], ofds[1], efds[1]);
+
+    /* The child's ends are no longer needed here. */
+    for (int *fd : { &ifds[0], &ofds[1], &efds[1] }) {
+        if (*fd != -1) {
+            ::close(*fd);
+            *fd = -1;
+        }
     }
 
-    pid = fork();
-    if (pid < 0) {
-        ::close(ofds[1]);
-        ::close(ofds[0]);
-        ::close(efds[1]);
-        ::close(efds[0]);
+    if (_pid <= 0) {
+        _pid = -1;
+        ClosePipe(ifds);
+        ClosePipe(ofds);
+        ClosePipe(efds);
         return false;
     }
 
-    if (pid == 0) {
-        ::close(ofds[0]);
-        ::close(efds[0]);
+    _exitcode = 0;
+    _usage = ext::nullopt;
+    _launched = true;
+    _reported = false;
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    /* Lets the exit be waited for alongside other processes' pipes. */
+    _pidfd = static_cast<int>(::syscall(SYS_pidfd_open, _pid, 0));
+#endif
+
+    _inputfd = ifds[1];
+    _input = input;
+    _inputBuffer.clear();
+    _inputOffset = 0;
+    if (_inputfd != -1) {
+        SetNonBlocking(_inputfd);
+    }
+
+    _outputfd = ofds[0];
+    _output.clear();
+    if (_outputfd != -1) {
+        SetNonBlocking(_outputfd);
+    }
+
+    _errorfd = efds[0];
+    _error.clear();
+    if (_errorfd != -1) {
+        SetNonBlocking(_errorfd);
+    }
+
+    return true;
+}
 
-        if (output != nullptr) {
-            ::close(1);
-            ::dup2(ofds[1], 1);
+void Subprocess::
+handleInput()
+{
+    for (;;) {
+        if (_inputOffset == _inputBuffer.size()) {
+            _inputBuffer.resize(kBufferSize);
+            _input->read(_inputBuffer.data(), _inputBuffer.size());
+            _inputBuffer.resize(static_cast<size_t>(_input->gcount()));
+            _inputOffset = 0;
+
+            if (_inputBuffer.empty()) {
+                /* End of input: let the process see end of file. */
+                ::close(_inputfd);
+                _inputfd = -1;
+                return;
+            }
         }
-        if (error != nullptr) {
-            ::close(2);
-            ::dup2(efds[1], 2);
+
+        ssize_t written = WriteInput(_inputfd, _inputBuffer.data() + _inputOffset, _inputBuffer.size() - _inputOffset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                /* The process stopped reading; drop the rest. */
+                ::close(_inputfd);
+                _inputfd = -1;
+            }
+            return;
         }
 
-        if (input != nullptr) {
-            // TODO!
+        _inputOffset += static_cast<size_t>(written);
+    }
+}
+
+void Subprocess::
+handleOutput(int *fd, std::string *buffer)
+{
+    for (;;) {
+        char    buf[kBufferSize];
+        ssize_t nread;
+
+        nread = ::read(*fd, buf, sizeof(buf));
+        if (nread < 0 && errno == EINTR) {
+            continue;
+        } else if (nread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else if (nread <= 0) {
+            ::close(*fd);
+            *fd = -1;
+            return;
         }
 
-        if (work_dir != nullptr) {
-            int rc = ::chdir(work_dir);
-            if (rc == -1) {
-                ::perror("chdir");
-                ::_exit(1);
+        buffer->append(buf, static_cast<size_t>(nread));
+    }
+}
+
+bool Subprocess::
+reap(bool block)
+{
+    int status;
+    struct rusage usage;
+
+    pid_t pid;
+    do {
+        pid = ::wait4(_pid, &status, (block ? 0 : WNOHANG), &usage);
+    } while (pid < 0 && errno == EINTR);
+
+    if (pid == 0) {
+        return false;
+    }
+
+    auto wall = std::chrono::steady_clock::now() - _start;
+
+    if (pid < 0) {
+        /* Already reaped elsewhere: there is no status to report. */
+        _exitcode = -1;
+    } else if (WIFSIGNALED(status)) {
+        _exitcode = 128 + WTERMSIG(status);
+    } else {
+        _exitcode = WEXITSTATUS(status);
+    }
+
+    if (pid > 0) {
+#if defined(__APPLE__)
+        uint64_t const maxrssUnit = 1;
+#else
+        uint64_t const maxrssUnit = 1024;
+#endif
+
+        _usage = Usage({
+            std::chrono::duration<double>(wall).count(),
+            static_cast<double>(usage.ru_utime.tv_sec) + static_cast<double>(usage.ru_utime.tv_usec) / 1e6,
+            static_cast<double>(usage.ru_stime.tv_sec) + static_cast<double>(usage.ru_stime.tv_usec) / 1e6,
+            static_cast<uint64_t>(usage.ru_maxrss) * maxrssUnit,
+        });
+    }
+
+    _pid = -1;
+    close();
+    return true;
+}
+
+void Subprocess::
+close()
+{
+    for (int *fd : { &_pidfd, &_inputfd, &_outputfd, &_errorfd }) {
+        if (*fd != -1) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    _input = nullptr;
+    _inputBuffer.clear();
+    _inputOffset = 0;
+}
+
+void Subprocess::
+Poll(std::vector<Subprocess *> const &processes, int timeout)
+{
+    enum class Source {
+        Input,
+        Output,
+        Error,
+        Exit,
+    };
+
+    std::vector<struct pollfd> fds;
+    std::vector<std::pair<Subprocess *, Source>> sources;
+    bool interval = false;
+
+    for (Subprocess *process : processes) {
+        /* Output is read to the end before the process is reaped. */
+        bool drained = (process->_outputfd == -1 && process->_errorfd == -1);
+        if (drained && process->_pidfd == -1 && process->running()) {
+            if (process->reap(false)) {
+                /* Exited; no need to wait. */
+                timeout = 0;
+            } else {
+                interval = true;
             }
         }
 
-        ::execve(path.c_str(), (char *const *)exec_args.data(), (char *const *)exec_env.data());
-        ::_exit(-1);
-        return false;
+        if (!process->running()) {
+            continue;
+        }
+
+        if (process->_inputfd != -1) {
+            fds.push_back({ process->_inputfd, POLLOUT, 0 });
+            sources.push_back({ process, Source::Input });
+        }
+        if (process->_outputfd != -1) {
+            fds.push_back({ process->_outputfd, POLLIN, 0 });
+            sources.push_back({ process, Source::Output });
+        }
+        if (process->_errorfd != -1) {
+            fds.push_back({ process->_errorfd, POLLIN, 0 });
+            sources.push_back({ process, Source::Error });
+        }
+        if (drained && process->_pidfd != -1) {
+            fds.push_back({ process->_pidfd, POLLIN, 0 });
+            sources.push_back({ process, Source::Exit });
+        }
     }
 
-    if (input != nullptr) {
-        // TODO!
+    if (interval && (timeout < 0 || timeout > kReapInterval)) {
+        timeout = kReapInterval;
     }
 
-    ::close(ofds[1]);
-    ::close(efds[1]);
+    if (::poll(fds.data(), fds.size(), timeout) <= 0) {
+        return;
+    }
 
-    if (output != nullptr) {
-        for (;;) {
-            char    buf[16384];
-            ssize_t nread;
+    for (size_t n = 0; n < fds.size(); n++) {
+        if (fds[n].revents == 0) {
+            continue;
+        }
+
+        /* Reaping a process closes its other descriptors. */
+        Subprocess *process = sources[n].first;
+        if (!process->running()) {
+            continue;
+        }
 
-            nread = ::read(ofds[0], buf, sizeof(buf));
-            if (nread <= 0)
+        switch (sources[n].second) {
+            case Source::Input:
+                process->handleInput();
+                break;
+            case Source::Output:
+                process->handleOutput(&process->_outputfd, &process->_output);
+                break;
+            case Source::Error:
+                process->handleOutput(&process->_errorfd, &process->_error);
                 break;
+            case Source::Exit:
+                process->reap(false);
+                break;
+        }
+    }
+}
+
+bool Subprocess::
+wait()
+{
+    if (!running()) {
+        _reported = _launched;
+        return _launched;
+    }
 
-            buf[nread] = '\0';
-            *output << buf;
+    std::vector<Subprocess *> processes = { this };
+    while (running()) {
+        if (_inputfd == -1 && _outputfd == -1 && _errorfd == -1) {
+            /* Nothing left to transfer; just wait for the exit. */
+            reap(true);
+        } else {
+            Poll(processes, -1);
         }
     }
 
-    if (error != nullptr) {
-        for (;;) {
-            char    buf[16384];
-            ssize_t nread;
+    _reported = true;
+    return true;
+}
 
-            nread = ::read(efds[0], buf, sizeof(buf));
-            if (nread <= 0)
-                break;
+Subprocess *Subprocess::
+WaitAny(std::vector<Subprocess *> const &processes, int timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
 
-            buf[nread] = '\0';
-            *error << buf;
+    for (;;) {
+        bool remaining = false;
+        for (Subprocess *process : processes) {
+            if (process->running()) {
+                remaining = true;
+            } else if (process->_launched && !process->_reported) {
+                process->_reported = true;
+                return process;
+            }
+        }
+
+        if (!remaining) {
+            return nullptr;
+        }
+
+        int wait = -1;
+        if (timeout >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() < 0) {
+                return nullptr;
+            }
+            wait = static_cast<int>(left.count());
         }
+
+        Poll(processes, wait);
+    }
+}
+
+bool Subprocess::
+execute(
+    std::string const &path,
+    std::vector<std::string> const &arguments,
+    std::unordered_map<std::string, std::string> const &environment,
+    std::string const &directory,
+    std::istream *input,
+    std::ostream *output,
+    std::ostream *error)
+{
+    if (!launch(path, arguments, environment, directory, input, output != nullptr, error != nullptr)) {
+        return false;
     }
 
-    ::close(ofds[0]);
-    ::close(efds[0]);
+    if (!wait()) {
+        return false;
+    }
 
-    int status;
-    ::waitpid(pid, &status, 0);
-    _exitcode = WEXITSTATUS(status);
+    if (output != nullptr) {
+        output->write(_output.data(), _output.size());
+    }
+    if (error != nullptr) {
+        error->write(_error.data(), _error.size());
+    }
 
     return true;
 }
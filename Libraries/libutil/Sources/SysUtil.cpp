@@ -11,6 +11,8 @@
 #include <libutil/FSUtil.h>
 
 #include <sstream>
+#include <vector>
+#include <cstdlib>
 #include <cstring>
 #include <cassert>
 
@@ -112,8 +114,13 @@ GetUserName()
 {
     std::string result;
 
-    struct passwd const *pw = ::getpwuid(::getuid());
-    if (pw != nullptr) {
+    /* Use the reentrant lookup, as this can be called from multiple threads. */
+    long size = ::sysconf(_SC_GETPW_R_SIZE_MAX);
+    std::vector<char> buffer = std::vector<char>(size > 0 ? static_cast<size_t>(size) : 16384);
+
+    struct passwd pwd;
+    struct passwd *pw = nullptr;
+    if (::getpwuid_r(::getuid(), &pwd, buffer.data(), buffer.size(), &pw) == 0 && pw != nullptr) {
         if (pw->pw_name != nullptr) {
             result = pw->pw_name;
         }
@@ -124,8 +131,6 @@ GetUserName()
         result = os.str();
     }
 
-    ::endpwent();
-
     return result;
 }
 
@@ -163,6 +168,23 @@ GetGroupID()
     return ::getgid();
 }
 
+ext::optional<std::string> SysUtil::
+GetCacheDirectory()
+{
+    if (char const *cacheDirectory = ::getenv("XCBUILD_CACHE_DIR")) {
+        if (cacheDirectory[0] == '\0') {
+            return ext::nullopt;
+        }
+        return std::string(cacheDirectory);
+    } else if (char const *cacheHome = ::getenv("XDG_CACHE_HOME")) {
+        return std::string(cacheHome) + "/xcbuild";
+    } else if (char const *home = ::getenv("HOME")) {
+        return std::string(home) + "/.cache/xcbuild";
+    } else {
+        return ext::nullopt;
+    }
+}
+
 void SysUtil::
 Sleep(uint64_t us, bool interruptible)
 {
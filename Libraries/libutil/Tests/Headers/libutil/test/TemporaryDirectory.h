@@ -0,0 +1,49 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_test_TemporaryDirectory_h
+#define __libutil_test_TemporaryDirectory_h
+
+#include <string>
+
+namespace libutil {
+namespace test {
+
+/*
+ * A directory on disk for tests that can't use a memory filesystem. The
+ * directory and everything in it is removed when this is destroyed.
+ */
+class TemporaryDirectory {
+private:
+    std::string _path;
+
+public:
+    /*
+     * Creates a directory in the temporary directory, starting with `name`.
+     * The test fails if it can't be created, and the path is left empty.
+     */
+    explicit TemporaryDirectory(std::string const &name);
+    ~TemporaryDirectory();
+
+private:
+    TemporaryDirectory(TemporaryDirectory const &) = delete;
+    TemporaryDirectory &operator=(TemporaryDirectory const &) = delete;
+
+public:
+    /*
+     * The path to the directory, or empty if it couldn't be created.
+     */
+    std::string const &path() const
+    { return _path; }
+};
+
+}
+}
+
+#endif  // !__libutil_test_TemporaryDirectory_h
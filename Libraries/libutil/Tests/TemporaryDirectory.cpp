@@ -0,0 +1,49 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/test/TemporaryDirectory.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using libutil::test::TemporaryDirectory;
+using libutil::DefaultFilesystem;
+
+TemporaryDirectory::
+TemporaryDirectory(std::string const &name)
+{
+    char const *temporary = ::getenv("TMPDIR");
+    std::string pattern = std::string(temporary != nullptr && temporary[0] != '\0' ? temporary : "/tmp") + "/" + name + ".XXXXXX";
+
+    std::vector<char> path = std::vector<char>(pattern.begin(), pattern.end());
+    path.push_back('\0');
+
+    if (::mkdtemp(path.data()) == nullptr) {
+        ADD_FAILURE() << "couldn't create temporary directory " << pattern << ": " << ::strerror(errno);
+        return;
+    }
+
+    _path = path.data();
+}
+
+TemporaryDirectory::
+~TemporaryDirectory()
+{
+    if (_path.empty()) {
+        return;
+    }
+
+    DefaultFilesystem filesystem;
+    EXPECT_TRUE(filesystem.removeDirectory(_path, true)) << "couldn't remove temporary directory " << _path;
+}
@@ -0,0 +1,145 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/test/TemporaryDirectory.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using libutil::DefaultFilesystem;
+using libutil::FileView;
+using libutil::test::TemporaryDirectory;
+
+TEST(DefaultFilesystem, ReadWrite)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_DefaultFilesystem");
+    std::string const &directory = temporary.path();
+    ASSERT_FALSE(directory.empty());
+    std::string path = directory + "/file";
+
+    std::vector<uint8_t> contents;
+    EXPECT_FALSE(filesystem.read(&contents, path));
+
+    EXPECT_TRUE(filesystem.write({ }, path));
+    EXPECT_TRUE(filesystem.read(&contents, path));
+    EXPECT_TRUE(contents.empty());
+
+    std::vector<uint8_t> large = std::vector<uint8_t>(1024 * 1024);
+    for (size_t n = 0; n < large.size(); n++) {
+        large[n] = static_cast<uint8_t>(n * 7);
+    }
+    EXPECT_TRUE(filesystem.write(large, path));
+    EXPECT_TRUE(filesystem.read(&contents, path));
+    EXPECT_EQ(large, contents);
+
+    /* Only the file itself is left, no temporary files. */
+    std::vector<std::string> entries;
+    filesystem.enumerateDirectory(directory, [&](std::string const &name) {
+        entries.push_back(name);
+    });
+    EXPECT_EQ(std::vector<std::string>({ "file" }), entries);
+}
+
+TEST(DefaultFilesystem, WritePreservesMode)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_DefaultFilesystem");
+    std::string const &directory = temporary.path();
+    ASSERT_FALSE(directory.empty());
+    std::string path = directory + "/script";
+
+    EXPECT_TRUE(filesystem.write({ 'a' }, path));
+    EXPECT_EQ(0, ::chmod(path.c_str(), 0750));
+    EXPECT_TRUE(filesystem.write({ 'b' }, path));
+
+    struct stat st;
+    EXPECT_EQ(0, ::stat(path.c_str(), &st));
+    EXPECT_EQ(0750u, st.st_mode & 07777);
+
+    /* Writing through a symbolic link replaces the target, not the link. */
+    std::string link = directory + "/link";
+    EXPECT_TRUE(filesystem.writeSymbolicLink("script", link));
+    EXPECT_TRUE(filesystem.write({ 'c' }, link));
+    EXPECT_TRUE(filesystem.isSymbolicLink(link));
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, path));
+    EXPECT_EQ(std::vector<uint8_t>({ 'c' }), contents);
+}
+
+TEST(DefaultFilesystem, Map)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_DefaultFilesystem");
+    std::string const &directory = temporary.path();
+    ASSERT_FALSE(directory.empty());
+
+    EXPECT_EQ(nullptr, filesystem.map(directory + "/missing"));
+
+    std::vector<uint8_t> small = { 's', 'm', 'a', 'l', 'l' };
+    EXPECT_TRUE(filesystem.write(small, directory + "/small"));
+    std::unique_ptr<FileView> smallView = filesystem.map(directory + "/small");
+    ASSERT_NE(nullptr, smallView);
+    EXPECT_FALSE(smallView->mapped());
+    EXPECT_EQ(small, std::vector<uint8_t>(smallView->data(), smallView->data() + smallView->size()));
+
+    std::vector<uint8_t> large = std::vector<uint8_t>(1024 * 1024, 'x');
+    EXPECT_TRUE(filesystem.write(large, directory + "/large"));
+    std::unique_ptr<FileView> largeView = filesystem.map(directory + "/large");
+    ASSERT_NE(nullptr, largeView);
+    EXPECT_TRUE(largeView->mapped());
+    EXPECT_EQ(large, std::vector<uint8_t>(largeView->data(), largeView->data() + largeView->size()));
+}
+
+TEST(DefaultFilesystem, ReadPrefix)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_DefaultFilesystem");
+    std::string const &directory = temporary.path();
+    ASSERT_FALSE(directory.empty());
+
+    std::vector<uint8_t> contents;
+    EXPECT_FALSE(filesystem.readPrefix(&contents, directory + "/missing", 4));
+
+    EXPECT_TRUE(filesystem.write({ 'a', 'b', 'c', 'd', 'e', 'f' }, directory + "/file"));
+    EXPECT_TRUE(filesystem.readPrefix(&contents, directory + "/file", 4));
+    EXPECT_EQ(std::vector<uint8_t>({ 'a', 'b', 'c', 'd' }), contents);
+
+    /* A shorter file is read whole. */
+    EXPECT_TRUE(filesystem.readPrefix(&contents, directory + "/file", 100));
+    EXPECT_EQ(std::vector<uint8_t>({ 'a', 'b', 'c', 'd', 'e', 'f' }), contents);
+}
+
+TEST(DefaultFilesystem, RemoveDirectory)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_DefaultFilesystem");
+    std::string const &directory = temporary.path();
+    ASSERT_FALSE(directory.empty());
+
+    EXPECT_TRUE(filesystem.createDirectory(directory + "/outer/inner"));
+    EXPECT_TRUE(filesystem.write({ 'a' }, directory + "/outer/inner/file"));
+    EXPECT_TRUE(filesystem.createDirectory(directory + "/target"));
+    EXPECT_TRUE(filesystem.write({ 'b' }, directory + "/target/file"));
+    EXPECT_TRUE(filesystem.writeSymbolicLink("../target", directory + "/outer/link"));
+
+    /* Only empty directories are removed unless recursive. */
+    EXPECT_FALSE(filesystem.removeDirectory(directory + "/outer", false));
+    EXPECT_TRUE(filesystem.isDirectory(directory + "/outer"));
+
+    /* Links are removed without removing what they point to. */
+    EXPECT_TRUE(filesystem.removeDirectory(directory + "/outer", true));
+    EXPECT_FALSE(filesystem.exists(directory + "/outer"));
+    EXPECT_TRUE(filesystem.exists(directory + "/target/file"));
+
+    EXPECT_FALSE(filesystem.removeDirectory(directory + "/missing", true));
+}
@@ -183,6 +183,23 @@ TEST(MemoryFilesystem, RemoveFile)
     EXPECT_FALSE(filesystem.removeFile("/invalid"));
 }
 
+TEST(MemoryFilesystem, RemoveDirectory)
+{
+    auto filesystem = BasicFilesystem();
+
+    EXPECT_TRUE(filesystem.removeDirectory("/dir2/dir3", false));
+    EXPECT_FALSE(filesystem.exists("/dir2/dir3"));
+
+    EXPECT_FALSE(filesystem.removeDirectory("/dir1", false));
+    EXPECT_TRUE(filesystem.removeDirectory("/dir1", true));
+    EXPECT_FALSE(filesystem.exists("/dir1"));
+    EXPECT_FALSE(filesystem.exists("/dir1/file2"));
+
+    EXPECT_FALSE(filesystem.removeDirectory("/file1", true));
+    EXPECT_FALSE(filesystem.removeDirectory("/invalid", true));
+    EXPECT_FALSE(filesystem.removeDirectory("/", true));
+}
+
 TEST(MemoryFilesystem, Read)
 {
     auto filesystem = BasicFilesystem();
@@ -251,6 +268,30 @@ TEST(MemoryFilesystem, Write)
     EXPECT_FALSE(filesystem.exists("/invalid/new"));
 }
 
+TEST(MemoryFilesystem, FileStatus)
+{
+    auto filesystem = BasicFilesystem();
+    uint64_t modified;
+    uint64_t size;
+
+    EXPECT_TRUE(filesystem.fileStatus("/file1", &modified, &size));
+    EXPECT_EQ(0u, modified);
+    EXPECT_EQ(3u, size);
+
+    /* Each write is later than the last. */
+    EXPECT_TRUE(filesystem.write(Contents("four"), "/file1"));
+    EXPECT_TRUE(filesystem.fileStatus("/file1", &modified, &size));
+    EXPECT_EQ(1u, modified);
+    EXPECT_EQ(4u, size);
+
+    EXPECT_TRUE(filesystem.write(Contents("new"), "/dir1/new"));
+    EXPECT_TRUE(filesystem.fileStatus("/dir1/new", &modified, &size));
+    EXPECT_EQ(2u, modified);
+    EXPECT_EQ(3u, size);
+
+    EXPECT_FALSE(filesystem.fileStatus("/invalid", &modified, &size));
+}
+
 TEST(MemoryFilesystem, ResolvePath)
 {
     auto filesystem = BasicFilesystem();
@@ -0,0 +1,117 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/Subprocess.h>
+
+#include <sstream>
+
+using libutil::Subprocess;
+
+static std::vector<std::string>
+Shell(std::string const &command)
+{
+    return { "-c", command };
+}
+
+TEST(Subprocess, Execute)
+{
+    Subprocess process;
+    std::ostringstream output;
+    std::ostringstream error;
+    EXPECT_TRUE(process.execute("/bin/sh", Shell("echo out; echo err >&2; exit 3"), nullptr, &output, &error));
+    EXPECT_EQ(3, process.exitcode());
+    EXPECT_EQ("out\n", output.str());
+    EXPECT_EQ("err\n", error.str());
+
+    EXPECT_FALSE(process.execute("/nonexistent"));
+}
+
+TEST(Subprocess, FullPipes)
+{
+    /* Fill the error pipe before writing any output. */
+    Subprocess process;
+    std::ostringstream output;
+    std::ostringstream error;
+    EXPECT_TRUE(process.execute("/bin/sh", Shell("i=0; while [ $i -lt 2000 ]; do echo 0123456789012345678901234567890123456789 >&2; i=$((i+1)); done; echo done"), nullptr, &output, &error));
+    EXPECT_EQ(0, process.exitcode());
+    EXPECT_EQ("done\n", output.str());
+    EXPECT_EQ(2000u * 41u, error.str().size());
+}
+
+TEST(Subprocess, Input)
+{
+    std::string contents;
+    for (int n = 0; n < 20000; n++) {
+        contents += std::to_string(n) + "\n";
+    }
+
+    Subprocess process;
+    std::istringstream input(contents);
+    std::ostringstream output;
+    EXPECT_TRUE(process.execute("/bin/cat", { }, &input, &output));
+    EXPECT_EQ(0, process.exitcode());
+    EXPECT_EQ(contents, output.str());
+
+    /* Input the process never reads is dropped. */
+    Subprocess ignore;
+    std::istringstream unread(contents);
+    EXPECT_TRUE(ignore.execute("/bin/sh", Shell("exit 0"), &unread));
+    EXPECT_EQ(0, ignore.exitcode());
+}
+
+TEST(Subprocess, Directory)
+{
+    Subprocess process;
+    std::ostringstream output;
+    EXPECT_TRUE(process.execute("/bin/sh", Shell("pwd"), { }, "/", nullptr, &output));
+    EXPECT_EQ("/\n", output.str());
+}
+
+TEST(Subprocess, WaitAny)
+{
+    Subprocess slow;
+    Subprocess fast;
+    Subprocess quiet;
+    ASSERT_TRUE(slow.launch("/bin/sh", Shell("sleep 1; echo slow"), { }, "", nullptr, true));
+    ASSERT_TRUE(fast.launch("/bin/sh", Shell("echo fast; exit 1"), { }, "", nullptr, true));
+    ASSERT_TRUE(quiet.launch("/bin/sh", Shell("exit 2"), { }, ""));
+
+    std::vector<Subprocess *> processes = { &slow, &fast, &quiet };
+    EXPECT_EQ(nullptr, Subprocess::WaitAny({ &slow }, 0));
+
+    std::vector<Subprocess *> finished;
+    while (Subprocess *process = Subprocess::WaitAny(processes)) {
+        finished.push_back(process);
+    }
+
+    ASSERT_EQ(3u, finished.size());
+    EXPECT_EQ(&slow, finished.back());
+    EXPECT_EQ("slow\n", slow.output());
+    EXPECT_EQ("fast\n", fast.output());
+    EXPECT_EQ(1, fast.exitcode());
+    EXPECT_EQ(2, quiet.exitcode());
+    EXPECT_FALSE(slow.running());
+}
+
+TEST(Subprocess, Usage)
+{
+    Subprocess process;
+    EXPECT_FALSE(process.usage());
+
+    ASSERT_TRUE(process.launch("/bin/sh", Shell("i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done"), { }, ""));
+    EXPECT_TRUE(process.running());
+    EXPECT_TRUE(process.wait());
+    EXPECT_FALSE(process.running());
+
+    ASSERT_TRUE(process.usage());
+    EXPECT_GT(process.usage()->wall, 0.0);
+    EXPECT_GT(process.usage()->user + process.usage()->system, 0.0);
+    EXPECT_GT(process.usage()->maximumResidentSize, 0u);
+}
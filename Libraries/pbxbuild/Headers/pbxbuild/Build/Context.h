@@ -12,9 +12,11 @@
 
 #include <pbxbuild/Base.h>
 #include <pbxbuild/WorkspaceContext.h>
+#include <pbxbuild/Build/DirectoryTreeCache.h>
 #include <pbxbuild/Build/Environment.h>
 #include <pbxbuild/Target/Environment.h>
 
+#include <mutex>
 #include <ext/optional>
 
 namespace pbxbuild {
@@ -36,7 +38,18 @@ private:
     std::vector<pbxsetting::Level>    _overrideLevels;
 
 private:
-    std::shared_ptr<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>> _targetEnvironments;
+    /*
+     * Target environments created so far. Shared between copies of the
+     * context, and locked as targets can be planned on multiple threads.
+     */
+    struct TargetEnvironments {
+        std::mutex                                                               mutex;
+        std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment> environments;
+    };
+    std::shared_ptr<TargetEnvironments> _targetEnvironments;
+
+private:
+    std::shared_ptr<DirectoryTreeCache> _directoryTreeCache;
 
 public:
     Context(
@@ -107,11 +120,20 @@ public:
 
 public:
     /*
-     * Create or fetch a target's computed environment.
+     * Create or fetch a target's computed environment. Safe to call from
+     * multiple threads at once.
      */
     ext::optional<Target::Environment>
     targetEnvironment(Build::Environment const &buildEnvironment, pbxproj::PBX::Target::shared_ptr const &target) const;
 
+public:
+    /*
+     * The directories below recursive search paths, shared by all targets
+     * in the build and between copies of the context.
+     */
+    DirectoryTreeCache *directoryTreeCache() const
+    { return _directoryTreeCache.get(); }
+
 public:
     /*
      * Finds a target by identifier within a project.
@@ -0,0 +1,144 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_Build_DirectoryTreeCache_h
+#define __pbxbuild_Build_DirectoryTreeCache_h
+
+#include <pbxbuild/Base.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pbxsetting { class Environment; }
+
+namespace pbxbuild {
+namespace Build {
+
+/*
+ * The directories below the roots of recursive search paths, ending in two
+ * asterisks. Each tree is walked once for the whole build, rather than by
+ * every target and tool that uses it, unless a build step creates paths in
+ * it and it is invalidated. Safe to use from multiple threads.
+ */
+class DirectoryTreeCache {
+public:
+    /*
+     * Which directories below a root are part of its tree.
+     */
+    class Filter {
+    private:
+        std::vector<std::string> _included;
+        std::vector<std::string> _excluded;
+        bool                     _followSymlinks;
+
+    public:
+        Filter(std::vector<std::string> const &included, std::vector<std::string> const &excluded, bool followSymlinks);
+
+    public:
+        /*
+         * Patterns for directory names to include, even if excluded.
+         */
+        std::vector<std::string> const &included() const
+        { return _included; }
+
+        /*
+         * Patterns for directory names to skip, along with their contents.
+         */
+        std::vector<std::string> const &excluded() const
+        { return _excluded; }
+
+        /*
+         * If symbolic links to directories are descended into.
+         */
+        bool followSymlinks() const
+        { return _followSymlinks; }
+
+    public:
+        /*
+         * If a directory with a name is part of the tree.
+         */
+        bool matches(std::string const &name) const;
+
+    public:
+        /*
+         * The filter from the recursive search path build settings.
+         */
+        static Filter
+        Create(pbxsetting::Environment const &environment);
+    };
+
+public:
+    /*
+     * Directories below a root, as paths relative to it.
+     */
+    typedef std::shared_ptr<std::vector<std::string> const> Directories;
+
+private:
+    std::mutex                                                   _mutex;
+    std::unordered_map<std::string, std::shared_future<Directories>> _trees;
+    std::vector<std::pair<std::string, Filter>>                  _roots;
+
+private:
+    /*
+     * Threads prefetching can start to help them, shared by all prefetches
+     * so planning multiple targets at once doesn't oversubscribe the CPU.
+     */
+    std::atomic<size_t>                                          _helpers;
+
+public:
+    DirectoryTreeCache();
+
+public:
+    /*
+     * The directories below a root, walking it if it hasn't been already.
+     * If another thread is walking the same tree, waits for it to finish.
+     */
+    Directories
+    directories(std::string const &root, Filter const &filter);
+
+    /*
+     * Walks multiple roots in parallel, so later lookups are cached. The
+     * calling thread walks roots too, helped by any threads available.
+     */
+    void
+    prefetch(std::vector<std::string> const &roots, Filter const &filter);
+
+    /*
+     * The roots requested so far and the filter for each, in the order
+     * they were first requested.
+     */
+    std::vector<std::pair<std::string, Filter>>
+    roots();
+
+    /*
+     * Forgets the trees that contain any of the given paths, or whose root
+     * is below one of them, so those are walked again when next requested.
+     * Used after a build step that may have created directories at those
+     * paths. Trees reaching a path only through a symbolic link are kept.
+     */
+    void
+    invalidate(std::vector<std::string> const &paths);
+
+public:
+    /*
+     * Walks a tree without caching it.
+     */
+    static Directories
+    Walk(std::string const &root, Filter const &filter);
+};
+
+}
+}
+
+#endif // !__pbxbuild_Build_DirectoryTreeCache_h
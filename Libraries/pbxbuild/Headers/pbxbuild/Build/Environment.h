@@ -60,10 +60,11 @@ public:
 public:
     /*
      * Creates a build environment from the default configuration
-     * of each of the build environment's subcomponents.
+     * of each of the build environment's subcomponents. The parsed
+     * specifications and SDK property lists are cached between runs.
      */
     static ext::optional<Environment>
-    Default(libutil::Filesystem const *filesystem);
+    Default(libutil::Filesystem *filesystem);
 };
 
 }
@@ -37,6 +37,11 @@ namespace Phase {
 
 class Environment;
 
+/*
+ * The state used while creating the invocations for a single target. The
+ * lazily created tool resolvers are specific to that target, so a context
+ * is never shared: targets planned on separate threads each have their own.
+ */
 class Context {
 private:
     Tool::Context                                       _toolContext;
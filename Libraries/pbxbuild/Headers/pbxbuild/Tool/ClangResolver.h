@@ -15,6 +15,10 @@
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/File.h>
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 namespace pbxbuild {
 namespace Tool {
 
@@ -26,6 +30,23 @@ class ClangResolver {
 private:
     pbxspec::PBX::Compiler::shared_ptr _compiler;
 
+public:
+    class SourceTemplate;
+
+private:
+    /*
+     * Compiler arguments evaluated once per environment, file type, and
+     * localization, with placeholders for each file's input and output.
+     * Null if the arguments can't be evaluated without the file.
+     */
+    mutable std::unordered_map<std::string, std::shared_ptr<SourceTemplate>> _sourceTemplates;
+
+    /*
+     * The environments templates were evaluated in. Held so their identities,
+     * which are part of the template keys, aren't reused.
+     */
+    mutable std::vector<std::shared_ptr<void const>> _templateEnvironments;
+
 public:
     ClangResolver(pbxspec::PBX::Compiler::shared_ptr const &compiler);
     ~ClangResolver();
@@ -32,6 +32,7 @@ private:
 
 private:
     SearchPaths                         _searchPaths;
+    Build::DirectoryTreeCache          *_directoryTreeCache;
 
 private:
     HeadermapInfo                       _headermapInfo;
@@ -49,7 +50,8 @@ public:
         xcsdk::SDK::Toolchain::vector const &toolchains,
         std::vector<std::string> const &executablePaths,
         std::string const &workingDirectory,
-        SearchPaths const &searchPaths);
+        SearchPaths const &searchPaths,
+        Build::DirectoryTreeCache *directoryTreeCache = nullptr);
     ~Context();
 
 public:
@@ -65,6 +67,8 @@ public:
 public:
     SearchPaths const &searchPaths() const
     { return _searchPaths; }
+    Build::DirectoryTreeCache *directoryTreeCache() const
+    { return _directoryTreeCache; }
 
 public:
     HeadermapInfo const &headermapInfo() const
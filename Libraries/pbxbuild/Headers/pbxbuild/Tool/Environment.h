@@ -14,6 +14,8 @@
 #include <pbxbuild/Phase/File.h>
 #include <pbxsetting/Environment.h>
 
+#include <unordered_map>
+
 namespace pbxbuild {
 namespace Tool {
 
@@ -65,6 +67,57 @@ public:
         std::string const &workingDirectory,
         std::vector<std::string> const &inputs,
         std::vector<std::string> const &outputs = { });
+
+public:
+    /*
+     * Creates a template environment for a tool. The settings that vary with
+     * the input and output, such as `InputFileBase` and `OutputDir`, are set
+     * to placeholders; values expanded in the template can be made specific
+     * to a file with `Instantiate()`. Returns nothing for tools that choose
+     * their own outputs, since those are expanded from the input.
+     */
+    static ext::optional<Tool::Environment>
+    CreateTemplate(
+        pbxspec::PBX::Tool::shared_ptr const &tool,
+        pbxsetting::Environment const &environment,
+        std::string const &workingDirectory,
+        std::string const &localization);
+
+    /*
+     * The values of the placeholders in a template environment for a file.
+     */
+    static std::unordered_map<std::string, std::string>
+    PlaceholderValues(
+        Phase::File const &input,
+        std::string const &output,
+        std::string const &workingDirectory);
+
+    /*
+     * Replaces placeholders in a value expanded from a template environment.
+     * Returns nothing if a placeholder was modified during expansion (for
+     * example, by a `:dir` modifier) and so cannot be replaced.
+     */
+    static ext::optional<std::string>
+    Instantiate(
+        std::string const &value,
+        std::unordered_map<std::string, std::string> const &values);
+
+    /*
+     * If a value contains any part of a placeholder.
+     */
+    static bool
+    ContainsPlaceholder(std::string const &value);
+
+public:
+    /*
+     * If expanding a value in this template environment would change a
+     * placeholder, by applying an operation to it or by using it in the name
+     * of a setting. The result can't be instantiated, and may no longer show
+     * the placeholder at all, so the value is checked before it's expanded.
+     * References to the settings given are followed into their values.
+     */
+    bool
+    changesPlaceholder(pbxsetting::Value const &value, std::unordered_map<std::string, pbxsetting::Value> const &settings) const;
 };
 
 }
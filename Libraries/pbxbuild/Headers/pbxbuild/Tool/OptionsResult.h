@@ -19,8 +19,10 @@
 namespace pbxsetting { class Environment; }
 
 namespace pbxbuild {
+namespace Build { class DirectoryTreeCache; }
 namespace Tool {
 
+class Context;
 class Environment;
 
 class OptionsResult {
@@ -47,11 +49,22 @@ public:
         std::string const &workingDirectory,
         std::vector<pbxspec::PBX::PropertyOption::shared_ptr> const &options,
         pbxspec::PBX::FileType::shared_ptr const &fileType,
-        std::unordered_set<std::string> const &deletedSettings = std::unordered_set<std::string>());
+        std::unordered_set<std::string> const &deletedSettings = std::unordered_set<std::string>(),
+        Build::DirectoryTreeCache *directoryTreeCache = nullptr);
 
     static OptionsResult Create(
         Tool::Environment const &toolEnvironment,
-        std::string const &workingDirectory,
+        Tool::Context const *toolContext,
+        pbxspec::PBX::FileType::shared_ptr const &fileType);
+
+    /*
+     * Creates options from a template tool environment. Returns nothing if
+     * the options depend on an input or output placeholder in a way that
+     * can't be instantiated later, such as in a condition or a list value.
+     */
+    static ext::optional<OptionsResult> CreateTemplate(
+        Tool::Environment const &toolEnvironment,
+        Tool::Context const *toolContext,
         pbxspec::PBX::FileType::shared_ptr const &fileType);
 };
 
@@ -11,6 +11,7 @@
 #define __pbxbuild_Tool_SearchPaths_h
 
 #include <pbxbuild/Base.h>
+#include <pbxbuild/Build/DirectoryTreeCache.h>
 
 namespace pbxsetting { class Environment; }
 
@@ -44,12 +45,21 @@ public:
     { return _librarySearchPaths; }
 
 public:
+    /*
+     * Creates the search paths for a target. Recursive paths are expanded
+     * through the cache, if provided, with their roots walked in parallel.
+     */
     static Tool::SearchPaths
-    Create(pbxsetting::Environment const &environment, std::string const &workingDirectory);
+    Create(pbxsetting::Environment const &environment, std::string const &workingDirectory, Build::DirectoryTreeCache *directoryTreeCache = nullptr);
 
 public:
+    /*
+     * Expands recursive paths, ending in two asterisks, into the directories
+     * below them, skipping those excluded by the recursive search path
+     * settings.
+     */
     static std::vector<std::string>
-    ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory);
+    ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory, Build::DirectoryTreeCache *directoryTreeCache = nullptr);
 };
 
 }
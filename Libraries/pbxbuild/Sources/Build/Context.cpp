@@ -29,23 +29,35 @@ Context(
     _configuration       (configuration),
     _defaultConfiguration(defaultConfiguration),
     _overrideLevels      (overrideLevels),
-    _targetEnvironments  (std::make_shared<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>>())
+    _targetEnvironments  (std::make_shared<TargetEnvironments>()),
+    _directoryTreeCache  (std::make_shared<DirectoryTreeCache>())
 {
 }
 
 ext::optional<pbxbuild::Target::Environment> Build::Context::
 targetEnvironment(Build::Environment const &buildEnvironment, pbxproj::PBX::Target::shared_ptr const &target) const
 {
-    auto TEI = _targetEnvironments->find(target);
-    if (TEI != _targetEnvironments->end()) {
-        return TEI->second;
-    } else {
-        ext::optional<Target::Environment> targetEnvironment = Target::Environment::Create(buildEnvironment, *this, target);
-        if (targetEnvironment) {
-            _targetEnvironments->insert(std::make_pair(target, *targetEnvironment));
+    {
+        std::lock_guard<std::mutex> lock(_targetEnvironments->mutex);
+
+        auto TEI = _targetEnvironments->environments.find(target);
+        if (TEI != _targetEnvironments->environments.end()) {
+            return TEI->second;
         }
-        return targetEnvironment;
     }
+
+    /*
+     * Not locked while creating: creating an environment can need the
+     * environments of other targets. If another thread created the same
+     * environment in the meantime, use that one so all callers share it.
+     */
+    ext::optional<Target::Environment> targetEnvironment = Target::Environment::Create(buildEnvironment, *this, target);
+    if (!targetEnvironment) {
+        return ext::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(_targetEnvironments->mutex);
+    return _targetEnvironments->environments.insert(std::make_pair(target, *targetEnvironment)).first->second;
 }
 
 pbxproj::PBX::Target::shared_ptr Build::Context::
@@ -0,0 +1,219 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/Build/DirectoryTreeCache.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Type.h>
+#include <libutil/FSUtil.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <fnmatch.h>
+
+namespace Build = pbxbuild::Build;
+using libutil::FSUtil;
+
+Build::DirectoryTreeCache::Filter::
+Filter(std::vector<std::string> const &included, std::vector<std::string> const &excluded, bool followSymlinks) :
+    _included      (included),
+    _excluded      (excluded),
+    _followSymlinks(followSymlinks)
+{
+}
+
+static bool
+MatchesAny(std::vector<std::string> const &patterns, std::string const &name)
+{
+    for (std::string const &pattern : patterns) {
+        if (::fnmatch(pattern.c_str(), name.c_str(), 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Build::DirectoryTreeCache::Filter::
+matches(std::string const &name) const
+{
+    return MatchesAny(_included, name) || !MatchesAny(_excluded, name);
+}
+
+Build::DirectoryTreeCache::Filter Build::DirectoryTreeCache::Filter::
+Create(pbxsetting::Environment const &environment)
+{
+    return Filter(
+        pbxsetting::Type::ParseList(environment.resolve("INCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES")),
+        pbxsetting::Type::ParseList(environment.resolve("EXCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES")),
+        pbxsetting::Type::ParseBoolean(environment.resolve("RECURSIVE_SEARCH_PATHS_FOLLOW_SYMLINKS")));
+}
+
+Build::DirectoryTreeCache::
+DirectoryTreeCache() :
+    _helpers(std::max(1u, std::thread::hardware_concurrency()) - 1)
+{
+}
+
+static std::string
+TreeKey(std::string const &root, Build::DirectoryTreeCache::Filter const &filter)
+{
+    std::string key = root;
+    key += '\0';
+    for (std::string const &pattern : filter.included()) {
+        key += pattern + ' ';
+    }
+    key += '\0';
+    for (std::string const &pattern : filter.excluded()) {
+        key += pattern + ' ';
+    }
+    key += '\0';
+    key += (filter.followSymlinks() ? "YES" : "NO");
+    return key;
+}
+
+Build::DirectoryTreeCache::Directories Build::DirectoryTreeCache::
+directories(std::string const &root, Filter const &filter)
+{
+    std::string key = TreeKey(root, filter);
+
+    std::promise<Directories> promise;
+    std::shared_future<Directories> future;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _trees.find(key);
+        if (it != _trees.end()) {
+            future = it->second;
+        } else {
+            _trees.insert({ key, promise.get_future().share() });
+            _roots.push_back({ root, filter });
+        }
+    }
+
+    if (future.valid()) {
+        return future.get();
+    }
+
+    /* This thread inserted the tree, so is responsible for walking it. */
+    Directories directories = Walk(root, filter);
+    promise.set_value(directories);
+    return directories;
+}
+
+void Build::DirectoryTreeCache::
+prefetch(std::vector<std::string> const &roots, Filter const &filter)
+{
+    if (roots.empty()) {
+        return;
+    }
+
+    /* Take as many helpers as are available and useful. */
+    size_t available = _helpers.load();
+    size_t helpers;
+    do {
+        helpers = std::min(available, roots.size() - 1);
+    } while (!_helpers.compare_exchange_weak(available, available - helpers));
+
+    std::atomic<size_t> next(0);
+    auto walk = [&] {
+        size_t index;
+        while ((index = next++) < roots.size()) {
+            directories(roots[index], filter);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < helpers; n++) {
+        threads.push_back(std::thread(walk));
+    }
+
+    walk();
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    _helpers += helpers;
+}
+
+std::vector<std::pair<std::string, Build::DirectoryTreeCache::Filter>> Build::DirectoryTreeCache::
+roots()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _roots;
+}
+
+static std::string
+ComparablePath(std::string const &path)
+{
+    std::string normalized = FSUtil::NormalizePath(path);
+    while (normalized.size() > 1 && normalized.back() == '/') {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
+/*
+ * If one path is the same as or below the other.
+ */
+static bool
+Overlaps(std::string const &a, std::string const &b)
+{
+    std::string const &shorter = (a.size() < b.size() ? a : b);
+    std::string const &longer = (a.size() < b.size() ? b : a);
+    return longer.compare(0, shorter.size(), shorter) == 0 &&
+        (longer.size() == shorter.size() || shorter == "/" || longer[shorter.size()] == '/');
+}
+
+void Build::DirectoryTreeCache::
+invalidate(std::vector<std::string> const &paths)
+{
+    std::vector<std::string> comparablePaths;
+    for (std::string const &path : paths) {
+        if (!path.empty()) {
+            comparablePaths.push_back(ComparablePath(path));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<std::pair<std::string, Filter>> roots;
+    for (std::pair<std::string, Filter> const &root : _roots) {
+        std::string comparableRoot = ComparablePath(root.first);
+        bool overlaps = std::any_of(comparablePaths.begin(), comparablePaths.end(), [&](std::string const &path) {
+            return Overlaps(comparableRoot, path);
+        });
+
+        if (overlaps) {
+            _trees.erase(TreeKey(root.first, root.second));
+        } else {
+            roots.push_back(root);
+        }
+    }
+    _roots = std::move(roots);
+}
+
+Build::DirectoryTreeCache::Directories Build::DirectoryTreeCache::
+Walk(std::string const &root, Filter const &filter)
+{
+    auto directories = std::make_shared<std::vector<std::string>>();
+
+    FSUtil::EnumerateDirectoriesRecursive(root, filter.followSymlinks(), [&](std::string const &path) -> bool {
+        if (!filter.matches(FSUtil::GetBaseName(path))) {
+            return false;
+        }
+
+        directories->push_back(path.substr(root.size() + 1));
+        return true;
+    });
+
+    return directories;
+}
@@ -12,6 +12,7 @@
 #include <xcsdk/Environment.h>
 #include <pbxsetting/DefaultSettings.h>
 #include <pbxsetting/Environment.h>
+#include <plist/Cache.h>
 #include <libutil/Filesystem.h>
 
 namespace Build = pbxbuild::Build;
@@ -26,7 +27,7 @@ Environment(pbxspec::Manager::shared_ptr const &specManager, std::shared_ptr<xcs
 }
 
 ext::optional<Build::Environment> Build::Environment::
-Default(Filesystem const *filesystem)
+Default(Filesystem *filesystem)
 {
     ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(filesystem);
     if (!developerRoot) {
@@ -51,13 +52,20 @@ Default(Filesystem const *filesystem)
         }
     }
 
+    /*
+     * Use the parsed specifications and SDK property lists from previous runs,
+     * for the files that haven't changed since.
+     */
+    ext::optional<std::string> cachePath = plist::Cache::DefaultPath(*developerRoot);
+    std::unique_ptr<plist::Cache> cache = (cachePath ? plist::Cache::Open(filesystem, *cachePath) : nullptr);
+
     /*
      * Register global specifications.
      */
-    specManager->registerDomains(filesystem, pbxspec::Manager::DefaultDomains(*developerRoot));
+    specManager->registerDomains(filesystem, pbxspec::Manager::DefaultDomains(*developerRoot), cache.get());
 
     auto configuration = xcsdk::Configuration::Load(filesystem, xcsdk::Configuration::DefaultPaths());
-    auto sdkManager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration);
+    auto sdkManager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration, cache.get());
     if (sdkManager == nullptr) {
         fprintf(stderr, "error: couldn't create SDK manager\n");
         return ext::nullopt;
@@ -70,12 +78,17 @@ Default(Filesystem const *filesystem)
     for (xcsdk::SDK::Platform::shared_ptr const &platform : sdkManager->platforms()) {
         platforms.insert({ platform->name(), platform->path() });
     }
-    specManager->registerDomains(filesystem, pbxspec::Manager::PlatformDomains(platforms));
+    specManager->registerDomains(filesystem, pbxspec::Manager::PlatformDomains(platforms), cache.get());
 
     /*
      * Register global specifications, but depend on platform-specific specifications.
      */
-    specManager->registerDomains(filesystem, pbxspec::Manager::PlatformDependentDomains(*developerRoot));
+    specManager->registerDomains(filesystem, pbxspec::Manager::PlatformDependentDomains(*developerRoot), cache.get());
+
+    if (cache != nullptr && cache->modified()) {
+        /* Not an error if the cache can't be written. */
+        cache->write(filesystem, *cachePath);
+    }
 
     pbxspec::PBX::BuildSystem::shared_ptr buildSystem = specManager->buildSystem("com.apple.build-system.core", { "default" });
     if (buildSystem == nullptr) {
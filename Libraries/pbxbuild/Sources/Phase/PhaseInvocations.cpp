@@ -26,6 +26,7 @@
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
 namespace Target = pbxbuild::Target;
+namespace Build = pbxbuild::Build;
 
 Phase::PhaseInvocations::
 PhaseInvocations(std::vector<Tool::Invocation> const &invocations) :
@@ -45,15 +46,18 @@ Create(Phase::Environment const &phaseEnvironment, pbxproj::PBX::Target::shared_
     pbxsetting::Environment const &environment = targetEnvironment.environment();
 
     /* Create the tool context for building. */
+    Build::DirectoryTreeCache *directoryTreeCache = phaseEnvironment.buildContext().directoryTreeCache();
     Tool::SearchPaths searchPaths = Tool::SearchPaths::Create(
         targetEnvironment.environment(),
-        targetEnvironment.workingDirectory());
+        targetEnvironment.workingDirectory(),
+        directoryTreeCache);
     Tool::Context toolContext = Tool::Context(
         targetEnvironment.sdk(),
         targetEnvironment.toolchains(),
         targetEnvironment.executablePaths(),
         targetEnvironment.workingDirectory(),
-        searchPaths);
+        searchPaths,
+        directoryTreeCache);
 
     Phase::Context phaseContext(toolContext);
 
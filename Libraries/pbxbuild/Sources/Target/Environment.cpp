@@ -126,7 +126,7 @@ PlatformArchitecturesLevel(pbxspec::Manager::shared_ptr const &specManager, std:
     std::vector<pbxsetting::Setting> architectureSettings;
     std::vector<std::string> platformArchitectures;
 
-    pbxspec::PBX::Architecture::vector architectures = specManager->architectures(specDomains);
+    pbxspec::PBX::Architecture::vector const &architectures = specManager->architectures(specDomains);
     for (pbxspec::PBX::Architecture::shared_ptr const &architecture : architectures) {
         ext::optional<pbxsetting::Setting> architectureSetting = architecture->defaultSetting();
         if (architectureSetting) {
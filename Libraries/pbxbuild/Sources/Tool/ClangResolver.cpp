@@ -24,6 +24,7 @@
 #include <libutil/FSUtil.h>
 
 namespace Tool = pbxbuild::Tool;
+namespace Phase = pbxbuild::Phase;
 using libutil::FSUtil;
 
 Tool::ClangResolver::
@@ -161,7 +162,7 @@ resolvePrecompiledHeader(
     pbxspec::PBX::Tool::shared_ptr tool = std::static_pointer_cast <pbxspec::PBX::Tool> (_compiler);
     Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { input }, { output });
     pbxsetting::Environment const &env = toolEnvironment.environment();
-    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), fileType);
+    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext, fileType);
     Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
 
     std::vector<std::string> arguments = precompiledHeaderInfo.arguments();
@@ -197,101 +198,284 @@ resolvePrecompiledHeader(
     toolContext->invocations().push_back(invocation);
 }
 
-void Tool::ClangResolver::
-resolveSource(
+/*
+ * The parts of a compile invocation that are the same for every file of a type.
+ */
+class Tool::ClangResolver::SourceTemplate {
+public:
+    Tool::Environment                            toolEnvironment;
+    Tool::Invocation::Executable                 executable;
+    std::vector<std::string>                     arguments;
+    size_t                                       dialectOffset;
+    bool                                         precompilePrefixHeader;
+    std::string                                  prefixHeaderFile;
+    std::vector<std::string>                     notUsedInPrecompsArguments;
+    std::vector<std::string>                     dependencyInfoArguments;
+    std::unordered_map<std::string, std::string> environment;
+    std::vector<std::string>                     linkerArgs;
+
+public:
+    SourceTemplate(Tool::Environment const &toolEnvironment, Tool::Invocation::Executable const &executable) :
+        toolEnvironment(toolEnvironment),
+        executable     (executable)
+    {
+    }
+};
+
+static std::shared_ptr<Tool::ClangResolver::SourceTemplate>
+CreateSourceTemplate(
     Tool::Context *toolContext,
-    pbxsetting::Environment const &environment,
-    Phase::File const &input,
-    std::string const &outputDirectory) const
+    pbxspec::PBX::Compiler::shared_ptr const &compiler,
+    Tool::Environment const &toolEnvironment,
+    Tool::OptionsResult const &options,
+    pbxspec::PBX::FileType::shared_ptr const &fileType)
 {
     Tool::HeadermapInfo const &headermapInfo = toolContext->headermapInfo();
+    pbxsetting::Environment const &env = toolEnvironment.environment();
 
-    std::string resolvedOutputDirectory;
-    if (_compiler->outputDir()) {
-        resolvedOutputDirectory = environment.expand(*_compiler->outputDir());
-    } else {
-        resolvedOutputDirectory = outputDirectory;
+    Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
+    std::string prefixHeader = env.resolve("GCC_PREFIX_HEADER");
+    std::string precompilePrefixHeader = env.resolve("GCC_PRECOMPILE_PREFIX_HEADER");
+
+    /*
+     * These are used before instantiation, so can't depend on the file.
+     */
+    if (Tool::Environment::ContainsPlaceholder(tokens.executable()) ||
+        Tool::Environment::ContainsPlaceholder(prefixHeader) ||
+        Tool::Environment::ContainsPlaceholder(precompilePrefixHeader)) {
+        return nullptr;
     }
 
-    std::string outputExtension = _compiler->outputFileExtension().value_or("o");
+    auto executable = Tool::Invocation::Executable::Determine(tokens.executable(), toolContext->executablePaths());
+    auto sourceTemplate = std::make_shared<Tool::ClangResolver::SourceTemplate>(toolEnvironment, executable);
 
-    std::string outputBaseName = FSUtil::GetBaseNameWithoutExtension(input.path());
-    if (!input.fileNameDisambiguator().empty()) {
-        outputBaseName = input.fileNameDisambiguator();
+    AppendDialectFlags(&sourceTemplate->arguments, fileType->GCCDialectName());
+    sourceTemplate->dialectOffset = sourceTemplate->arguments.size();
+
+    sourceTemplate->arguments.insert(sourceTemplate->arguments.end(), tokens.arguments().begin(), tokens.arguments().end());
+    Tool::CompilerCommon::AppendIncludePathFlags(&sourceTemplate->arguments, env, toolContext->searchPaths(), headermapInfo);
+    AppendFrameworkPathFlags(&sourceTemplate->arguments, env, toolContext->searchPaths());
+    AppendCustomFlags(&sourceTemplate->arguments, env, fileType->GCCDialectName());
+
+    sourceTemplate->precompilePrefixHeader = pbxsetting::Type::ParseBoolean(precompilePrefixHeader);
+    if (!prefixHeader.empty()) {
+        sourceTemplate->prefixHeaderFile = FSUtil::ResolveRelativePath(prefixHeader, toolContext->workingDirectory());
     }
-    std::string output = resolvedOutputDirectory + "/" + outputBaseName + "." + outputExtension;
 
-    pbxspec::PBX::FileType::shared_ptr const &fileType = input.fileType();
-    std::vector<std::string> const &inputArguments = input.buildFile()->compilerFlags();
+    AppendNotUsedInPrecompsFlags(&sourceTemplate->notUsedInPrecompsArguments, env);
+    AppendDependencyInfoFlags(&sourceTemplate->dependencyInfoArguments, compiler, env);
 
-    pbxspec::PBX::Tool::shared_ptr tool = std::static_pointer_cast <pbxspec::PBX::Tool> (_compiler);
-    Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { input }, { output });
-    pbxsetting::Environment const &env = toolEnvironment.environment();
+    sourceTemplate->environment = options.environment();
+    sourceTemplate->linkerArgs = options.linkerArgs();
 
-    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), fileType);
-    Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
+    return sourceTemplate;
+}
+
+static bool
+InstantiateAll(std::vector<std::string> *result, std::vector<std::string> const &values, std::unordered_map<std::string, std::string> const &placeholderValues)
+{
+    for (std::string const &value : values) {
+        ext::optional<std::string> instantiated = Tool::Environment::Instantiate(value, placeholderValues);
+        if (!instantiated) {
+            return false;
+        }
+        result->push_back(*instantiated);
+    }
+    return true;
+}
+
+static bool
+InstantiateSource(
+    Tool::Context *toolContext,
+    pbxspec::PBX::Compiler::shared_ptr const &compiler,
+    Tool::ClangResolver::SourceTemplate const &sourceTemplate,
+    std::unordered_map<std::string, std::string> const &placeholderValues,
+    Phase::File const &input,
+    std::string const &output,
+    Tool::Invocation *invocation,
+    std::shared_ptr<Tool::PrecompiledHeaderInfo> *precompiledHeaderInfo,
+    std::vector<std::string> *linkerArgs)
+{
+    Tool::HeadermapInfo const &headermapInfo = toolContext->headermapInfo();
+    pbxsetting::Environment const &env = sourceTemplate.toolEnvironment.environment();
+    pbxspec::PBX::FileType::shared_ptr const &fileType = input.fileType();
+    std::vector<std::string> const &inputArguments = input.buildFile()->compilerFlags();
 
     std::vector<std::string> inputDependencies;
     inputDependencies.insert(inputDependencies.end(), headermapInfo.systemHeadermapFiles().begin(), headermapInfo.systemHeadermapFiles().end());
     inputDependencies.insert(inputDependencies.end(), headermapInfo.userHeadermapFiles().begin(), headermapInfo.userHeadermapFiles().end());
 
     std::vector<std::string> arguments;
-    AppendDialectFlags(&arguments, fileType->GCCDialectName());
-    size_t dialectOffset = arguments.size();
-
-    arguments.insert(arguments.end(), tokens.arguments().begin(), tokens.arguments().end());
-    Tool::CompilerCommon::AppendIncludePathFlags(&arguments, env, toolContext->searchPaths(), headermapInfo);
-    AppendFrameworkPathFlags(&arguments, env, toolContext->searchPaths());
-    AppendCustomFlags(&arguments, env, fileType->GCCDialectName());
+    if (!InstantiateAll(&arguments, sourceTemplate.arguments, placeholderValues)) {
+        return false;
+    }
 
-    bool precompilePrefixHeader = pbxsetting::Type::ParseBoolean(env.resolve("GCC_PRECOMPILE_PREFIX_HEADER"));
-    std::string prefixHeader = env.resolve("GCC_PREFIX_HEADER");
-    std::shared_ptr<Tool::PrecompiledHeaderInfo> precompiledHeaderInfo = nullptr;
+    if (!sourceTemplate.prefixHeaderFile.empty()) {
+        std::string const &prefixHeaderFile = sourceTemplate.prefixHeaderFile;
 
-    if (!prefixHeader.empty()) {
-        std::string prefixHeaderFile = FSUtil::ResolveRelativePath(prefixHeader, toolContext->workingDirectory());
-
-        if (precompilePrefixHeader) {
+        if (sourceTemplate.precompilePrefixHeader) {
             std::vector<std::string> precompiledHeaderArguments;
             AppendDialectFlags(&precompiledHeaderArguments, fileType->GCCDialectName(), "-header");
-            precompiledHeaderArguments.insert(precompiledHeaderArguments.end(), arguments.begin() + dialectOffset, arguments.end());
+            precompiledHeaderArguments.insert(precompiledHeaderArguments.end(), arguments.begin() + sourceTemplate.dialectOffset, arguments.end());
             // Added below, but need to have here in case it affects the precompiled header (as it often does).
             precompiledHeaderArguments.insert(precompiledHeaderArguments.end(), inputArguments.begin(), inputArguments.end());
 
-            precompiledHeaderInfo = std::make_shared<Tool::PrecompiledHeaderInfo>(PrecompiledHeaderInfo::Create(_compiler, prefixHeaderFile, fileType, precompiledHeaderArguments));
-            AppendPrefixHeaderFlags(&arguments, env.expand(precompiledHeaderInfo->logicalOutputPath()));
-            inputDependencies.push_back(env.expand(precompiledHeaderInfo->compileOutputPath()));
+            *precompiledHeaderInfo = std::make_shared<Tool::PrecompiledHeaderInfo>(Tool::PrecompiledHeaderInfo::Create(compiler, prefixHeaderFile, fileType, precompiledHeaderArguments));
+
+            ext::optional<std::string> logicalOutputPath = Tool::Environment::Instantiate(env.expand((*precompiledHeaderInfo)->logicalOutputPath()), placeholderValues);
+            ext::optional<std::string> compileOutputPath = Tool::Environment::Instantiate(env.expand((*precompiledHeaderInfo)->compileOutputPath()), placeholderValues);
+            if (!logicalOutputPath || !compileOutputPath) {
+                return false;
+            }
+
+            AppendPrefixHeaderFlags(&arguments, *logicalOutputPath);
+            inputDependencies.push_back(*compileOutputPath);
         } else {
             AppendPrefixHeaderFlags(&arguments, prefixHeaderFile);
             inputDependencies.push_back(prefixHeaderFile);
         }
     }
 
-    AppendNotUsedInPrecompsFlags(&arguments, env);
+    if (!InstantiateAll(&arguments, sourceTemplate.notUsedInPrecompsArguments, placeholderValues)) {
+        return false;
+    }
     // After all of the configurable settings, so they can override.
     arguments.insert(arguments.end(), inputArguments.begin(), inputArguments.end());
-    AppendDependencyInfoFlags(&arguments, _compiler, env);
-    AppendInputOutputFlags(&arguments, _compiler, input.path(), output);
-
-    std::string logMessage = CompileLogMessage(_compiler, "CompileC", input.path(), fileType, output, env, toolContext->workingDirectory());
+    if (!InstantiateAll(&arguments, sourceTemplate.dependencyInfoArguments, placeholderValues)) {
+        return false;
+    }
+    AppendInputOutputFlags(&arguments, compiler, input.path(), output);
 
     std::vector<Tool::Invocation::DependencyInfo> dependencyInfo;
-    if (_compiler->dependencyInfoFile()) {
+    if (compiler->dependencyInfoFile()) {
+        ext::optional<std::string> dependencyInfoFile = Tool::Environment::Instantiate(env.expand(*compiler->dependencyInfoFile()), placeholderValues);
+        if (!dependencyInfoFile) {
+            return false;
+        }
+
         dependencyInfo.push_back(Tool::Invocation::DependencyInfo(
             dependency::DependencyInfoFormat::Makefile,
-            env.expand(*_compiler->dependencyInfoFile())));
+            *dependencyInfoFile));
+    }
+
+    std::unordered_map<std::string, std::string> environment;
+    for (auto const &entry : sourceTemplate.environment) {
+        ext::optional<std::string> variable = Tool::Environment::Instantiate(entry.first, placeholderValues);
+        ext::optional<std::string> value = Tool::Environment::Instantiate(entry.second, placeholderValues);
+        if (!variable || !value) {
+            return false;
+        }
+        environment.insert({ *variable, *value });
+    }
+
+    if (!InstantiateAll(linkerArgs, sourceTemplate.linkerArgs, placeholderValues)) {
+        return false;
+    }
+
+    std::vector<std::string> inputs;
+    for (std::string const &input : sourceTemplate.toolEnvironment.inputs()) {
+        ext::optional<std::string> path = Tool::Environment::Instantiate(input, placeholderValues);
+        if (!path) {
+            return false;
+        }
+        inputs.push_back(FSUtil::ResolveRelativePath(*path, toolContext->workingDirectory()));
+    }
+
+    std::vector<std::string> outputs;
+    for (std::string const &output : sourceTemplate.toolEnvironment.outputs()) {
+        ext::optional<std::string> path = Tool::Environment::Instantiate(output, placeholderValues);
+        if (!path) {
+            return false;
+        }
+        outputs.push_back(FSUtil::ResolveRelativePath(*path, toolContext->workingDirectory()));
+    }
+
+    std::string logMessage = CompileLogMessage(compiler, "CompileC", input.path(), fileType, output, env, toolContext->workingDirectory());
+
+    invocation->executable() = sourceTemplate.executable;
+    invocation->arguments() = arguments;
+    invocation->environment() = environment;
+    invocation->workingDirectory() = toolContext->workingDirectory();
+    invocation->inputs() = inputs;
+    invocation->outputs() = outputs;
+    invocation->inputDependencies() = inputDependencies;
+    invocation->dependencyInfo() = dependencyInfo;
+    invocation->logMessage() = logMessage;
+    return true;
+}
+
+void Tool::ClangResolver::
+resolveSource(
+    Tool::Context *toolContext,
+    pbxsetting::Environment const &environment,
+    Phase::File const &input,
+    std::string const &outputDirectory) const
+{
+    std::string resolvedOutputDirectory;
+    if (_compiler->outputDir()) {
+        resolvedOutputDirectory = environment.expand(*_compiler->outputDir());
+    } else {
+        resolvedOutputDirectory = outputDirectory;
+    }
+
+    std::string outputExtension = _compiler->outputFileExtension().value_or("o");
+
+    std::string outputBaseName = FSUtil::GetBaseNameWithoutExtension(input.path());
+    if (!input.fileNameDisambiguator().empty()) {
+        outputBaseName = input.fileNameDisambiguator();
+    }
+    std::string output = resolvedOutputDirectory + "/" + outputBaseName + "." + outputExtension;
+
+    pbxspec::PBX::FileType::shared_ptr const &fileType = input.fileType();
+    pbxspec::PBX::Tool::shared_ptr tool = std::static_pointer_cast <pbxspec::PBX::Tool> (_compiler);
+
+    /*
+     * Evaluating the compiler options is the bulk of the work for each file, but
+     * they rarely depend on the file itself. Evaluate them once for each type of
+     * file, then fill in the input and output for each file.
+     */
+    std::shared_ptr<void const> identity = environment.identity();
+    std::string templateKey = std::to_string(reinterpret_cast<uintptr_t>(identity.get())) + '\0' + fileType->identifier() + '\0' + input.localization();
+    auto it = _sourceTemplates.find(templateKey);
+    if (it == _sourceTemplates.end()) {
+        _templateEnvironments.push_back(identity);
+
+        std::shared_ptr<SourceTemplate> sourceTemplate = nullptr;
+        if (ext::optional<Tool::Environment> toolEnvironment = Tool::Environment::CreateTemplate(tool, environment, toolContext->workingDirectory(), input.localization())) {
+            if (ext::optional<Tool::OptionsResult> options = Tool::OptionsResult::CreateTemplate(*toolEnvironment, toolContext, fileType)) {
+                sourceTemplate = CreateSourceTemplate(toolContext, _compiler, *toolEnvironment, *options, fileType);
+            }
+        }
+        it = _sourceTemplates.insert({ templateKey, sourceTemplate }).first;
     }
 
     Tool::Invocation invocation;
-    invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable(), toolContext->executablePaths());
-    invocation.arguments() = arguments;
-    invocation.environment() = options.environment();
-    invocation.workingDirectory() = toolContext->workingDirectory();
-    invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
-    invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
-    invocation.inputDependencies() = inputDependencies;
-    invocation.dependencyInfo() = dependencyInfo;
-    invocation.logMessage() = logMessage;
+    std::shared_ptr<Tool::PrecompiledHeaderInfo> precompiledHeaderInfo = nullptr;
+    std::vector<std::string> linkerArgs;
+
+    bool instantiated = false;
+    if (it->second != nullptr) {
+        std::unordered_map<std::string, std::string> placeholderValues = Tool::Environment::PlaceholderValues(input, output, toolContext->workingDirectory());
+        instantiated = InstantiateSource(toolContext, _compiler, *it->second, placeholderValues, input, output, &invocation, &precompiledHeaderInfo, &linkerArgs);
+        if (!instantiated) {
+            /* A placeholder was modified, so the template can't be used for any file. */
+            it->second = nullptr;
+            precompiledHeaderInfo = nullptr;
+            linkerArgs.clear();
+        }
+    }
+
+    if (!instantiated) {
+        /* Evaluate the options for just this file; there are no placeholders to replace. */
+        Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { input }, { output });
+        Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext, fileType);
+
+        std::shared_ptr<SourceTemplate> sourceTemplate = CreateSourceTemplate(toolContext, _compiler, toolEnvironment, options, fileType);
+        if (sourceTemplate == nullptr || !InstantiateSource(toolContext, _compiler, *sourceTemplate, { }, input, output, &invocation, &precompiledHeaderInfo, &linkerArgs)) {
+            fprintf(stderr, "error: unable to create compile invocation for %s\n", input.path().c_str());
+            return;
+        }
+    }
 
     /* Add the compilation invocation to the context. */
     toolContext->invocations().push_back(invocation);
@@ -325,7 +509,7 @@ resolveSource(
         compilationInfo->linkerDriver() = _compiler->execPath()->raw();
     }
 
-    for (std::string const &linkerArg : options.linkerArgs()) {
+    for (std::string const &linkerArg : linkerArgs) {
         std::vector<std::string> *linkerArguments = &compilationInfo->linkerArguments();
 
         /* Avoid duplicating arguments for multiple compiler invocations. */
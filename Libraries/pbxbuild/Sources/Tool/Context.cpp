@@ -10,6 +10,7 @@
 #include <pbxbuild/Tool/Context.h>
 
 namespace Tool = pbxbuild::Tool;
+namespace Build = pbxbuild::Build;
 
 Tool::Context::
 Context(
@@ -17,12 +18,14 @@ Context(
     xcsdk::SDK::Toolchain::vector const &toolchains,
     std::vector<std::string> const &executablePaths,
     std::string const &workingDirectory,
-    Tool::SearchPaths const &searchPaths) :
-    _sdk             (sdk),
-    _toolchains      (toolchains),
-    _executablePaths (executablePaths),
-    _workingDirectory(workingDirectory),
-    _searchPaths     (searchPaths)
+    Tool::SearchPaths const &searchPaths,
+    Build::DirectoryTreeCache *directoryTreeCache) :
+    _sdk               (sdk),
+    _toolchains        (toolchains),
+    _executablePaths   (executablePaths),
+    _workingDirectory  (workingDirectory),
+    _searchPaths       (searchPaths),
+    _directoryTreeCache(directoryTreeCache)
 {
 }
 
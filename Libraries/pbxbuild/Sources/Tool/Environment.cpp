@@ -10,6 +10,8 @@
 #include <pbxbuild/Tool/Environment.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
+#include <set>
 #include <sstream>
 
 namespace Tool = pbxbuild::Tool;
@@ -263,3 +265,182 @@ Create(
 
     return CreateInternal(tool, environment, workingDirectory, toolInputs, outputs);
 }
+
+/*
+ * Marks the placeholders in a template environment. Placeholders contain a
+ * path separator and an extension so that operations like `:dir` change them.
+ */
+static char const PlaceholderMarker = '\x1d';
+
+static std::string
+Placeholder(std::string const &setting)
+{
+    return PlaceholderMarker + setting + "/" + PlaceholderMarker + "." + PlaceholderMarker;
+}
+
+static std::vector<std::string> const &
+PlaceholderSettings()
+{
+    static std::vector<std::string> const settings = {
+        "Input",
+        "InputPath",
+        "InputFile",
+        "InputFileName",
+        "InputFileBase",
+        "InputFileSuffix",
+        "InputFileRelativePath",
+        "InputFileBaseUniquefier",
+        "InputFileTextEncoding",
+        "Output",
+        "OutputPath",
+        "OutputFile",
+        "OutputDir",
+        "OutputFileName",
+        "OutputFileBase",
+    };
+    return settings;
+}
+
+ext::optional<Tool::Environment> Tool::Environment::
+CreateTemplate(
+    pbxspec::PBX::Tool::shared_ptr const &tool,
+    pbxsetting::Environment const &environment,
+    std::string const &workingDirectory,
+    std::string const &localization)
+{
+    if (tool->outputs() || tool->outputPath()) {
+        return ext::nullopt;
+    }
+
+    std::vector<Tool::Input> inputs = { Tool::Input(Placeholder("InputPath"), localization, Placeholder("InputFileBaseUniquefier")) };
+    std::vector<std::string> outputs = { Placeholder("OutputPath") };
+    Tool::Environment toolEnvironment = CreateInternal(tool, environment, workingDirectory, inputs, outputs);
+
+    /*
+     * Replace the settings derived from the input and output paths as well.
+     */
+    std::vector<pbxsetting::Setting> settings;
+    for (std::string const &setting : PlaceholderSettings()) {
+        settings.push_back(pbxsetting::Setting::Create(setting, Placeholder(setting)));
+    }
+    toolEnvironment._environment.insertFront(pbxsetting::Level(settings), false);
+
+    return toolEnvironment;
+}
+
+std::unordered_map<std::string, std::string> Tool::Environment::
+PlaceholderValues(
+    Phase::File const &input,
+    std::string const &output,
+    std::string const &workingDirectory)
+{
+    pbxsetting::Environment environment;
+    environment.insertFront(InputLevel(Tool::Input(input.path(), input.localization(), input.fileNameDisambiguator()), workingDirectory), false);
+    environment.insertFront(OutputLevel(output), false);
+
+    std::unordered_map<std::string, std::string> values;
+    for (std::string const &setting : PlaceholderSettings()) {
+        values.insert({ setting, environment.resolve(setting) });
+    }
+    return values;
+}
+
+ext::optional<std::string> Tool::Environment::
+Instantiate(
+    std::string const &value,
+    std::unordered_map<std::string, std::string> const &values)
+{
+    std::string result;
+
+    std::string::size_type offset = 0;
+    std::string::size_type start;
+    while ((start = value.find(PlaceholderMarker, offset)) != std::string::npos) {
+        std::string::size_type end = value.find('/', start);
+        if (end == std::string::npos) {
+            return ext::nullopt;
+        }
+
+        auto it = values.find(value.substr(start + 1, end - start - 1));
+        if (it == values.end()) {
+            return ext::nullopt;
+        }
+
+        std::string placeholder = Placeholder(it->first);
+        if (value.compare(start, placeholder.size(), placeholder) != 0) {
+            return ext::nullopt;
+        }
+
+        result.append(value, offset, start - offset);
+        result += it->second;
+        offset = start + placeholder.size();
+    }
+
+    result.append(value, offset, std::string::npos);
+    return result;
+}
+
+bool Tool::Environment::
+ContainsPlaceholder(std::string const &value)
+{
+    return value.find(PlaceholderMarker) != std::string::npos;
+}
+
+static bool
+ChangesPlaceholder(
+    pbxsetting::Value const &value,
+    bool changed,
+    pbxsetting::Environment const &environment,
+    std::unordered_map<std::string, pbxsetting::Value> const &settings,
+    std::set<std::pair<std::string, bool>> *visited)
+{
+    pbxsetting::Value::Program const &program = value.program();
+
+    size_t names = 0;
+    for (pbxsetting::Value::Program::Instruction const &instruction : program.instructions()) {
+        switch (instruction.opcode) {
+            case pbxsetting::Value::Program::Instruction::Literal:
+                break;
+            case pbxsetting::Value::Program::Instruction::Begin:
+                names++;
+                break;
+            case pbxsetting::Value::Program::Instruction::End:
+                names--;
+                break;
+            case pbxsetting::Value::Program::Instruction::Reference: {
+                pbxsetting::Value::Program::Reference const &reference = program.references()[instruction.offset];
+
+                /* Part of a setting name, or with operations applied. */
+                bool referenceChanged = (changed || names > 0 || !reference.operations.empty());
+
+                std::vector<std::string> const &placeholders = PlaceholderSettings();
+                if (std::find(placeholders.begin(), placeholders.end(), reference.setting) != placeholders.end()) {
+                    if (referenceChanged) {
+                        return true;
+                    }
+                    break;
+                }
+
+                if (referenceChanged && Tool::Environment::ContainsPlaceholder(environment.resolve(reference.setting))) {
+                    return true;
+                }
+
+                auto it = settings.find(reference.setting);
+                if (it != settings.end() && visited->insert({ reference.setting, referenceChanged }).second) {
+                    if (ChangesPlaceholder(it->second, referenceChanged, environment, settings, visited)) {
+                        return true;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool Tool::Environment::
+changesPlaceholder(pbxsetting::Value const &value, std::unordered_map<std::string, pbxsetting::Value> const &settings) const
+{
+    std::set<std::pair<std::string, bool>> visited;
+    return ChangesPlaceholder(value, false, _environment, settings, &visited);
+}
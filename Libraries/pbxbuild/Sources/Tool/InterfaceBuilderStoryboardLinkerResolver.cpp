@@ -43,7 +43,7 @@ resolve(
      * Resolve the tool options.
      */
     Tool::Environment toolEnvironment = Tool::Environment::Create(_tool, interfaceBuilderEnvironment, toolContext->workingDirectory(), inputs);
-    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), nullptr);
+    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext, nullptr);
     Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
 
     pbxsetting::Environment const &environment = toolEnvironment.environment();
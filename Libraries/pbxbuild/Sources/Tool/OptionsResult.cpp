@@ -8,6 +8,7 @@
  */
 
 #include <pbxbuild/Tool/OptionsResult.h>
+#include <pbxbuild/Tool/Context.h>
 #include <pbxbuild/Tool/SearchPaths.h>
 #include <pbxbuild/Tool/Environment.h>
 #include <pbxsetting/Type.h>
@@ -17,6 +18,7 @@
 #include <plist/String.h>
 
 namespace Tool = pbxbuild::Tool;
+namespace Build = pbxbuild::Build;
 
 Tool::OptionsResult::
 OptionsResult(std::vector<std::string> const &arguments, std::unordered_map<std::string, std::string> const &environment, std::vector<std::string> const &linkerArgs) :
@@ -32,12 +34,15 @@ Tool::OptionsResult::
 }
 
 static bool
-EvaluateCondition(std::string const &condition, pbxsetting::Environment const &environment)
+EvaluateCondition(std::string const &condition, pbxsetting::Environment const &environment, bool *dependent)
 {
 #define WARN_UNHANDLED_CONDITION 0
 
     // TODO(grp): Evaluate condition expression language correctly.
     std::string expression = environment.expand(pbxsetting::Value::Parse(condition));
+    if (dependent != nullptr && Tool::Environment::ContainsPlaceholder(expression)) {
+        *dependent = true;
+    }
 
     std::string::size_type eq = expression.find(" == ");
     if (eq != std::string::npos) {
@@ -80,13 +85,13 @@ AddOptionArgumentValue(std::vector<std::string> *arguments, pbxsetting::Environm
 }
 
 static void
-AddOptionArgumentValues(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, std::vector<pbxsetting::Value> const &args, pbxspec::PBX::PropertyOption::shared_ptr const &option)
+AddOptionArgumentValues(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, Build::DirectoryTreeCache *directoryTreeCache, std::vector<pbxsetting::Value> const &args, pbxspec::PBX::PropertyOption::shared_ptr const &option)
 {
     if ((option->type() == "StringList" || option->type() == "stringlist") ||
         (option->type() == "PathList" || option->type() == "pathlist")) {
         std::vector<std::string> values = pbxsetting::Type::ParseList(environment.resolve(option->name()));
         if (option->flattenRecursiveSearchPathsInValue()) {
-            values = Tool::SearchPaths::ExpandRecursive(values, environment, workingDirectory);
+            values = Tool::SearchPaths::ExpandRecursive(values, environment, workingDirectory, directoryTreeCache);
         }
 
         for (std::string const &value : values) {
@@ -111,7 +116,7 @@ ArgumentValuesFromArray(plist::Array const *args)
 }
 
 static void
-AddOptionValuesArguments(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, plist::Array const *values, std::string const &value, pbxspec::PBX::PropertyOption::shared_ptr const &option)
+AddOptionValuesArguments(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, Build::DirectoryTreeCache *directoryTreeCache, plist::Array const *values, std::string const &value, pbxspec::PBX::PropertyOption::shared_ptr const &option)
 {
     if (values == nullptr) {
         return;
@@ -128,10 +133,10 @@ AddOptionValuesArguments(std::vector<std::string> *arguments, pbxsetting::Enviro
                 if (entryValue->value() == value) {
                     if (auto entryFlag = entry->value <plist::String> ("CommandLineFlag")) {
                         std::vector<pbxsetting::Value> argsValues = { pbxsetting::Value::Parse(entryFlag->value()) };
-                        AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+                        AddOptionArgumentValues(arguments, environment, workingDirectory, directoryTreeCache, argsValues, option);
                     } else if (auto entryArgs = entry->value <plist::Array> ("CommandLineArgs")) {
                         std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(entryArgs);
-                        AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+                        AddOptionArgumentValues(arguments, environment, workingDirectory, directoryTreeCache, argsValues, option);
                     }
                 }
             }
@@ -140,7 +145,7 @@ AddOptionValuesArguments(std::vector<std::string> *arguments, pbxsetting::Enviro
 }
 
 static void
-AddOptionArgsArguments(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, plist::Object const *argsValue, std::string const &value, pbxspec::PBX::PropertyOption::shared_ptr const &option)
+AddOptionArgsArguments(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, Build::DirectoryTreeCache *directoryTreeCache, plist::Object const *argsValue, std::string const &value, pbxspec::PBX::PropertyOption::shared_ptr const &option)
 {
     /*
      * `CommandLineArgs` and `AdditionalLinkerArgs` are either arrays of arguments or dictionaries
@@ -149,25 +154,27 @@ AddOptionArgsArguments(std::vector<std::string> *arguments, pbxsetting::Environm
 
     if (auto args = plist::CastTo <plist::Array> (argsValue)) {
         std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(args);
-        AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+        AddOptionArgumentValues(arguments, environment, workingDirectory, directoryTreeCache, argsValues, option);
     } else if (auto argsValues = plist::CastTo <plist::Dictionary> (argsValue)) {
         if (auto args = argsValues->value <plist::Array> (value)) {
             std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(args);
-            AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+            AddOptionArgumentValues(arguments, environment, workingDirectory, directoryTreeCache, argsValues, option);
         } else if (auto args = argsValues->value <plist::Array> ("<<otherwise>>")) {
             std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(args);
-            AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+            AddOptionArgumentValues(arguments, environment, workingDirectory, directoryTreeCache, argsValues, option);
         }
     }
 }
 
-Tool::OptionsResult Tool::OptionsResult::
-Create(
+static Tool::OptionsResult
+CreateInternal(
     pbxsetting::Environment const &environment,
     std::string const &workingDirectory,
+    Build::DirectoryTreeCache *directoryTreeCache,
     std::vector<pbxspec::PBX::PropertyOption::shared_ptr> const &options,
     pbxspec::PBX::FileType::shared_ptr const &fileType,
-    std::unordered_set<std::string> const &deletedSettings)
+    std::unordered_set<std::string> const &deletedSettings,
+    bool *dependent)
 {
     std::vector<std::string> arguments;
     std::unordered_map<std::string, std::string> environmentVariables;
@@ -180,10 +187,10 @@ Create(
             continue;
         }
 
-        if (option->condition() && !EvaluateCondition(*option->condition(), environment)) {
+        if (option->condition() && !EvaluateCondition(*option->condition(), environment, dependent)) {
             continue;
         }
-        if (option->commandLineCondition() && !EvaluateCondition(*option->commandLineCondition(), environment)) {
+        if (option->commandLineCondition() && !EvaluateCondition(*option->commandLineCondition(), environment, dependent)) {
             continue;
         }
 
@@ -198,6 +205,13 @@ Create(
         // TODO(grp): Use PropertyOption::conditionFlavors().
         std::string value = environment.resolve(option->name());
 
+        /*
+         * The value is parsed and compared below, which a placeholder can't stand in for.
+         */
+        if (dependent != nullptr && Tool::Environment::ContainsPlaceholder(value)) {
+            *dependent = true;
+        }
+
         if (option->type() == "Boolean" || option->type() == "bool") {
             bool booleanValue = pbxsetting::Type::ParseBoolean(value);
             ext::optional<pbxsetting::Value> const &flag = (booleanValue ? option->commandLineFlag() : option->commandLineFlagIfFalse());
@@ -213,25 +227,25 @@ Create(
 
                     /* Pass both the command line flag and the option value itself. */
                     std::vector<pbxsetting::Value> values = { flag, pbxsetting::Value::Variable("value") };
-                    AddOptionArgumentValues(&arguments, environment, workingDirectory, values, option);
+                    AddOptionArgumentValues(&arguments, environment, workingDirectory, directoryTreeCache, values, option);
                 }
             }
         }
 
-        AddOptionValuesArguments(&arguments, environment, workingDirectory, plist::CastTo<plist::Array>(option->values()), value, option);
-        AddOptionValuesArguments(&arguments, environment, workingDirectory, plist::CastTo<plist::Array>(option->allowedValues()), value, option);
+        AddOptionValuesArguments(&arguments, environment, workingDirectory, directoryTreeCache, plist::CastTo<plist::Array>(option->values()), value, option);
+        AddOptionValuesArguments(&arguments, environment, workingDirectory, directoryTreeCache, plist::CastTo<plist::Array>(option->allowedValues()), value, option);
 
         if (!value.empty()) {
             /* Pass the prefix then the option value in the same argument. */
             if (option->commandLinePrefixFlag()) {
                 pbxsetting::Value const &prefix = *option->commandLinePrefixFlag();
                 pbxsetting::Value prefixValue = prefix + pbxsetting::Value::Variable("value");
-                AddOptionArgumentValues(&arguments, environment, workingDirectory, { prefixValue }, option);
+                AddOptionArgumentValues(&arguments, environment, workingDirectory, directoryTreeCache, { prefixValue }, option);
             }
         }
 
-        AddOptionArgsArguments(&arguments, environment, workingDirectory, option->commandLineArgs(), value, option);
-        AddOptionArgsArguments(&linkerArgs, environment, workingDirectory, option->additionalLinkerArgs(), value, option);
+        AddOptionArgsArguments(&arguments, environment, workingDirectory, directoryTreeCache, option->commandLineArgs(), value, option);
+        AddOptionArgsArguments(&linkerArgs, environment, workingDirectory, directoryTreeCache, option->additionalLinkerArgs(), value, option);
 
         if (option->setValueInEnvironmentVariable()) {
             std::string const &variable = environment.expand(*option->setValueInEnvironmentVariable());
@@ -249,14 +263,127 @@ Create(
 
 Tool::OptionsResult Tool::OptionsResult::
 Create(
-    Tool::Environment const &toolEnvironment,
+    pbxsetting::Environment const &environment,
     std::string const &workingDirectory,
+    std::vector<pbxspec::PBX::PropertyOption::shared_ptr> const &options,
+    pbxspec::PBX::FileType::shared_ptr const &fileType,
+    std::unordered_set<std::string> const &deletedSettings,
+    Build::DirectoryTreeCache *directoryTreeCache)
+{
+    return CreateInternal(environment, workingDirectory, directoryTreeCache, options, fileType, deletedSettings, nullptr);
+}
+
+Tool::OptionsResult Tool::OptionsResult::
+Create(
+    Tool::Environment const &toolEnvironment,
+    Tool::Context const *toolContext,
     pbxspec::PBX::FileType::shared_ptr const &fileType)
 {
     return Create(
         toolEnvironment.environment(),
-        workingDirectory,
+        toolContext->workingDirectory(),
         toolEnvironment.tool()->options().value_or(pbxspec::PBX::PropertyOption::vector()),
         fileType,
-        toolEnvironment.tool()->deletedProperties().value_or(std::unordered_set<std::string>()));
+        toolEnvironment.tool()->deletedProperties().value_or(std::unordered_set<std::string>()),
+        toolContext->directoryTreeCache());
+}
+
+static void
+AppendArgumentValues(std::vector<pbxsetting::Value> *values, plist::Object const *argsValue)
+{
+    if (auto args = plist::CastTo <plist::Array> (argsValue)) {
+        std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(args);
+        values->insert(values->end(), argsValues.begin(), argsValues.end());
+    } else if (auto argsValues = plist::CastTo <plist::Dictionary> (argsValue)) {
+        for (size_t n = 0; n < argsValues->count(); n++) {
+            AppendArgumentValues(values, argsValues->value(n));
+        }
+    }
+}
+
+/*
+ * Every value that could be expanded for an option, whichever way it's used.
+ */
+static std::vector<pbxsetting::Value>
+OptionValues(pbxspec::PBX::PropertyOption::shared_ptr const &option)
+{
+    std::vector<pbxsetting::Value> values = { pbxsetting::Value::Variable(option->name()) };
+
+    if (option->condition()) {
+        values.push_back(pbxsetting::Value::Parse(*option->condition()));
+    }
+    if (option->commandLineCondition()) {
+        values.push_back(pbxsetting::Value::Parse(*option->commandLineCondition()));
+    }
+
+    for (ext::optional<pbxsetting::Value> const &value : { option->commandLineFlag(), option->commandLineFlagIfFalse(), option->commandLinePrefixFlag(), option->setValueInEnvironmentVariable() }) {
+        if (value) {
+            values.push_back(*value);
+        }
+    }
+
+    for (plist::Object const *object : { option->values(), option->allowedValues() }) {
+        if (auto entries = plist::CastTo <plist::Array> (object)) {
+            for (size_t n = 0; n < entries->count(); n++) {
+                if (auto entry = entries->value <plist::Dictionary> (n)) {
+                    if (auto entryFlag = entry->value <plist::String> ("CommandLineFlag")) {
+                        values.push_back(pbxsetting::Value::Parse(entryFlag->value()));
+                    }
+                    AppendArgumentValues(&values, entry->value <plist::Array> ("CommandLineArgs"));
+                }
+            }
+        }
+    }
+
+    AppendArgumentValues(&values, option->commandLineArgs());
+    AppendArgumentValues(&values, option->additionalLinkerArgs());
+
+    return values;
+}
+
+ext::optional<Tool::OptionsResult> Tool::OptionsResult::
+CreateTemplate(
+    Tool::Environment const &toolEnvironment,
+    Tool::Context const *toolContext,
+    pbxspec::PBX::FileType::shared_ptr const &fileType)
+{
+    pbxspec::PBX::PropertyOption::vector const &options = toolEnvironment.tool()->options().value_or(pbxspec::PBX::PropertyOption::vector());
+
+    /*
+     * Operations on placeholders are found before expanding anything, since
+     * they can change a placeholder past recognition. The tool's own settings
+     * are followed, as is `value` in arguments, which is the option's value.
+     */
+    pbxsetting::Level defaultSettings = toolEnvironment.tool()->defaultSettings();
+    std::unordered_map<std::string, pbxsetting::Value> settings;
+    for (pbxsetting::Setting const &setting : defaultSettings.settings()) {
+        settings.insert({ setting.name(), setting.value() });
+    }
+
+    for (pbxspec::PBX::PropertyOption::shared_ptr const &option : options) {
+        settings.erase("value");
+        settings.insert({ "value", pbxsetting::Value::Variable(option->name()) });
+
+        for (pbxsetting::Value const &value : OptionValues(option)) {
+            if (toolEnvironment.changesPlaceholder(value, settings)) {
+                return ext::nullopt;
+            }
+        }
+    }
+
+    bool dependent = false;
+    Tool::OptionsResult result = CreateInternal(
+        toolEnvironment.environment(),
+        toolContext->workingDirectory(),
+        toolContext->directoryTreeCache(),
+        options,
+        fileType,
+        toolEnvironment.tool()->deletedProperties().value_or(std::unordered_set<std::string>()),
+        &dependent);
+
+    if (dependent) {
+        return ext::nullopt;
+    }
+
+    return result;
 }
@@ -14,6 +14,7 @@
 #include <libutil/FSUtil.h>
 
 namespace Tool = pbxbuild::Tool;
+namespace Build = pbxbuild::Build;
 using libutil::FSUtil;
 
 Tool::SearchPaths::
@@ -29,41 +30,61 @@ SearchPaths(
 {
 }
 
-static void
-AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &environment, std::string const &workingDirectory, std::vector<std::string> const &paths)
+static std::string
+SDKPath(pbxsetting::Environment const &environment, std::string const &path)
 {
-    for (std::string path : paths) {
-        // TODO(grp): Is this the right place to insert the SDKROOT? Should all path lists have this, or just *_SEARCH_PATHS?
-        std::string const system = "/System";
-        std::string const usr    = "/usr";
-        if ((path.size() >= system.size() && path.compare(0, system.size(), system) == 0) ||
-            (path.size() >=    usr.size() && path.compare(0,    usr.size(),    usr) == 0)) {
-            std::string sdkPath = FSUtil::NormalizePath(environment.resolve("SDKROOT") + path);
-
-            // TODO(grp): Testing if the directory exists seems fragile.
-            if (FSUtil::TestForDirectory(sdkPath)) {
-                path = sdkPath;
-            }
+    // TODO(grp): Is this the right place to insert the SDKROOT? Should all path lists have this, or just *_SEARCH_PATHS?
+    std::string const system = "/System";
+    std::string const usr    = "/usr";
+    if ((path.size() >= system.size() && path.compare(0, system.size(), system) == 0) ||
+        (path.size() >=    usr.size() && path.compare(0,    usr.size(),    usr) == 0)) {
+        std::string sdkPath = FSUtil::NormalizePath(environment.resolve("SDKROOT") + path);
+
+        // TODO(grp): Testing if the directory exists seems fragile.
+        if (FSUtil::TestForDirectory(sdkPath)) {
+            return sdkPath;
         }
+    }
+
+    return path;
+}
+
+static bool
+RecursiveRoot(std::string const &path, std::string *root)
+{
+    std::string recursive = "**";
+    if (path.size() >= recursive.size() && path.substr(path.size() - recursive.size()) == recursive) {
+        *root = path.substr(0, path.size() - recursive.size());
+        return true;
+    }
+
+    return false;
+}
+
+static void
+AppendPaths(
+    std::vector<std::string> *args,
+    pbxsetting::Environment const &environment,
+    std::string const &workingDirectory,
+    Build::DirectoryTreeCache *directoryTreeCache,
+    Build::DirectoryTreeCache::Filter const &filter,
+    std::vector<std::string> const &paths)
+{
+    for (std::string const &entry : paths) {
+        std::string path = SDKPath(environment, entry);
 
-        std::string recursive = "**";
-        if (path.size() >= recursive.size() && path.substr(path.size() - recursive.size()) == recursive) {
-            std::string root = path.substr(0, path.size() - recursive.size());
+        std::string root;
+        if (RecursiveRoot(path, &root)) {
             args->push_back(root);
 
             std::string absoluteRoot = FSUtil::ResolveRelativePath(root, workingDirectory);
-            FSUtil::EnumerateRecursive(absoluteRoot, [&](std::string const &path) -> bool {
-                // TODO(grp): Use build settings for included and excluded recursive paths.
-                // Included: INCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES
-                // Excluded: EXCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES
-                // Follow: RECURSIVE_SEARCH_PATHS_FOLLOW_SYMLINKS
-
-                if (FSUtil::TestForDirectory(path)) {
-                    std::string relativePath = root + "/" + path.substr(absoluteRoot.size() + 1);
-                    args->push_back(relativePath);
-                }
-                return true;
-            });
+            Build::DirectoryTreeCache::Directories directories = (directoryTreeCache != nullptr ?
+                directoryTreeCache->directories(absoluteRoot, filter) :
+                Build::DirectoryTreeCache::Walk(absoluteRoot, filter));
+
+            for (std::string const &directory : *directories) {
+                args->push_back(root + "/" + directory);
+            }
         } else {
             args->push_back(path);
         }
@@ -71,29 +92,64 @@ AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &envir
 }
 
 std::vector<std::string> Tool::SearchPaths::
-ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory)
+ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory, Build::DirectoryTreeCache *directoryTreeCache)
 {
+    Build::DirectoryTreeCache::Filter filter = Build::DirectoryTreeCache::Filter::Create(environment);
+
     std::vector<std::string> result;
-    AppendPaths(&result, environment, workingDirectory, paths);
+    AppendPaths(&result, environment, workingDirectory, directoryTreeCache, filter, paths);
     return result;
 }
 
 Tool::SearchPaths Tool::SearchPaths::
-Create(pbxsetting::Environment const &environment, std::string const &workingDirectory)
+Create(pbxsetting::Environment const &environment, std::string const &workingDirectory, Build::DirectoryTreeCache *directoryTreeCache)
 {
+    Build::DirectoryTreeCache::Filter filter = Build::DirectoryTreeCache::Filter::Create(environment);
+
+    std::vector<std::string> productTypeHeaderSearchPaths = pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_HEADER_SEARCH_PATHS"));
+    std::vector<std::string> headerSearchPathsSetting = pbxsetting::Type::ParseList(environment.resolve("HEADER_SEARCH_PATHS"));
+    std::vector<std::string> userHeaderSearchPathsSetting = pbxsetting::Type::ParseList(environment.resolve("USER_HEADER_SEARCH_PATHS"));
+    std::vector<std::string> frameworkSearchPathsSetting = pbxsetting::Type::ParseList(environment.resolve("FRAMEWORK_SEARCH_PATHS"));
+    std::vector<std::string> productTypeFrameworkSearchPaths = pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_FRAMEWORK_SEARCH_PATHS"));
+    std::vector<std::string> librarySearchPathsSetting = pbxsetting::Type::ParseList(environment.resolve("LIBRARY_SEARCH_PATHS"));
+
+    /*
+     * Walk all of the recursive roots at once, since they are often separate trees.
+     */
+    if (directoryTreeCache != nullptr) {
+        std::vector<std::string> roots;
+        for (std::vector<std::string> const *paths : {
+            &productTypeHeaderSearchPaths,
+            &headerSearchPathsSetting,
+            &userHeaderSearchPathsSetting,
+            &frameworkSearchPathsSetting,
+            &productTypeFrameworkSearchPaths,
+            &librarySearchPathsSetting,
+        }) {
+            for (std::string const &path : *paths) {
+                std::string root;
+                if (RecursiveRoot(SDKPath(environment, path), &root)) {
+                    roots.push_back(FSUtil::ResolveRelativePath(root, workingDirectory));
+                }
+            }
+        }
+
+        directoryTreeCache->prefetch(roots, filter);
+    }
+
     std::vector<std::string> headerSearchPaths;
-    AppendPaths(&headerSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_HEADER_SEARCH_PATHS")));
-    AppendPaths(&headerSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("HEADER_SEARCH_PATHS")));
+    AppendPaths(&headerSearchPaths, environment, workingDirectory, directoryTreeCache, filter, productTypeHeaderSearchPaths);
+    AppendPaths(&headerSearchPaths, environment, workingDirectory, directoryTreeCache, filter, headerSearchPathsSetting);
 
     std::vector<std::string> userHeaderSearchPaths;
-    AppendPaths(&userHeaderSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("USER_HEADER_SEARCH_PATHS")));
+    AppendPaths(&userHeaderSearchPaths, environment, workingDirectory, directoryTreeCache, filter, userHeaderSearchPathsSetting);
 
     std::vector<std::string> frameworkSearchPaths;
-    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("FRAMEWORK_SEARCH_PATHS")));
-    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_FRAMEWORK_SEARCH_PATHS")));
+    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, directoryTreeCache, filter, frameworkSearchPathsSetting);
+    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, directoryTreeCache, filter, productTypeFrameworkSearchPaths);
 
     std::vector<std::string> librarySearchPaths;
-    AppendPaths(&librarySearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("LIBRARY_SEARCH_PATHS")));
+    AppendPaths(&librarySearchPaths, environment, workingDirectory, directoryTreeCache, filter, librarySearchPathsSetting);
 
     return Tool::SearchPaths(headerSearchPaths, userHeaderSearchPaths, frameworkSearchPaths, librarySearchPaths);
 }
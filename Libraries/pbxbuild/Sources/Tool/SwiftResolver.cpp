@@ -243,7 +243,7 @@ resolve(
      * Resolve the tool options.
      */
     Tool::Environment toolEnvironment = Tool::Environment::Create(_compiler, baseEnvironment, toolContext->workingDirectory(), inputs);
-    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), nullptr);
+    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext, nullptr);
     Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
 
     pbxsetting::Environment const &environment = toolEnvironment.environment();
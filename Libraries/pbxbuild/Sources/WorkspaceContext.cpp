@@ -12,6 +12,12 @@
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+
 using pbxbuild::WorkspaceContext;
 using pbxbuild::DerivedDataHash;
 using libutil::Filesystem;
@@ -126,66 +132,140 @@ IterateWorkspaceFiles(xcworkspace::XC::Workspace::shared_ptr const &workspace, s
     }
 }
 
+/*
+ * Calls a function for each index, spread across threads. Callers write
+ * results to each index's own slot, so the result doesn't depend on the
+ * order the threads run in.
+ */
 static void
-LoadWorkspaceProjects(Filesystem const *filesystem, std::vector<pbxproj::PBX::Project::shared_ptr> *projects, xcworkspace::XC::Workspace::shared_ptr const &workspace)
+ParallelForEach(size_t count, std::function<void(size_t)> const &function)
 {
-    /*
-     * Load all the projects in the workspace.
-     */
-    IterateWorkspaceFiles(workspace, [&](xcworkspace::XC::FileRef::shared_ptr const &ref) {
-        std::string path = ref->resolve(workspace);
+    size_t jobs = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    if (jobs <= 1) {
+        for (size_t n = 0; n < count; n++) {
+            function(n);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = ATOMIC_VAR_INIT(0);
+
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < jobs; n++) {
+        threads.push_back(std::thread([&]() {
+            for (size_t index = next++; index < count; index = next++) {
+                function(index);
+            }
+        }));
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
 
-        pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, path);
-        if (project != nullptr) {
-            projects->push_back(project);
+/*
+ * Loads projects that have not been loaded yet, in parallel. Projects are
+ * appended in the order of their paths, skipping failures and duplicates:
+ * paths already requested, or that resolve to an already loaded project.
+ */
+static std::vector<pbxproj::PBX::Project::shared_ptr>
+LoadProjects(
+    Filesystem const *filesystem,
+    std::vector<std::string> const &paths,
+    std::unordered_set<std::string> *requestedPaths,
+    std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
+    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> *projectsMap)
+{
+    std::vector<std::string> unrequestedPaths;
+    for (std::string const &path : paths) {
+        if (requestedPaths->insert(FSUtil::NormalizePath(path)).second) {
+            unrequestedPaths.push_back(path);
         }
+    }
+
+    std::vector<pbxproj::PBX::Project::shared_ptr> loaded = std::vector<pbxproj::PBX::Project::shared_ptr>(unrequestedPaths.size());
+    ParallelForEach(unrequestedPaths.size(), [&](size_t index) {
+        loaded[index] = pbxproj::PBX::Project::Open(filesystem, unrequestedPaths[index]);
     });
+
+    std::vector<pbxproj::PBX::Project::shared_ptr> added;
+    for (pbxproj::PBX::Project::shared_ptr const &project : loaded) {
+        if (project == nullptr) {
+            continue;
+        }
+
+        /* Normalize path so it can be found on lookup. */
+        std::string normalizedPath = FSUtil::NormalizePath(project->projectFile());
+        if (projectsMap->insert({ normalizedPath, project }).second) {
+            added.push_back(project);
+        }
+    }
+
+    projects->insert(projects->end(), added.begin(), added.end());
+    return added;
 }
 
 static void
-LoadNestedProjects(Filesystem const *filesystem, std::vector<pbxproj::PBX::Project::shared_ptr> *projects, pbxsetting::Environment const &baseEnvironment, std::vector<pbxproj::PBX::Project::shared_ptr> const &rootProjects)
+LoadWorkspaceProjects(
+    Filesystem const *filesystem,
+    std::unordered_set<std::string> *requestedPaths,
+    std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
+    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> *projectsMap,
+    xcworkspace::XC::Workspace::shared_ptr const &workspace)
 {
-    std::vector<pbxproj::PBX::Project::shared_ptr> nestedProjects;
+    /*
+     * Find all the projects in the workspace.
+     */
+    std::vector<std::string> paths;
+    IterateWorkspaceFiles(workspace, [&](xcworkspace::XC::FileRef::shared_ptr const &ref) {
+        paths.push_back(ref->resolve(workspace));
+    });
 
     /*
-     * Load all nested projects recursively.
+     * Load them together.
+     */
+    LoadProjects(filesystem, paths, requestedPaths, projects, projectsMap);
+}
+
+static void
+LoadNestedProjects(
+    Filesystem const *filesystem,
+    std::unordered_set<std::string> *requestedPaths,
+    std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
+    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> *projectsMap,
+    pbxsetting::Environment const &baseEnvironment,
+    std::vector<pbxproj::PBX::Project::shared_ptr> const &rootProjects)
+{
+    /*
+     * Load nested projects one level at a time, so each level loads in
+     * parallel but projects are added in the same order as loading them
+     * one by one. Projects already loaded are skipped, so references that
+     * form a cycle stop.
      */
-    for (pbxproj::PBX::Project::shared_ptr const &project : rootProjects) {
-        /*
-         * Determine the settings environment to find the project paths. This may not be complete,
-         * but it's unclear exactly what settings are available here. Notably, we don't yet know what
-         * the configuration or what target to use, so just the project settings seems reasonable.
-         */
-        pbxsetting::Environment environment = baseEnvironment;
-        environment.insertFront(project->settings(), false);
-
-        /*
-         * Find the nested projects.
-         */
-        for (pbxproj::PBX::Project::ProjectReference const &projectReference : project->projectReferences()) {
-            pbxproj::PBX::FileReference::shared_ptr const &projectFileReference = projectReference.projectReference();
-            std::string projectPath = environment.expand(projectFileReference->resolve());
+    std::vector<pbxproj::PBX::Project::shared_ptr> level = rootProjects;
+    while (!level.empty()) {
+        std::vector<std::string> paths;
+
+        for (pbxproj::PBX::Project::shared_ptr const &project : level) {
+            /*
+             * Determine the settings environment to find the project paths. This may not be complete,
+             * but it's unclear exactly what settings are available here. Notably, we don't yet know what
+             * the configuration or what target to use, so just the project settings seems reasonable.
+             */
+            pbxsetting::Environment environment = baseEnvironment;
+            environment.insertFront(project->settings(), false);
 
             /*
-             * Load the project.
+             * Find the nested projects.
              */
-            pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, projectPath);
-            if (project != nullptr) {
-                nestedProjects.push_back(project);
+            for (pbxproj::PBX::Project::ProjectReference const &projectReference : project->projectReferences()) {
+                pbxproj::PBX::FileReference::shared_ptr const &projectFileReference = projectReference.projectReference();
+                paths.push_back(environment.expand(projectFileReference->resolve()));
             }
         }
-    }
-
-    /*
-     * Append the nested projects. This has to be after the loop as `rootProjects` might alias `projects`.
-     */
-    projects->insert(projects->end(), nestedProjects.begin(), nestedProjects.end());
 
-    if (!nestedProjects.empty()) {
-        /*
-         * Load nested projects of the nested projects.
-         */
-        LoadNestedProjects(filesystem, projects, baseEnvironment, nestedProjects);
+        level = LoadProjects(filesystem, paths, requestedPaths, projects, projectsMap);
     }
 }
 
@@ -193,34 +273,27 @@ static void
 LoadProjectSchemes(Filesystem const *filesystem, std::vector<xcscheme::SchemeGroup::shared_ptr> *schemeGroups, std::vector<pbxproj::PBX::Project::shared_ptr> const &projects)
 {
     /*
-     * Load the schemes inside the projects.
+     * Load the schemes inside the projects, in parallel.
      */
-    for (pbxproj::PBX::Project::shared_ptr const &project : projects) {
-        xcscheme::SchemeGroup::shared_ptr projectGroup = xcscheme::SchemeGroup::Open(filesystem, project->basePath(), project->projectFile(), project->name());
+    std::vector<xcscheme::SchemeGroup::shared_ptr> projectGroups = std::vector<xcscheme::SchemeGroup::shared_ptr>(projects.size());
+    ParallelForEach(projects.size(), [&](size_t index) {
+        pbxproj::PBX::Project::shared_ptr const &project = projects[index];
+        projectGroups[index] = xcscheme::SchemeGroup::Open(filesystem, project->basePath(), project->projectFile(), project->name());
+    });
+
+    for (xcscheme::SchemeGroup::shared_ptr const &projectGroup : projectGroups) {
         if (projectGroup != nullptr) {
             schemeGroups->push_back(projectGroup);
         }
     }
 }
 
-static std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr>
-CreateProjectMap(std::vector<pbxproj::PBX::Project::shared_ptr> const &projects)
-{
-    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> projectsMap;
-
-    for (pbxproj::PBX::Project::shared_ptr const &project : projects) {
-        /* Normalize path so it can be found on lookup. */
-        std::string normalizedPath = FSUtil::NormalizePath(project->projectFile());
-        projectsMap.insert({ normalizedPath, project });
-    }
-
-    return projectsMap;
-}
-
 WorkspaceContext WorkspaceContext::
 Workspace(Filesystem const *filesystem, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace)
 {
+    std::unordered_set<std::string> requestedPaths;
     std::vector<pbxproj::PBX::Project::shared_ptr> projects;
+    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> projectsMap;
     std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
 
     /*
@@ -234,12 +307,12 @@ Workspace(Filesystem const *filesystem, pbxsetting::Environment const &baseEnvir
     /*
      * Load projects within the workspace.
      */
-    LoadWorkspaceProjects(filesystem, &projects, workspace);
+    LoadWorkspaceProjects(filesystem, &requestedPaths, &projects, &projectsMap, workspace);
 
     /*
      * Recursively load nested projects within those projects.
      */
-    LoadNestedProjects(filesystem, &projects, baseEnvironment, projects);
+    LoadNestedProjects(filesystem, &requestedPaths, &projects, &projectsMap, baseEnvironment, projects);
 
     /*
      * Load schemes for all projects, including nested projects.
@@ -251,24 +324,29 @@ Workspace(Filesystem const *filesystem, pbxsetting::Environment const &baseEnvir
      */
     DerivedDataHash derivedDataHash = DerivedDataHash::Create(workspace->projectFile());
 
-    return WorkspaceContext(workspace->basePath(), derivedDataHash, workspace, nullptr, schemeGroups, CreateProjectMap(projects));
+    return WorkspaceContext(workspace->basePath(), derivedDataHash, workspace, nullptr, schemeGroups, projectsMap);
 }
 
 WorkspaceContext WorkspaceContext::
 Project(Filesystem const *filesystem, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project)
 {
+    std::unordered_set<std::string> requestedPaths;
     std::vector<pbxproj::PBX::Project::shared_ptr> projects;
+    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> projectsMap;
     std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
 
     /*
      * The root is a project, so it should be in the projects list.
      */
+    std::string normalizedPath = FSUtil::NormalizePath(project->projectFile());
+    requestedPaths.insert(normalizedPath);
     projects.push_back(project);
+    projectsMap.insert({ normalizedPath, project });
 
     /*
      * Recursively load nested projects within the project.
      */
-    LoadNestedProjects(filesystem, &projects, baseEnvironment, projects);
+    LoadNestedProjects(filesystem, &requestedPaths, &projects, &projectsMap, baseEnvironment, projects);
 
     /*
      * Load schemes for all projects, including the root and nested projects.
@@ -280,5 +358,5 @@ Project(Filesystem const *filesystem, pbxsetting::Environment const &baseEnviron
      */
     DerivedDataHash derivedDataHash = DerivedDataHash::Create(project->projectFile());
 
-    return WorkspaceContext(project->basePath(), derivedDataHash, nullptr, project, schemeGroups, CreateProjectMap(projects));
+    return WorkspaceContext(project->basePath(), derivedDataHash, nullptr, project, schemeGroups, projectsMap);
 }
@@ -0,0 +1,168 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Build/DirectoryTreeCache.h>
+#include <libutil/test/TemporaryDirectory.h>
+
+#include <algorithm>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Build = pbxbuild::Build;
+using libutil::test::TemporaryDirectory;
+
+/*
+ * Creates a directory tree in a directory:
+ *
+ *   a/
+ *   a/b/
+ *   a/b.lproj/
+ *   a/b.lproj/c/
+ *   d/
+ *   d/link -> ../a
+ *   file
+ */
+static void
+CreateTree(std::string const &root)
+{
+    for (char const *directory : { "/a", "/a/b", "/a/b.lproj", "/a/b.lproj/c", "/d" }) {
+        EXPECT_EQ(0, ::mkdir((root + directory).c_str(), 0755));
+    }
+    EXPECT_EQ(0, ::symlink("../a", (root + "/d/link").c_str()));
+    EXPECT_EQ(0, ::close(::creat((root + "/file").c_str(), 0644)));
+}
+
+static std::vector<std::string>
+Sorted(Build::DirectoryTreeCache::Directories const &directories)
+{
+    std::vector<std::string> sorted = *directories;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+TEST(DirectoryTreeCache, Walk)
+{
+    TemporaryDirectory temporary("test_DirectoryTreeCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateTree(root);
+
+    auto all = Build::DirectoryTreeCache::Filter({ }, { }, false);
+    EXPECT_EQ(std::vector<std::string>({ "a", "a/b", "a/b.lproj", "a/b.lproj/c", "d", "d/link" }), Sorted(Build::DirectoryTreeCache::Walk(root, all)));
+
+    auto follow = Build::DirectoryTreeCache::Filter({ }, { }, true);
+    EXPECT_EQ(std::vector<std::string>({ "a", "a/b", "a/b.lproj", "a/b.lproj/c", "d", "d/link", "d/link/b", "d/link/b.lproj", "d/link/b.lproj/c" }), Sorted(Build::DirectoryTreeCache::Walk(root, follow)));
+}
+
+TEST(DirectoryTreeCache, Excluded)
+{
+    TemporaryDirectory temporary("test_DirectoryTreeCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateTree(root);
+
+    auto excluded = Build::DirectoryTreeCache::Filter({ }, { "*.lproj", "d" }, false);
+    EXPECT_EQ(std::vector<std::string>({ "a", "a/b" }), Sorted(Build::DirectoryTreeCache::Walk(root, excluded)));
+
+    auto included = Build::DirectoryTreeCache::Filter({ "b.lproj" }, { "*.lproj", "d" }, false);
+    EXPECT_EQ(std::vector<std::string>({ "a", "a/b", "a/b.lproj", "a/b.lproj/c" }), Sorted(Build::DirectoryTreeCache::Walk(root, included)));
+}
+
+TEST(DirectoryTreeCache, Cached)
+{
+    TemporaryDirectory temporary("test_DirectoryTreeCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateTree(root);
+
+    auto filter = Build::DirectoryTreeCache::Filter({ }, { "*.lproj" }, false);
+    auto other = Build::DirectoryTreeCache::Filter({ }, { }, false);
+
+    Build::DirectoryTreeCache cache;
+    cache.prefetch({ root, root + "/a" }, filter);
+
+    /* Both roots were walked; the same filter returns the same result. */
+    auto directories = cache.directories(root, filter);
+    EXPECT_EQ(directories, cache.directories(root, filter));
+    EXPECT_EQ(std::vector<std::string>({ "b" }), Sorted(cache.directories(root + "/a", filter)));
+
+    /* A different filter is a separate tree. */
+    EXPECT_NE(directories, cache.directories(root, other));
+    EXPECT_EQ(6u, cache.directories(root, other)->size());
+}
+
+TEST(DirectoryTreeCache, Invalidate)
+{
+    TemporaryDirectory temporary("test_DirectoryTreeCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateTree(root);
+
+    auto filter = Build::DirectoryTreeCache::Filter({ }, { "*.lproj", "d" }, false);
+
+    Build::DirectoryTreeCache cache;
+    EXPECT_EQ(std::vector<std::string>({ "a", "a/b" }), Sorted(cache.directories(root, filter)));
+    EXPECT_EQ(std::vector<std::string>({ "b" }), Sorted(cache.directories(root + "/a", filter)));
+    EXPECT_EQ(std::vector<std::string>({ "link" }), Sorted(cache.directories(root + "/d", filter)));
+
+    /* A directory created after the walk is only seen once invalidated. */
+    EXPECT_EQ(0, ::mkdir((root + "/a/e").c_str(), 0755));
+    EXPECT_EQ(std::vector<std::string>({ "a", "a/b" }), Sorted(cache.directories(root, filter)));
+
+    /* Only the trees containing the new directory are walked again. */
+    cache.invalidate({ root + "/a/e" });
+    EXPECT_EQ(1u, cache.roots().size());
+    EXPECT_EQ(root + "/d", cache.roots().front().first);
+    EXPECT_EQ(std::vector<std::string>({ "a", "a/b", "a/e" }), Sorted(cache.directories(root, filter)));
+    EXPECT_EQ(std::vector<std::string>({ "b", "e" }), Sorted(cache.directories(root + "/a", filter)));
+
+    /* As are trees below a new directory. */
+    cache.invalidate({ root + "/" });
+    EXPECT_TRUE(cache.roots().empty());
+
+    /* A path that only shares a prefix with a root is outside its tree. */
+    cache.directories(root + "/a", filter);
+    cache.invalidate({ root + "/ab" });
+    EXPECT_EQ(1u, cache.roots().size());
+}
+
+TEST(DirectoryTreeCache, ConcurrentPrefetch)
+{
+    TemporaryDirectory temporary("test_DirectoryTreeCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateTree(root);
+
+    auto filter = Build::DirectoryTreeCache::Filter({ }, { }, false);
+
+    /* Prefetches at once share helpers, with each caller walking as well. */
+    Build::DirectoryTreeCache cache;
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < 8; n++) {
+        threads.push_back(std::thread([&] {
+            cache.prefetch({ root, root + "/a", root + "/a/b.lproj", root + "/d" }, filter);
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(4u, cache.roots().size());
+    EXPECT_EQ(Sorted(Build::DirectoryTreeCache::Walk(root, filter)), Sorted(cache.directories(root, filter)));
+    EXPECT_EQ(std::vector<std::string>({ "b", "b.lproj", "b.lproj/c" }), Sorted(cache.directories(root + "/a", filter)));
+
+    /* Prefetching after the others finished walks the trees again. */
+    cache.invalidate({ root });
+    cache.prefetch({ root, root + "/a" }, filter);
+    EXPECT_EQ(2u, cache.roots().size());
+}
@@ -0,0 +1,236 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxproj/PBX/Project.h>
+#include <pbxproj/PBX/BaseGroup.h>
+#include <pbxproj/PBX/BuildFile.h>
+#include <pbxproj/PBX/BuildPhase.h>
+#include <pbxproj/PBX/Target.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <thread>
+
+using libutil::MemoryFilesystem;
+
+/*
+ * A project with a target building files from a nested group:
+ *
+ *   G (main group)
+ *     S (Sources)
+ *       F1 main.c
+ *       F2 util.c
+ *       V Localizable.strings
+ *         F3 en.lproj/Localizable.strings
+ *     F0 README
+ *
+ * The target's sources phase builds util.c then main.c, and its resources
+ * phase copies the strings.
+ */
+static MemoryFilesystem
+ProjectFilesystem()
+{
+    std::string contents = "{ \
+        archiveVersion = 1; \
+        objectVersion = 46; \
+        objects = { \
+            P = { isa = PBXProject; mainGroup = G; targets = (T); }; \
+            G = { isa = PBXGroup; children = (S, F0); sourceTree = \"<group>\"; }; \
+            S = { isa = PBXGroup; children = (F1, F2, V); path = Sources; sourceTree = \"<group>\"; }; \
+            F0 = { isa = PBXFileReference; path = README; sourceTree = \"<group>\"; }; \
+            F1 = { isa = PBXFileReference; path = main.c; sourceTree = \"<group>\"; }; \
+            F2 = { isa = PBXFileReference; path = util.c; sourceTree = \"<group>\"; }; \
+            V = { isa = PBXVariantGroup; children = (F3); name = Localizable.strings; sourceTree = \"<group>\"; }; \
+            F3 = { isa = PBXFileReference; name = en; path = en.lproj/Localizable.strings; sourceTree = \"<group>\"; }; \
+            T = { isa = PBXNativeTarget; name = App; buildPhases = (SP, RP); buildRules = (); dependencies = (); }; \
+            SP = { isa = PBXSourcesBuildPhase; files = (B1, B2); }; \
+            RP = { isa = PBXResourcesBuildPhase; files = (B3); }; \
+            B1 = { isa = PBXBuildFile; fileRef = F2; }; \
+            B2 = { isa = PBXBuildFile; fileRef = F1; }; \
+            B3 = { isa = PBXBuildFile; fileRef = V; }; \
+        }; \
+        rootObject = P; \
+    }";
+
+    return MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Project.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", std::vector<uint8_t>(contents.begin(), contents.end())),
+        }),
+    });
+}
+
+static pbxproj::PBX::BaseGroup::shared_ptr
+AsGroup(pbxproj::PBX::GroupItem::shared_ptr const &item)
+{
+    if (item == nullptr || (item->type() != pbxproj::PBX::GroupItem::Type::Group && item->type() != pbxproj::PBX::GroupItem::Type::VariantGroup)) {
+        return nullptr;
+    }
+
+    return std::static_pointer_cast<pbxproj::PBX::BaseGroup>(item);
+}
+
+static std::vector<std::string>
+Names(pbxproj::PBX::GroupItem::vector const &items)
+{
+    std::vector<std::string> names;
+    for (pbxproj::PBX::GroupItem::shared_ptr const &item : items) {
+        names.push_back(item->name());
+    }
+    return names;
+}
+
+/*
+ * The items built by each of the target's build phases.
+ */
+static std::vector<pbxproj::PBX::GroupItem::vector>
+BuildPhaseItems(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    std::vector<pbxproj::PBX::GroupItem::vector> items;
+    for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : target->buildPhases()) {
+        pbxproj::PBX::GroupItem::vector phaseItems;
+        for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildPhase->files()) {
+            phaseItems.push_back(buildFile->fileRef());
+        }
+        items.push_back(phaseItems);
+    }
+    return items;
+}
+
+TEST(LazyProject, ChildrenAndBuildPhases)
+{
+    auto filesystem = ProjectFilesystem();
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/Project.xcodeproj");
+    ASSERT_NE(nullptr, project);
+    ASSERT_EQ(1, project->targets().size());
+
+    pbxproj::PBX::Group::shared_ptr const &mainGroup = project->mainGroup();
+    ASSERT_NE(nullptr, mainGroup);
+    EXPECT_EQ(std::vector<std::string>({ "Sources", "README" }), Names(mainGroup->children()));
+
+    pbxproj::PBX::BaseGroup::shared_ptr sources = AsGroup(mainGroup->children().front());
+    ASSERT_NE(nullptr, sources);
+    EXPECT_EQ(std::vector<std::string>({ "main.c", "util.c", "Localizable.strings" }), Names(sources->children()));
+
+    pbxproj::PBX::BaseGroup::shared_ptr strings = AsGroup(sources->children().back());
+    ASSERT_NE(nullptr, strings);
+    EXPECT_EQ(std::vector<std::string>({ "en" }), Names(strings->children()));
+
+    /* Parsed once; later calls return the same objects. */
+    EXPECT_EQ(&mainGroup->children(), &project->mainGroup()->children());
+    EXPECT_EQ(sources, AsGroup(project->mainGroup()->children().front()));
+
+    std::vector<pbxproj::PBX::GroupItem::vector> items = BuildPhaseItems(project->targets().front());
+    ASSERT_EQ(2, items.size());
+    EXPECT_EQ(std::vector<std::string>({ "util.c", "main.c" }), Names(items[0]));
+    EXPECT_EQ(std::vector<std::string>({ "Localizable.strings" }), Names(items[1]));
+
+    /* Items reached through groups and through build files are shared. */
+    EXPECT_EQ(sources->children()[1], items[0][0]);
+    EXPECT_EQ(sources->children()[2], items[1][0]);
+}
+
+TEST(LazyProject, ParentFromBuildFile)
+{
+    auto filesystem = ProjectFilesystem();
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/Project.xcodeproj");
+    ASSERT_NE(nullptr, project);
+    ASSERT_EQ(1, project->targets().size());
+
+    /* Reach the items from the target before parsing any group. */
+    std::vector<pbxproj::PBX::GroupItem::vector> items = BuildPhaseItems(project->targets().front());
+    ASSERT_EQ(2, items.size());
+    ASSERT_EQ(2, items[0].size());
+    ASSERT_EQ(1, items[1].size());
+
+    /* Paths still resolve through the groups containing the items. */
+    EXPECT_EQ("$(SOURCE_ROOT)/Sources/util.c", items[0][0]->resolve().raw());
+    EXPECT_EQ("$(SOURCE_ROOT)/Sources/main.c", items[0][1]->resolve().raw());
+    EXPECT_EQ("$(SOURCE_ROOT)/Sources", items[1][0]->resolve().raw());
+
+    pbxproj::PBX::BaseGroup::shared_ptr strings = AsGroup(items[1][0]);
+    ASSERT_NE(nullptr, strings);
+    ASSERT_EQ(1, strings->children().size());
+    EXPECT_EQ("$(SOURCE_ROOT)/Sources/en.lproj/Localizable.strings", strings->children().front()->resolve().raw());
+
+    /* Parsing the groups afterwards finds the same items. */
+    pbxproj::PBX::BaseGroup::shared_ptr sources = AsGroup(project->mainGroup()->children().front());
+    ASSERT_NE(nullptr, sources);
+    EXPECT_EQ(std::vector<std::string>({ "main.c", "util.c", "Localizable.strings" }), Names(sources->children()));
+    EXPECT_EQ(items[0][1], sources->children()[0]);
+    EXPECT_EQ(items[0][0], sources->children()[1]);
+}
+
+TEST(LazyProject, ResolveBuildableReference)
+{
+    auto filesystem = ProjectFilesystem();
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/Project.xcodeproj");
+    ASSERT_NE(nullptr, project);
+
+    /* Objects not parsed yet are parsed when referenced. */
+    pbxproj::PBX::Object::shared_ptr reference = project->resolveBuildableReference("F2");
+    ASSERT_NE(nullptr, reference);
+    EXPECT_EQ("PBXFileReference", reference->isa());
+    EXPECT_EQ("F2", reference->blueprintIdentifier());
+
+    auto fileReference = std::static_pointer_cast<pbxproj::PBX::GroupItem>(reference);
+    EXPECT_EQ("$(SOURCE_ROOT)/Sources/util.c", fileReference->resolve().raw());
+
+    /* And are the same objects reached later. */
+    std::vector<pbxproj::PBX::GroupItem::vector> items = BuildPhaseItems(project->targets().front());
+    ASSERT_EQ(2, items.size());
+    ASSERT_EQ(2, items[0].size());
+    EXPECT_EQ(reference, items[0][0]);
+
+    pbxproj::PBX::Object::shared_ptr target = project->resolveBuildableReference("T");
+    ASSERT_NE(nullptr, target);
+    EXPECT_EQ(project->targets().front(), target);
+
+    EXPECT_EQ(nullptr, project->resolveBuildableReference("missing"));
+}
+
+TEST(LazyProject, ConcurrentAccess)
+{
+    auto filesystem = ProjectFilesystem();
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/Project.xcodeproj");
+    ASSERT_NE(nullptr, project);
+    ASSERT_EQ(1, project->targets().size());
+
+    /* Targets are planned on multiple threads, parsing as they go. */
+    std::vector<std::vector<pbxproj::PBX::GroupItem::vector>> items(8);
+    std::vector<pbxproj::PBX::GroupItem::vector> children(items.size());
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < items.size(); n++) {
+        threads.push_back(std::thread([&, n] {
+            if (n % 2 == 0) {
+                items[n] = BuildPhaseItems(project->targets().front());
+            }
+
+            if (pbxproj::PBX::BaseGroup::shared_ptr sources = AsGroup(project->mainGroup()->children().front())) {
+                children[n] = sources->children();
+            }
+
+            if (n % 2 != 0) {
+                items[n] = BuildPhaseItems(project->targets().front());
+            }
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (size_t n = 0; n < items.size(); n++) {
+        EXPECT_EQ(items.front(), items[n]);
+        EXPECT_EQ(children.front(), children[n]);
+    }
+
+    ASSERT_EQ(3, children.front().size());
+    EXPECT_EQ(std::vector<std::string>({ "main.c", "util.c", "Localizable.strings" }), Names(children.front()));
+    ASSERT_EQ(2, items.front().size());
+    EXPECT_EQ(children.front()[1], items.front()[0][0]);
+}
@@ -0,0 +1,175 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Tool/Environment.h>
+#include <pbxbuild/Tool/OptionsResult.h>
+#include <pbxbuild/Tool/Context.h>
+#include <pbxbuild/Tool/SearchPaths.h>
+#include <pbxbuild/Phase/File.h>
+#include <pbxspec/Manager.h>
+#include <pbxsetting/Level.h>
+#include <pbxsetting/Setting.h>
+#include <libutil/MemoryFilesystem.h>
+
+namespace Tool = pbxbuild::Tool;
+using libutil::MemoryFilesystem;
+
+/*
+ * Options for each way of using the input and output.
+ */
+static std::vector<std::pair<std::string, std::string>> const Options = {
+    { "plain", "{ Name = PLAIN; Type = String; DefaultValue = YES; CommandLineArgs = (\"-in\", \"$(InputPath)\", \"-out\", \"$(OutputPath)\"); }" },
+    { "prefix", "{ Name = PREFIX; Type = String; DefaultValue = YES; CommandLineArgs = (\"-name=$(InputFileBase)$(InputFileSuffix)\"); }" },
+    { "identifier", "{ Name = IDENTIFIER; Type = String; DefaultValue = YES; CommandLineArgs = (\"$(InputFileBase:identifier)\"); }" },
+    { "c99extidentifier", "{ Name = C99; Type = String; DefaultValue = YES; CommandLineArgs = (\"$(InputFileBase:c99extidentifier)\"); }" },
+    { "rfc1034identifier", "{ Name = RFC1034; Type = String; DefaultValue = YES; CommandLineArgs = (\"$(InputFileBase:rfc1034identifier)\"); }" },
+    { "quote", "{ Name = QUOTE; Type = String; DefaultValue = YES; CommandLineArgs = (\"$(InputPath:quote)\"); }" },
+    { "dir", "{ Name = DIR; Type = String; DefaultValue = YES; CommandLineArgs = (\"$(InputPath:dir)\", \"$(OutputPath:base)\"); }" },
+    { "lower", "{ Name = LOWER; Type = String; DefaultValue = YES; CommandLineArgs = (\"$(InputFileName:lower)\"); }" },
+    { "nested", "{ Name = NESTED; Type = String; DefaultValue = YES; CommandLineArgs = (\"$(FLAGS_$(InputFileBase))\"); }" },
+};
+
+/*
+ * A compiler named after each option, using it along with the plain option,
+ * and a compiler named "all" using every option.
+ */
+static pbxspec::Manager::shared_ptr
+SpecManager()
+{
+    std::string all;
+    std::string contents = "(";
+    for (std::pair<std::string, std::string> const &option : Options) {
+        contents += "{ Type = Compiler; Identifier = " + option.first + "; Name = " + option.first + "; Options = (" + Options.front().second + ", " + option.second + "); },";
+        all += option.second + ",";
+    }
+    contents += "{ Type = Compiler; Identifier = all; Name = all; Options = (" + all + "); },";
+    contents += ")";
+
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("Tools.xcspec", std::vector<uint8_t>(contents.begin(), contents.end())),
+    });
+
+    pbxspec::Manager::shared_ptr specManager = pbxspec::Manager::Create();
+    specManager->registerDomains(&filesystem, { { "test", "/Tools.xcspec" } });
+    return specManager;
+}
+
+/*
+ * Evaluates the tool's arguments for a file from a template, falling back to
+ * evaluating them directly when any argument can't be instantiated.
+ */
+static std::vector<std::string>
+TemplateArguments(
+    pbxspec::PBX::Tool::shared_ptr const &tool,
+    pbxsetting::Environment const &environment,
+    Tool::Context const *toolContext,
+    pbxbuild::Phase::File const &input,
+    std::string const &output,
+    bool *instantiated)
+{
+    *instantiated = false;
+
+    ext::optional<Tool::Environment> toolEnvironment = Tool::Environment::CreateTemplate(tool, environment, toolContext->workingDirectory(), input.localization());
+    if (toolEnvironment) {
+        if (ext::optional<Tool::OptionsResult> options = Tool::OptionsResult::CreateTemplate(*toolEnvironment, toolContext, nullptr)) {
+            std::unordered_map<std::string, std::string> values = Tool::Environment::PlaceholderValues(input, output, toolContext->workingDirectory());
+
+            std::vector<std::string> arguments;
+            for (std::string const &argument : options->arguments()) {
+                ext::optional<std::string> value = Tool::Environment::Instantiate(argument, values);
+                if (!value) {
+                    arguments.clear();
+                    break;
+                }
+                arguments.push_back(*value);
+            }
+
+            if (arguments.size() == options->arguments().size()) {
+                *instantiated = true;
+                return arguments;
+            }
+        }
+    }
+
+    Tool::Environment direct = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { input }, { output });
+    return Tool::OptionsResult::Create(direct, toolContext, nullptr).arguments();
+}
+
+/*
+ * Evaluates the tool's arguments for a file both ways, returning whether the
+ * template could be used.
+ */
+static bool
+ExpectEquivalent(
+    pbxspec::PBX::Tool::shared_ptr const &tool,
+    pbxsetting::Environment const &environment,
+    Tool::Context const *toolContext,
+    std::string const &path)
+{
+    pbxbuild::Phase::File input = pbxbuild::Phase::File(nullptr, nullptr, nullptr, path, "", "");
+    std::string output = "/Build/Objects/" + input.path().substr(input.path().rfind('/') + 1) + ".o";
+
+    Tool::Environment direct = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { input }, { output });
+    std::vector<std::string> expected = Tool::OptionsResult::Create(direct, toolContext, nullptr).arguments();
+    EXPECT_FALSE(expected.empty());
+
+    bool instantiated;
+    std::vector<std::string> arguments = TemplateArguments(tool, environment, toolContext, input, output, &instantiated);
+    EXPECT_EQ(expected, arguments) << path;
+
+    return instantiated;
+}
+
+TEST(ToolEnvironment, TemplateMatchesDirect)
+{
+    pbxspec::Manager::shared_ptr specManager = SpecManager();
+
+    pbxsetting::Environment environment;
+    environment.insertBack(pbxsetting::Level({
+        pbxsetting::Setting::Create("FLAGS_main", "-main"),
+        pbxsetting::Setting::Create("FLAGS_my-file", "-my-file"),
+    }), false);
+
+    Tool::SearchPaths searchPaths = Tool::SearchPaths({ }, { }, { }, { });
+    Tool::Context toolContext = Tool::Context(nullptr, { }, { }, "/Source", searchPaths);
+
+    std::vector<std::string> paths = {
+        "/Source/main.c",
+        "/Source/My File.c",
+        "/Source/my-file.c",
+        "/Source/1st.File.c",
+        "/Source/Dir With Space/Na-me.2.C",
+        "relative/$weird'name.m",
+    };
+
+    /* Options using the input and output as they are use the template. */
+    for (char const *name : { "plain", "prefix" }) {
+        pbxspec::PBX::Tool::shared_ptr tool = specManager->compiler(name, { "test" });
+        ASSERT_NE(nullptr, tool);
+        for (std::string const &path : paths) {
+            EXPECT_TRUE(ExpectEquivalent(tool, environment, &toolContext, path)) << name;
+        }
+    }
+
+    /* Options applying operations to the input or output match as well. */
+    for (std::pair<std::string, std::string> const &option : Options) {
+        pbxspec::PBX::Tool::shared_ptr tool = specManager->compiler(option.first, { "test" });
+        ASSERT_NE(nullptr, tool);
+        for (std::string const &path : paths) {
+            ExpectEquivalent(tool, environment, &toolContext, path);
+        }
+    }
+
+    pbxspec::PBX::Tool::shared_ptr all = specManager->compiler("all", { "test" });
+    ASSERT_NE(nullptr, all);
+    for (std::string const &path : paths) {
+        ExpectEquivalent(all, environment, &toolContext, path);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/WorkspaceContext.h>
+#include <pbxsetting/Environment.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxbuild::WorkspaceContext;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+/*
+ * A project referencing other projects by absolute path.
+ */
+static MemoryFilesystem::Entry
+ProjectEntry(std::string const &name, std::vector<std::string> const &references)
+{
+    std::string objects;
+    std::string projectReferences;
+    for (size_t n = 0; n < references.size(); n++) {
+        std::string index = std::to_string(n);
+        objects += "R" + index + " = { isa = PBXFileReference; sourceTree = \"<absolute>\"; path = \"Projects/" + references[n] + ".xcodeproj\"; };";
+        projectReferences += "{ ProductGroup = G; ProjectRef = R" + index + "; },";
+    }
+
+    std::string contents = "{ \
+        archiveVersion = 1; \
+        objectVersion = 46; \
+        objects = { \
+            P = { isa = PBXProject; mainGroup = G; projectReferences = (" + projectReferences + "); }; \
+            G = { isa = PBXGroup; children = (); sourceTree = \"<group>\"; }; \
+            " + objects + " \
+        }; \
+        rootObject = P; \
+    }";
+
+    return MemoryFilesystem::Entry::Directory(name + ".xcodeproj", {
+        MemoryFilesystem::Entry::File("project.pbxproj", Contents(contents)),
+    });
+}
+
+TEST(WorkspaceContext, NestedProjects)
+{
+    /*
+     * A -> B, C; B -> A, D; C -> D, E; D -> B. The cycles must terminate,
+     * and each project must be loaded once, in breadth-first order.
+     */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Projects", {
+            ProjectEntry("A", { "B", "C" }),
+            ProjectEntry("B", { "A", "D" }),
+            ProjectEntry("C", { "D", "E" }),
+            ProjectEntry("D", { "B" }),
+            ProjectEntry("E", { }),
+        }),
+    });
+
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/Projects/A.xcodeproj");
+    ASSERT_NE(nullptr, project);
+
+    WorkspaceContext context = WorkspaceContext::Project(&filesystem, pbxsetting::Environment(), project);
+    EXPECT_EQ(project, context.project());
+
+    ASSERT_EQ(5, context.projects().size());
+    for (char const *name : { "A", "B", "C", "D", "E" }) {
+        pbxproj::PBX::Project::shared_ptr nested = context.project("/Projects/" + std::string(name) + ".xcodeproj");
+        ASSERT_NE(nullptr, nested);
+        EXPECT_EQ(name, nested->name());
+    }
+    EXPECT_EQ(nullptr, context.project("/Projects/F.xcodeproj"));
+
+    /* Scheme groups follow the order the projects were found in. */
+    std::vector<std::string> names;
+    for (xcscheme::SchemeGroup::shared_ptr const &schemeGroup : context.schemeGroups()) {
+        names.push_back(schemeGroup->name());
+    }
+    EXPECT_EQ(std::vector<std::string>({ "A", "B", "C", "D", "E" }), names);
+}
@@ -16,6 +16,7 @@
 #include <string>
 #include <unordered_set>
 
+namespace plist { class Array; }
 namespace plist { class Dictionary; }
 
 namespace pbxproj { namespace PBX {
@@ -25,17 +26,24 @@ public:
     typedef std::shared_ptr <BaseGroup> shared_ptr;
 
 private:
-    GroupItem::vector _children;
+    plist::Array const        *_childIdentifiers;
+    mutable std::atomic<bool>  _childrenParsed;
+    mutable GroupItem::vector  _children;
 
 protected:
     BaseGroup(std::string const &isa, GroupItem::Type type);
 
 public:
-    inline GroupItem::vector const &children() const
-    { return _children; }
+    /*
+     * The items in the group. Parsed on first use.
+     */
+    GroupItem::vector const &children() const;
 
 protected:
     bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check) override;
+
+private:
+    void parseChildren(Context &context) const;
 };
 
 } }
@@ -33,7 +33,6 @@ private:
     Type        _type;
 
 protected:
-    friend class BaseGroup;
     GroupItem  *_parent;
     std::string _name;
     std::string _path;
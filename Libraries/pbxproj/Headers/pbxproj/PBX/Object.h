@@ -12,6 +12,8 @@
 
 #include <pbxproj/ISA.h>
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_set>
@@ -28,8 +30,9 @@ public:
     typedef std::vector <shared_ptr> vector;
 
 private:
-    std::string _isa;
-    std::string _blueprintIdentifier;
+    std::string            _isa;
+    std::string            _blueprintIdentifier;
+    std::weak_ptr<Context> _context;
 
 protected:
     Object(std::string const &isa);
@@ -55,6 +58,13 @@ private:
 protected:
     virtual bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check);
 
+protected:
+    /*
+     * Parses part of the object on first use, from the property list kept
+     * by its project. Does nothing if the project has since been released.
+     */
+    void materialize(std::atomic<bool> *materialized, std::function<void(Context &)> const &parse) const;
+
 public:
     template <typename T>
     inline bool isa() const
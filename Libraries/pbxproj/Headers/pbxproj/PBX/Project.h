@@ -42,19 +42,30 @@ private:
     std::string                        _name;
     std::unordered_map<std::string, Object::shared_ptr> _blueprints;
 
+private:
+    /*
+     * Keeps the property list and the parsed objects, so the rest of the
+     * objects can be parsed from it on first use.
+     */
+    std::shared_ptr<Context>           _parseContext;
+
 private:
     XC::ConfigurationList::shared_ptr  _buildConfigurationList;
     std::string                        _compatibilityVersion;
     std::string                        _developmentRegion;
     bool                               _hasScannedForEncodings;
     std::vector<std::string>             _knownRegions;
-    Group::shared_ptr                  _mainGroup;
-    Group::shared_ptr                  _productRefGroup;
+    std::string                        _mainGroupIdentifier;
+    std::string                        _productRefGroupIdentifier;
+    mutable std::atomic<bool>          _groupsParsed;
+    mutable Group::shared_ptr          _mainGroup;
+    mutable Group::shared_ptr          _productRefGroup;
     std::string                        _projectDirPath;
     std::string                        _projectRoot;
     std::vector<ProjectReference>      _projectReferences;
     Target::vector                     _targets;
-    FileReference::vector              _fileReferences;
+    mutable std::atomic<bool>          _fileReferencesParsed;
+    mutable FileReference::vector      _fileReferences;
 
 public:
     Project();
@@ -83,12 +94,16 @@ public:
     { return _knownRegions; }
 
 public:
-    inline Group::shared_ptr const &mainGroup() const
-    { return _mainGroup; }
+    /*
+     * The root group of the project. Parsed on first use.
+     */
+    Group::shared_ptr const &mainGroup() const;
 
 public:
-    inline Group::shared_ptr const &productRefGroup() const
-    { return _productRefGroup; }
+    /*
+     * The group containing the products. Parsed on first use.
+     */
+    Group::shared_ptr const &productRefGroup() const;
 
 public:
     inline std::string const &projectDirPath() const
@@ -123,21 +138,16 @@ protected:
     { _blueprints[object->blueprintIdentifier()] = object; }
 
 public:
-    inline FileReference::vector const &fileReferences() const
-    { return _fileReferences; }
+    /*
+     * All file references in the project. Parsed on first use.
+     */
+    FileReference::vector const &fileReferences() const;
 
 public:
-    inline Object::shared_ptr resolveBuildableReference(std::string const &blueprintIdentifier) const
-    {
-        if (blueprintIdentifier.empty())
-            return Object::shared_ptr();
-
-        auto I = _blueprints.find(blueprintIdentifier);
-        if (I == _blueprints.end())
-            return Object::shared_ptr();
-        else
-            return I->second;
-    }
+    /*
+     * Finds an object by identifier, parsing it if not yet used.
+     */
+    Object::shared_ptr resolveBuildableReference(std::string const &blueprintIdentifier) const;
 
 public:
     pbxsetting::Level settings(void) const;
@@ -145,6 +155,10 @@ public:
 protected:
     bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check) override;
 
+private:
+    void parseGroups(Context &context) const;
+    void parseFileReferences(Context &context) const;
+
 public:
     static inline char const *Isa()
     { return ISA::PBXProject; }
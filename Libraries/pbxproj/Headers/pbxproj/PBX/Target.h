@@ -15,6 +15,8 @@
 #include <pbxproj/PBX/BuildPhase.h>
 #include <pbxproj/PBX/TargetDependency.h>
 
+namespace plist { class Array; }
+
 namespace pbxproj { namespace PBX {
 
 class Project;
@@ -41,7 +43,9 @@ private:
     std::string                       _name;
     std::string                       _productName;
     XC::ConfigurationList::shared_ptr _buildConfigurationList;
-    PBX::BuildPhase::vector           _buildPhases;
+    plist::Array const               *_buildPhaseIdentifiers;
+    mutable std::atomic<bool>         _buildPhasesParsed;
+    mutable PBX::BuildPhase::vector   _buildPhases;
     PBX::TargetDependency::vector     _dependencies;
 
 protected:
@@ -68,8 +72,10 @@ public:
     { return _buildConfigurationList; }
 
 public:
-    inline BuildPhase::vector const &buildPhases() const
-    { return _buildPhases; }
+    /*
+     * The build phases of the target. Parsed on first use.
+     */
+    BuildPhase::vector const &buildPhases() const;
 
 public:
     inline TargetDependency::vector const &dependencies() const
@@ -80,6 +86,9 @@ public:
 
 protected:
     bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check) override;
+
+private:
+    void parseBuildPhases(Context &context) const;
 };
 
 } }
@@ -18,6 +18,7 @@
 #include <plist/Keys/Unpack.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -30,6 +31,7 @@ namespace PBX {
 
 class Object;
 class Project;
+class GroupItem;
 class Group;
 class VariantGroup;
 class FileReference;
@@ -60,17 +62,32 @@ class VersionGroup;
 
 }
 
-class Context {
+class Context : public std::enable_shared_from_this<Context> {
 public:
     //
-    // Parsing context
+    // Parsing context. The property list is kept by the project, so
+    // that objects not needed yet can be parsed from it on first use.
     //
+    std::unique_ptr<plist::Object> propertyList;
     plist::Dictionary const *objects;
 
     //
-    // The main project
+    // Held while parsing. Objects parsed on first use can be reached from
+    // multiple threads, and share the caches below.
     //
-    std::shared_ptr<PBX::Project> project;
+    std::recursive_mutex mutex;
+
+    //
+    // The main project. Weak, as the project owns the context.
+    //
+    std::weak_ptr<PBX::Project> project;
+
+    //
+    // The group containing each group item, by identifier. Built on first
+    // use, so items can be parsed without parsing their group's siblings.
+    //
+    std::unordered_map <std::string, std::string> parents;
+    bool parentsIndexed;
 
     //
     // Cached values
@@ -103,12 +120,15 @@ public:
 public:
     Context()
     {
-        project = nullptr;
+        objects = nullptr;
+        parentsIndexed = false;
     }
 
     inline void clear()
     {
-        project = nullptr;
+        project.reset();
+        parents.clear();
+        parentsIndexed = false;
         projects.clear();
         fileReferences.clear();
         referenceProxies.clear();
@@ -249,6 +269,17 @@ public:
         return parseObject(cache, id->value(), dict);
     }
 
+public:
+    //
+    // Parses an object of any supported type by its identifier.
+    //
+    std::shared_ptr <PBX::Object> parseObject(std::string const &id);
+
+    //
+    // Parses the group containing a group item, but not its other children.
+    //
+    PBX::GroupItem *parentGroup(std::string const &id);
+
 private:
     void cacheObject(std::shared_ptr <PBX::Object> const &O, std::string const &id);
 };
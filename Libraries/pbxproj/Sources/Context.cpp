@@ -9,19 +9,118 @@
 
 #include <pbxproj/Context.h>
 #include <pbxproj/PBX/Project.h>
+#include <pbxproj/PBX/AggregateTarget.h>
+#include <pbxproj/PBX/LegacyTarget.h>
+#include <pbxproj/PBX/NativeTarget.h>
+#include <pbxproj/PBX/BuildPhases.h>
+#include <pbxproj/PBX/ReferenceProxy.h>
+#include <pbxproj/PBX/VariantGroup.h>
+#include <pbxproj/XC/VersionGroup.h>
+#include <plist/Array.h>
 
 using pbxproj::Context;
 
 void Context::
 cacheObject(PBX::Object::shared_ptr const &O, std::string const &id)
 {
-    if (project == nullptr && O->isa <PBX::Project> ()) {
+    if (project.expired() && O->isa <PBX::Project> ()) {
         project = std::static_pointer_cast <PBX::Project> (O);
     }
 
     O->setBlueprintIdentifier(id);
+    O->_context = shared_from_this();
 
-    if (project != nullptr && project != O) {
-        project->cacheObject(O);
+    PBX::Project::shared_ptr P = project.lock();
+    if (P != nullptr && P != O) {
+        P->cacheObject(O);
+    }
+}
+
+pbxproj::PBX::Object::shared_ptr Context::
+parseObject(std::string const &id)
+{
+    if (auto D = get <PBX::FileReference> (id)) {
+        return parseObject(fileReferences, id, D);
+    } else if (auto D = get <PBX::Group> (id)) {
+        return parseObject(groups, id, D);
+    } else if (auto D = get <PBX::VariantGroup> (id)) {
+        return parseObject(variantGroups, id, D);
+    } else if (auto D = get <XC::VersionGroup> (id)) {
+        return parseObject(versionGroups, id, D);
+    } else if (auto D = get <PBX::ReferenceProxy> (id)) {
+        return parseObject(referenceProxies, id, D);
+    } else if (auto D = get <PBX::BuildFile> (id)) {
+        return parseObject(buildFiles, id, D);
+    } else if (auto D = get <PBX::NativeTarget> (id)) {
+        return parseObject(nativeTargets, id, D);
+    } else if (auto D = get <PBX::AggregateTarget> (id)) {
+        return parseObject(aggregateTargets, id, D);
+    } else if (auto D = get <PBX::LegacyTarget> (id)) {
+        return parseObject(legacyTargets, id, D);
+    } else if (auto D = get <PBX::TargetDependency> (id)) {
+        return parseObject(targetDependencies, id, D);
+    } else if (auto D = get <PBX::ContainerItemProxy> (id)) {
+        return parseObject(containerItemProxies, id, D);
+    } else if (auto D = get <PBX::BuildRule> (id)) {
+        return parseObject(buildRules, id, D);
+    } else if (auto D = get <PBX::HeadersBuildPhase> (id)) {
+        return parseObject(headersBuildPhases, id, D);
+    } else if (auto D = get <PBX::SourcesBuildPhase> (id)) {
+        return parseObject(sourcesBuildPhases, id, D);
+    } else if (auto D = get <PBX::ResourcesBuildPhase> (id)) {
+        return parseObject(resourcesBuildPhases, id, D);
+    } else if (auto D = get <PBX::FrameworksBuildPhase> (id)) {
+        return parseObject(frameworksBuildPhases, id, D);
+    } else if (auto D = get <PBX::CopyFilesBuildPhase> (id)) {
+        return parseObject(copyFilesBuildPhases, id, D);
+    } else if (auto D = get <PBX::ShellScriptBuildPhase> (id)) {
+        return parseObject(shellScriptBuildPhases, id, D);
+    } else if (auto D = get <PBX::AppleScriptBuildPhase> (id)) {
+        return parseObject(appleScriptBuildPhases, id, D);
+    } else if (auto D = get <PBX::RezBuildPhase> (id)) {
+        return parseObject(rezBuildPhases, id, D);
+    } else if (auto D = get <XC::BuildConfiguration> (id)) {
+        return parseObject(buildConfigurations, id, D);
+    } else if (auto D = get <XC::ConfigurationList> (id)) {
+        return parseObject(configurationLists, id, D);
+    } else {
+        return nullptr;
+    }
+}
+
+pbxproj::PBX::GroupItem *Context::
+parentGroup(std::string const &id)
+{
+    if (!parentsIndexed) {
+        parentsIndexed = true;
+
+        for (size_t n = 0; n < objects->count(); n++) {
+            auto O  = objects->value <plist::Dictionary> (n);
+            auto Cs = (O != nullptr ? O->value <plist::Array> ("children") : nullptr);
+            if (Cs == nullptr) {
+                continue;
+            }
+
+            for (size_t m = 0; m < Cs->count(); m++) {
+                if (auto C = Cs->value <plist::String> (m)) {
+                    parents.insert({ C->value(), objects->key(n) });
+                }
+            }
+        }
+    }
+
+    auto I = parents.find(id);
+    if (I == parents.end()) {
+        return nullptr;
+    }
+
+    if (auto D = get <PBX::Group> (I->second)) {
+        return parseObject(groups, I->second, D).get();
+    } else if (auto D = get <PBX::VariantGroup> (I->second)) {
+        return parseObject(variantGroups, I->second, D).get();
+    } else if (auto D = get <XC::VersionGroup> (I->second)) {
+        return parseObject(versionGroups, I->second, D).get();
+    } else {
+        return nullptr;
     }
 }
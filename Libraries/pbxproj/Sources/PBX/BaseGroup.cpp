@@ -23,10 +23,21 @@ using pbxproj::PBX::BaseGroup;
 
 BaseGroup::
 BaseGroup(std::string const &isa, GroupItem::Type type) :
-    GroupItem(isa, type)
+    GroupItem        (isa, type),
+    _childIdentifiers(nullptr),
+    _childrenParsed  (false)
 {
 }
 
+pbxproj::PBX::GroupItem::vector const &BaseGroup::
+children() const
+{
+    materialize(&_childrenParsed, [this](Context &context) {
+        parseChildren(context);
+    });
+    return _children;
+}
+
 bool BaseGroup::
 parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check)
 {
@@ -42,59 +53,50 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
         fprintf(stderr, "%s", unpack.errorText().c_str());
     }
 
-    if (Cs != nullptr) {
-        for (size_t n = 0; n < Cs->count(); n++) {
-            auto ID = Cs->value <plist::String> (n);
-            if (ID == nullptr) {
-                continue;
-            }
+    /* Children are parsed on first use. */
+    _childIdentifiers = Cs;
 
-            if (auto C = context.get <Group> (ID)) {
-                auto O = context.parseObject(context.groups, ID->value(), C);
-                if (!O) {
-                    return false;
-                }
-
-                O->_parent = this;
-                _children.push_back(O);
-            } else if (auto C = context.get <VariantGroup> (ID)) {
-                auto O = context.parseObject(context.variantGroups, ID->value(), C);
-                if (!O) {
-                    return false;
-                }
-
-                O->_parent = this;
-                _children.push_back(O);
-            } else if (auto C = context.get <XC::VersionGroup> (ID)) {
-                auto O = context.parseObject(context.versionGroups, ID->value(), C);
-                if (!O) {
-                    return false;
-                }
-
-                O->_parent = this;
-                _children.push_back(O);
-            } else if (auto C = context.get <FileReference> (ID)) {
-                auto O = context.parseObject(context.fileReferences, ID->value(), C);
-                if (!O) {
-                    return false;
-                }
-
-                O->_parent = this;
-                _children.push_back(O);
-            } else if (auto C = context.get <ReferenceProxy> (ID)) {
-                auto O = context.parseObject(context.referenceProxies, ID->value(), C);
-                if (!O) {
-                    return false;
-                }
-
-                O->_parent = this;
-                _children.push_back(O);
-            } else if (context.objects->value(ID->value()) != nullptr) {
+    return true;
+}
+
+void BaseGroup::
+parseChildren(Context &context) const
+{
+    if (_childIdentifiers == nullptr) {
+        return;
+    }
+
+    for (size_t n = 0; n < _childIdentifiers->count(); n++) {
+        auto ID = _childIdentifiers->value <plist::String> (n);
+        if (ID == nullptr) {
+            continue;
+        }
+
+        GroupItem::shared_ptr O;
+        if (auto C = context.get <Group> (ID)) {
+            O = context.parseObject(context.groups, ID->value(), C);
+        } else if (auto C = context.get <VariantGroup> (ID)) {
+            O = context.parseObject(context.variantGroups, ID->value(), C);
+        } else if (auto C = context.get <XC::VersionGroup> (ID)) {
+            O = context.parseObject(context.versionGroups, ID->value(), C);
+        } else if (auto C = context.get <FileReference> (ID)) {
+            O = context.parseObject(context.fileReferences, ID->value(), C);
+        } else if (auto C = context.get <ReferenceProxy> (ID)) {
+            O = context.parseObject(context.referenceProxies, ID->value(), C);
+        } else {
+            if (context.objects->value(ID->value()) != nullptr) {
                 fprintf(stderr, "warning: group '%s' contains unsupported child reference to '%s'\n",
                         _name.c_str(), ID->value().c_str());
             }
+            continue;
         }
-    }
 
-    return true;
+        if (!O) {
+            fprintf(stderr, "warning: group '%s' contains invalid child '%s'\n",
+                    _name.c_str(), ID->value().c_str());
+            continue;
+        }
+
+        _children.push_back(O);
+    }
 }
@@ -8,6 +8,7 @@
  */
 
 #include <pbxproj/PBX/GroupItem.h>
+#include <pbxproj/Context.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
 #include <plist/Keys/Unpack.h>
@@ -73,5 +74,11 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
         _path = P->value();
     }
 
+    /*
+     * Items can be parsed before their group, such as when reached from a
+     * build file, so find the group separately. Paths resolve through it.
+     */
+    _parent = context.parentGroup(blueprintIdentifier());
+
     return true;
 }
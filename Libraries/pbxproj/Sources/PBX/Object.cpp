@@ -8,6 +8,7 @@
  */
 
 #include <pbxproj/PBX/Object.h>
+#include <pbxproj/Context.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
 #include <plist/Keys/Unpack.h>
@@ -45,3 +46,21 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
     return true;
 }
 
+void Object::
+materialize(std::atomic<bool> *materialized, std::function<void(Context &)> const &parse) const
+{
+    if (materialized->load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::shared_ptr<Context> context = _context.lock();
+    if (context == nullptr) {
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(context->mutex);
+    if (!materialized->load(std::memory_order_relaxed)) {
+        parse(*context);
+        materialized->store(true, std::memory_order_release);
+    }
+}
@@ -30,10 +30,85 @@ using libutil::SysUtil;
 Project::
 Project() :
     Object                 (Isa()),
-    _hasScannedForEncodings(false)
+    _hasScannedForEncodings(false),
+    _groupsParsed          (false),
+    _fileReferencesParsed  (false)
 {
 }
 
+pbxproj::PBX::Group::shared_ptr const &Project::
+mainGroup() const
+{
+    materialize(&_groupsParsed, [this](Context &context) {
+        parseGroups(context);
+    });
+    return _mainGroup;
+}
+
+pbxproj::PBX::Group::shared_ptr const &Project::
+productRefGroup() const
+{
+    materialize(&_groupsParsed, [this](Context &context) {
+        parseGroups(context);
+    });
+    return _productRefGroup;
+}
+
+pbxproj::PBX::FileReference::vector const &Project::
+fileReferences() const
+{
+    materialize(&_fileReferencesParsed, [this](Context &context) {
+        parseFileReferences(context);
+    });
+    return _fileReferences;
+}
+
+pbxproj::PBX::Object::shared_ptr Project::
+resolveBuildableReference(std::string const &blueprintIdentifier) const
+{
+    if (blueprintIdentifier.empty() || _parseContext == nullptr) {
+        return Object::shared_ptr();
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(_parseContext->mutex);
+
+    auto I = _blueprints.find(blueprintIdentifier);
+    if (I != _blueprints.end()) {
+        return I->second;
+    }
+
+    return _parseContext->parseObject(blueprintIdentifier);
+}
+
+void Project::
+parseGroups(Context &context) const
+{
+    if (!_mainGroupIdentifier.empty()) {
+        if (auto MG = context.get <Group> (_mainGroupIdentifier)) {
+            _mainGroup = context.parseObject(context.groups, _mainGroupIdentifier, MG);
+        }
+    }
+
+    if (!_productRefGroupIdentifier.empty()) {
+        if (auto PRG = context.get <Group> (_productRefGroupIdentifier)) {
+            _productRefGroup = context.parseObject(context.groups, _productRefGroupIdentifier, PRG);
+        }
+    }
+}
+
+void Project::
+parseFileReferences(Context &context) const
+{
+    for (size_t n = 0; n < context.objects->count(); n++) {
+        std::string const &FRID = context.objects->key(n);
+        if (auto FR = context.get <FileReference> (FRID)) {
+            if (auto O = context.parseObject(context.fileReferences, FRID, FR)) {
+                _fileReferences.push_back(O);
+            }
+        }
+    }
+}
+
 pbxsetting::Level Project::
 settings(void) const
 {
@@ -118,15 +193,13 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
         }
     }
 
+    /* Groups are parsed on first use. */
     if (MG != nullptr) {
-        _mainGroup = context.parseObject(context.groups, MGID, MG);
-        if (!_mainGroup) {
-            return false;
-        }
+        _mainGroupIdentifier = MGID;
     }
 
     if (PRG != nullptr) {
-        _productRefGroup = context.parseObject(context.groups, PRGID, PRG);
+        _productRefGroupIdentifier = PRGID;
     }
 
     if (PDP != nullptr) {
@@ -264,16 +337,17 @@ Open(Filesystem const *filesystem, std::string const &path)
     }
 
     //
-    // Initialize context
+    // Initialize context. It keeps the property list, for parsing the
+    // objects that aren't needed yet on first use.
     //
-    Context context;
-    context.objects = Os;
+    auto context = std::make_shared<Context>();
+    context->objects = Os;
 
     //
     // Fetch the project dictionary (root object)
     //
     std::string PID;
-    auto P = context.indirect <Project> (&unpack, "rootObject", &PID);
+    auto P = context->indirect <Project> (&unpack, "rootObject", &PID);
     if (P == nullptr) {
         fprintf(stderr, "error: unable to parse project\n");
         return nullptr;
@@ -289,7 +363,10 @@ Open(Filesystem const *filesystem, std::string const &path)
     //
     // Parse the project dictionary and create the project object.
     //
-    auto project = context.parseObject(context.projects, PID, P);
+    auto project = context->parseObject(context->projects, PID, P);
+    if (project == nullptr) {
+        return nullptr;
+    }
 
     //
     // Save some useful info
@@ -300,11 +377,12 @@ Open(Filesystem const *filesystem, std::string const &path)
     project->_name        = FSUtil::GetBaseNameWithoutExtension(project->_projectFile);
 
     //
-    // Transfer all file references from cache.
+    // Hand the context to the project. The context must not in turn keep
+    // the project, or neither would be released.
     //
-    for (auto const &I : context.fileReferences) {
-        project->_fileReferences.push_back(I.second);
-    }
+    context->projects.clear();
+    context->propertyList = std::move(result.first);
+    project->_parseContext = context;
 
     return project;
 }
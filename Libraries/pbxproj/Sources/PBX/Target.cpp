@@ -22,11 +22,22 @@ using pbxproj::PBX::FileReference;
 
 Target::
 Target(std::string const &isa, Type type) :
-    Object(isa),
-    _type (type)
+    Object                (isa),
+    _type                 (type),
+    _buildPhaseIdentifiers(nullptr),
+    _buildPhasesParsed    (false)
 {
 }
 
+pbxproj::PBX::BuildPhase::vector const &Target::
+buildPhases() const
+{
+    materialize(&_buildPhasesParsed, [this](Context &context) {
+        parseBuildPhases(context);
+    });
+    return _buildPhases;
+}
+
 pbxsetting::Level Target::
 settings(void) const
 {
@@ -85,75 +96,8 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
         }
     }
 
-    if (BPs != nullptr) {
-        for (size_t n = 0; n < BPs->count(); n++) {
-            auto ID = BPs->value <plist::String> (n);
-            if (ID == nullptr) {
-                continue;
-            }
-
-            if (auto BPd = context.get <HeadersBuildPhase> (ID)) {
-                auto O = context.parseObject(context.headersBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <SourcesBuildPhase> (ID)) {
-                auto O = context.parseObject(context.sourcesBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <ResourcesBuildPhase> (ID)) {
-                auto O = context.parseObject(context.resourcesBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <FrameworksBuildPhase> (ID)) {
-                auto O = context.parseObject(context.frameworksBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <CopyFilesBuildPhase> (ID)) {
-                auto O = context.parseObject(context.copyFilesBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <ShellScriptBuildPhase> (ID)) {
-                auto O = context.parseObject(context.shellScriptBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <AppleScriptBuildPhase> (ID)) {
-                auto O = context.parseObject(context.appleScriptBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else if (auto BPd = context.get <RezBuildPhase> (ID)) {
-                auto O = context.parseObject(context.rezBuildPhases, ID->value(), BPd);
-                if (!O) {
-                    return false;
-                }
-
-                _buildPhases.push_back(O);
-            } else {
-                fprintf(stderr, "warning: target '%s' contains unsupported build phase reference to '%s'\n",
-                        _name.c_str(), ID->value().c_str());
-            }
-        }
-    }
+    /* Build phases are parsed on first use. */
+    _buildPhaseIdentifiers = BPs;
 
     if (Ds != nullptr) {
         for (size_t n = 0; n < Ds->count(); n++) {
@@ -172,3 +116,49 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void Target::
+parseBuildPhases(Context &context) const
+{
+    if (_buildPhaseIdentifiers == nullptr) {
+        return;
+    }
+
+    for (size_t n = 0; n < _buildPhaseIdentifiers->count(); n++) {
+        auto ID = _buildPhaseIdentifiers->value <plist::String> (n);
+        if (ID == nullptr) {
+            continue;
+        }
+
+        BuildPhase::shared_ptr O;
+        if (auto BPd = context.get <HeadersBuildPhase> (ID)) {
+            O = context.parseObject(context.headersBuildPhases, ID->value(), BPd);
+        } else if (auto BPd = context.get <SourcesBuildPhase> (ID)) {
+            O = context.parseObject(context.sourcesBuildPhases, ID->value(), BPd);
+        } else if (auto BPd = context.get <ResourcesBuildPhase> (ID)) {
+            O = context.parseObject(context.resourcesBuildPhases, ID->value(), BPd);
+        } else if (auto BPd = context.get <FrameworksBuildPhase> (ID)) {
+            O = context.parseObject(context.frameworksBuildPhases, ID->value(), BPd);
+        } else if (auto BPd = context.get <CopyFilesBuildPhase> (ID)) {
+            O = context.parseObject(context.copyFilesBuildPhases, ID->value(), BPd);
+        } else if (auto BPd = context.get <ShellScriptBuildPhase> (ID)) {
+            O = context.parseObject(context.shellScriptBuildPhases, ID->value(), BPd);
+        } else if (auto BPd = context.get <AppleScriptBuildPhase> (ID)) {
+            O = context.parseObject(context.appleScriptBuildPhases, ID->value(), BPd);
+        } else if (auto BPd = context.get <RezBuildPhase> (ID)) {
+            O = context.parseObject(context.rezBuildPhases, ID->value(), BPd);
+        } else {
+            fprintf(stderr, "warning: target '%s' contains unsupported build phase reference to '%s'\n",
+                    _name.c_str(), ID->value().c_str());
+            continue;
+        }
+
+        if (!O) {
+            fprintf(stderr, "warning: target '%s' contains invalid build phase '%s'\n",
+                    _name.c_str(), ID->value().c_str());
+            continue;
+        }
+
+        _buildPhases.push_back(O);
+    }
+}
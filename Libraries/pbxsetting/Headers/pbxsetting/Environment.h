@@ -14,6 +14,8 @@
 #include <pbxsetting/Level.h>
 
 #include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -28,10 +30,31 @@ private:
     std::list<Level> _levels;
     size_t           _offset;
 
+private:
+    /*
+     * Resolved values by condition, then by setting. Copies of an environment
+     * share this cache until a level is inserted, which starts a new one. The
+     * copies can be resolved from multiple threads, so access is locked.
+     */
+    struct ResolutionCache {
+        std::mutex                                                                 mutex;
+        std::unordered_map<Condition, std::unordered_map<std::string, std::string>> values;
+    };
+    mutable std::shared_ptr<ResolutionCache> _cache;
+
 public:
     Environment();
     ~Environment();
 
+public:
+    /*
+     * Identifies the settings in this environment. Copies share an identity
+     * until a level is inserted into either. An identity is not reused by
+     * another environment while it is held.
+     */
+    std::shared_ptr<void const> identity() const
+    { return _cache; }
+
 public:
     /*
      * Evaluate a build setting in the environment.
@@ -90,9 +113,10 @@ private:
         std::string setting;
         std::list<Level>::const_iterator it;
     };
-    std::string resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const;
-    std::string resolveInheritance(Condition const &condition, InheritanceContext const &context) const;
-    std::string resolveAssignment(Condition const &condition, std::string const &setting) const;
+    void resolveReference(Condition const &condition, std::string const &raw, std::string const &setting, std::vector<Value::Program::Operation> const &operations, InheritanceContext const &context, std::string *result) const;
+    void resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context, std::string *result) const;
+    void resolveInheritance(Condition const &condition, InheritanceContext const &context, std::string *result) const;
+    std::string const &resolveAssignment(Condition const &condition, std::string const &setting) const;
 };
 
 }
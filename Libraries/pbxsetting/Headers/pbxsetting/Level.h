@@ -15,6 +15,7 @@
 #include <pbxsetting/Value.h>
 
 #include <vector>
+#include <unordered_map>
 #include <utility>
 #include <memory>
 
@@ -28,6 +29,7 @@ namespace pbxsetting {
 class Level {
 private:
     std::shared_ptr<std::vector<Setting>> _settings;
+    std::shared_ptr<std::unordered_map<std::string, std::vector<size_t>>> _index;
 
 public:
     /*
@@ -52,7 +52,92 @@ public:
         std::shared_ptr<class Value> value;
     };
 
-    std::vector<Entry> _entries;
+public:
+    /*
+     * A flattened, pre-compiled form of the value for fast evaluation. The
+     * instructions are in postfix order: literals are slices of a single
+     * string, references with a constant name point into a table of settings
+     * with their operations already parsed, and references with a computed
+     * name evaluate their name between a `Begin` and an `End` instruction.
+     */
+    class Program {
+    public:
+        enum class Operation {
+            Identifier,
+            C99ExtIdentifier,
+            RFC1034Identifier,
+            Quote,
+            Lower,
+            Upper,
+            StandardizePath,
+            Base,
+            Dir,
+            File,
+            Suffix,
+            Unknown,
+        };
+
+        struct Reference {
+            /* The full text of the reference, including operations. */
+            std::string            raw;
+            /* The setting name, without any operations. */
+            std::string            setting;
+            std::vector<Operation> operations;
+        };
+
+        struct Instruction {
+            enum Opcode {
+                Literal,
+                Reference,
+                Begin,
+                End,
+            };
+
+            Opcode opcode;
+            /* For `Literal`, the slice of `text()`; for `Reference`, the index into `references()`. */
+            size_t offset;
+            size_t length;
+        };
+
+    private:
+        std::string              _text;
+        std::vector<Reference>   _references;
+        std::vector<Instruction> _instructions;
+
+    public:
+        std::string const &text() const
+        { return _text; }
+        std::vector<Reference> const &references() const
+        { return _references; }
+        std::vector<Instruction> const &instructions() const
+        { return _instructions; }
+
+    public:
+        /*
+         * Parses the operation in a setting reference, like `identifier` in
+         * `$(PRODUCT_NAME:identifier)`.
+         */
+        static Operation
+        ParseOperation(std::string const &operation);
+
+        /*
+         * Splits the full text of a setting reference into the setting name
+         * and the operations that follow it.
+         */
+        static void
+        ParseReference(std::string const &raw, std::string *setting, std::vector<Operation> *operations);
+
+    public:
+        static std::shared_ptr<Program const>
+        Compile(std::vector<Entry> const &entries);
+
+    private:
+        void compile(std::vector<Entry> const &entries);
+    };
+
+private:
+    std::vector<Entry>             _entries;
+    std::shared_ptr<Program const> _program;
 
 public:
     Value(std::vector<Entry> const &entries);
@@ -70,6 +155,12 @@ public:
     std::vector<Entry> const &entries() const
     { return _entries; }
 
+    /*
+     * The compiled form of the value, used for evaluation.
+     */
+    Program const &program() const
+    { return *_program; }
+
 public:
     /*
      * The raw representation of the value. This string will be
@@ -25,8 +25,9 @@ public:
     typedef std::vector <shared_ptr> vector;
 
 private:
-    std::string _path;
-    Level       _level;
+    std::string              _path;
+    Level                    _level;
+    std::vector<std::string> _includedPaths;
 
 public:
     typedef std::function <bool(std::string const &filename, unsigned line,
@@ -41,6 +42,9 @@ public:
     { return _path; }
     inline Level const &level() const
     { return _level; }
+    /* The resolved paths of this file and all files it includes. */
+    inline std::vector<std::string> const &includedPaths() const
+    { return _includedPaths; }
 
 public:
     static Config::shared_ptr
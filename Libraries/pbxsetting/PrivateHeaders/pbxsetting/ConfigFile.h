@@ -41,7 +41,7 @@ public:
 
 public:
     std::pair<bool, Level>
-    open(std::string const &path, Environment const &environment, XC::Config::error_function const &error);
+    open(std::string const &path, Environment const &environment, XC::Config::error_function const &error, std::vector<std::string> *included = nullptr);
 
 private:
     bool parse(std::string const &path, Environment const &environment);
@@ -14,6 +14,7 @@
 #include <libutil/Base.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdarg>
 
@@ -28,7 +29,7 @@ ConfigFile::ConfigFile()
 }
 
 std::pair<bool, Level> ConfigFile::
-open(std::string const &path, Environment const &environment, XC::Config::error_function const &error)
+open(std::string const &path, Environment const &environment, XC::Config::error_function const &error, std::vector<std::string> *included)
 {
     bool parsed = false;
     std::vector<Setting> settings;
@@ -54,6 +55,11 @@ open(std::string const &path, Environment const &environment, XC::Config::error_
         }
     }
 
+    if (included != nullptr) {
+        included->insert(included->end(), _included.begin(), _included.end());
+        std::sort(included->begin(), included->end());
+    }
+
     _included.clear();
     _processed.clear();
     _error = nullptr;
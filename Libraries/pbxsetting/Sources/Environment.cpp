@@ -22,7 +22,8 @@ using libutil::FSUtil;
 
 Environment::
 Environment() :
-    _offset(0)
+    _offset(0),
+    _cache (std::make_shared<ResolutionCache>())
 {
 }
 
@@ -31,174 +32,228 @@ Environment::
 {
 }
 
-static std::string
-ProcessOperation(std::string const &value, std::string const &operation)
+static void
+ProcessOperation(std::string *value, Value::Program::Operation operation, std::string const &reference)
 {
-    const std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    const std::string digits = "0123456789";
-
-    if (operation == "identifier" || operation == "c99extidentifier") {
-        // TODO(grp): Support c99extidentifier correctly. Requires Unicode handling.
-
-        const std::string begin = alphabet + "_";
-        const std::string subsequent = begin + digits;
-
-        std::string result = value;
-        std::string::size_type offset = result.find_first_not_of(begin);
-        while (offset != std::string::npos) {
-            result[offset] = '_';
-            offset = result.find_first_not_of(subsequent, offset);
+    static const std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    static const std::string digits = "0123456789";
+
+    switch (operation) {
+        case Value::Program::Operation::Identifier:
+        case Value::Program::Operation::C99ExtIdentifier: {
+            // TODO(grp): Support c99extidentifier correctly. Requires Unicode handling.
+
+            static const std::string begin = alphabet + "_";
+            static const std::string subsequent = begin + digits;
+
+            std::string &result = *value;
+            std::string::size_type offset = result.find_first_not_of(begin);
+            while (offset != std::string::npos) {
+                result[offset] = '_';
+                offset = result.find_first_not_of(subsequent, offset);
+            }
+            break;
         }
-
-        return result;
-    } else if (operation == "rfc1034identifier") {
-        const std::string begin = alphabet;
-        const std::string subsequent = alphabet + digits + "-";
-        const std::string end = alphabet + digits;
-
-        std::string result = value;
-        for (std::string::iterator it = result.begin(), prev = result.end(), next = (it == result.end() ? it : std::next(it)); it != result.end(); prev = it, ++it, next = (it == result.end() ? it : std::next(it))) {
-            // Cannot start or end with a dot.
-            if (prev == result.end() || next == result.end()) {
-                if (*it == '.') {
-                    *it = '-';
+        case Value::Program::Operation::RFC1034Identifier: {
+            static const std::string begin = alphabet;
+            static const std::string subsequent = alphabet + digits + "-";
+            static const std::string end = alphabet + digits;
+
+            std::string &result = *value;
+            for (std::string::iterator it = result.begin(), prev = result.end(), next = (it == result.end() ? it : std::next(it)); it != result.end(); prev = it, ++it, next = (it == result.end() ? it : std::next(it))) {
+                // Cannot start or end with a dot.
+                if (prev == result.end() || next == result.end()) {
+                    if (*it == '.') {
+                        *it = '-';
+                    }
                 }
-            }
 
-            // Cannot have digit or hyphen after dot, or hyphen before dot.
-            if (prev == result.end() || *prev == '.') {
-                if (begin.find(*it) == std::string::npos) {
-                    *it = '-';
-                }
-            } else if (next != result.end() && *next == '.') {
-                if (subsequent.find(*it) == std::string::npos) {
-                    *it = '-';
-                }
-            } else {
-                if (end.find(*it) == std::string::npos) {
-                    *it = '-';
+                // Cannot have digit or hyphen after dot, or hyphen before dot.
+                if (prev == result.end() || *prev == '.') {
+                    if (begin.find(*it) == std::string::npos) {
+                        *it = '-';
+                    }
+                } else if (next != result.end() && *next == '.') {
+                    if (subsequent.find(*it) == std::string::npos) {
+                        *it = '-';
+                    }
+                } else {
+                    if (end.find(*it) == std::string::npos) {
+                        *it = '-';
+                    }
                 }
             }
+            break;
         }
-
-        return result;
-    } else if (operation == "quote") {
-        // FIXME(grp): This is (probably) valid, but not necessarily compatible. Algorithm from Python's shlex.quote().
-        if (value.find_first_not_of(alphabet + digits + "@%_-+=:,./") == std::string::npos) {
-            return value;
-        } else {
-            std::string result = value;
-            std::string::size_type offset = 0;
-            while ((offset = result.find("'", offset)) != std::string::npos) {
-                result.replace(offset, 1, "'\"'\"'");
-                offset += 5;
+        case Value::Program::Operation::Quote: {
+            // FIXME(grp): This is (probably) valid, but not necessarily compatible. Algorithm from Python's shlex.quote().
+            static const std::string safe = alphabet + digits + "@%_-+=:,./";
+            if (value->find_first_not_of(safe) != std::string::npos) {
+                std::string::size_type offset = 0;
+                while ((offset = value->find("'", offset)) != std::string::npos) {
+                    value->replace(offset, 1, "'\"'\"'");
+                    offset += 5;
+                }
+                value->insert(value->begin(), '\'');
+                value->push_back('\'');
             }
-            return "'" + result + "'";
+            break;
+        }
+        case Value::Program::Operation::Lower: {
+            std::transform(value->begin(), value->end(), value->begin(), ::tolower);
+            break;
+        }
+        case Value::Program::Operation::Upper: {
+            std::transform(value->begin(), value->end(), value->begin(), ::toupper);
+            break;
+        }
+        case Value::Program::Operation::StandardizePath: {
+            *value = FSUtil::NormalizePath(*value);
+            break;
+        }
+        case Value::Program::Operation::Base: {
+            *value = FSUtil::GetBaseNameWithoutExtension(*value);
+            break;
+        }
+        case Value::Program::Operation::Dir: {
+            *value = FSUtil::GetDirectoryName(*value);
+            break;
+        }
+        case Value::Program::Operation::File: {
+            *value = FSUtil::GetBaseName(*value);
+            break;
+        }
+        case Value::Program::Operation::Suffix: {
+            *value = "." + FSUtil::GetFileExtension(*value);
+            break;
+        }
+        case Value::Program::Operation::Unknown: {
+            fprintf(stderr, "warning: unknown build setting operation in '%s'\n", reference.c_str());
+            break;
         }
-    } else if (operation == "lower") {
-        std::string result = value;
-        std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-        return result;
-    } else if (operation == "upper") {
-        std::string result = value;
-        std::transform(result.begin(), result.end(), result.begin(), ::toupper);
-        return result;
-    } else if (operation == "standardizepath") {
-        return FSUtil::NormalizePath(value);
-    } else if (operation == "base") {
-        return FSUtil::GetBaseNameWithoutExtension(value);
-    } else if (operation == "dir") {
-        return FSUtil::GetDirectoryName(value);
-    } else if (operation == "file") {
-        return FSUtil::GetBaseName(value);
-    } else if (operation == "suffix") {
-        return "." + FSUtil::GetFileExtension(value);
-    } else {
-        fprintf(stderr, "warning: unknown build setting operation '%s'\n", operation.c_str());
-        return value;
     }
 }
 
-std::string Environment::
-resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const
+void Environment::
+resolveReference(Condition const &condition, std::string const &raw, std::string const &setting, std::vector<Value::Program::Operation> const &operations, InheritanceContext const &context, std::string *result) const
 {
-    std::string result;
-    for (auto const &entry : value.entries()) {
-        switch (entry.type) {
-            case Value::Entry::String: {
-                result += entry.string;
-                break;
-            }
-            case Value::Entry::Value: {
-                std::string resolved = resolveValue(condition, *entry.value, context);
-                if (context.valid && (resolved == context.setting || resolved == "inherited")) {
-                    result += resolveInheritance(condition, context);
-                } else {
-                    std::string setting = resolved;
+    if (context.valid && (raw == context.setting || raw == "inherited")) {
+        resolveInheritance(condition, context, result);
+    } else if (operations.empty()) {
+        result->append(resolveAssignment(condition, setting));
+    } else {
+        std::string value = resolveAssignment(condition, setting);
+        for (Value::Program::Operation operation : operations) {
+            ProcessOperation(&value, operation, raw);
+        }
+        result->append(value);
+    }
+}
 
-                    std::string::size_type colon = resolved.find(':');
-                    if (colon != std::string::npos) {
-                        setting = resolved.substr(0, colon);
-                    }
+void Environment::
+resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context, std::string *result) const
+{
+    Value::Program const &program = value.program();
 
-                    std::string value = resolveAssignment(condition, setting);
+    /* Start of the computed names of nested references in the result. */
+    std::vector<size_t> names;
 
-                    while (colon != std::string::npos) {
-                        std::string::size_type next = resolved.find(':', colon + 1);
+    for (Value::Program::Instruction const &instruction : program.instructions()) {
+        switch (instruction.opcode) {
+            case Value::Program::Instruction::Literal: {
+                result->append(program.text(), instruction.offset, instruction.length);
+                break;
+            }
+            case Value::Program::Instruction::Reference: {
+                Value::Program::Reference const &reference = program.references()[instruction.offset];
+                resolveReference(condition, reference.raw, reference.setting, reference.operations, context, result);
+                break;
+            }
+            case Value::Program::Instruction::Begin: {
+                names.push_back(result->size());
+                break;
+            }
+            case Value::Program::Instruction::End: {
+                size_t start = names.back();
+                names.pop_back();
 
-                        std::string operation = resolved.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
-                        value = ProcessOperation(value, operation);
+                std::string raw = result->substr(start);
+                result->resize(start);
 
-                        colon = next;
-                    }
+                std::string setting;
+                std::vector<Value::Program::Operation> operations;
+                Value::Program::ParseReference(raw, &setting, &operations);
 
-                    result += value;
-                }
+                resolveReference(condition, raw, setting, operations, context, result);
                 break;
             }
         }
     }
-    return result;
 }
 
-std::string Environment::
-resolveInheritance(Condition const &condition, InheritanceContext const &context) const
+void Environment::
+resolveInheritance(Condition const &condition, InheritanceContext const &context, std::string *result) const
 {
     InheritanceContext ctx = context;
     for (++ctx.it; ctx.it != _levels.end(); ++ctx.it) {
-        auto result = ctx.it->get(ctx.setting, condition);
-        if (result.first) {
-            return resolveValue(condition, result.second, ctx);
+        auto level = ctx.it->get(ctx.setting, condition);
+        if (level.first) {
+            resolveValue(condition, level.second, ctx, result);
+            return;
         }
     }
-
-    return "";
 }
 
-std::string Environment::
+std::string const &Environment::
 resolveAssignment(Condition const &condition, std::string const &setting) const
 {
+    {
+        std::lock_guard<std::mutex> lock(_cache->mutex);
+
+        auto values = _cache->values.find(condition);
+        if (values != _cache->values.end()) {
+            auto it = values->second.find(setting);
+            if (it != values->second.end()) {
+                return it->second;
+            }
+        }
+    }
+
+    std::string value;
+    bool found = false;
+
     InheritanceContext context = { .valid = true, .setting = setting };
 
     for (context.it = _levels.begin(); context.it != _levels.end(); ++context.it) {
         Level const &level = *context.it;
         auto result = level.get(setting, condition);
         if (result.first) {
-            return resolveValue(condition, result.second, context);
+            resolveValue(condition, result.second, context, &value);
+            found = true;
+            break;
         }
     }
 
-    if (condition.values().empty()) {
-        return "";
-    } else {
-        return resolveAssignment(Condition::Empty(), setting);
+    if (!found && !condition.values().empty()) {
+        value = resolveAssignment(Condition::Empty(), setting);
     }
+
+    /*
+     * Resolving may have added other values, so look up the condition again.
+     * Another thread may have resolved the same setting meanwhile; the values
+     * are identical, so keep the first. Cached values are never moved, so
+     * references to them stay valid.
+     */
+    std::lock_guard<std::mutex> lock(_cache->mutex);
+    return _cache->values[condition].emplace(setting, std::move(value)).first->second;
 }
 
 std::string Environment::
 expand(Value const &value, Condition const &condition) const
 {
-    return resolveValue(condition, value, { .valid = false });
+    std::string result;
+    resolveValue(condition, value, { .valid = false }, &result);
+    return result;
 }
 
 std::string Environment::
@@ -238,6 +293,8 @@ computeValues(Condition const &condition) const
 void Environment::
 insertFront(Level const &level, bool isDefault)
 {
+    _cache = std::make_shared<ResolutionCache>();
+
     if (!isDefault) {
         _levels.push_front(level);
         ++_offset;
@@ -249,6 +306,8 @@ insertFront(Level const &level, bool isDefault)
 void Environment::
 insertBack(Level const &level, bool isDefault)
 {
+    _cache = std::make_shared<ResolutionCache>();
+
     if (!isDefault) {
         _levels.insert(std::next(_levels.begin(), _offset), level);
         ++_offset;
@@ -16,8 +16,13 @@ using pbxsetting::Value;
 
 Level::
 Level(std::vector<Setting> const &settings) :
-    _settings(std::make_shared<std::vector<Setting>>(settings))
+    _settings(std::make_shared<std::vector<Setting>>(settings)),
+    _index   (std::make_shared<std::unordered_map<std::string, std::vector<size_t>>>())
 {
+    /* Index settings by name; later settings in a level override earlier ones. */
+    for (size_t i = 0; i < _settings->size(); ++i) {
+        (*_index)[(*_settings)[i].name()].push_back(i);
+    }
 }
 
 Level::
@@ -28,9 +33,15 @@ Level::
 std::pair<bool, Value> Level::
 get(std::string const &setting, Condition const &condition) const
 {
-    for (auto it = _settings->rbegin(); it != _settings->rend(); ++it) {
-        if (it->match(setting, condition)) {
-            return std::make_pair(true, it->value());
+    auto indexes = _index->find(setting);
+    if (indexes == _index->end()) {
+        return std::make_pair(false, Value::Empty());
+    }
+
+    for (auto it = indexes->second.rbegin(); it != indexes->second.rend(); ++it) {
+        Setting const &candidate = (*_settings)[*it];
+        if (candidate.condition().match(condition)) {
+            return std::make_pair(true, candidate.value());
         }
     }
 
@@ -15,6 +15,7 @@
 #include <plist/Real.h>
 #include <plist/String.h>
 
+#include <algorithm>
 #include <cassert>
 
 using pbxsetting::Value;
@@ -56,7 +57,8 @@ operator!=(Entry const &entry) const
 
 Value::
 Value(std::vector<Entry> const &entries) :
-    _entries(entries)
+    _entries(entries),
+    _program(Program::Compile(entries))
 {
 }
 
@@ -65,6 +67,95 @@ Value::
 {
 }
 
+Value::Program::Operation Value::Program::
+ParseOperation(std::string const &operation)
+{
+    if (operation == "identifier") {
+        return Operation::Identifier;
+    } else if (operation == "c99extidentifier") {
+        return Operation::C99ExtIdentifier;
+    } else if (operation == "rfc1034identifier") {
+        return Operation::RFC1034Identifier;
+    } else if (operation == "quote") {
+        return Operation::Quote;
+    } else if (operation == "lower") {
+        return Operation::Lower;
+    } else if (operation == "upper") {
+        return Operation::Upper;
+    } else if (operation == "standardizepath") {
+        return Operation::StandardizePath;
+    } else if (operation == "base") {
+        return Operation::Base;
+    } else if (operation == "dir") {
+        return Operation::Dir;
+    } else if (operation == "file") {
+        return Operation::File;
+    } else if (operation == "suffix") {
+        return Operation::Suffix;
+    } else {
+        return Operation::Unknown;
+    }
+}
+
+void Value::Program::
+ParseReference(std::string const &raw, std::string *setting, std::vector<Operation> *operations)
+{
+    std::string::size_type colon = raw.find(':');
+    *setting = raw.substr(0, colon);
+
+    while (colon != std::string::npos) {
+        std::string::size_type next = raw.find(':', colon + 1);
+        operations->push_back(ParseOperation(raw.substr(colon + 1, next == std::string::npos ? next : next - colon - 1)));
+        colon = next;
+    }
+}
+
+void Value::Program::
+compile(std::vector<Entry> const &entries)
+{
+    for (Value::Entry const &entry : entries) {
+        switch (entry.type) {
+            case Value::Entry::String: {
+                if (!_instructions.empty() && _instructions.back().opcode == Instruction::Literal && _instructions.back().offset + _instructions.back().length == _text.size()) {
+                    /* Extend the previous literal. */
+                    _instructions.back().length += entry.string.size();
+                } else {
+                    _instructions.push_back({ Instruction::Literal, _text.size(), entry.string.size() });
+                }
+                _text += entry.string;
+                break;
+            }
+            case Value::Entry::Value: {
+                bool constant = std::all_of(entry.value->entries().begin(), entry.value->entries().end(), [](Value::Entry const &nested) {
+                    return nested.type == Value::Entry::String;
+                });
+
+                if (constant) {
+                    Reference reference;
+                    reference.raw = entry.value->raw();
+                    ParseReference(reference.raw, &reference.setting, &reference.operations);
+
+                    _instructions.push_back({ Instruction::Reference, _references.size(), 0 });
+                    _references.push_back(reference);
+                } else {
+                    _instructions.push_back({ Instruction::Begin, 0, 0 });
+                    compile(entry.value->entries());
+                    _instructions.push_back({ Instruction::End, 0, 0 });
+                }
+                break;
+            }
+        }
+    }
+}
+
+std::shared_ptr<Value::Program const> Value::Program::
+Compile(std::vector<Entry> const &entries)
+{
+    std::shared_ptr<Program> program = std::make_shared<Program>();
+    program->compile(entries);
+    return program;
+}
+
 std::string Value::
 raw() const
 {
@@ -24,7 +24,8 @@ Config::~Config()
 Config::shared_ptr Config::
 Open(std::string const &path, Environment const &environment, error_function const &error)
 {
-    std::pair<bool, Level> result = ConfigFile().open(path, environment, error);
+    std::vector<std::string> includedPaths;
+    std::pair<bool, Level> result = ConfigFile().open(path, environment, error, &includedPaths);
     if (!result.first) {
         return nullptr;
     }
@@ -32,6 +33,7 @@ Open(std::string const &path, Environment const &environment, error_function con
     auto config = std::make_shared <Config> ();
     config->_path = path;
     config->_level = result.second;
+    config->_includedPaths = includedPaths;
 
     return config;
 }
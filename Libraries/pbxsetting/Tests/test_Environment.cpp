@@ -2,6 +2,8 @@
 #include <gtest/gtest.h>
 #include <pbxsetting/Environment.h>
 
+#include <thread>
+
 using pbxsetting::Environment;
 using pbxsetting::Level;
 using pbxsetting::Setting;
@@ -172,3 +174,70 @@ TEST(Environment, Default)
     EXPECT_EQ(env.resolve("THREE"), "3");
 }
 
+TEST(Environment, InsertAfterResolve)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE = one"),
+        Setting::Parse("TWO = $(ONE) two"),
+    }), false);
+    EXPECT_EQ(env.resolve("TWO"), "one two");
+
+    Environment copy = env;
+    copy.insertFront(Level({
+        Setting::Parse("ONE = 1"),
+    }), false);
+    EXPECT_EQ(copy.resolve("TWO"), "1 two");
+    EXPECT_EQ(env.resolve("TWO"), "one two");
+
+    env.insertBack(Level({
+        Setting::Parse("THREE = three"),
+    }), false);
+    EXPECT_EQ(env.resolve("THREE"), "three");
+}
+
+TEST(Environment, Conditions)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("FLAGS = -generic"),
+        Setting::Parse("FLAGS[arch=arm64] = -arm64"),
+        Setting::Parse("OTHER = $(FLAGS)"),
+    }), false);
+
+    pbxsetting::Condition arm64 = pbxsetting::Condition(std::unordered_map<std::string, std::string>({ { "arch", "arm64" } }));
+    pbxsetting::Condition x86_64 = pbxsetting::Condition(std::unordered_map<std::string, std::string>({ { "arch", "x86_64" } }));
+    EXPECT_EQ(env.resolve("OTHER", arm64), "-arm64");
+    EXPECT_EQ(env.resolve("OTHER", x86_64), "-generic");
+    EXPECT_EQ(env.resolve("OTHER"), "-generic");
+    EXPECT_EQ(env.resolve("OTHER", arm64), "-arm64");
+}
+
+TEST(Environment, ConcurrentCopies)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE = one"),
+        Setting::Parse("TWO = $(ONE) two"),
+        Setting::Parse("THREE = $(TWO) three"),
+    }), false);
+
+    /* Copies share a cache, so resolving them at once must be safe. */
+    std::vector<std::string> results = std::vector<std::string>(8);
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < results.size(); n++) {
+        Environment copy = env;
+        threads.push_back(std::thread([copy, n, &results]() {
+            for (int i = 0; i < 100; i++) {
+                results[n] = copy.resolve("THREE");
+            }
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (std::string const &result : results) {
+        EXPECT_EQ(result, "one two three");
+    }
+}
@@ -209,3 +209,30 @@ TEST(Value, Add)
     ASSERT_EQ(string_string.entries().at(0).type, Value::Entry::String);
     EXPECT_EQ(string_string.entries().at(0).string, "teststring");
 }
+
+TEST(Value, Program)
+{
+    Value value = Value::Parse("ONE_$(TWO:upper:quote)_$(THREE_$(FOUR))");
+    Value::Program const &program = value.program();
+
+    ASSERT_EQ(program.references().size(), 2);
+    EXPECT_EQ(program.references().at(0).raw, "TWO:upper:quote");
+    EXPECT_EQ(program.references().at(0).setting, "TWO");
+    ASSERT_EQ(program.references().at(0).operations.size(), 2);
+    EXPECT_EQ(program.references().at(0).operations.at(0), Value::Program::Operation::Upper);
+    EXPECT_EQ(program.references().at(0).operations.at(1), Value::Program::Operation::Quote);
+    EXPECT_EQ(program.references().at(1).setting, "FOUR");
+
+    ASSERT_EQ(program.instructions().size(), 7);
+    EXPECT_EQ(program.instructions().at(0).opcode, Value::Program::Instruction::Literal);
+    EXPECT_EQ(program.instructions().at(1).opcode, Value::Program::Instruction::Reference);
+    EXPECT_EQ(program.instructions().at(2).opcode, Value::Program::Instruction::Literal);
+    EXPECT_EQ(program.instructions().at(3).opcode, Value::Program::Instruction::Begin);
+    EXPECT_EQ(program.instructions().at(4).opcode, Value::Program::Instruction::Literal);
+    EXPECT_EQ(program.instructions().at(5).opcode, Value::Program::Instruction::Reference);
+    EXPECT_EQ(program.instructions().at(6).opcode, Value::Program::Instruction::End);
+    EXPECT_EQ(program.text(), "ONE__THREE_");
+
+    EXPECT_EQ(Value::Parse("").program().instructions().size(), 0);
+    EXPECT_EQ((Value::String("A") + Value::String("B")).program().instructions().size(), 1);
+}
@@ -0,0 +1,90 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxsetting/DefaultSettings.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Setting.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using pbxsetting::DefaultSettings;
+using pbxsetting::Environment;
+using pbxsetting::Level;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+
+/*
+ * Microbenchmark for build setting evaluation over the default setting levels,
+ * with a level of typical project settings in front of them.
+ */
+int
+main(int argc, char **argv)
+{
+    size_t iterations = (argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000);
+
+    Environment environment;
+    for (Level const &level : DefaultSettings::Levels()) {
+        environment.insertBack(level, true);
+    }
+    environment.insertFront(Level({
+        Setting::Parse("PRODUCT_NAME", "My App"),
+        Setting::Parse("PRODUCT_MODULE_NAME", "$(PRODUCT_NAME:c99extidentifier)"),
+        Setting::Parse("PRODUCT_BUNDLE_IDENTIFIER", "com.example.$(PRODUCT_NAME:rfc1034identifier:lower)"),
+        Setting::Parse("DEVELOPER_DIR", "/Applications/Xcode.app/Contents/Developer"),
+        Setting::Parse("DEVELOPER_LIBRARY_DIR", "$(DEVELOPER_DIR)/Library"),
+        Setting::Parse("DEVELOPER_USR_DIR", "$(DEVELOPER_DIR)/usr"),
+        Setting::Parse("DEVELOPER_BIN_DIR", "$(DEVELOPER_USR_DIR)/bin"),
+        Setting::Parse("ARCH_SUFFIX_x86_64", "64"),
+        Setting::Parse("CURRENT_ARCH", "x86_64"),
+        Setting::Parse("ARCH_SUFFIX", "$(ARCH_SUFFIX_$(CURRENT_ARCH))"),
+        Setting::Parse("OTHER_CFLAGS", "-DNAME=$(PRODUCT_NAME:quote) -DSUFFIX=$(ARCH_SUFFIX)"),
+    }), false);
+
+    std::vector<Value> values;
+    Level system = DefaultSettings::System();
+    for (Setting const &setting : system.settings()) {
+        values.push_back(setting.value());
+    }
+    values.push_back(Value::Parse("$(PRODUCT_BUNDLE_IDENTIFIER) $(OTHER_CFLAGS) $(DEVELOPER_BIN_DIR)/clang"));
+
+    /* Resolve every setting from an empty cache. */
+    auto start = std::chrono::steady_clock::now();
+    size_t settings = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        Environment copy = environment;
+        copy.insertFront(Level({ }), false);
+        settings += copy.computeValues(pbxsetting::Condition::Empty()).size();
+    }
+    auto cold = std::chrono::steady_clock::now() - start;
+
+    /* Expand values against a warm cache. */
+    start = std::chrono::steady_clock::now();
+    size_t length = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        for (Value const &value : values) {
+            length += environment.expand(value).size();
+        }
+    }
+    auto warm = std::chrono::steady_clock::now() - start;
+
+    printf("cold: %zu settings in %.3f ms (%.1f ns/setting)\n",
+        settings,
+        std::chrono::duration<double, std::milli>(cold).count(),
+        std::chrono::duration<double, std::nano>(cold).count() / std::max<size_t>(settings, 1));
+    printf("warm: %zu expansions in %.3f ms (%.1f ns/expansion, %zu bytes)\n",
+        iterations * values.size(),
+        std::chrono::duration<double, std::milli>(warm).count(),
+        std::chrono::duration<double, std::nano>(warm).count() / std::max<size_t>(iterations * values.size(), 1),
+        length);
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxspec_FileTypeIndex_h
+#define __pbxspec_FileTypeIndex_h
+
+#include <pbxspec/PBX/FileType.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pbxspec {
+
+/*
+ * Determines the file type of paths from the file types in a set of domains.
+ * The file types are ordered once, most specific first, and indexed by their
+ * extensions; only types without extensions are tested against every path.
+ * Results are remembered per path. Safe to use from multiple threads.
+ */
+class FileTypeIndex {
+public:
+    typedef std::shared_ptr<FileTypeIndex> shared_ptr;
+
+private:
+    PBX::FileType::vector                                     _fileTypes;
+    std::unordered_map<std::string, std::vector<size_t>>      _extensionFileTypes;
+    std::vector<size_t>                                       _otherFileTypes;
+    size_t                                                    _magicWordLength;
+    PBX::FileType::shared_ptr                                 _file;
+    PBX::FileType::shared_ptr                                 _folder;
+
+private:
+    mutable std::mutex                                        _resolvedMutex;
+    mutable std::unordered_map<std::string, PBX::FileType::shared_ptr> _resolved;
+
+public:
+    FileTypeIndex(
+        PBX::FileType::vector const &fileTypes,
+        PBX::FileType::shared_ptr const &file,
+        PBX::FileType::shared_ptr const &folder);
+
+public:
+    /*
+     * All file types, in the order they are matched.
+     */
+    PBX::FileType::vector const &fileTypes() const
+    { return _fileTypes; }
+
+public:
+    /*
+     * Determine the file type of a path. Falls back to the generic file or
+     * folder type if no more specific type matches.
+     */
+    PBX::FileType::shared_ptr
+    resolve(std::string const &filePath) const;
+
+private:
+    PBX::FileType::shared_ptr
+    match(std::string const &filePath) const;
+
+public:
+    /*
+     * Create an index of file types. Fails if the file types inherit from
+     * each other in a cycle.
+     */
+    static FileTypeIndex::shared_ptr
+    Create(
+        PBX::FileType::vector const &fileTypes,
+        PBX::FileType::shared_ptr const &file,
+        PBX::FileType::shared_ptr const &folder);
+};
+
+}
+
+#endif // !__pbxspec_FileTypeIndex_h
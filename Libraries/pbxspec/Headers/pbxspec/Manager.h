@@ -24,26 +24,50 @@
 #include <pbxspec/PBX/PropertyConditionFlavor.h>
 #include <pbxspec/PBX/Specification.h>
 #include <pbxspec/PBX/Tool.h>
+#include <pbxspec/FileTypeIndex.h>
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <unordered_set>
 #include <utility>
 
 namespace libutil { class Filesystem; }
+namespace plist { class Cache; }
 
 namespace pbxspec {
 
+/*
+ * Holds the specifications loaded from each domain. Specifications are found
+ * by identifier through an index. The lists returned for a set of domains are
+ * created once and are valid until more specifications are registered.
+ */
 class Manager {
 public:
     typedef std::shared_ptr <Manager> shared_ptr;
 
+private:
+    typedef std::unordered_map<std::string, PBX::Specification::shared_ptr> IdentifierSpecifications;
+
 private:
     std::unordered_set<std::string>                                           _domains;
     std::map<std::string, std::map<char const *, PBX::Specification::vector>> _specifications;
+    std::map<std::string, std::map<char const *, IdentifierSpecifications>>   _specificationIdentifiers;
     PBX::BuildRule::vector                                                    _buildRules;
+    std::vector<std::string>                                                  _loadedFilePaths;
+
+private:
+    typedef std::pair<void const *, char const *> ViewType;
+
+    mutable std::mutex                                                                   _viewsMutex;
+    mutable std::map<ViewType, std::unordered_map<std::string, std::shared_ptr<void>>> _views;
+
+private:
+    mutable std::mutex                                                        _fileTypeIndexesMutex;
+    mutable std::unordered_map<std::string, FileTypeIndex::shared_ptr>        _fileTypeIndexes;
 
 public:
     Manager();
@@ -52,79 +76,86 @@ public:
 public:
     PBX::Specification::shared_ptr
     specification(char const *type, std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::Specification::vector
+    PBX::Specification::vector const &
     specifications(char const *type, std::vector<std::string> const &domains) const;
 
 public:
     PBX::Architecture::shared_ptr
     architecture(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::Architecture::vector
+    PBX::Architecture::vector const &
     architectures(std::vector<std::string> const &domains) const;
 
 public:
     PBX::BuildPhase::shared_ptr
     buildPhase(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::BuildPhase::vector
+    PBX::BuildPhase::vector const &
     buildPhases(std::vector<std::string> const &domains) const;
 
 public:
     PBX::BuildSettings::shared_ptr
     buildSettings(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::BuildSettings::vector
+    PBX::BuildSettings::vector const &
     buildSettingses(std::vector<std::string> const &domains) const;
 
 public:
     PBX::BuildStep::shared_ptr
     buildStep(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::BuildStep::vector
+    PBX::BuildStep::vector const &
     buildSteps(std::vector<std::string> const &domains) const;
 
 public:
     PBX::BuildSystem::shared_ptr
     buildSystem(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::BuildSystem::vector
+    PBX::BuildSystem::vector const &
     buildSystems(std::vector<std::string> const &domains) const;
 
 public:
     PBX::Compiler::shared_ptr
     compiler(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::Compiler::vector
+    PBX::Compiler::vector const &
     compilers(std::vector<std::string> const &domains) const;
 
 public:
     PBX::FileType::shared_ptr
     fileType(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::FileType::vector
+    PBX::FileType::vector const &
     fileTypes(std::vector<std::string> const &domains) const;
 
+    /*
+     * An index for determining the file type of paths, created once for
+     * each set of domains. Null if the file types can't be ordered.
+     */
+    FileTypeIndex::shared_ptr
+    fileTypeIndex(std::vector<std::string> const &domains) const;
+
 public:
     PBX::Linker::shared_ptr
     linker(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::Linker::vector
+    PBX::Linker::vector const &
     linkers(std::vector<std::string> const &domains) const;
 
 public:
     PBX::PackageType::shared_ptr
     packageType(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::PackageType::vector
+    PBX::PackageType::vector const &
     packageTypes(std::vector<std::string> const &domains) const;
 
 public:
     PBX::ProductType::shared_ptr
     productType(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::ProductType::vector
+    PBX::ProductType::vector const &
     productTypes(std::vector<std::string> const &domains) const;
 
 public:
     PBX::PropertyConditionFlavor::shared_ptr
     propertyConditionFlavor(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::PropertyConditionFlavor::vector
+    PBX::PropertyConditionFlavor::vector const &
     propertyConditionFlavors(std::vector<std::string> const &domains) const;
 
 public:
     PBX::Tool::shared_ptr
     tool(std::string const &identifier, std::vector<std::string> const &domains) const;
-    PBX::Tool::vector
+    PBX::Tool::vector const &
     tools(std::vector<std::string> const &domains) const;
 
 public:
@@ -133,9 +164,20 @@ public:
     PBX::BuildRule::vector synthesizedBuildRules(std::vector<std::string> const &domains) const;
 
 public:
-    void registerDomains(libutil::Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains);
+    /*
+     * Loads the specifications in each domain. Specification files are read
+     * through the cache, if provided.
+     */
+    void registerDomains(libutil::Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains, plist::Cache *cache = nullptr);
     bool registerBuildRules(libutil::Filesystem const *filesystem, std::string const &path);
 
+public:
+    /*
+     * All specification and build rule files loaded into the manager.
+     */
+    std::vector<std::string> const &loadedFilePaths() const
+    { return _loadedFilePaths; }
+
 private:
     void addSpecification(PBX::Specification::shared_ptr const &specification);
     bool inheritSpecification(PBX::Specification::shared_ptr const &specification);
@@ -145,7 +187,7 @@ private:
     typename T::shared_ptr
     findSpecification(std::vector<std::string> const &domains, std::string const &identifier, char const *type = T::Type()) const;
     template <typename T>
-    typename T::vector
+    typename T::vector const &
     findSpecifications(std::vector<std::string> const &domains, char const *type = T::Type()) const;
 
 public:
@@ -25,6 +25,7 @@
 #include <pbxspec/PBX/Specification.h>
 #include <pbxspec/PBX/Tool.h>
 
+#include <pbxspec/FileTypeIndex.h>
 #include <pbxspec/Manager.h>
 
 #endif  // !__pbxspec_pbxspec_h
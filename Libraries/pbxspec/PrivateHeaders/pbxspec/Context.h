@@ -12,6 +12,8 @@
 
 #include <pbxspec/Manager.h>
 
+namespace plist { class Cache; }
+
 namespace pbxspec {
 
 class Context {
@@ -20,6 +22,10 @@ public:
 
 public:
     std::string defaultType;
+
+public:
+    /* Parsed specification files, if caching them. */
+    plist::Cache *cache;
 };
 
 }
@@ -0,0 +1,244 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxspec/FileTypeIndex.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Wildcard.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+using pbxspec::FileTypeIndex;
+using pbxspec::PBX::FileType;
+using libutil::FSUtil;
+using libutil::Wildcard;
+
+static std::string
+Lowercase(std::string const &string)
+{
+    std::string result = string;
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+FileTypeIndex::
+FileTypeIndex(
+    FileType::vector const &fileTypes,
+    FileType::shared_ptr const &file,
+    FileType::shared_ptr const &folder) :
+    _fileTypes      (fileTypes),
+    _magicWordLength(0),
+    _file           (file),
+    _folder         (folder)
+{
+    for (size_t i = 0; i < _fileTypes.size(); i++) {
+        FileType::shared_ptr const &fileType = _fileTypes[i];
+
+        if (fileType->extensions()) {
+            /* Extensions match case-insensitively, for example ".S" as ".s". */
+            std::unordered_set<std::string> extensions;
+            for (std::string const &extension : *fileType->extensions()) {
+                if (extensions.insert(Lowercase(extension)).second) {
+                    _extensionFileTypes[Lowercase(extension)].push_back(i);
+                }
+            }
+        } else {
+            _otherFileTypes.push_back(i);
+        }
+
+        if (fileType->magicWords()) {
+            for (std::vector<uint8_t> const &magicWord : *fileType->magicWords()) {
+                _magicWordLength = std::max(_magicWordLength, magicWord.size());
+            }
+        }
+    }
+}
+
+FileType::shared_ptr FileTypeIndex::
+resolve(std::string const &filePath) const
+{
+    {
+        std::lock_guard<std::mutex> lock(_resolvedMutex);
+        auto it = _resolved.find(filePath);
+        if (it != _resolved.end()) {
+            return it->second;
+        }
+    }
+
+    FileType::shared_ptr fileType = match(filePath);
+
+    std::lock_guard<std::mutex> lock(_resolvedMutex);
+    _resolved.insert({ filePath, fileType });
+    return fileType;
+}
+
+FileType::shared_ptr FileTypeIndex::
+match(std::string const &filePath) const
+{
+    bool isReadable = FSUtil::TestForRead(filePath);
+    bool isFolder = isReadable && FSUtil::TestForDirectory(filePath);
+
+    std::string fileExtension = FSUtil::GetFileExtension(filePath);
+    std::string fileName = FSUtil::GetBaseName(filePath);
+
+    ext::optional<std::vector<uint8_t>> fileContents;
+
+    /* Candidates are types with this extension and types without any extension, in order. */
+    std::vector<size_t> candidates;
+    auto it = _extensionFileTypes.find(Lowercase(fileExtension));
+    if (it != _extensionFileTypes.end()) {
+        std::merge(it->second.begin(), it->second.end(), _otherFileTypes.begin(), _otherFileTypes.end(), std::back_inserter(candidates));
+    } else {
+        candidates = _otherFileTypes;
+    }
+
+    for (size_t candidate : candidates) {
+        FileType::shared_ptr const &fileType = _fileTypes[candidate];
+
+        if (isReadable && fileType->isFolder() != isFolder) {
+            continue;
+        }
+
+        /* Having an extension means it matched, since it's a candidate. */
+        bool empty = !fileType->extensions();
+
+        if (fileType->prefix()) {
+            empty = false;
+            bool matched = false;
+
+            for (std::string const &prefix : *fileType->prefix()) {
+                if (fileName.find(prefix) == 0) {
+                    matched = true;
+                }
+            }
+
+            if (!matched) {
+                continue;
+            }
+        }
+
+        if (fileType->filenamePatterns()) {
+            empty = false;
+            bool matched = false;
+
+            for (std::string const &pattern : *fileType->filenamePatterns()) {
+                if (Wildcard::Match(pattern, fileName)) {
+                    matched = true;
+                }
+            }
+
+            if (!matched) {
+                continue;
+            }
+        }
+
+        if (isReadable && fileType->permissions()) {
+            empty = false;
+            bool matched = false;
+
+            std::string const &permissions = *fileType->permissions();
+            if (permissions == "read") {
+                matched = isReadable;
+            } else if (permissions == "write") {
+                matched = FSUtil::TestForWrite(filePath);
+            } else if (permissions == "executable") {
+                matched = FSUtil::TestForExecute(filePath);
+            } else {
+                fprintf(stderr, "warning: unhandled permission %s\n", permissions.c_str());
+            }
+
+            if (!matched) {
+                continue;
+            }
+        }
+
+        // TODO(grp): Support TypeCodes. Not very important.
+
+        if (isReadable && fileType->magicWords()) {
+            empty = false;
+            bool matched = false;
+
+            /* Read enough for any magic word, once. */
+            if (!fileContents) {
+                fileContents = std::vector<uint8_t>();
+
+                std::ifstream fileHandle(filePath, std::ios::in | std::ios::binary);
+                if (fileHandle.good()) {
+                    fileContents->resize(_magicWordLength);
+                    fileHandle.read((char *)fileContents->data(), _magicWordLength);
+                    fileContents->resize(fileHandle.gcount());
+                }
+            }
+
+            for (std::vector<uint8_t> const &magicWord : *fileType->magicWords()) {
+                if (fileContents->size() >= magicWord.size() && std::equal(magicWord.begin(), magicWord.end(), fileContents->begin())) {
+                    matched = true;
+                }
+            }
+
+            if (!matched) {
+                continue;
+            }
+        }
+
+        //
+        // Matched no checks.
+        //
+        if (empty) {
+            continue;
+        }
+
+        //
+        // Matched all checks.
+        //
+        return fileType;
+    }
+
+    return (isFolder ? _folder : _file);
+}
+
+FileTypeIndex::shared_ptr FileTypeIndex::
+Create(
+    FileType::vector const &fileTypes,
+    FileType::shared_ptr const &file,
+    FileType::shared_ptr const &folder)
+{
+    /*
+     * Include base types, then order so more specific file types are
+     * matched first: each type comes before its base types.
+     */
+    FileType::vector all;
+    std::unordered_map<FileType::shared_ptr, size_t> depths;
+    for (FileType::shared_ptr const &fileType : fileTypes) {
+        for (FileType::shared_ptr type = fileType; type != nullptr && depths.find(type) == depths.end(); type = type->base()) {
+            depths.insert({ type, 0 });
+            all.push_back(type);
+        }
+    }
+
+    for (FileType::shared_ptr const &fileType : all) {
+        size_t depth = 0;
+        for (FileType::shared_ptr type = fileType->base(); type != nullptr; type = type->base()) {
+            if (++depth > all.size()) {
+                fprintf(stderr, "error: cycle creating file type graph\n");
+                return nullptr;
+            }
+        }
+        depths[fileType] = depth;
+    }
+
+    std::stable_sort(all.begin(), all.end(), [&depths](FileType::shared_ptr const &lhs, FileType::shared_ptr const &rhs) {
+        return depths.at(lhs) > depths.at(rhs);
+    });
+
+    return std::make_shared<FileTypeIndex>(all, file, folder);
+}
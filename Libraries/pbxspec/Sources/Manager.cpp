@@ -18,6 +18,7 @@
 
 using pbxspec::Manager;
 using pbxspec::Context;
+using pbxspec::FileTypeIndex;
 using pbxspec::PBX::Specification;
 using pbxspec::PBX::Architecture;
 using pbxspec::PBX::BuildPhase;
@@ -46,22 +47,41 @@ Manager::
 }
 
 template <typename T>
-typename T::vector Manager::
+typename T::vector const & Manager::
 findSpecifications(std::vector<std::string> const &domains, char const *type) const
 {
+    static typename T::vector const empty;
     if (type == nullptr) {
-        return typename T::vector();
+        return empty;
     }
 
-    typename T::vector specifications;
+    /* Views are cached by the element type as well as the specification type. */
+    static char const elementType = 0;
 
+    std::string key;
     for (std::string const &domain : domains) {
-        if (domain == AnyDomain()) {
+        key += domain;
+        key += '\0';
+    }
+
+    std::lock_guard<std::mutex> lock(_viewsMutex);
+
+    std::unordered_map<std::string, std::shared_ptr<void>> &views = _views[ViewType(&elementType, type)];
+    auto vit = views.find(key);
+    if (vit != views.end()) {
+        return *static_cast<typename T::vector const *>(vit->second.get());
+    }
+
+    auto specifications = std::make_shared<typename T::vector>();
+
+    std::string const anyDomain = AnyDomain();
+    for (std::string const &domain : domains) {
+        if (domain == anyDomain) {
             for (auto const &entry : _specifications) {
                 auto const &it = entry.second.find(type);
                 if (it != entry.second.end()) {
                     for (auto const &s : it->second) {
-                        specifications.emplace_back(std::static_pointer_cast<T>(s));
+                        specifications->emplace_back(std::static_pointer_cast<T>(s));
                     }
                 }
             }
@@ -71,28 +91,53 @@ findSpecifications(std::vector<std::string> const &domains, char const *type) co
                 auto const &it = doit->second.find(type);
                 if (it != doit->second.end()) {
                     for (auto const &s : it->second) {
-                        specifications.emplace_back(std::static_pointer_cast<T>(s));
+                        specifications->emplace_back(std::static_pointer_cast<T>(s));
                     }
                 }
             }
         }
     }
 
-    return specifications;
+    views.insert({ key, specifications });
+    return *specifications;
 }
 
 template <typename T>
 typename T::shared_ptr Manager::
 findSpecification(std::vector<std::string> const &domains, std::string const &identifier, char const *type) const
 {
-    typename T::vector vector = findSpecifications <T> (domains, type);
+    if (type == nullptr) {
+        return nullptr;
+    }
 
-    auto I = std::find_if(vector.begin(), vector.end(), [&identifier](Specification::shared_ptr const &spec) -> bool {
-        return identifier == spec->identifier();
-    });
+    auto find = [type, &identifier](std::map<char const *, IdentifierSpecifications> const &types) -> typename T::shared_ptr {
+        auto const &it = types.find(type);
+        if (it != types.end()) {
+            auto const &sit = it->second.find(identifier);
+            if (sit != it->second.end()) {
+                return std::static_pointer_cast<T>(sit->second);
+            }
+        }
+        return nullptr;
+    };
 
-    if (I != vector.end()) {
-        return *I;
+    /* The first match in the order of the domains. */
+    std::string const anyDomain = AnyDomain();
+    for (std::string const &domain : domains) {
+        if (domain == anyDomain) {
+            for (auto const &entry : _specificationIdentifiers) {
+                if (typename T::shared_ptr specification = find(entry.second)) {
+                    return specification;
+                }
+            }
+        } else {
+            auto const &doit = _specificationIdentifiers.find(domain);
+            if (doit != _specificationIdentifiers.end()) {
+                if (typename T::shared_ptr specification = find(doit->second)) {
+                    return specification;
+                }
+            }
+        }
     }
 
     return nullptr;
@@ -104,7 +149,7 @@ specification(char const *type, std::string const &identifier, std::vector<std::
     return findSpecification <Specification> (domains, identifier, type);
 }
 
-Specification::vector Manager::
+Specification::vector const & Manager::
 specifications(char const *type, std::vector<std::string> const &domains) const
 {
     return findSpecifications <Specification> (domains, type);
@@ -116,7 +161,7 @@ architecture(std::string const &identifier, std::vector<std::string> const &doma
     return findSpecification <Architecture> (domains, identifier);
 }
 
-Architecture::vector Manager::
+Architecture::vector const & Manager::
 architectures(std::vector<std::string> const &domains) const
 {
     return findSpecifications <Architecture> (domains);
@@ -128,7 +173,7 @@ buildPhase(std::string const &identifier, std::vector<std::string> const &domain
     return findSpecification <BuildPhase> (domains, identifier);
 }
 
-BuildPhase::vector Manager::
+BuildPhase::vector const & Manager::
 buildPhases(std::vector<std::string> const &domains) const
 {
     return findSpecifications <BuildPhase> (domains);
@@ -140,7 +185,7 @@ buildSettings(std::string const &identifier, std::vector<std::string> const &dom
     return findSpecification <BuildSettings> (domains, identifier);
 }
 
-BuildSettings::vector Manager::
+BuildSettings::vector const & Manager::
 buildSettingses(std::vector<std::string> const &domains) const
 {
     return findSpecifications <BuildSettings> (domains);
@@ -152,7 +197,7 @@ buildStep(std::string const &identifier, std::vector<std::string> const &domains
     return findSpecification <BuildStep> (domains, identifier);
 }
 
-BuildStep::vector Manager::
+BuildStep::vector const & Manager::
 buildSteps(std::vector<std::string> const &domains) const
 {
     return findSpecifications <BuildStep> (domains);
@@ -164,7 +209,7 @@ buildSystem(std::string const &identifier, std::vector<std::string> const &domai
     return findSpecification <BuildSystem> (domains, identifier);
 }
 
-BuildSystem::vector Manager::
+BuildSystem::vector const & Manager::
 buildSystems(std::vector<std::string> const &domains) const
 {
     return findSpecifications <BuildSystem> (domains);
@@ -176,7 +221,7 @@ compiler(std::string const &identifier, std::vector<std::string> const &domains)
     return findSpecification <Compiler> (domains, identifier);
 }
 
-Compiler::vector Manager::
+Compiler::vector const & Manager::
 compilers(std::vector<std::string> const &domains) const
 {
     return findSpecifications <Compiler> (domains);
@@ -188,19 +233,40 @@ fileType(std::string const &identifier, std::vector<std::string> const &domains)
     return findSpecification <FileType> (domains, identifier);
 }
 
-FileType::vector Manager::
+FileType::vector const & Manager::
 fileTypes(std::vector<std::string> const &domains) const
 {
     return findSpecifications <FileType> (domains);
 }
 
+FileTypeIndex::shared_ptr Manager::
+fileTypeIndex(std::vector<std::string> const &domains) const
+{
+    std::string key;
+    for (std::string const &domain : domains) {
+        key += domain;
+        key += '\0';
+    }
+
+    std::lock_guard<std::mutex> lock(_fileTypeIndexesMutex);
+
+    auto it = _fileTypeIndexes.find(key);
+    if (it != _fileTypeIndexes.end()) {
+        return it->second;
+    }
+
+    FileTypeIndex::shared_ptr index = FileTypeIndex::Create(fileTypes(domains), fileType("file", domains), fileType("folder", domains));
+    _fileTypeIndexes.insert({ key, index });
+    return index;
+}
+
 Linker::shared_ptr Manager::
 linker(std::string const &identifier, std::vector<std::string> const &domains) const
 {
     return findSpecification <Linker> (domains, identifier);
 }
 
-Linker::vector Manager::
+Linker::vector const & Manager::
 linkers(std::vector<std::string> const &domains) const
 {
     return findSpecifications <Linker> (domains);
@@ -212,7 +278,7 @@ packageType(std::string const &identifier, std::vector<std::string> const &domai
     return findSpecification <PackageType> (domains, identifier);
 }
 
-PackageType::vector Manager::
+PackageType::vector const & Manager::
 packageTypes(std::vector<std::string> const &domains) const
 {
     return findSpecifications <PackageType> (domains);
@@ -224,7 +290,7 @@ productType(std::string const &identifier, std::vector<std::string> const &domai
     return findSpecification <ProductType> (domains, identifier);
 }
 
-ProductType::vector Manager::
+ProductType::vector const & Manager::
 productTypes(std::vector<std::string> const &domains) const
 {
     return findSpecifications <ProductType> (domains);
@@ -236,7 +302,7 @@ propertyConditionFlavor(std::string const &identifier, std::vector<std::string>
     return findSpecification <PropertyConditionFlavor> (domains, identifier);
 }
 
-PropertyConditionFlavor::vector Manager::
+PropertyConditionFlavor::vector const & Manager::
 propertyConditionFlavors(std::vector<std::string> const &domains) const
 {
     return findSpecifications <PropertyConditionFlavor> (domains);
@@ -248,7 +314,7 @@ tool(std::string const &identifier, std::vector<std::string> const &domains) con
     return findSpecification <Tool> (domains, identifier);
 }
 
-Tool::vector Manager::
+Tool::vector const & Manager::
 tools(std::vector<std::string> const &domains) const
 {
     return findSpecifications <Tool> (domains);
@@ -314,6 +380,15 @@ addSpecification(PBX::Specification::shared_ptr const &spec)
             spec->type(), spec->domain().c_str(), spec->identifier().c_str());
 #endif
     _specifications[spec->domain()][spec->type()].push_back(spec);
+    _specificationIdentifiers[spec->domain()][spec->type()].insert({ spec->identifier(), spec });
+
+    {
+        std::lock_guard<std::mutex> lock(_viewsMutex);
+        _views.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(_fileTypeIndexesMutex);
+    _fileTypeIndexes.clear();
 }
 
 bool Manager::
@@ -357,7 +432,7 @@ inheritSpecification(PBX::Specification::shared_ptr const &specification)
 }
 
 void Manager::
-registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains)
+registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains, plist::Cache *cache)
 {
     PBX::Specification::vector specifications;
 
@@ -371,6 +446,7 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
 
         Context context = {
             .domain = domain.first,
+            .cache = cache,
         };
 
         if (filesystem->isDirectory(domain.second)) {
@@ -389,6 +465,8 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
                     fprintf(stderr, "importing specification '%s'\n", filename.c_str());
 #endif
 
+                    _loadedFilePaths.push_back(filename);
+
                     ext::optional<PBX::Specification::vector> fileSpecifications = Specification::Open(filesystem, &context, filename);
                     if (fileSpecifications) {
                         specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
@@ -402,6 +480,8 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
 #if 0
             fprintf(stderr, "importing specification '%s'\n", domain.second.c_str());
 #endif
+            _loadedFilePaths.push_back(domain.second);
+
             ext::optional<PBX::Specification::vector> fileSpecifications = Specification::Open(filesystem, &context, domain.second);
             if (fileSpecifications) {
                 specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
@@ -447,6 +527,8 @@ registerBuildRules(Filesystem const *filesystem, std::string const &path)
         return false;
     }
 
+    _loadedFilePaths.push_back(path);
+
     std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents).first;
     if (plist == nullptr) {
         return false;
@@ -22,6 +22,7 @@
 #include <pbxspec/Manager.h>
 #include <plist/Array.h>
 #include <plist/Boolean.h>
+#include <plist/Cache.h>
 #include <plist/Dictionary.h>
 #include <plist/Object.h>
 #include <plist/String.h>
@@ -206,18 +207,12 @@ Open(Filesystem const *filesystem, Context *context, std::string const &filename
         return ext::nullopt;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, realPath)) {
-        fprintf(stderr, "error: unable to read specification plist\n");
-        return ext::nullopt;
-    }
-
     //
-    // Parse property list
+    // Read and parse property list
     //
-    std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents).first;
+    std::unique_ptr<plist::Object> plist = plist::Cache::Read(context->cache, filesystem, realPath);
     if (plist == nullptr) {
-        fprintf(stderr, "error: unable to parse specification plist\n");
+        fprintf(stderr, "error: unable to read or parse specification plist\n");
         return ext::nullopt;
     }
 
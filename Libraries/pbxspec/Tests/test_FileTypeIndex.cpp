@@ -0,0 +1,247 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxspec/Manager.h>
+#include <libutil/FSUtil.h>
+#include <libutil/MemoryFilesystem.h>
+#include <libutil/Wildcard.h>
+#include <libutil/test/TemporaryDirectory.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using pbxspec::FileTypeIndex;
+using pbxspec::PBX::FileType;
+using libutil::FSUtil;
+using libutil::MemoryFilesystem;
+using libutil::Wildcard;
+using libutil::test::TemporaryDirectory;
+
+/*
+ * File types using each way of matching a path, including types that share
+ * extensions and types that inherit from each other.
+ */
+static pbxspec::Manager::shared_ptr
+SpecManager()
+{
+    std::string contents = "( \
+        { Type = FileType; Identifier = file; }, \
+        { Type = FileType; Identifier = folder; IsFolder = YES; }, \
+        { Type = FileType; Identifier = text; BasedOn = file; Extensions = (txt); }, \
+        { Type = FileType; Identifier = text.plain; BasedOn = text; Extensions = (txt, text); }, \
+        { Type = FileType; Identifier = sourcecode.c; BasedOn = text; Extensions = (c, S); }, \
+        { Type = FileType; Identifier = sourcecode.c.h; BasedOn = sourcecode.c; Extensions = (h); }, \
+        { Type = FileType; Identifier = sourcecode.make; BasedOn = text; FilenamePatterns = (Makefile, \"*.mk\"); }, \
+        { Type = FileType; Identifier = text.readme; BasedOn = text; Prefix = (README); }, \
+        { Type = FileType; Identifier = text.script; BasedOn = text; MagicWord = (\"#!\"); }, \
+        { Type = FileType; Identifier = compiled.mach-o; BasedOn = file; MagicWord = (FEEDFACE, MACH); }, \
+        { Type = FileType; Identifier = compiled.executable; BasedOn = file; Permissions = executable; }, \
+        { Type = FileType; Identifier = wrapper.bundle; BasedOn = folder; IsFolder = YES; Extensions = (bundle); }, \
+        { Type = FileType; Identifier = wrapper.txt; BasedOn = folder; IsFolder = YES; Extensions = (txt); }, \
+    )";
+
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("Types.xcspec", std::vector<uint8_t>(contents.begin(), contents.end())),
+    });
+
+    pbxspec::Manager::shared_ptr specManager = pbxspec::Manager::Create();
+    specManager->registerDomains(&filesystem, { { "test", "/Types.xcspec" } });
+    return specManager;
+}
+
+/*
+ * Matches a path by testing every file type in order, as file types were
+ * matched before they were indexed.
+ */
+static FileType::shared_ptr
+LinearResolve(FileTypeIndex const &index, FileType::shared_ptr const &file, FileType::shared_ptr const &folder, std::string const &filePath)
+{
+    bool isReadable = FSUtil::TestForRead(filePath);
+    bool isFolder = isReadable && FSUtil::TestForDirectory(filePath);
+
+    std::string fileExtension = FSUtil::GetFileExtension(filePath);
+    std::string fileName = FSUtil::GetBaseName(filePath);
+
+    for (FileType::shared_ptr const &fileType : index.fileTypes()) {
+        if (isReadable && fileType->isFolder() != isFolder) {
+            continue;
+        }
+
+        bool empty = true;
+
+        if (fileType->extensions()) {
+            empty = false;
+            bool matched = false;
+            for (std::string const &extension : *fileType->extensions()) {
+                if (strcasecmp(extension.c_str(), fileExtension.c_str()) == 0) {
+                    matched = true;
+                }
+            }
+            if (!matched) {
+                continue;
+            }
+        }
+
+        if (fileType->prefix()) {
+            empty = false;
+            bool matched = false;
+            for (std::string const &prefix : *fileType->prefix()) {
+                if (fileName.find(prefix) == 0) {
+                    matched = true;
+                }
+            }
+            if (!matched) {
+                continue;
+            }
+        }
+
+        if (fileType->filenamePatterns()) {
+            empty = false;
+            bool matched = false;
+            for (std::string const &pattern : *fileType->filenamePatterns()) {
+                if (Wildcard::Match(pattern, fileName)) {
+                    matched = true;
+                }
+            }
+            if (!matched) {
+                continue;
+            }
+        }
+
+        if (isReadable && fileType->permissions()) {
+            empty = false;
+            if (*fileType->permissions() == "executable" && !FSUtil::TestForExecute(filePath)) {
+                continue;
+            }
+        }
+
+        if (isReadable && fileType->magicWords()) {
+            empty = false;
+            bool matched = false;
+            for (std::vector<uint8_t> const &magicWord : *fileType->magicWords()) {
+                std::vector<uint8_t> contents = std::vector<uint8_t>(magicWord.size());
+                std::ifstream fileHandle(filePath, std::ios::in | std::ios::binary);
+                fileHandle.read((char *)contents.data(), contents.size());
+                if (fileHandle.good() && contents == magicWord) {
+                    matched = true;
+                }
+            }
+            if (!matched) {
+                continue;
+            }
+        }
+
+        if (empty) {
+            continue;
+        }
+
+        return fileType;
+    }
+
+    return (isFolder ? folder : file);
+}
+
+static void
+CreateFile(std::string const &path, std::string const &contents, mode_t mode = 0644)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode);
+    ASSERT_NE(-1, fd);
+    EXPECT_EQ(static_cast<ssize_t>(contents.size()), ::write(fd, contents.data(), contents.size()));
+    ::close(fd);
+}
+
+TEST(FileTypeIndex, Order)
+{
+    pbxspec::Manager::shared_ptr specManager = SpecManager();
+    FileTypeIndex::shared_ptr index = specManager->fileTypeIndex({ "test" });
+    ASSERT_NE(nullptr, index);
+
+    /* Each file type comes before its base types. */
+    FileType::vector const &fileTypes = index->fileTypes();
+    for (size_t n = 0; n < fileTypes.size(); n++) {
+        for (FileType::shared_ptr base = fileTypes[n]->base(); base != nullptr; base = base->base()) {
+            auto it = std::find(fileTypes.begin(), fileTypes.end(), base);
+            ASSERT_NE(fileTypes.end(), it);
+            EXPECT_LT(n, static_cast<size_t>(it - fileTypes.begin()));
+        }
+    }
+}
+
+TEST(FileTypeIndex, MatchesLinearScan)
+{
+    pbxspec::Manager::shared_ptr specManager = SpecManager();
+    FileTypeIndex::shared_ptr index = specManager->fileTypeIndex({ "test" });
+    ASSERT_NE(nullptr, index);
+
+    FileType::shared_ptr file = specManager->fileType("file", { "test" });
+    FileType::shared_ptr folder = specManager->fileType("folder", { "test" });
+    ASSERT_NE(nullptr, file);
+    ASSERT_NE(nullptr, folder);
+
+    TemporaryDirectory temporary("test_FileTypeIndex");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+
+    CreateFile(root + "/main.c", "int main;");
+    CreateFile(root + "/start.S", "nop");
+    CreateFile(root + "/header.h", "");
+    CreateFile(root + "/notes.txt", "notes");
+    CreateFile(root + "/notes.TEXT", "notes");
+    CreateFile(root + "/Makefile", "all:");
+    CreateFile(root + "/rules.mk", "all:");
+    CreateFile(root + "/README.md", "readme");
+    CreateFile(root + "/run", "#!/bin/sh", 0755);
+    CreateFile(root + "/run.txt", "#!/bin/sh");
+    CreateFile(root + "/binary", "MACH-O");
+    CreateFile(root + "/tool", "\x7f" "ELF", 0755);
+    CreateFile(root + "/data", "data");
+    ::mkdir((root + "/Resources.bundle").c_str(), 0755);
+    ::mkdir((root + "/folder.txt").c_str(), 0755);
+    ::mkdir((root + "/directory").c_str(), 0755);
+
+    std::vector<std::string> paths;
+    for (char const *name : {
+        "main.c", "start.S", "header.h", "notes.txt", "notes.TEXT", "Makefile", "rules.mk", "README.md",
+        "run", "run.txt", "binary", "tool", "data", "Resources.bundle", "folder.txt", "directory",
+        "missing.c", "missing.txt", "README", "missing",
+    }) {
+        paths.push_back(root + "/" + std::string(name));
+    }
+
+    for (std::string const &path : paths) {
+        FileType::shared_ptr expected = LinearResolve(*index, file, folder, path);
+        ASSERT_NE(nullptr, expected);
+
+        FileType::shared_ptr fileType = index->resolve(path);
+        ASSERT_NE(nullptr, fileType);
+        EXPECT_EQ(expected->identifier(), fileType->identifier()) << path;
+
+        /* Remembered results are the same. */
+        EXPECT_EQ(fileType, index->resolve(path));
+    }
+
+    /* Spot check that each way of matching was exercised. */
+    EXPECT_EQ("sourcecode.c", index->resolve(root + "/start.S")->identifier());
+    EXPECT_EQ("sourcecode.c.h", index->resolve(root + "/header.h")->identifier());
+    EXPECT_EQ("text.plain", index->resolve(root + "/notes.TEXT")->identifier());
+    EXPECT_EQ("sourcecode.make", index->resolve(root + "/rules.mk")->identifier());
+    EXPECT_EQ("text.readme", index->resolve(root + "/README.md")->identifier());
+    EXPECT_EQ("text.script", index->resolve(root + "/run")->identifier());
+    EXPECT_EQ("compiled.mach-o", index->resolve(root + "/binary")->identifier());
+    EXPECT_EQ("compiled.executable", index->resolve(root + "/tool")->identifier());
+    EXPECT_EQ("wrapper.txt", index->resolve(root + "/folder.txt")->identifier());
+    EXPECT_EQ("folder", index->resolve(root + "/directory")->identifier());
+    EXPECT_EQ("file", index->resolve(root + "/data")->identifier());
+}
@@ -0,0 +1,107 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Arena_h
+#define __plist_Arena_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plist {
+
+/*
+ * Memory for building large property lists. While an arena is the current
+ * arena for a thread, objects created on that thread are allocated from it
+ * and long dictionary keys are interned in it. Deleting those objects still runs
+ * their destructors, but their memory is only released, all at once, when
+ * the arena is destroyed.
+ *
+ * Objects allocated from an arena must be destroyed before it. An arena can
+ * only be current on one thread at a time; its objects can be used and
+ * destroyed from any thread.
+ */
+class Arena {
+private:
+    struct Chunk {
+        std::unique_ptr<uint8_t[]> data;
+        size_t                     size;
+    };
+
+private:
+    std::vector<Chunk>         _chunks;
+    size_t                     _offset;
+    size_t                     _allocated;
+    std::vector<std::string *> _strings;
+    size_t                     _stringCount;
+
+public:
+    Arena();
+    ~Arena();
+
+public:
+    Arena(Arena const &) = delete;
+    Arena &operator=(Arena const &) = delete;
+
+public:
+    /*
+     * The total size of the memory allocated from the arena.
+     */
+    size_t allocated() const
+    { return _allocated; }
+
+public:
+    /*
+     * Allocates memory suitably aligned for any property list object.
+     */
+    void *allocate(size_t size);
+
+    /*
+     * The single copy of a string held by the arena.
+     */
+    std::string const *intern(std::string const &string);
+
+public:
+    /*
+     * Makes an arena current on this thread for the lifetime of the scope.
+     * A null arena allocates normally within the scope.
+     */
+    class Scope {
+    private:
+        Arena *_previous;
+
+    public:
+        explicit Scope(Arena *arena);
+        ~Scope();
+
+    public:
+        Scope(Scope const &) = delete;
+        Scope &operator=(Scope const &) = delete;
+    };
+
+public:
+    /*
+     * The current arena for this thread, if any.
+     */
+    static Arena *Current();
+
+public:
+    /*
+     * Allocates and frees the memory for a property list object: from the
+     * current arena if there is one, otherwise from the heap.
+     */
+    static void *AllocateObject(size_t size);
+    static void FreeObject(void *pointer);
+};
+
+}
+
+#endif  // !__plist_Arena_h
@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Cache_h
+#define __plist_Cache_h
+
+#include <plist/Object.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace libutil { class FileView; }
+
+namespace plist {
+
+/*
+ * Parsed property lists, keyed by path. Each entry is valid while the file
+ * it was parsed from has the same modification time and size. The cache is
+ * stored as a single snapshot file holding each property list in the binary
+ * format; the snapshot is mapped, and only the entries used are parsed.
+ *
+ * Snapshots are specific to the machine that wrote them and are discarded
+ * when the snapshot format version changes.
+ */
+class Cache {
+private:
+    struct Entry {
+        uint64_t             modified;
+        uint64_t             size;
+        uint8_t const       *data;
+        size_t               dataSize;
+        std::vector<uint8_t> contents;
+    };
+
+private:
+    std::unique_ptr<libutil::FileView>     _view;
+    std::unordered_map<std::string, Entry> _entries;
+    bool                                   _modified;
+    mutable std::mutex                     _mutex;
+
+public:
+    Cache();
+    ~Cache();
+
+public:
+    /*
+     * If any entries were added or replaced since the cache was opened.
+     */
+    bool modified() const;
+
+public:
+    /*
+     * Reads and parses a property list, or uses the cached copy if the file
+     * is unchanged. Returns nullptr if the file can't be read or parsed.
+     */
+    std::unique_ptr<Object>
+    read(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Writes the cache to a snapshot file, creating its directory.
+     */
+    bool
+    write(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * Opens a snapshot file. A missing, outdated, or corrupt snapshot opens
+     * as an empty cache.
+     */
+    static std::unique_ptr<Cache>
+    Open(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * The default snapshot path for a set of property lists identified by a
+     * key, such as the developer root they are loaded from. Returns nothing
+     * if there's no cache directory.
+     */
+    static ext::optional<std::string>
+    DefaultPath(std::string const &key);
+
+public:
+    /*
+     * Reads a property list through a cache, if there is one.
+     */
+    static std::unique_ptr<Object>
+    Read(Cache *cache, libutil::Filesystem const *filesystem, std::string const &path);
+};
+
+}
+
+#endif  // !__plist_Cache_h
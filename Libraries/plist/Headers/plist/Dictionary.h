@@ -13,19 +13,37 @@
 #include <plist/Base.h>
 #include <plist/Object.h>
 
-#include <algorithm>
+#include <cstdint>
+#include <string>
 #include <vector>
-#include <unordered_map>
 
 namespace plist {
 
 class Dictionary : public Object {
 private:
-    std::vector<std::string>                                 _keys;
-    std::unordered_map<std::string, std::unique_ptr<Object>> _map;
+    /*
+     * Entries are kept in insertion order. In a dictionary created in an arena,
+     * long keys added on the arena's thread are interned in it.
+     */
+    struct Entry {
+        std::string              ownedKey;
+        std::string const       *internedKey;
+        std::unique_ptr<Object>  value;
+
+        inline std::string const &key() const
+        {
+            return (internedKey != nullptr ? *internedKey : ownedKey);
+        }
+    };
+
+private:
+    std::vector<Entry>     _entries;
+    std::vector<uint32_t>  _index;
+    Arena                 *_arena;
 
 public:
-    Dictionary()
+    Dictionary() :
+        _arena(Arena::Current())
     {
     }
 
@@ -40,27 +58,27 @@ public:
 public:
     inline bool empty() const
     {
-        return _map.empty();
+        return _entries.empty();
     }
 
     inline size_t count() const
     {
-        return _map.size();
+        return _entries.size();
     }
 
     inline std::string const &key(size_t index) const
     {
-        return _keys[index];
+        return _entries[index].key();
     }
 
     inline Object const *value(size_t index) const
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].value.get() : nullptr;
     }
 
     inline Object *value(size_t index)
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].value.get() : nullptr;
     }
 
     template <typename T>
@@ -77,14 +95,14 @@ public:
 
     inline Object const *value(std::string const &key) const
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        size_t index = find(key);
+        return (index != npos ? _entries[index].value.get() : nullptr);
     }
 
     inline Object *value(std::string const &key)
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        size_t index = find(key);
+        return (index != npos ? _entries[index].value.get() : nullptr);
     }
 
     template <typename T>
@@ -102,39 +120,62 @@ public:
 public:
     inline void clear()
     {
-        _keys.clear();
-        _map.clear();
+        _entries.clear();
+        _index.clear();
     }
 
 public:
-    inline void set(std::string const &key, std::unique_ptr<Object> obj)
-    {
-        remove(key);
-        _keys.push_back(key);
-        _map.insert(std::make_pair(key, std::move(obj)));
-    }
+    /*
+     * Sets the value for a key. Replacing a value moves its key to the end.
+     */
+    void set(std::string const &key, std::unique_ptr<Object> obj);
+    void set(std::string &&key, std::unique_ptr<Object> obj);
 
-    inline void remove(std::string const &key)
-    {
-        auto it = _map.find(key);
+    void remove(std::string const &key);
 
-        if (it != _map.end()) {
-            _map.erase(it);
-            _keys.erase(std::find(_keys.begin(), _keys.end(), key));
+public:
+    class const_iterator {
+    private:
+        std::vector<Entry>::const_iterator _it;
+
+    public:
+        explicit const_iterator(std::vector<Entry>::const_iterator it) :
+            _it(it)
+        {
         }
-    }
 
-public:
-    inline std::vector<std::string>::const_iterator begin() const
+    public:
+        inline std::string const &operator*() const
+        { return _it->key(); }
+        inline std::string const *operator->() const
+        { return &_it->key(); }
+
+        inline const_iterator &operator++()
+        { ++_it; return *this; }
+
+        inline bool operator==(const_iterator const &other) const
+        { return _it == other._it; }
+        inline bool operator!=(const_iterator const &other) const
+        { return _it != other._it; }
+    };
+
+    inline const_iterator begin() const
     {
-        return _keys.begin();
+        return const_iterator(_entries.begin());
     }
 
-    inline std::vector<std::string>::const_iterator end() const
+    inline const_iterator end() const
     {
-        return _keys.end();
+        return const_iterator(_entries.end());
     }
 
+private:
+    static size_t const npos = static_cast<size_t>(-1);
+
+    size_t find(std::string const &key) const;
+    void append(Entry &&entry);
+    void reindex();
+
 public:
     static std::unique_ptr<Dictionary> Coerce(Object const *obj);
 
@@ -174,8 +215,8 @@ public:
         if (count() != obj->count())
             return false;
 
-        for (auto const &it : _map) {
-            if (!value(it.first)->equals(obj->value(it.first)))
+        for (Entry const &entry : _entries) {
+            if (!entry.value->equals(obj->value(entry.key())))
                 return false;
         }
 
@@ -25,6 +25,15 @@ public:
 
 public:
     static Binary Create();
+
+public:
+    using Format<Binary>::Deserialize;
+
+    /*
+     * Deserialize from contents not held in a vector, such as a mapped file.
+     */
+    static std::pair<std::unique_ptr<Object>, std::string>
+    Deserialize(uint8_t const *data, size_t size, Binary const &format);
 };
 
 }
@@ -43,6 +43,17 @@ public:
         return Deserialize(contents, *format);
     }
 
+    /*
+     * Deserializes with the resulting objects allocated from an arena. The
+     * arena must outlive them.
+     */
+    static std::pair<std::unique_ptr<Object>, std::string>
+    Deserialize(std::vector<uint8_t> const &contents, Arena *arena)
+    {
+        Arena::Scope scope(arena);
+        return Deserialize(contents);
+    }
+
 public:
     static std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string>
     Serialize(Object const *object, T const &format);
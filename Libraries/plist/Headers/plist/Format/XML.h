@@ -18,11 +18,22 @@ namespace plist {
 namespace Format {
 
 class XML : public Format<XML> {
+public:
+    /*
+     * How documents are read. The streaming parser handles the XML used
+     * by property lists, and uses libxml2 for anything else.
+     */
+    enum class Parser {
+        Streaming,
+        LibXML2,
+    };
+
 private:
     Encoding _encoding;
+    Parser   _parser;
 
 private:
-    XML(Encoding encoding);
+    XML(Encoding encoding, Parser parser);
 
 public:
     static Type FormatType();
@@ -30,9 +41,11 @@ public:
 public:
     inline Encoding encoding() const
     { return _encoding; }
+    inline Parser parser() const
+    { return _parser; }
 
 public:
-    static XML Create(Encoding encoding);
+    static XML Create(Encoding encoding, Parser parser = Parser::Streaming);
 };
 
 }
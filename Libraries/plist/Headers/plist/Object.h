@@ -10,6 +10,7 @@
 #ifndef __plist_Object_h
 #define __plist_Object_h
 
+#include <plist/Arena.h>
 #include <plist/Base.h>
 #include <plist/ObjectType.h>
 
@@ -29,6 +30,20 @@ public:
     {
     }
 
+public:
+    /*
+     * Objects are allocated from the current arena, if there is one.
+     */
+    static void *operator new(size_t size)
+    {
+        return Arena::AllocateObject(size);
+    }
+
+    static void operator delete(void *pointer)
+    {
+        Arena::FreeObject(pointer);
+    }
+
 public:
     virtual ObjectType type() const = 0;
 
@@ -24,6 +24,7 @@ typedef struct ASCIIPListLexer {
     int         line;
     int         tokenBegin;
     int         tokenLength;
+    int         vectorized;
 } ASCIIPListLexer;
 
 enum {
@@ -58,6 +59,12 @@ extern "C" {
 void ASCIIPListLexerInit(ASCIIPListLexer *lexer, char const *buffer,
         int length, int style);
 
+/*
+ * Scan whitespace, strings and comments in blocks, where the processor
+ * supports it. Enabled by default; tokens are the same either way.
+ */
+void ASCIIPListLexerSetVectorized(ASCIIPListLexer *lexer, int vectorized);
+
 int ASCIIPListLexerReadToken(ASCIIPListLexer *lexer);
 char *ASCIIPListCopyUnquotedString(ASCIIPListLexer const *lexer, int lossByte);
 char *ASCIIPListCopyData(ASCIIPListLexer const *lexer);
@@ -13,6 +13,7 @@
 #include <plist/Format/ASCIIPListLexer.h>
 #include <plist/Object.h>
 #include <plist/String.h>
+#include <ext/optional>
 
 #include <stack>
 #include <string>
@@ -49,8 +50,8 @@ private:
     std::stack<std::unique_ptr<plist::Object>> _containerStack;
 
 private:
-    std::unique_ptr<plist::String> _key;
-    std::stack<std::unique_ptr<plist::String>> _keyStack;
+    ext::optional<std::string>     _key;
+    std::stack<ext::optional<std::string>> _keyStack;
 
 private:
     ContextState                _contextState;
@@ -83,12 +84,12 @@ private:
     void decrementLevel();
 
 private:
-    bool push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key);
+    bool push(ValueState state, std::unique_ptr<plist::Object> container, ext::optional<std::string> key);
     bool pop();
 
 private:
     bool beginContainer(std::unique_ptr<plist::Object> container);
-    bool storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value);
+    bool storeKeyValue(ext::optional<std::string> key, std::unique_ptr<plist::Object> value);
     bool endContainer(bool isArray);
 
 private:
@@ -102,7 +103,7 @@ private:
     bool endDictionary();
 
 private:
-    bool storeKey(std::unique_ptr<plist::String> key);
+    bool storeKey(std::string key);
     bool storeValue(std::unique_ptr<plist::Object> value);
 };
 
@@ -11,20 +11,36 @@
 #define __plist_Format_BaseXMLParser_h
 
 #include <plist/Base.h>
+#include <ext/optional>
 
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <utility>
 
 #include <libxml/xmlreader.h>
 
 namespace plist {
 namespace Format {
 
+class XMLTokenizer;
+
+/*
+ * Event-driven XML parser. Documents are read with the built-in streaming
+ * tokenizer when they use only what it supports, and with libxml2 otherwise.
+ */
 class BaseXMLParser {
+protected:
+    typedef std::vector<std::pair<std::string, std::string>> Attributes;
+
 private:
     ::xmlTextReaderPtr _parser;
+    XMLTokenizer      *_tokenizer;
     size_t             _depth;
+    bool               _stopped;
+
+private:
+    std::string        _name;
+    Attributes         _attributes;
 
 private:
     size_t             _line;
@@ -43,7 +59,14 @@ public:
     { return _error; }
 
 protected:
-    bool parse(std::vector<uint8_t> const &contents);
+    /*
+     * Parses a UTF-8 document. With `streaming` false, always uses libxml2.
+     */
+    bool parse(std::vector<uint8_t> const &contents, bool streaming = true);
+
+private:
+    ext::optional<bool> parseStreaming(std::vector<uint8_t> const &contents);
+    bool parseLibXML2(std::vector<uint8_t> const &contents);
 
 protected:
     inline size_t depth() const
@@ -54,9 +77,9 @@ protected:
     virtual void onEndParse(bool success);
 
 protected:
-    virtual void onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth);
+    virtual void onStartElement(std::string const &name, Attributes const &attrs, size_t depth);
     virtual void onEndElement(std::string const &name, size_t depth);
-    virtual void onCharacterData(std::string const &cdata, size_t depth);
+    virtual void onCharacterData(char const *cdata, size_t size, size_t depth);
 
 protected:
     void error(std::string format, ...);
@@ -33,7 +33,7 @@ private:
     virtual void onEndParse(bool success);
 
 private:
-    void onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t);
+    void onStartElement(std::string const &name, Attributes const &attrs, size_t);
     void onEndElement(std::string const &name, size_t);
 };
 
@@ -41,16 +41,16 @@ public:
     XMLParser();
 
 public:
-    Object *parse(std::vector<uint8_t> const &contents);
+    Object *parse(std::vector<uint8_t> const &contents, bool streaming = true);
 
 private:
     virtual void onBeginParse();
     virtual void onEndParse(bool success);
 
 private:
-    void onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth);
+    void onStartElement(std::string const &name, Attributes const &attrs, size_t depth);
     void onEndElement(std::string const &name, size_t depth);
-    void onCharacterData(std::string const &cdata, size_t depth);
+    void onCharacterData(char const *cdata, size_t size, size_t depth);
 
 private:
     void push(Object *object);
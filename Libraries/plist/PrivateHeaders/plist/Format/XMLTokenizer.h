@@ -0,0 +1,106 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_XMLTokenizer_h
+#define __plist_Format_XMLTokenizer_h
+
+#include <plist/Base.h>
+
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Tokenizer for the subset of XML used by property lists and similar
+ * documents: elements and attributes, the predefined and numeric entities,
+ * comments, CDATA sections, and a document type declaration without an
+ * internal subset. Input must be UTF-8.
+ *
+ * Names, attribute values, and text point into the input where possible;
+ * only text containing entities or carriage returns is copied, to decode it.
+ * Anything outside the subset is reported as unsupported rather than as an
+ * error, so the caller can fall back to a complete XML parser.
+ */
+class XMLTokenizer {
+public:
+    enum class Token {
+        StartElement,
+        EndElement,
+        Text,
+        CDATA,
+        End,
+        Unsupported,
+        Error,
+    };
+
+    struct Span {
+        char const *data;
+        size_t      size;
+    };
+
+    struct Attribute {
+        Span name;
+        Span value;
+    };
+
+private:
+    char const             *_begin;
+    char const             *_end;
+    char const             *_current;
+    char const             *_token;
+    bool                    _start;
+
+private:
+    Span                    _name;
+    bool                    _empty;
+    std::vector<Attribute>  _attributes;
+    Span                    _text;
+    std::string             _buffer;
+    std::vector<size_t>     _decoded;
+
+public:
+    XMLTokenizer(char const *data, size_t size);
+
+public:
+    /*
+     * Reads the next token. After a start element, `name()`, `empty()`, and
+     * `attributes()` describe it; after an end element, `name()`; and after
+     * text or a CDATA section, `text()`. They are valid until the next token.
+     */
+    Token next();
+
+public:
+    Span const &name() const
+    { return _name; }
+    bool empty() const
+    { return _empty; }
+    std::vector<Attribute> const &attributes() const
+    { return _attributes; }
+    Span const &text() const
+    { return _text; }
+
+public:
+    /*
+     * The one-based line and column where the last token started.
+     */
+    void location(size_t *line, size_t *column) const;
+
+private:
+    Token readElement();
+    Token readEndElement();
+    Token readText();
+    Token decode(char const *begin, char const *end, bool attribute);
+};
+
+}
+}
+
+#endif  // !__plist_Format_XMLTokenizer_h
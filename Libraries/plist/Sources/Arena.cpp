@@ -0,0 +1,166 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Arena.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+using plist::Arena;
+
+/*
+ * Objects are aligned for their widest members: 64-bit integers, doubles,
+ * and pointers. Each object is preceded by a header of the same size that
+ * records where it was allocated from.
+ */
+static size_t const Alignment = sizeof(uint64_t);
+
+enum class ObjectSource : uint64_t {
+    Heap  = 0x68656170,
+    Arena = 0x6172656e,
+};
+
+static size_t const MinimumChunkSize = 64 * 1024;
+
+static thread_local Arena *CurrentArena = nullptr;
+
+Arena::
+Arena() :
+    _offset     (0),
+    _allocated  (0),
+    _stringCount(0)
+{
+}
+
+Arena::
+~Arena()
+{
+    /* Interned strings live in the arena, but may own heap storage. */
+    for (std::string *string : _strings) {
+        if (string != nullptr) {
+            string->~basic_string();
+        }
+    }
+}
+
+void *Arena::
+allocate(size_t size)
+{
+    size = (size + Alignment - 1) & ~(Alignment - 1);
+
+    if (_chunks.empty() || _chunks.back().size - _offset < size) {
+        /* Grow chunks with the arena, so large trees need few of them. */
+        size_t chunkSize = std::max(std::max(MinimumChunkSize, _allocated / 4), size);
+        chunkSize = (chunkSize + Alignment - 1) & ~(Alignment - 1);
+
+        Chunk chunk;
+        chunk.data = std::unique_ptr<uint8_t[]>(new uint8_t[chunkSize]);
+        chunk.size = chunkSize;
+        _chunks.push_back(std::move(chunk));
+        _offset = 0;
+    }
+
+    void *pointer = _chunks.back().data.get() + _offset;
+    _offset += size;
+    _allocated += size;
+    return pointer;
+}
+
+std::string const *Arena::
+intern(std::string const &string)
+{
+    /*
+     * Strings are indexed by an open addressing table kept at most half full.
+     */
+    if ((_stringCount + 1) * 2 > _strings.size()) {
+        std::vector<std::string *> strings = std::vector<std::string *>(std::max<size_t>(_strings.size() * 2, 256), nullptr);
+        size_t mask = strings.size() - 1;
+        for (std::string *existing : _strings) {
+            if (existing != nullptr) {
+                size_t slot = std::hash<std::string>()(*existing) & mask;
+                while (strings[slot] != nullptr) {
+                    slot = (slot + 1) & mask;
+                }
+                strings[slot] = existing;
+            }
+        }
+        _strings = std::move(strings);
+    }
+
+    size_t mask = _strings.size() - 1;
+    size_t slot = std::hash<std::string>()(string) & mask;
+    while (_strings[slot] != nullptr) {
+        if (*_strings[slot] == string) {
+            return _strings[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    _strings[slot] = new (allocate(sizeof(std::string))) std::string(string);
+    _stringCount++;
+    return _strings[slot];
+}
+
+Arena::Scope::
+Scope(Arena *arena) :
+    _previous(CurrentArena)
+{
+    CurrentArena = arena;
+}
+
+Arena::Scope::
+~Scope()
+{
+    CurrentArena = _previous;
+}
+
+Arena *Arena::
+Current()
+{
+    return CurrentArena;
+}
+
+void *Arena::
+AllocateObject(size_t size)
+{
+    uint8_t *header;
+    ObjectSource source;
+
+    if (CurrentArena != nullptr) {
+        header = static_cast<uint8_t *>(CurrentArena->allocate(Alignment + size));
+        source = ObjectSource::Arena;
+    } else {
+        header = static_cast<uint8_t *>(::malloc(Alignment + size));
+        if (header == nullptr) {
+            /* Same as the global allocator without exceptions. */
+            std::abort();
+        }
+        source = ObjectSource::Heap;
+    }
+
+    *reinterpret_cast<ObjectSource *>(header) = source;
+    return header + Alignment;
+}
+
+void Arena::
+FreeObject(void *pointer)
+{
+    if (pointer == nullptr) {
+        return;
+    }
+
+    uint8_t *header = static_cast<uint8_t *>(pointer) - Alignment;
+    if (*reinterpret_cast<ObjectSource *>(header) == ObjectSource::Heap) {
+        ::free(header);
+    }
+
+    /* Arena memory is released with the arena. */
+}
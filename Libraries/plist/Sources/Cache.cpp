@@ -0,0 +1,276 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Cache.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/Binary.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FileView.h>
+#include <libutil/FSUtil.h>
+#include <libutil/SysUtil.h>
+#include <libutil/md5.h>
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+using plist::Cache;
+using plist::Object;
+using libutil::Filesystem;
+using libutil::FileView;
+using libutil::FSUtil;
+using libutil::SysUtil;
+
+/*
+ * Bump when the snapshot layout or the parsing of any format changes.
+ */
+static char const SnapshotMagic[8] = { 'x', 'c', 'p', 'l', 'c', 'a', 'c', 'h' };
+static uint32_t const SnapshotVersion = 1;
+
+/*
+ * Snapshot layout, in native byte order:
+ *
+ *   magic[8], version: u32, count: u32
+ *   count * { pathSize: u32, path, modified: u64, size: u64, dataSize: u32, data }
+ *
+ * The data of each entry is a binary property list.
+ */
+
+namespace {
+
+class SnapshotReader {
+private:
+    uint8_t const *_data;
+    size_t         _size;
+    size_t         _offset;
+
+public:
+    SnapshotReader(uint8_t const *data, size_t size) :
+        _data  (data),
+        _size  (size),
+        _offset(0)
+    {
+    }
+
+public:
+    template<typename T>
+    bool value(T *value)
+    {
+        if (_size - _offset < sizeof(T)) {
+            return false;
+        }
+
+        ::memcpy(value, _data + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return true;
+    }
+
+    bool bytes(size_t size, uint8_t const **bytes)
+    {
+        if (_size - _offset < size) {
+            return false;
+        }
+
+        *bytes = _data + _offset;
+        _offset += size;
+        return true;
+    }
+};
+
+template<typename T>
+void
+AppendValue(std::vector<uint8_t> *contents, T value)
+{
+    uint8_t const *bytes = reinterpret_cast<uint8_t const *>(&value);
+    contents->insert(contents->end(), bytes, bytes + sizeof(T));
+}
+
+}
+
+Cache::
+Cache() :
+    _modified(false)
+{
+}
+
+Cache::
+~Cache()
+{
+}
+
+bool Cache::
+modified() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _modified;
+}
+
+std::unique_ptr<Object> Cache::
+read(Filesystem const *filesystem, std::string const &path)
+{
+    /* Check the file before reading it, so a change while reading is seen next time. */
+    uint64_t modified = 0;
+    uint64_t size = 0;
+    bool status = filesystem->fileStatus(path, &modified, &size);
+
+    if (status) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _entries.find(path);
+        if (it != _entries.end() && it->second.modified == modified && it->second.size == size) {
+            Entry const &entry = it->second;
+            auto result = plist::Format::Binary::Deserialize(entry.data, entry.dataSize, plist::Format::Binary::Create());
+            if (result.first != nullptr) {
+                return std::move(result.first);
+            }
+        }
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Object> object = plist::Format::Any::Deserialize(contents).first;
+    if (object == nullptr || !status) {
+        return object;
+    }
+
+    auto serialized = plist::Format::Binary::Serialize(object.get(), plist::Format::Binary::Create());
+    if (serialized.first != nullptr) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        Entry &entry = _entries[path];
+        entry.modified = modified;
+        entry.size = size;
+        entry.contents = std::move(*serialized.first);
+        entry.data = entry.contents.data();
+        entry.dataSize = entry.contents.size();
+        _modified = true;
+    }
+
+    return object;
+}
+
+bool Cache::
+write(Filesystem *filesystem, std::string const &path) const
+{
+    std::vector<uint8_t> contents;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        contents.insert(contents.end(), SnapshotMagic, SnapshotMagic + sizeof(SnapshotMagic));
+        AppendValue<uint32_t>(&contents, SnapshotVersion);
+        AppendValue<uint32_t>(&contents, static_cast<uint32_t>(_entries.size()));
+
+        for (auto const &pair : _entries) {
+            Entry const &entry = pair.second;
+
+            AppendValue<uint32_t>(&contents, static_cast<uint32_t>(pair.first.size()));
+            contents.insert(contents.end(), pair.first.begin(), pair.first.end());
+            AppendValue<uint64_t>(&contents, entry.modified);
+            AppendValue<uint64_t>(&contents, entry.size);
+            AppendValue<uint32_t>(&contents, static_cast<uint32_t>(entry.dataSize));
+            contents.insert(contents.end(), entry.data, entry.data + entry.dataSize);
+        }
+    }
+
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path))) {
+        return false;
+    }
+
+    return filesystem->write(contents, path);
+}
+
+std::unique_ptr<Cache> Cache::
+Open(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<Cache> cache = std::unique_ptr<Cache>(new Cache());
+
+    std::unique_ptr<FileView> view = filesystem->map(path);
+    if (view == nullptr) {
+        return cache;
+    }
+
+    SnapshotReader reader = SnapshotReader(view->data(), view->size());
+
+    uint8_t const *magic;
+    uint32_t version;
+    uint32_t count;
+    if (!reader.bytes(sizeof(SnapshotMagic), &magic) || ::memcmp(magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0 ||
+        !reader.value(&version) || version != SnapshotVersion ||
+        !reader.value(&count)) {
+        return cache;
+    }
+
+    std::unordered_map<std::string, Entry> entries;
+    entries.reserve(count);
+
+    for (uint32_t n = 0; n < count; n++) {
+        uint32_t pathSize;
+        uint8_t const *pathData;
+        uint32_t dataSize;
+
+        Entry entry;
+        if (!reader.value(&pathSize) || !reader.bytes(pathSize, &pathData) ||
+            !reader.value(&entry.modified) || !reader.value(&entry.size) ||
+            !reader.value(&dataSize) || !reader.bytes(dataSize, &entry.data)) {
+            /* Truncated or corrupt; start over. */
+            return cache;
+        }
+
+        entry.dataSize = dataSize;
+        entries.insert({ std::string(reinterpret_cast<char const *>(pathData), pathSize), std::move(entry) });
+    }
+
+    cache->_view = std::move(view);
+    cache->_entries = std::move(entries);
+    return cache;
+}
+
+ext::optional<std::string> Cache::
+DefaultPath(std::string const &key)
+{
+    ext::optional<std::string> directory = SysUtil::GetCacheDirectory();
+    if (!directory) {
+        return ext::nullopt;
+    }
+
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<md5_byte_t const *>(key.data()), key.size());
+
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream name;
+    name << "plist-" << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        name << std::setw(2) << static_cast<int>(c);
+    }
+    name << ".cache";
+
+    return *directory + "/" + name.str();
+}
+
+std::unique_ptr<Object> Cache::
+Read(Cache *cache, Filesystem const *filesystem, std::string const &path)
+{
+    if (cache != nullptr) {
+        return cache->read(filesystem, path);
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return nullptr;
+    }
+
+    return plist::Format::Any::Deserialize(contents).first;
+}
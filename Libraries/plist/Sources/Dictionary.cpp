@@ -9,15 +9,140 @@
 
 #include <plist/Dictionary.h>
 
+#include <functional>
+
+using plist::Arena;
 using plist::Object;
 using plist::Dictionary;
 
+/*
+ * Small dictionaries are searched in order; larger ones are indexed by an
+ * open addressing table of entry positions, kept at most half full.
+ */
+static size_t const IndexThreshold = 8;
+
+/*
+ * Keys short enough to be stored inline by std::string cost nothing extra
+ * to hold in each dictionary, so only longer keys are interned.
+ */
+static bool
+ShouldIntern(Arena *arena, std::string const &key)
+{
+    return arena != nullptr && arena == Arena::Current() && key.size() > std::string().capacity();
+}
+
 std::unique_ptr<Dictionary> Dictionary::
 New()
 {
     return std::unique_ptr<Dictionary>(new Dictionary());
 }
 
+size_t Dictionary::
+find(std::string const &key) const
+{
+    if (_index.empty()) {
+        for (size_t n = 0; n < _entries.size(); n++) {
+            if (_entries[n].key() == key) {
+                return n;
+            }
+        }
+        return npos;
+    }
+
+    size_t mask = _index.size() - 1;
+    for (size_t slot = std::hash<std::string>()(key) & mask; ; slot = (slot + 1) & mask) {
+        uint32_t position = _index[slot];
+        if (position == 0) {
+            return npos;
+        } else if (_entries[position - 1].key() == key) {
+            return position - 1;
+        }
+    }
+}
+
+void Dictionary::
+reindex()
+{
+    _index.clear();
+    if (_entries.size() <= IndexThreshold) {
+        return;
+    }
+
+    size_t size = 16;
+    while (size < _entries.size() * 2) {
+        size *= 2;
+    }
+    _index.resize(size, 0);
+
+    size_t mask = size - 1;
+    for (size_t n = 0; n < _entries.size(); n++) {
+        size_t slot = std::hash<std::string>()(_entries[n].key()) & mask;
+        while (_index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        _index[slot] = static_cast<uint32_t>(n + 1);
+    }
+}
+
+void Dictionary::
+append(Entry &&entry)
+{
+    _entries.push_back(std::move(entry));
+
+    if (_index.empty() ? _entries.size() > IndexThreshold : _entries.size() * 2 > _index.size()) {
+        reindex();
+    } else if (!_index.empty()) {
+        size_t mask = _index.size() - 1;
+        size_t slot = std::hash<std::string>()(_entries.back().key()) & mask;
+        while (_index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        _index[slot] = static_cast<uint32_t>(_entries.size());
+    }
+}
+
+void Dictionary::
+set(std::string const &key, std::unique_ptr<Object> obj)
+{
+    remove(key);
+
+    Entry entry;
+    if (ShouldIntern(_arena, key)) {
+        entry.internedKey = _arena->intern(key);
+    } else {
+        entry.ownedKey = key;
+        entry.internedKey = nullptr;
+    }
+    entry.value = std::move(obj);
+    append(std::move(entry));
+}
+
+void Dictionary::
+set(std::string &&key, std::unique_ptr<Object> obj)
+{
+    remove(key);
+
+    Entry entry;
+    if (ShouldIntern(_arena, key)) {
+        entry.internedKey = _arena->intern(key);
+    } else {
+        entry.ownedKey = std::move(key);
+        entry.internedKey = nullptr;
+    }
+    entry.value = std::move(obj);
+    append(std::move(entry));
+}
+
+void Dictionary::
+remove(std::string const &key)
+{
+    size_t index = find(key);
+    if (index != npos) {
+        _entries.erase(_entries.begin() + index);
+        reindex();
+    }
+}
+
 std::unique_ptr<Object> Dictionary::
 _copy() const
 {
@@ -35,7 +160,7 @@ merge(Dictionary const *dict, bool replace)
         return;
 
     for (auto const &key : *dict) {
-        if (replace || _map.find(key) == _map.end()) {
+        if (replace || find(key) == npos) {
             set(key, dict->value(key)->copy());
         }
     }
@@ -14,6 +14,17 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ASCII_PLIST_LEXER_VECTOR 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ASCII_PLIST_LEXER_VECTOR 16
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ASCII_PLIST_LEXER_VECTOR 16
+#endif
+
 /*
  * Syntax:
  *
@@ -83,6 +94,195 @@ istokenseparator(char ch, ASCIIPListLexer *lexer)
              (ch == ',' || ch == ';' || ch == ')' || ch == '=')));
 }
 
+/** Vector Scanning **/
+
+/*
+ * Each helper skips over a run of bytes that the scalar loops would step
+ * over one at a time, and stops at the first byte they would look at. The
+ * last partial block is always left to the scalar loops, so nothing past
+ * the end of the buffer is read.
+ */
+
+#if defined(ASCII_PLIST_LEXER_VECTOR)
+
+#if defined(__AVX2__)
+typedef __m256i VectorType;
+
+static inline VectorType
+VectorLoad(char const *p)
+{ return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p)); }
+
+static inline VectorType
+VectorEqual(VectorType v, char ch)
+{ return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(ch)); }
+
+static inline VectorType
+VectorRange(VectorType v, char lo, char hi)
+{
+    return _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(lo)), v),
+                            _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(hi)), v));
+}
+
+static inline VectorType
+VectorOr(VectorType a, VectorType b)
+{ return _mm256_or_si256(a, b); }
+
+static inline VectorType
+VectorLowercase(VectorType v)
+{ return _mm256_or_si256(v, _mm256_set1_epi8(0x20)); }
+
+static inline uint32_t
+VectorMask(VectorType v)
+{ return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+#elif defined(__SSE2__)
+typedef __m128i VectorType;
+
+static inline VectorType
+VectorLoad(char const *p)
+{ return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p)); }
+
+static inline VectorType
+VectorEqual(VectorType v, char ch)
+{ return _mm_cmpeq_epi8(v, _mm_set1_epi8(ch)); }
+
+static inline VectorType
+VectorRange(VectorType v, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(lo)), v),
+                         _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(hi)), v));
+}
+
+static inline VectorType
+VectorOr(VectorType a, VectorType b)
+{ return _mm_or_si128(a, b); }
+
+static inline VectorType
+VectorLowercase(VectorType v)
+{ return _mm_or_si128(v, _mm_set1_epi8(0x20)); }
+
+static inline uint32_t
+VectorMask(VectorType v)
+{ return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+#else
+typedef uint8x16_t VectorType;
+
+static inline VectorType
+VectorLoad(char const *p)
+{ return vld1q_u8(reinterpret_cast<uint8_t const *>(p)); }
+
+static inline VectorType
+VectorEqual(VectorType v, char ch)
+{ return vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(ch))); }
+
+static inline VectorType
+VectorRange(VectorType v, char lo, char hi)
+{ return vandq_u8(vcgeq_u8(v, vdupq_n_u8(static_cast<uint8_t>(lo))), vcleq_u8(v, vdupq_n_u8(static_cast<uint8_t>(hi)))); }
+
+static inline VectorType
+VectorOr(VectorType a, VectorType b)
+{ return vorrq_u8(a, b); }
+
+static inline VectorType
+VectorLowercase(VectorType v)
+{ return vorrq_u8(v, vdupq_n_u8(0x20)); }
+
+static inline uint32_t
+VectorMask(VectorType v)
+{
+    /* Weight each lane by its bit, then sum each half into a byte. */
+    static uint8_t const weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t bits = vandq_u8(v, vld1q_u8(weights));
+    return static_cast<uint32_t>(vaddv_u8(vget_low_u8(bits))) | (static_cast<uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+}
+#endif
+
+static uint32_t const VectorFull = (ASCII_PLIST_LEXER_VECTOR == 32 ? 0xFFFFFFFFu : 0xFFFFu);
+
+#endif
+
+/*
+ * Finds the first of four bytes.
+ */
+static inline char const *
+ASCIIPListLexerFind(ASCIIPListLexer const *lexer, char const *p, char a, char b, char c, char d)
+{
+#if defined(ASCII_PLIST_LEXER_VECTOR)
+    if (lexer->vectorized) {
+        while (lexer->endBuffer - p >= ASCII_PLIST_LEXER_VECTOR) {
+            VectorType v = VectorLoad(p);
+            uint32_t mask = VectorMask(VectorOr(VectorOr(VectorEqual(v, a), VectorEqual(v, b)),
+                                                VectorOr(VectorEqual(v, c), VectorEqual(v, d))));
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += ASCII_PLIST_LEXER_VECTOR;
+        }
+    }
+#endif
+    return p;
+}
+
+/*
+ * Skips characters allowed in unquoted strings.
+ */
+static inline char const *
+ASCIIPListLexerSkipUnquoted(ASCIIPListLexer const *lexer, char const *p)
+{
+#if defined(ASCII_PLIST_LEXER_VECTOR)
+    if (lexer->vectorized) {
+        while (lexer->endBuffer - p >= ASCII_PLIST_LEXER_VECTOR) {
+            VectorType v = VectorLoad(p);
+            VectorType allowed = VectorOr(VectorRange(v, '0', '9'), VectorRange(VectorLowercase(v), 'a', 'z'));
+            allowed = VectorOr(allowed, VectorOr(VectorEqual(v, '_'), VectorEqual(v, '.')));
+            allowed = VectorOr(allowed, VectorOr(VectorEqual(v, '$'), VectorEqual(v, '-')));
+            allowed = VectorOr(allowed, VectorOr(VectorEqual(v, ':'), VectorEqual(v, '/')));
+
+            uint32_t mask = ~VectorMask(allowed) & VectorFull;
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += ASCII_PLIST_LEXER_VECTOR;
+        }
+    }
+#endif
+    return p;
+}
+
+/*
+ * Skips whitespace, counting lines.
+ */
+static inline char const *
+ASCIIPListLexerSkipWhitespace(ASCIIPListLexer *lexer, char const *p)
+{
+#if defined(ASCII_PLIST_LEXER_VECTOR)
+    if (lexer->vectorized) {
+        while (lexer->endBuffer - p >= ASCII_PLIST_LEXER_VECTOR) {
+            VectorType v = VectorLoad(p);
+            VectorType newline = VectorEqual(v, '\n');
+            VectorType space = VectorOr(VectorOr(VectorEqual(v, ' '), VectorEqual(v, '\t')),
+                                        VectorOr(VectorEqual(v, '\r'), VectorEqual(v, '\f')));
+
+            uint32_t other = ~VectorMask(VectorOr(space, newline)) & VectorFull;
+            uint32_t lines = VectorMask(newline);
+            if (other != 0) {
+                lines &= (1u << __builtin_ctz(other)) - 1;
+            }
+
+            if (lines != 0) {
+                lexer->line += __builtin_popcount(lines);
+                lexer->lineStart = p + (31 - __builtin_clz(lines)) + 1;
+            }
+
+            if (other != 0) {
+                return p + __builtin_ctz(other);
+            }
+            p += ASCII_PLIST_LEXER_VECTOR;
+        }
+    }
+#endif
+    return p;
+}
+
 static inline bool
 isodigit(char ch)
 { return (ch >= '0' && ch <= '7'); }
@@ -108,7 +308,9 @@ ASCIIPListLexerReadInlineComment(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0' && *p != '\n' && *p != '\r'; p++)
+    b = p;
+    p = ASCIIPListLexerFind(lexer, p, '\0', '\n', '\r', '\r');
+    for (; *p != '\0' && *p != '\n' && *p != '\r'; p++)
         ;
     lexer->tokenLength = p - b;
     lexer->pointer = p;
@@ -122,7 +324,7 @@ ASCIIPListLexerReadLongComment(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0'; p++) {
+    for (b = p; *(p = ASCIIPListLexerFind(lexer, p, '\0', '\n', '*', '*')) != '\0'; p++) {
         if (p[0] == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -142,7 +344,7 @@ ASCIIPListLexerReadSingleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\'' && *p != '\0'; p++) {
+    for (b = p; *(p = ASCIIPListLexerFind(lexer, p, '\'', '\0', '\n', '\n')) != '\'' && *p != '\0'; p++) {
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -165,7 +367,7 @@ ASCIIPListLexerReadDoubleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\"' && *p != '\0'; p++) {
+    for (b = p; *(p = ASCIIPListLexerFind(lexer, p, '\"', '\0', '\n', '\\')) != '\"' && *p != '\0'; p++) {
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -299,6 +501,7 @@ ASCIIPListLexerReadKeyword(ASCIIPListLexer *lexer)
         }
     } else if (lexer->style == kASCIIPListLexerStyleASCII) {
         rc = kASCIIPListLexerTokenUnquotedString;
+        p = ASCIIPListLexerSkipUnquoted(lexer, p);
         /*
             * '$' is encountered in pbxproj files.
             */
@@ -430,10 +633,12 @@ ASCIIPListLexerReadToken(ASCIIPListLexer *lexer)
 
             case ' ': case '\f': case '\t': case '\r':
                  p++;
+                 p = ASCIIPListLexerSkipWhitespace(lexer, p);
                  break;
 
             case '\n':
                  p++, lexer->line++; lexer->lineStart = p;
+                 p = ASCIIPListLexerSkipWhitespace(lexer, p);
                  break;
 
             default:
@@ -467,6 +672,13 @@ ASCIIPListLexerInit(ASCIIPListLexer *lexer, char const *buffer, int length,
     lexer->endBuffer = lexer->inputBuffer + length;
     lexer->style = style;
     lexer->line = 1;
+    lexer->vectorized = 1;
+}
+
+void
+ASCIIPListLexerSetVectorized(ASCIIPListLexer *lexer, int vectorized)
+{
+    lexer->vectorized = vectorized;
 }
 
 /* Convert sequence \xXX */
@@ -11,6 +11,7 @@
 #include <plist/Objects.h>
 
 #include <cstdlib>
+#include <cstring>
 
 using plist::Format::ASCIIParser;
 using plist::Object;
@@ -25,7 +26,6 @@ ASCIIParser() :
     _level(0),
     _state(ValueState::Init),
     _container(nullptr),
-    _key(nullptr),
     _contextState(ContextState::Parsing)
 {
 }
@@ -78,7 +78,7 @@ abort(std::string const &error, int line)
 }
 
 bool ASCIIParser::
-push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key)
+push(ValueState state, std::unique_ptr<plist::Object> container, ext::optional<std::string> key)
 {
     if (isAborted()) {
         return false;
@@ -100,11 +100,7 @@ push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr
         _container = nullptr;
     }
 
-    if (key != nullptr) {
-        _key = std::move(key);
-    } else {
-        _key = nullptr;
-    }
+    _key = std::move(key);
 
     return true;
 }
@@ -120,7 +116,7 @@ pop()
 
         /* Reset current state. */
         _container = nullptr;
-        _key = nullptr;
+        _key = ext::nullopt;
 
         _state = ValueState::Init;
         return true;
@@ -153,7 +149,7 @@ beginContainer(std::unique_ptr<plist::Object> object)
         state = ValueState::Dictionary;
     }
 
-    if (!push(state, std::move(object), nullptr)) {
+    if (!push(state, std::move(object), ext::nullopt)) {
         abort("Cannot push the current state.");
         return false;
     }
@@ -162,10 +158,10 @@ beginContainer(std::unique_ptr<plist::Object> object)
 }
 
 bool ASCIIParser::
-storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value)
+storeKeyValue(ext::optional<std::string> key, std::unique_ptr<plist::Object> value)
 {
     if (_container == nullptr) {
-        if (_key != nullptr) {
+        if (_key) {
             abort("Storing key/value pair with no container.");
             return false;
         }
@@ -180,14 +176,14 @@ storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object>
         return true;
     }
 
-    if (key != nullptr) {
+    if (key) {
         if (_container->type() != Dictionary::Type()) {
             abort("Storing key/value with no dictionary container.");
             return false;
         }
 
         plist::Dictionary *dict = static_cast<plist::Dictionary *>(_container.get());
-        dict->set(key->value(), std::move(value));
+        dict->set(std::move(*key), std::move(value));
 
         _state = ValueState::Dictionary;
     } else {
@@ -208,7 +204,7 @@ storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object>
 bool ASCIIParser::
 endContainer(bool isArray)
 {
-    std::unique_ptr<plist::String> key;
+    ext::optional<std::string> key;
     std::unique_ptr<plist::Object> value;
     bool success;
 
@@ -242,7 +238,7 @@ endContainer(bool isArray)
 
     /* Take ownership of the saved key. */
     key = std::move(_key);
-    _key = nullptr;
+    _key = ext::nullopt;
 
     success = storeKeyValue(std::move(key), std::move(value));
 
@@ -291,17 +287,8 @@ endDictionary()
  * Store the key of the current dictionary.
  */
 bool ASCIIParser::
-storeKey(std::unique_ptr<plist::String> key)
+storeKey(std::string key)
 {
-    if (key == nullptr) {
-        key = String::New();
-
-        if (key == nullptr) {
-            abort("Cannot create empty key.");
-            return false;
-        }
-    }
-
     if (_state != ValueState::Dictionary) {
         abort("Storing key in wrong state.");
         return false;
@@ -319,7 +306,7 @@ storeValue(std::unique_ptr<plist::Object> value)
     bool success;
 
     success = storeKeyValue(std::move(_key), std::move(value));
-    _key = nullptr;
+    _key = ext::nullopt;
 
     if (_state == ValueState::DictionaryValue) {
         _state = ValueState::Dictionary;
@@ -506,24 +493,30 @@ parse(ASCIIPListLexer *lexer, bool strings)
 
                     if (token == kASCIIPListLexerTokenUnquotedString ||
                         token == kASCIIPListLexerTokenQuotedString) {
-                        char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        std::unique_ptr<String> string = String::New(std::string(contents));
-                        free(contents);
-
-                        if (string == NULL) {
-                            abort("OOM when copying string", lexer->line);
-                            return false;
+                        std::string string;
+                        char const *begin = lexer->inputBuffer + lexer->tokenBegin;
+                        if (::memchr(begin, '\\', lexer->tokenLength) == nullptr) {
+                            /* Without escapes, the token is the string. */
+                            string.assign(begin, lexer->tokenLength);
+                        } else {
+                            char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
+                            if (contents == NULL) {
+                                abort("OOM when copying string", lexer->line);
+                                return false;
+                            }
+                            string = contents;
+                            free(contents);
                         }
 
                         /* Container context */
                         if (isDictionary) {
-                            ASCIIDebug("Storing string %s as key", string->value().c_str());
+                            ASCIIDebug("Storing string %s as key", string.c_str());
                             if (!storeKey(std::move(string))) {
                                 return false;
                             }
                         } else {
-                            ASCIIDebug("Storing string %s", string->value().c_str());
-                            if (!storeValue(std::move(string))) {
+                            ASCIIDebug("Storing string %s", string.c_str());
+                            if (!storeValue(String::New(std::move(string)))) {
                                 return false;
                             }
                         }
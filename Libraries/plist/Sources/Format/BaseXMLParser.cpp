@@ -8,23 +8,157 @@
  */
 
 #include <plist/Format/BaseXMLParser.h>
+#include <plist/Format/XMLTokenizer.h>
 
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
+#include <mutex>
 
 using plist::Format::BaseXMLParser;
+using plist::Format::XMLTokenizer;
 
 BaseXMLParser::BaseXMLParser() :
-    _parser (nullptr),
-    _depth  (0)
+    _parser   (nullptr),
+    _tokenizer(nullptr),
+    _depth    (0),
+    _stopped  (false),
+    _line     (0),
+    _column   (0)
 {
 }
 
+/*
+ * Text of only whitespace is reported separately by libxml2, and ignored.
+ */
+static bool
+IsBlank(char const *data, size_t size)
+{
+    for (size_t n = 0; n < size; n++) {
+        if (data[n] != ' ' && data[n] != '\t' && data[n] != '\n' && data[n] != '\r') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BaseXMLParser::
+parse(std::vector<uint8_t> const &contents, bool streaming)
+{
+    if (streaming) {
+        if (ext::optional<bool> result = parseStreaming(contents)) {
+            return *result;
+        }
+    }
+
+    return parseLibXML2(contents);
+}
+
+ext::optional<bool> BaseXMLParser::
+parseStreaming(std::vector<uint8_t> const &contents)
+{
+    XMLTokenizer tokenizer = XMLTokenizer(reinterpret_cast<char const *>(contents.data()), contents.size());
+    _tokenizer = &tokenizer;
+    _depth     = 0;
+    _stopped   = false;
+
+    onBeginParse();
+
+    /*
+     * Malformed documents are left to libxml2 as well, for its diagnostics.
+     */
+    ext::optional<bool> result;
+    std::vector<XMLTokenizer::Span> elements;
+    bool root = false;
+
+    while (!result) {
+        XMLTokenizer::Token token = tokenizer.next();
+        if (token == XMLTokenizer::Token::StartElement) {
+            if (root && elements.empty()) {
+                break;
+            }
+            root = true;
+
+            XMLTokenizer::Span const &name = tokenizer.name();
+            _name.assign(name.data, name.size);
+
+            std::vector<XMLTokenizer::Attribute> const &attributes = tokenizer.attributes();
+            _attributes.resize(attributes.size());
+            for (size_t n = 0; n < attributes.size(); n++) {
+                _attributes[n].first.assign(attributes[n].name.data, attributes[n].name.size);
+                _attributes[n].second.assign(attributes[n].value.data, attributes[n].value.size);
+            }
+
+            _depth = elements.size();
+            onStartElement(_name, _attributes, _depth);
+
+            if (tokenizer.empty()) {
+                if (!_stopped) {
+                    onEndElement(_name, _depth);
+                }
+            } else {
+                elements.push_back(name);
+            }
+        } else if (token == XMLTokenizer::Token::EndElement) {
+            XMLTokenizer::Span const &name = tokenizer.name();
+            if (elements.empty() || elements.back().size != name.size || ::memcmp(elements.back().data, name.data, name.size) != 0) {
+                break;
+            }
+            elements.pop_back();
+
+            _name.assign(name.data, name.size);
+            _depth = elements.size();
+            onEndElement(_name, _depth);
+        } else if (token == XMLTokenizer::Token::Text || token == XMLTokenizer::Token::CDATA) {
+            XMLTokenizer::Span const &text = tokenizer.text();
+            if (elements.empty()) {
+                if (token == XMLTokenizer::Token::CDATA || !IsBlank(text.data, text.size)) {
+                    break;
+                }
+            } else if (token == XMLTokenizer::Token::CDATA || !IsBlank(text.data, text.size)) {
+                _depth = elements.size();
+                onCharacterData(text.data, text.size, _depth);
+            }
+        } else if (token == XMLTokenizer::Token::End) {
+            if (!root || !elements.empty()) {
+                break;
+            }
+            result = true;
+        } else {
+            /* Unsupported or malformed. */
+            break;
+        }
+
+        if (_stopped) {
+            result = false;
+        }
+    }
+
+    _tokenizer = nullptr;
+    _depth     = 0;
+
+    if (!result) {
+        /* Discard anything built, to start over with libxml2. */
+        onEndParse(false);
+        return ext::nullopt;
+    }
+
+    onEndParse(*result);
+    return result;
+}
+
 bool BaseXMLParser::
-parse(std::vector<uint8_t> const &contents)
+parseLibXML2(std::vector<uint8_t> const &contents)
 {
-    _depth  = 0;
-    _parser = ::xmlReaderForMemory(reinterpret_cast<char const *>(contents.data()), contents.size(), nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
+    /* libxml2 must be initialized once before it's used from multiple threads. */
+    static std::once_flag initialized;
+    std::call_once(initialized, []() {
+        ::xmlInitParser();
+    });
+
+    _depth   = 0;
+    _stopped = false;
+    _parser  = ::xmlReaderForMemory(reinterpret_cast<char const *>(contents.data()), contents.size(), nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
     if (_parser == nullptr) {
         return false;
     }
@@ -37,14 +171,14 @@ parse(std::vector<uint8_t> const &contents)
 
         int type = xmlTextReaderNodeType(_parser);
         if (type == 1 /* Start element. */) {
-            std::unordered_map<std::string, std::string> attrs;
+            _attributes.clear();
 
             ret = xmlTextReaderMoveToFirstAttribute(_parser);
             while (ret == 1) {
                 /* Store attribute. */
                 xmlChar const *name = xmlTextReaderConstName(_parser);
                 xmlChar const *value = xmlTextReaderConstValue(_parser);
-                attrs[std::string(reinterpret_cast<char const *>(name))] = std::string(reinterpret_cast<char const *>(value));
+                _attributes.emplace_back(std::string(reinterpret_cast<char const *>(name)), std::string(reinterpret_cast<char const *>(value)));
 
                 ret = xmlTextReaderMoveToNextAttribute(_parser);
             }
@@ -65,19 +199,19 @@ parse(std::vector<uint8_t> const &contents)
                 break;
             }
 
-            xmlChar const *name = xmlTextReaderConstName(_parser);
-            onStartElement(std::string(reinterpret_cast<char const *>(name)), attrs, _depth);
+            _name = reinterpret_cast<char const *>(xmlTextReaderConstName(_parser));
+            onStartElement(_name, _attributes, _depth);
 
-            if (ret == 1) {
+            if (ret == 1 && !_stopped) {
                 /* Empty element. */
-                onEndElement(std::string(reinterpret_cast<char const *>(name)), _depth);
+                onEndElement(_name, _depth);
             }
         } else if (type == 15 /* End element. */) {
-            xmlChar const *name = xmlTextReaderConstName(_parser);
-            onEndElement(std::string(reinterpret_cast<char const *>(name)), _depth);
-        } else if (type == 3 /* Text. */) {
-            xmlChar const *value = xmlTextReaderConstValue(_parser);
-            onCharacterData(std::string(reinterpret_cast<char const *>(value)), _depth);
+            _name = reinterpret_cast<char const *>(xmlTextReaderConstName(_parser));
+            onEndElement(_name, _depth);
+        } else if (type == 3 /* Text. */ || type == 4 /* CDATA. */) {
+            char const *value = reinterpret_cast<char const *>(xmlTextReaderConstValue(_parser));
+            onCharacterData(value, ::strlen(value), _depth);
         }
 
         /* Handle error. */
@@ -109,7 +243,7 @@ onEndParse(bool success)
 }
 
 void BaseXMLParser::
-onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth)
+onStartElement(std::string const &name, Attributes const &attrs, size_t depth)
 {
 }
 
@@ -119,7 +253,7 @@ onEndElement(std::string const &name, size_t depth)
 }
 
 void BaseXMLParser::
-onCharacterData(std::string const &cdata, size_t depth)
+onCharacterData(char const *cdata, size_t size, size_t depth)
 {
 }
 
@@ -137,8 +271,12 @@ error(std::string format, ...)
     }
     va_end(ap);
 
-    _line = ::xmlTextReaderGetParserLineNumber(_parser);
-    _column = ::xmlTextReaderGetParserColumnNumber(_parser);
+    if (_tokenizer != nullptr) {
+        _tokenizer->location(&_line, &_column);
+    } else if (_parser != nullptr) {
+        _line = ::xmlTextReaderGetParserLineNumber(_parser);
+        _column = ::xmlTextReaderGetParserColumnNumber(_parser);
+    }
     _error = std::string(buf);
 
     if (buf != sErrorMessage) {
@@ -147,4 +285,5 @@ error(std::string format, ...)
 
     ::xmlFreeTextReader(_parser);
     _parser = nullptr;
+    _stopped = true;
 }
@@ -51,7 +51,7 @@ onEndParse(bool success)
 }
 
 void SimpleXMLParser::
-onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t)
+onStartElement(std::string const &name, Attributes const &attrs, size_t)
 {
     Dictionary *dict = Dictionary::New().release();
 
@@ -20,8 +20,9 @@ using plist::Format::XMLWriter;
 using plist::Object;
 
 XML::
-XML(Encoding encoding) :
-    _encoding(encoding)
+XML(Encoding encoding, Parser parser) :
+    _encoding(encoding),
+    _parser  (parser)
 {
 }
 
@@ -88,7 +89,7 @@ Deserialize(std::vector<uint8_t> const &contents, XML const &format)
     std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
 
     XMLParser parser;
-    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(data));
+    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(data, format.parser() == XML::Parser::Streaming));
     if (root == nullptr) {
         return std::make_pair(nullptr, parser.error());
     }
@@ -117,7 +118,7 @@ Serialize(Object const *object, XML const &format)
 } }
 
 XML XML::
-Create(Encoding encoding)
+Create(Encoding encoding, Parser parser)
 {
-    return XML(encoding);
+    return XML(encoding, parser);
 }
@@ -21,12 +21,12 @@ XMLParser::XMLParser() :
 }
 
 Object *XMLParser::
-parse(std::vector<uint8_t> const &contents)
+parse(std::vector<uint8_t> const &contents, bool streaming)
 {
     if (_root != nullptr)
         return nullptr;
 
-    if (!BaseXMLParser::parse(contents))
+    if (!BaseXMLParser::parse(contents, streaming))
         return nullptr;
 
     return _root;
@@ -66,7 +66,7 @@ onEndParse(bool success)
 }
 
 void XMLParser::
-onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth)
+onStartElement(std::string const &name, Attributes const &attrs, size_t depth)
 {
     if (depth == 0) {
         if (name != "plist") {
@@ -98,18 +98,19 @@ onEndElement(std::string const &name, size_t)
 }
 
 void XMLParser::
-onCharacterData(std::string const &cdata, size_t)
+onCharacterData(char const *cdata, size_t size, size_t)
 {
     if (!isExpectingCDATA()) {
-        for (size_t n = 0; n < cdata.size(); n++) {
+        for (size_t n = 0; n < size; n++) {
             if (!isspace(cdata[n])) {
-                error("unexpected cdata: " + cdata);
+                error("unexpected cdata: " + std::string(cdata, size));
+                return;
             }
         }
         return;
     }
 
-    _cdata += cdata;
+    _cdata.append(cdata, size);
 }
 
 inline bool XMLParser::
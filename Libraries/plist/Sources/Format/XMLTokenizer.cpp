@@ -0,0 +1,504 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/XMLTokenizer.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using plist::Format::XMLTokenizer;
+
+static size_t const NotDecoded = static_cast<size_t>(-1);
+
+static inline bool
+IsSpace(char c)
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+static inline bool
+IsNameEnd(char c)
+{
+    return (IsSpace(c) || c == '/' || c == '>' || c == '=');
+}
+
+static inline bool
+StartsWith(char const *p, char const *end, char const *prefix)
+{
+    size_t length = ::strlen(prefix);
+    return (static_cast<size_t>(end - p) >= length && ::memcmp(p, prefix, length) == 0);
+}
+
+static inline char const *
+Find(char const *p, char const *end, char const *string)
+{
+    return std::search(p, end, string, string + ::strlen(string));
+}
+
+static inline char const *
+SkipSpace(char const *p, char const *end)
+{
+    while (p != end && IsSpace(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static inline char const *
+ScanName(char const *p, char const *end)
+{
+    while (p != end && !IsNameEnd(*p)) {
+        p++;
+    }
+    return p;
+}
+
+/*
+ * Finds the next character that ends or interrupts a run of text: the start
+ * of markup, an entity, or a carriage return to normalize.
+ */
+static inline char const *
+FindSpecial(char const *p, char const *end)
+{
+#if defined(__SSE2__)
+    __m128i const lt = _mm_set1_epi8('<');
+    __m128i const amp = _mm_set1_epi8('&');
+    __m128i const cr = _mm_set1_epi8('\r');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+        __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, amp)), _mm_cmpeq_epi8(chunk, cr));
+        int mask = _mm_movemask_epi8(match);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    uint8x16_t const lt = vdupq_n_u8('<');
+    uint8x16_t const amp = vdupq_n_u8('&');
+    uint8x16_t const cr = vdupq_n_u8('\r');
+
+    while (end - p >= 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<uint8_t const *>(p));
+        uint8x16_t match = vorrq_u8(vorrq_u8(vceqq_u8(chunk, lt), vceqq_u8(chunk, amp)), vceqq_u8(chunk, cr));
+        if (vmaxvq_u8(match) != 0) {
+            /* Narrow each byte of the match to four bits of a 64-bit mask. */
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+            return p + (__builtin_ctzll(mask) >> 2);
+        }
+        p += 16;
+    }
+#endif
+
+    while (p != end && *p != '<' && *p != '&' && *p != '\r') {
+        p++;
+    }
+    return p;
+}
+
+static void
+AppendUTF8(std::string *string, uint32_t c)
+{
+    if (c < 0x80) {
+        string->push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        string->push_back(static_cast<char>(0xC0 | (c >> 6)));
+        string->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+        string->push_back(static_cast<char>(0xE0 | (c >> 12)));
+        string->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        string->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+        string->push_back(static_cast<char>(0xF0 | (c >> 18)));
+        string->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+        string->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        string->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+}
+
+XMLTokenizer::
+XMLTokenizer(char const *data, size_t size) :
+    _begin  (data),
+    _end    (data + size),
+    _current(data),
+    _token  (data),
+    _start  (true),
+    _name   ({ nullptr, 0 }),
+    _empty  (false),
+    _text   ({ nullptr, 0 })
+{
+    /* Skip a UTF-8 byte order mark. */
+    if (StartsWith(_current, _end, "\xEF\xBB\xBF")) {
+        _current += 3;
+    }
+}
+
+XMLTokenizer::Token XMLTokenizer::
+next()
+{
+    for (;;) {
+        bool start = _start;
+        _start = false;
+
+        _token = _current;
+        if (_current == _end) {
+            return Token::End;
+        } else if (*_current != '<') {
+            return readText();
+        }
+
+        char const *p = _current + 1;
+        if (p == _end) {
+            return Token::Error;
+        } else if (*p == '/') {
+            return readEndElement();
+        } else if (*p == '?') {
+            char const *close = Find(p, _end, "?>");
+            if (close == _end) {
+                return Token::Error;
+            }
+
+            char const *target = p + 1;
+            char const *targetEnd = ScanName(target, close);
+            if (targetEnd - target == 3 && ::strncasecmp(target, "xml", 3) == 0) {
+                /* Only the declaration at the start is valid. */
+                if (!start) {
+                    return Token::Unsupported;
+                }
+
+                /* Input is always UTF-8. */
+                char const *encoding = Find(targetEnd, close, "encoding");
+                if (encoding != close) {
+                    char const *value = SkipSpace(encoding + 8, close);
+                    if (value == close || *value != '=') {
+                        return Token::Error;
+                    }
+                    value = SkipSpace(value + 1, close);
+                    if (!StartsWith(value, close, "\"UTF-8\"") && !StartsWith(value, close, "'UTF-8'") &&
+                        !StartsWith(value, close, "\"utf-8\"") && !StartsWith(value, close, "'utf-8'")) {
+                        return Token::Unsupported;
+                    }
+                }
+            }
+
+            /* Other processing instructions are ignored. */
+            _current = close + 2;
+        } else if (StartsWith(p, _end, "!--")) {
+            char const *close = Find(p + 3, _end, "-->");
+            if (close == _end) {
+                return Token::Error;
+            }
+
+            _current = close + 3;
+        } else if (StartsWith(p, _end, "![CDATA[")) {
+            char const *begin = p + 8;
+            char const *close = Find(begin, _end, "]]>");
+            if (close == _end) {
+                return Token::Error;
+            }
+
+            /* Line endings would need normalizing. */
+            if (::memchr(begin, '\r', close - begin) != nullptr) {
+                return Token::Unsupported;
+            }
+
+            _text = { begin, static_cast<size_t>(close - begin) };
+            _current = close + 3;
+            return Token::CDATA;
+        } else if (StartsWith(p, _end, "!DOCTYPE")) {
+            /* An internal subset can declare entities and defaults. */
+            char quote = '\0';
+            for (p += 8; p != _end; p++) {
+                if (quote != '\0') {
+                    if (*p == quote) {
+                        quote = '\0';
+                    }
+                } else if (*p == '"' || *p == '\'') {
+                    quote = *p;
+                } else if (*p == '[') {
+                    return Token::Unsupported;
+                } else if (*p == '>') {
+                    break;
+                }
+            }
+            if (p == _end) {
+                return Token::Error;
+            }
+
+            _current = p + 1;
+        } else if (*p == '!') {
+            return Token::Unsupported;
+        } else {
+            return readElement();
+        }
+    }
+}
+
+XMLTokenizer::Token XMLTokenizer::
+readElement()
+{
+    char const *p = _current + 1;
+    char const *nameEnd = ScanName(p, _end);
+    if (nameEnd == p) {
+        return Token::Error;
+    }
+    _name = { p, static_cast<size_t>(nameEnd - p) };
+    p = nameEnd;
+
+    _attributes.clear();
+    _decoded.clear();
+    _buffer.clear();
+
+    for (;;) {
+        char const *space = p;
+        p = SkipSpace(p, _end);
+        if (p == _end) {
+            return Token::Error;
+        } else if (*p == '>') {
+            _empty = false;
+            p += 1;
+            break;
+        } else if (*p == '/') {
+            if (p + 1 == _end || p[1] != '>') {
+                return Token::Error;
+            }
+            _empty = true;
+            p += 2;
+            break;
+        } else if (p == space) {
+            /* Attributes must be separated by whitespace. */
+            return Token::Error;
+        }
+
+        Attribute attribute;
+        char const *attributeNameEnd = ScanName(p, _end);
+        if (attributeNameEnd == p) {
+            return Token::Error;
+        }
+        attribute.name = { p, static_cast<size_t>(attributeNameEnd - p) };
+
+        p = SkipSpace(attributeNameEnd, _end);
+        if (p == _end || *p != '=') {
+            return Token::Error;
+        }
+        p = SkipSpace(p + 1, _end);
+        if (p == _end || (*p != '"' && *p != '\'')) {
+            return Token::Error;
+        }
+
+        char const *value = p + 1;
+        char const *valueEnd = static_cast<char const *>(::memchr(value, *p, _end - value));
+        if (valueEnd == nullptr || ::memchr(value, '<', valueEnd - value) != nullptr) {
+            return Token::Error;
+        }
+        p = valueEnd + 1;
+
+        bool normalize = false;
+        for (char const *c = value; c != valueEnd; c++) {
+            if (*c == '&' || (IsSpace(*c) && *c != ' ')) {
+                normalize = true;
+                break;
+            }
+        }
+
+        if (normalize) {
+            /* Decoded values are fixed up below, once the buffer is complete. */
+            size_t offset = _buffer.size();
+            Token result = decode(value, valueEnd, true);
+            if (result != Token::Text) {
+                return result;
+            }
+            attribute.value = { nullptr, _buffer.size() - offset };
+            _decoded.push_back(offset);
+        } else {
+            attribute.value = { value, static_cast<size_t>(valueEnd - value) };
+            _decoded.push_back(NotDecoded);
+        }
+
+        for (Attribute const &existing : _attributes) {
+            if (existing.name.size == attribute.name.size && ::memcmp(existing.name.data, attribute.name.data, attribute.name.size) == 0) {
+                return Token::Error;
+            }
+        }
+
+        _attributes.push_back(attribute);
+    }
+
+    for (size_t n = 0; n < _attributes.size(); n++) {
+        if (_decoded[n] != NotDecoded) {
+            _attributes[n].value.data = _buffer.data() + _decoded[n];
+        }
+    }
+
+    _current = p;
+    return Token::StartElement;
+}
+
+XMLTokenizer::Token XMLTokenizer::
+readEndElement()
+{
+    char const *p = _current + 2;
+    char const *nameEnd = ScanName(p, _end);
+    if (nameEnd == p) {
+        return Token::Error;
+    }
+    _name = { p, static_cast<size_t>(nameEnd - p) };
+
+    p = SkipSpace(nameEnd, _end);
+    if (p == _end || *p != '>') {
+        return Token::Error;
+    }
+
+    _current = p + 1;
+    return Token::EndElement;
+}
+
+XMLTokenizer::Token XMLTokenizer::
+readText()
+{
+    char const *begin = _current;
+    char const *p = FindSpecial(begin, _end);
+
+    if (p == _end || *p == '<') {
+        /* Common case: the text can be used in place. */
+        _text = { begin, static_cast<size_t>(p - begin) };
+        _current = p;
+        return Token::Text;
+    }
+
+    char const *end = static_cast<char const *>(::memchr(p, '<', _end - p));
+    if (end == nullptr) {
+        end = _end;
+    }
+
+    _buffer.clear();
+    Token result = decode(begin, end, false);
+    if (result != Token::Text) {
+        return result;
+    }
+
+    _text = { _buffer.data(), _buffer.size() };
+    _current = end;
+    return Token::Text;
+}
+
+/*
+ * Appends text or an attribute value to the buffer, replacing entities and
+ * normalizing line endings. Returns `Token::Text` on success.
+ */
+XMLTokenizer::Token XMLTokenizer::
+decode(char const *begin, char const *end, bool attribute)
+{
+    char const *p = begin;
+    while (p != end) {
+        char const *special = FindSpecial(p, end);
+        if (attribute) {
+            for (char const *c = p; c != special; c++) {
+                _buffer.push_back(*c == '\t' || *c == '\n' ? ' ' : *c);
+            }
+        } else {
+            _buffer.append(p, special - p);
+        }
+        p = special;
+
+        if (p == end) {
+            break;
+        } else if (*p == '\r') {
+            _buffer.push_back(attribute ? ' ' : '\n');
+            p++;
+            if (p != end && *p == '\n') {
+                p++;
+            }
+            continue;
+        } else if (*p == '<') {
+            return Token::Error;
+        }
+
+        char const *semicolon = static_cast<char const *>(::memchr(p, ';', end - p));
+        if (semicolon == nullptr) {
+            return Token::Error;
+        }
+
+        char const *entity = p + 1;
+        size_t length = semicolon - entity;
+        if (length > 1 && entity[0] == '#') {
+            bool hex = (entity[1] == 'x');
+            char const *digits = entity + (hex ? 2 : 1);
+            if (digits == semicolon) {
+                return Token::Error;
+            }
+
+            uint32_t c = 0;
+            for (char const *d = digits; d != semicolon; d++) {
+                uint32_t digit;
+                if (*d >= '0' && *d <= '9') {
+                    digit = *d - '0';
+                } else if (hex && *d >= 'a' && *d <= 'f') {
+                    digit = *d - 'a' + 10;
+                } else if (hex && *d >= 'A' && *d <= 'F') {
+                    digit = *d - 'A' + 10;
+                } else {
+                    return Token::Error;
+                }
+
+                c = c * (hex ? 16 : 10) + digit;
+                if (c > 0x10FFFF) {
+                    return Token::Error;
+                }
+            }
+
+            /* Only characters allowed in XML documents. */
+            if ((c < 0x20 && c != '\t' && c != '\n' && c != '\r') || (c >= 0xD800 && c <= 0xDFFF) || c == 0xFFFE || c == 0xFFFF) {
+                return Token::Error;
+            }
+
+            AppendUTF8(&_buffer, c);
+        } else if (length == 2 && ::memcmp(entity, "lt", 2) == 0) {
+            _buffer.push_back('<');
+        } else if (length == 2 && ::memcmp(entity, "gt", 2) == 0) {
+            _buffer.push_back('>');
+        } else if (length == 3 && ::memcmp(entity, "amp", 3) == 0) {
+            _buffer.push_back('&');
+        } else if (length == 4 && ::memcmp(entity, "quot", 4) == 0) {
+            _buffer.push_back('"');
+        } else if (length == 4 && ::memcmp(entity, "apos", 4) == 0) {
+            _buffer.push_back('\'');
+        } else {
+            /* Other entities must be declared in a document type. */
+            return Token::Unsupported;
+        }
+
+        p = semicolon + 1;
+    }
+
+    return Token::Text;
+}
+
+void XMLTokenizer::
+location(size_t *line, size_t *column) const
+{
+    size_t lines = 1;
+    char const *start = _begin;
+    for (char const *p = _begin; p != _token; p++) {
+        if (*p == '\n') {
+            lines++;
+            start = p + 1;
+        }
+    }
+
+    *line = lines;
+    *column = static_cast<size_t>(_token - start) + 1;
+}
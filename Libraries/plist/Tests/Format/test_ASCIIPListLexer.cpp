@@ -0,0 +1,100 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/ASCIIPListLexer.h>
+
+#include <string>
+#include <vector>
+
+struct Token {
+    int token;
+    int begin;
+    int length;
+    int line;
+    long lineStart;
+
+    bool operator==(Token const &rhs) const
+    {
+        return token == rhs.token && begin == rhs.begin && length == rhs.length && line == rhs.line && lineStart == rhs.lineStart;
+    }
+};
+
+static std::vector<Token>
+Tokens(std::string const &contents, int style, bool vectorized)
+{
+    ASCIIPListLexer lexer;
+    ASCIIPListLexerInit(&lexer, contents.c_str(), contents.size(), style);
+    ASCIIPListLexerSetVectorized(&lexer, vectorized);
+
+    std::vector<Token> tokens;
+    for (;;) {
+        char const *pointer = lexer.pointer;
+        int token = ASCIIPListLexerReadToken(&lexer);
+        tokens.push_back({ token, lexer.tokenBegin, lexer.tokenLength, lexer.line, lexer.lineStart - lexer.inputBuffer });
+        if (token < 0 || lexer.pointer == pointer) {
+            break;
+        }
+    }
+    return tokens;
+}
+
+static void
+ExpectSame(std::string const &contents, int style = kASCIIPListLexerStyleASCII)
+{
+    std::vector<Token> scalar = Tokens(contents, style, false);
+    std::vector<Token> vectorized = Tokens(contents, style, true);
+
+    ASSERT_EQ(scalar.size(), vectorized.size()) << contents;
+    for (size_t n = 0; n < scalar.size(); n++) {
+        EXPECT_TRUE(scalar[n] == vectorized[n]) << "token " << n << " in " << contents;
+    }
+}
+
+TEST(ASCIIPListLexer, Project)
+{
+    std::string contents = "// !$*UTF8*$!\n{\n\tarchiveVersion = 1;\n\tobjects = {\n\n/* Begin PBXBuildFile section */\n";
+    for (int n = 0; n < 64; n++) {
+        std::string identifier = std::to_string(n);
+        identifier = std::string(24 - identifier.size(), '0') + identifier;
+        contents += "\t\t" + identifier + " /* File" + std::to_string(n) + ".m in Sources */ = {isa = PBXBuildFile; ";
+        contents += "fileRef = " + identifier + "; settings = {COMPILER_FLAGS = \"-DNAME=\\\"value\\\" -fobjc-arc\"; }; };\n";
+        contents += std::string(n % 37, ' ') + "path = Sources/Group-" + std::to_string(n) + "/$(SRCROOT)/File.m;\r\n";
+    }
+    contents += "/* End PBXBuildFile section */\n\t};\n}\n";
+
+    ExpectSame(contents);
+    ExpectSame(contents, kASCIIPListLexerStyleJSON);
+}
+
+TEST(ASCIIPListLexer, Boundaries)
+{
+    /* Every token type, shifted across vector block boundaries. */
+    std::string body =
+        "key = \"a long quoted string with \\\"escapes\\\" and\nnewlines in it\";\n"
+        "'single quoted\nstring' = <0fbd 7766 5544>;\n"
+        "unquoted.string_with-$chars:/slashes = ( one, two, three );\n"
+        "/* a long\ncomment */ // an inline comment\r\n"
+        "non-ascii = \"caf\xC3\xA9\";\n"
+        "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\n";
+
+    for (size_t shift = 0; shift < 64; shift++) {
+        ExpectSame("{" + std::string(shift, ' ') + body + "}");
+        ExpectSame("{" + std::string(shift, '\n') + body);
+    }
+}
+
+TEST(ASCIIPListLexer, Unterminated)
+{
+    std::string body = std::string(100, 'a');
+    ExpectSame("\"" + body);
+    ExpectSame("'" + body);
+    ExpectSame("/*" + body);
+    ExpectSame("\"" + body + "\\");
+}
@@ -70,3 +70,87 @@ TEST(XML, UID)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+
+static std::unique_ptr<plist::Object>
+Parse(std::string const &contents, XML::Parser parser)
+{
+    return XML::Deserialize(Contents(contents), XML::Create(Encoding::UTF8, parser)).first;
+}
+
+TEST(XML, Text)
+{
+    std::string contents = std::string(XMLHeader) +
+        "<dict>\n"
+        "\t<!-- comment -->\n"
+        "\t<key>a&lt;b&amp;c</key>\n"
+        "\t<string>&#65;&#x42;&quot;&apos;&gt; &#x263A;</string>\n"
+        "\t<key>cdata</key>\n"
+        "\t<string><![CDATA[<not> & markup]]></string>\n"
+        "\t<key>split</key>\n"
+        "\t<string>one<!-- two -->three</string>\n"
+        "\t<key>lines</key>\n"
+        "\t<string>one\r\ntwo\rthree</string>\n"
+        "</dict>\n" + std::string(XMLFooter);
+
+    auto dictionary = Dictionary::New();
+    dictionary->set("a<b&c", String::New("AB\"'> \xE2\x98\xBA"));
+    dictionary->set("cdata", String::New("<not> & markup"));
+    dictionary->set("split", String::New("onethree"));
+    dictionary->set("lines", String::New("one\ntwo\nthree"));
+
+    auto streaming = Parse(contents, XML::Parser::Streaming);
+    ASSERT_NE(nullptr, streaming);
+    EXPECT_TRUE(streaming->equals(dictionary.get()));
+
+    auto libxml2 = Parse(contents, XML::Parser::LibXML2);
+    ASSERT_NE(nullptr, libxml2);
+    EXPECT_TRUE(libxml2->equals(dictionary.get()));
+}
+
+TEST(XML, Parsers)
+{
+    std::vector<std::string> documents = {
+        "<plist version=\"1.0\"><array><integer>1</integer><real>2.5</real><true/><data>AAEC</data></array></plist>",
+        "<?xml version='1.0' encoding='utf-8'?>\n<plist><string>  </string></plist>\n",
+        "\xEF\xBB\xBF<plist><dict><key>date</key><date>2016-01-01T00:00:00Z</date></dict></plist>",
+        "<plist><dict><key>empty</key><string/><key>space</key><string> a </string></dict></plist>",
+    };
+
+    for (std::string const &document : documents) {
+        auto streaming = Parse(document, XML::Parser::Streaming);
+        auto libxml2 = Parse(document, XML::Parser::LibXML2);
+        ASSERT_NE(nullptr, streaming) << document;
+        ASSERT_NE(nullptr, libxml2) << document;
+        EXPECT_TRUE(streaming->equals(libxml2.get())) << document;
+    }
+}
+
+TEST(XML, Fallback)
+{
+    /* Declared entities are only supported by libxml2. */
+    std::string contents =
+        "<?xml version=\"1.0\"?>\n"
+        "<!DOCTYPE plist [ <!ENTITY name \"value\"> ]>\n"
+        "<plist><string>&name;</string></plist>\n";
+
+    auto result = Parse(contents, XML::Parser::Streaming);
+    ASSERT_NE(nullptr, result);
+    EXPECT_TRUE(result->equals(String::New("value").get()));
+}
+
+TEST(XML, Errors)
+{
+    std::vector<std::string> documents = {
+        "<plist><string>unclosed</plist>",
+        "<plist><string>a</string></plist><plist/>",
+        "<plist><string>&unknown;</string></plist>",
+        "<plist><string>a &amp b</string></plist>",
+        "<plist><unknown/></plist>",
+        "",
+    };
+
+    for (std::string const &document : documents) {
+        auto result = XML::Deserialize(Contents(document), XML::Create(Encoding::UTF8));
+        EXPECT_EQ(nullptr, result.first) << document;
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Cache.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <libutil/MemoryFilesystem.h>
+
+using plist::Cache;
+using plist::Dictionary;
+using plist::Integer;
+using plist::String;
+using libutil::MemoryFilesystem;
+
+static void
+WriteString(MemoryFilesystem *filesystem, std::string const &path, std::string const &contents)
+{
+    EXPECT_TRUE(filesystem->write(std::vector<uint8_t>(contents.begin(), contents.end()), path));
+}
+
+static std::string
+ReadName(Cache *cache, MemoryFilesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<plist::Object> object = cache->read(filesystem, path);
+    auto dict = plist::CastTo<Dictionary>(object.get());
+    if (dict == nullptr) {
+        return std::string();
+    }
+
+    auto count = dict->value<Integer>("Count");
+    EXPECT_NE(nullptr, count);
+    EXPECT_EQ(3, count != nullptr ? count->value() : 0);
+
+    auto name = dict->value<String>("Name");
+    return (name != nullptr ? name->value() : std::string());
+}
+
+TEST(Cache, Snapshot)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    std::string path = "/Info.plist";
+    std::string snapshot = "/cache/snapshot";
+
+    WriteString(&filesystem, path, "<plist><dict><key>Name</key><string>one</string><key>Count</key><integer>3</integer></dict></plist>");
+
+    /* Missing snapshot: parsed from the file. */
+    std::unique_ptr<Cache> cache = Cache::Open(&filesystem, snapshot);
+    EXPECT_FALSE(cache->modified());
+    EXPECT_EQ("one", ReadName(cache.get(), &filesystem, path));
+    EXPECT_TRUE(cache->modified());
+    EXPECT_TRUE(cache->write(&filesystem, snapshot));
+
+    /* Same size and modification time: the snapshot is used. */
+    uint64_t modified;
+    uint64_t size;
+    ASSERT_TRUE(filesystem.fileStatus(path, &modified, &size));
+    WriteString(&filesystem, path, "<plist><dict><key>Name</key><string>two</string><key>Count</key><integer>3</integer></dict></plist>");
+    filesystem.root().child("Info.plist")->modified() = modified;
+
+    cache = Cache::Open(&filesystem, snapshot);
+    EXPECT_EQ("one", ReadName(cache.get(), &filesystem, path));
+    EXPECT_FALSE(cache->modified());
+
+    /* Changed size: parsed again. */
+    WriteString(&filesystem, path, "<plist><dict><key>Name</key><string>three</string><key>Count</key><integer>3</integer></dict></plist>");
+    EXPECT_EQ("three", ReadName(cache.get(), &filesystem, path));
+    EXPECT_TRUE(cache->modified());
+
+    /* Changed modification time alone: parsed again. */
+    cache = Cache::Open(&filesystem, snapshot);
+    WriteString(&filesystem, path, "<plist><dict><key>Name</key><string>two</string><key>Count</key><integer>3</integer></dict></plist>");
+    EXPECT_EQ("two", ReadName(cache.get(), &filesystem, path));
+    EXPECT_TRUE(cache->modified());
+
+    /* Missing files aren't cached. */
+    EXPECT_EQ(nullptr, cache->read(&filesystem, "/missing.plist"));
+}
+
+TEST(Cache, Corrupt)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    std::string path = "/Info.plist";
+    std::string snapshot = "/snapshot";
+
+    WriteString(&filesystem, path, "<plist><dict><key>Name</key><string>one</string><key>Count</key><integer>3</integer></dict></plist>");
+
+    std::unique_ptr<Cache> cache = Cache::Open(&filesystem, snapshot);
+    EXPECT_EQ("one", ReadName(cache.get(), &filesystem, path));
+    EXPECT_TRUE(cache->write(&filesystem, snapshot));
+
+    /* A truncated snapshot opens empty. */
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, snapshot));
+    contents.resize(contents.size() - 1);
+    ASSERT_TRUE(filesystem.write(contents, snapshot));
+
+    cache = Cache::Open(&filesystem, snapshot);
+    EXPECT_EQ("one", ReadName(cache.get(), &filesystem, path));
+    EXPECT_TRUE(cache->modified());
+}
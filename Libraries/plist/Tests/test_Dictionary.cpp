@@ -0,0 +1,113 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Arena.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/ASCII.h>
+
+using plist::Arena;
+using plist::Dictionary;
+using plist::Integer;
+using plist::String;
+
+static std::vector<std::string>
+Keys(Dictionary const *dict)
+{
+    std::vector<std::string> keys;
+    for (std::string const &key : *dict) {
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+TEST(Dictionary, Order)
+{
+    auto dict = Dictionary::New();
+    dict->set("b", Integer::New(1));
+    dict->set("a", Integer::New(2));
+    dict->set("c", Integer::New(3));
+    EXPECT_EQ(std::vector<std::string>({ "b", "a", "c" }), Keys(dict.get()));
+
+    /* Replacing a value moves its key to the end. */
+    dict->set("b", Integer::New(4));
+    EXPECT_EQ(std::vector<std::string>({ "a", "c", "b" }), Keys(dict.get()));
+    EXPECT_EQ(4, dict->value<Integer>("b")->value());
+    EXPECT_EQ(3, dict->count());
+
+    dict->remove("c");
+    dict->remove("missing");
+    EXPECT_EQ(std::vector<std::string>({ "a", "b" }), Keys(dict.get()));
+    EXPECT_EQ(nullptr, dict->value("c"));
+    EXPECT_EQ(nullptr, dict->value(2));
+}
+
+TEST(Dictionary, Large)
+{
+    auto dict = Dictionary::New();
+    for (int n = 0; n < 1000; n++) {
+        dict->set("key" + std::to_string(n), Integer::New(n));
+    }
+    EXPECT_EQ(1000, dict->count());
+
+    for (int n = 999; n >= 0; n -= 3) {
+        dict->remove("key" + std::to_string(n));
+    }
+    for (int n = 0; n < 1000; n++) {
+        Integer const *value = dict->value<Integer>("key" + std::to_string(n));
+        if ((999 - n) % 3 == 0) {
+            EXPECT_EQ(nullptr, value);
+        } else {
+            ASSERT_NE(nullptr, value);
+            EXPECT_EQ(n, value->value());
+        }
+    }
+
+    for (size_t n = 0; n < dict->count(); n++) {
+        EXPECT_EQ(dict->value(n), dict->value(dict->key(n)));
+    }
+
+    auto copy = dict->copy();
+    EXPECT_TRUE(copy->equals(dict.get()));
+    EXPECT_EQ(Keys(dict.get()), Keys(copy.get()));
+}
+
+TEST(Dictionary, Arena)
+{
+    std::string contents = "{ a = { LongDescriptiveName = one; }; b = { LongDescriptiveName = two; }; c = ( { name = three; } ); }";
+
+    Arena arena;
+    auto result = plist::Format::ASCII::Deserialize(std::vector<uint8_t>(contents.begin(), contents.end()), &arena);
+    EXPECT_NE(0, arena.allocated());
+    EXPECT_EQ(nullptr, Arena::Current());
+
+    auto root = plist::CastTo<Dictionary>(result.first.get());
+    ASSERT_NE(nullptr, root);
+    auto a = root->value<Dictionary>("a");
+    auto b = root->value<Dictionary>("b");
+    ASSERT_NE(nullptr, a);
+    ASSERT_NE(nullptr, b);
+    EXPECT_EQ("one", a->value<String>("LongDescriptiveName")->value());
+    EXPECT_EQ("two", b->value<String>("LongDescriptiveName")->value());
+
+    /* Long keys are shared within the arena. */
+    EXPECT_EQ(&a->key(0), &b->key(0));
+
+    /* Outside of the arena, objects are allocated and keys held normally. */
+    size_t allocated = arena.allocated();
+    auto copy = root->copy();
+    b->set("other", String::New("four"));
+    EXPECT_EQ(allocated, arena.allocated());
+    EXPECT_TRUE(copy->value<Dictionary>("a")->equals(a));
+    EXPECT_EQ("four", b->value<String>("other")->value());
+
+    result.first.reset();
+}
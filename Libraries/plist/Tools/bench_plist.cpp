@@ -0,0 +1,192 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Arena.h>
+#include <plist/Dictionary.h>
+#include <plist/Object.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/XML.h>
+#include <plist/Format/ASCIIPListLexer.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <sys/resource.h>
+
+using libutil::DefaultFilesystem;
+
+/*
+ * Generates a project file in the same shape as a large `.pbxproj`: a flat
+ * dictionary of objects keyed by identifier, each a small dictionary.
+ */
+static std::vector<uint8_t>
+GenerateProject(size_t files)
+{
+    std::ostringstream out;
+    out << "// !$*UTF8*$!\n{\n\tarchiveVersion = 1;\n\tobjectVersion = 46;\n\tobjects = {\n";
+
+    char identifier[25];
+    for (size_t n = 0; n < files; n++) {
+        snprintf(identifier, sizeof(identifier), "%024zX", n * 2);
+        out << "\t\t" << identifier << " = {isa = PBXFileReference; lastKnownFileType = sourcecode.c.objc; ";
+        out << "name = File" << n << ".m; path = Sources/Group" << (n / 64) << "/File" << n << ".m; sourceTree = \"<group>\"; };\n";
+
+        char reference[25];
+        snprintf(reference, sizeof(reference), "%024zX", n * 2 + 1);
+        out << "\t\t" << reference << " = {isa = PBXBuildFile; fileRef = " << identifier << "; settings = {COMPILER_FLAGS = \"-fobjc-arc\"; }; };\n";
+    }
+
+    out << "\t};\n\trootObject = 000000000000000000000000;\n}\n";
+
+    std::string string = out.str();
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+/*
+ * Converts a property list to XML, to compare the XML parsers.
+ */
+static std::vector<uint8_t>
+ConvertToXML(std::vector<uint8_t> const &contents)
+{
+    auto result = plist::Format::Any::Deserialize(contents);
+    if (result.first == nullptr) {
+        return std::vector<uint8_t>();
+    }
+
+    auto serialized = plist::Format::XML::Serialize(result.first.get(), plist::Format::XML::Create(plist::Format::Encoding::UTF8));
+    if (serialized.first == nullptr) {
+        return std::vector<uint8_t>();
+    }
+
+    return *serialized.first;
+}
+
+/*
+ * Reads every token from an ASCII property list, without parsing it.
+ */
+static size_t
+Lex(std::vector<uint8_t> const &contents, bool vectorized)
+{
+    ASCIIPListLexer lexer;
+    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(contents.data()), contents.size(), kASCIIPListLexerStyleASCII);
+    ASCIIPListLexerSetVectorized(&lexer, vectorized);
+
+    size_t tokens = 0;
+    while (ASCIIPListLexerReadToken(&lexer) >= 0) {
+        tokens++;
+    }
+    return tokens;
+}
+
+/*
+ * Benchmark for parsing a large project file: with objects allocated from
+ * the heap or from an arena, converted to XML and read by the streaming
+ * parser or by libxml2, or only lexed, in blocks or a byte at a time. Run
+ * each mode in its own process to compare peak memory use.
+ *
+ * Usage: bench_plist [heap|arena|xml|libxml2|lex|lex-scalar] [files | path]
+ */
+int
+main(int argc, char **argv)
+{
+    std::string mode = (argc > 1 ? argv[1] : "heap");
+    bool arena = (mode == "arena");
+    bool xml = (mode == "xml" || mode == "libxml2");
+
+    std::vector<uint8_t> contents;
+    if (argc > 2 && strspn(argv[2], "0123456789") != strlen(argv[2])) {
+        DefaultFilesystem filesystem;
+        if (!filesystem.read(&contents, argv[2])) {
+            fprintf(stderr, "error: unable to read %s\n", argv[2]);
+            return 1;
+        }
+    } else {
+        contents = GenerateProject(argc > 2 ? std::strtoul(argv[2], NULL, 10) : 100000);
+    }
+
+    if (mode == "lex" || mode == "lex-scalar") {
+        auto start = std::chrono::steady_clock::now();
+        size_t tokens = Lex(contents, mode == "lex");
+        auto duration = std::chrono::steady_clock::now() - start;
+
+        printf("%s: %zu bytes, %zu tokens in %.3f ms\n",
+            mode.c_str(),
+            contents.size(),
+            tokens,
+            std::chrono::duration<double, std::milli>(duration).count());
+        return 0;
+    }
+
+    if (xml) {
+        contents = ConvertToXML(contents);
+        if (contents.empty()) {
+            fprintf(stderr, "error: unable to convert to XML\n");
+            return 1;
+        }
+    }
+
+    struct rusage before;
+    ::getrusage(RUSAGE_SELF, &before);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t objects = 0;
+    size_t allocated = 0;
+    {
+        std::unique_ptr<plist::Arena> objectArena = (arena ? std::unique_ptr<plist::Arena>(new plist::Arena()) : nullptr);
+
+        std::pair<std::unique_ptr<plist::Object>, std::string> result;
+        if (xml) {
+            plist::Format::XML::Parser parser = (mode == "xml" ? plist::Format::XML::Parser::Streaming : plist::Format::XML::Parser::LibXML2);
+            result = plist::Format::XML::Deserialize(contents, plist::Format::XML::Create(plist::Format::Encoding::UTF8, parser));
+        } else {
+            result = plist::Format::Any::Deserialize(contents, objectArena.get());
+        }
+        if (result.first == nullptr) {
+            fprintf(stderr, "error: %s\n", result.second.c_str());
+            return 1;
+        }
+
+        if (auto root = plist::CastTo<plist::Dictionary>(result.first.get())) {
+            if (auto dict = root->value<plist::Dictionary>("objects")) {
+                objects = dict->count();
+            }
+        }
+        if (objectArena != nullptr) {
+            allocated = objectArena->allocated();
+        }
+    }
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    struct rusage after;
+    ::getrusage(RUSAGE_SELF, &after);
+
+#if defined(__APPLE__)
+    long const maxrssUnit = 1024;
+#else
+    long const maxrssUnit = 1;
+#endif
+
+    printf("%s: %zu bytes, %zu objects in %.3f ms, peak RSS %ld KiB (+%ld KiB)",
+        mode.c_str(),
+        contents.size(),
+        objects,
+        std::chrono::duration<double, std::milli>(duration).count(),
+        after.ru_maxrss / maxrssUnit,
+        (after.ru_maxrss - before.ru_maxrss) / maxrssUnit);
+    if (arena) {
+        printf(", %zu KiB in arena", allocated / 1024);
+    }
+    printf("\n");
+
+    return 0;
+}
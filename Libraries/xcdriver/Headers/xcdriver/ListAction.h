@@ -23,7 +23,7 @@ private:
 
 public:
     static int
-    Run(libutil::Filesystem const *filesystem, Options const &options);
+    Run(libutil::Filesystem *filesystem, Options const &options);
 };
 
 }
@@ -45,6 +45,8 @@ private:
     std::string _formatter;
     std::string _executor;
     bool        _generate;
+    bool        _actionCache;
+    int         _actionCacheSize;
 
 private:
     bool        _parallelizeTargets;
@@ -142,6 +144,12 @@ public:
     /* Extension. */
     bool generate() const
     { return _generate; }
+    /* Extension. */
+    bool actionCache() const
+    { return _actionCache; }
+    /* Extension. */
+    int actionCacheSize() const
+    { return _actionCacheSize; }
 
 public:
     bool parallelizeTargets() const
@@ -10,7 +10,9 @@
 #include <xcdriver/BuildAction.h>
 #include <xcdriver/Action.h>
 #include <xcdriver/Options.h>
+#include <xcexecution/ActionCache.h>
 #include <xcexecution/NinjaExecutor.h>
+#include <xcexecution/ParallelExecutor.h>
 #include <xcexecution/SimpleExecutor.h>
 #include <xcformatter/DefaultFormatter.h>
 #include <builtin/Registry.h>
@@ -52,14 +54,20 @@ CreateExecutor(
     std::string const &executor,
     std::shared_ptr<xcformatter::Formatter> const &formatter,
     bool dryRun,
-    bool generate)
+    bool generate,
+    int jobs,
+    std::shared_ptr<xcexecution::ActionCache> const &actionCache)
 {
     if (executor == "simple" || executor.empty()) {
         auto registry = builtin::Registry::Default();
-        auto executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry);
+        auto executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry, actionCache, jobs > 0 ? jobs : 0);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
     } else if (executor == "ninja") {
-        auto executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate);
+        auto executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate, actionCache);
+        return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
+    } else if (executor == "parallel") {
+        auto registry = builtin::Registry::Default();
+        auto executor = xcexecution::ParallelExecutor::Create(formatter, dryRun, registry, jobs > 0 ? jobs : 0);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
     }
 
@@ -77,10 +85,15 @@ VerifySupportedOptions(Options const &options)
         fprintf(stderr, "warning: destination option not implemented\n");
     }
 
-    if (options.parallelizeTargets() || options.jobs() > 0) {
+    /* The simple executor uses the job count only for planning targets. */
+    if ((options.parallelizeTargets() && options.executor() != "parallel") || (options.jobs() > 0 && options.executor() == "ninja")) {
         fprintf(stderr, "warning: job control option not implemented\n");
     }
 
+    if ((options.actionCache() || options.actionCacheSize() != 0) && options.executor() == "parallel") {
+        fprintf(stderr, "warning: action cache option not implemented\n");
+    }
+
     if (options.hideShellScriptEnvironment()) {
         fprintf(stderr, "warning: output control option not implemented\n");
     }
@@ -122,10 +135,25 @@ Run(Filesystem *filesystem, Options const &options)
         return -1;
     }
 
+    /*
+     * Open the action cache, if requested.
+     */
+    std::shared_ptr<xcexecution::ActionCache> actionCache;
+    if (options.actionCache()) {
+        ext::optional<std::string> actionCachePath = xcexecution::ActionCache::DefaultPath();
+        uint64_t actionCacheSize = static_cast<uint64_t>(options.actionCacheSize() > 0 ? options.actionCacheSize() : 5120) * 1024 * 1024;
+        if (actionCachePath) {
+            actionCache = xcexecution::ActionCache::Open(*actionCachePath, actionCacheSize);
+        }
+        if (actionCache == nullptr) {
+            fprintf(stderr, "warning: unable to open action cache\n");
+        }
+    }
+
     /*
      * Create the executor used to perform the build.
      */
-    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate());
+    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate(), options.jobs(), actionCache);
     if (executor == nullptr) {
         fprintf(stderr, "error: unknown executor %s\n", options.executor().c_str());
         return -1;
@@ -150,9 +178,25 @@ Run(Filesystem *filesystem, Options const &options)
     xcexecution::Parameters parameters = Action::CreateParameters(options, overrideLevels);
 
     /*
-     * Perform the build!
+     * Perform the build! The cache is shared by every process using it, so
+     * compare its statistics before and after to report on this build.
      */
+    xcexecution::ActionCache::Statistics before = (actionCache != nullptr ? actionCache->statistics() : xcexecution::ActionCache::Statistics());
     bool success = executor->build(filesystem, *buildEnvironment, parameters);
+
+    if (actionCache != nullptr) {
+        xcexecution::ActionCache::Statistics after = actionCache->statistics();
+        uint64_t hits = after.hits - before.hits;
+        uint64_t misses = after.misses - before.misses;
+        if (hits + misses > 0) {
+            printf("Action cache: %llu hits, %llu misses (%.0f%% hit rate), %.1f MB cached\n",
+                static_cast<unsigned long long>(hits),
+                static_cast<unsigned long long>(misses),
+                100.0 * hits / (hits + misses),
+                after.size / (1024.0 * 1024.0));
+        }
+    }
+
     if (!success) {
         return 1;
     }
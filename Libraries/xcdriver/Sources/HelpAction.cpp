@@ -60,13 +60,22 @@ Run()
     fprintf(
         stdout,
         "    -executor NAME                              "
-        "use the execution engine NAME. currently 'ninja' and 'simple' are "
-        "supported\n");
+        "use the execution engine NAME. currently 'ninja', 'simple', and "
+        "'parallel' are supported\n");
     fprintf(
         stdout,
         "    -generate                                   "
         "specify that an execution engine based on generating another build "
         "language should regenerate\n");
+    fprintf(
+        stdout,
+        "    -actionCache                                "
+        "restore the outputs of tools run before with the same inputs from a "
+        "local cache. supported by the 'ninja' and 'simple' executors\n");
+    fprintf(
+        stdout,
+        "    -actionCacheSize MB                         "
+        "limit the local action cache to MB megabytes (default 5120)\n");
     fprintf(
         stdout,
         "    -project NAME                               "
@@ -120,11 +129,12 @@ Run()
     fprintf(
         stdout,
         "    -parallelizeTargets                         "
-        "not yet implemented\n");
+        "build independent targets in parallel. implied by the 'parallel' "
+        "executor\n");
     fprintf(
         stdout,
         "    -jobs NUMBER                                "
-        "not yet implemented\n");
+        "run up to NUMBER commands at once with the 'parallel' executor\n");
     fprintf(
         stdout,
         "    -dry-run                                    "
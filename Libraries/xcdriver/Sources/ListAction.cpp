@@ -31,7 +31,7 @@ ListAction::
 }
 
 int ListAction::
-Run(Filesystem const *filesystem, Options const &options)
+Run(Filesystem *filesystem, Options const &options)
 {
     ext::optional<pbxbuild::Build::Environment> buildEnvironment = pbxbuild::Build::Environment::Default(filesystem);
     if (!buildEnvironment) {
@@ -29,7 +29,7 @@ ShowBuildSettingsAction::
 }
 
 int ShowBuildSettingsAction::
-Run(Filesystem const *filesystem, Options const &options)
+Run(Filesystem *filesystem, Options const &options)
 {
     if (!Action::VerifyBuildActions(options.actions())) {
         return -1;
@@ -14,6 +14,7 @@
 #include <xcsdk/SDK/Manager.h>
 #include <xcsdk/SDK/Platform.h>
 #include <xcsdk/SDK/Target.h>
+#include <plist/Cache.h>
 #include <libutil/Filesystem.h>
 
 using xcdriver::ShowSDKsAction;
@@ -31,7 +32,7 @@ ShowSDKsAction::
 }
 
 int ShowSDKsAction::
-Run(Filesystem const *filesystem, Options const &options)
+Run(Filesystem *filesystem, Options const &options)
 {
     ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(filesystem);
     if (!developerRoot) {
@@ -39,13 +40,24 @@ Run(Filesystem const *filesystem, Options const &options)
         return 1;
     }
 
+    /*
+     * Use the parsed property lists from previous runs, if unchanged.
+     */
+    ext::optional<std::string> cachePath = plist::Cache::DefaultPath(*developerRoot);
+    std::unique_ptr<plist::Cache> cache = (cachePath ? plist::Cache::Open(filesystem, *cachePath) : nullptr);
+
     auto configuration = xcsdk::Configuration::Load(filesystem, xcsdk::Configuration::DefaultPaths());
-    auto manager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration);
+    auto manager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration, cache.get());
     if (manager == nullptr) {
         fprintf(stderr, "error: unable to open developer directory\n");
         return 1;
     }
 
+    if (cache != nullptr && cache->modified()) {
+        /* Not an error if the cache can't be written. */
+        cache->write(filesystem, *cachePath);
+    }
+
     for (auto const &platform : manager->platforms()) {
         printf("%s SDKs:\n", platform->description().c_str());
         for (auto const &target : platform->targets()) {
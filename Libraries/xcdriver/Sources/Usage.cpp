@@ -29,7 +29,7 @@ Text() {
         "[-sdk [<sdkname>|<sdkpath>]] "
         "[-showBuildSettings] [<buildsetting>=<value>]... "
         "[-formatter [default]] "
-        "[-executor [simple|ninja]] "
+        "[-executor [simple|ninja|parallel]] [-jobs <number>] "
         "[-generate] "
         "[<buildaction>]..." << std::endl;
 
@@ -42,7 +42,7 @@ Text() {
         "[-showBuildSettings] "
         "[<buildsetting>=<value>]... "
         "[-formatter [default]] "
-        "[-executor [simple|ninja]] "
+        "[-executor [simple|ninja|parallel]] [-jobs <number>] "
         "[-generate] "
         "[<buildaction>]..." << std::endl;
 
@@ -55,7 +55,7 @@ Text() {
         "[-showBuildSettings] "
         "[<buildsetting>=<value>]... "
         "[-formatter [default]] "
-        "[-executor [simple|ninja]] "
+        "[-executor [simple|ninja|parallel]] [-jobs <number>] "
         "[-generate] "
         "[<buildaction>]..." << std::endl;
 
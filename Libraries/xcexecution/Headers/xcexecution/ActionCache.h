@@ -0,0 +1,168 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_ActionCache_h
+#define __xcexecution_ActionCache_h
+
+#include <pbxbuild/Tool/Invocation.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Local cache of invocation outputs, shared between builds. An invocation
+ * is keyed by its executable, arguments, environment, and the contents of
+ * its declared inputs. Each key maps to the outputs of the runs recorded
+ * for it, along with the contents of the inputs each run discovered, such
+ * as included headers, and the error output of the run. When those inputs
+ * still match, the outputs are restored instead of running the invocation
+ * again, and the error output is returned so warnings are shown again.
+ *
+ * Outputs are stored once by the digest of their contents, and restored
+ * by cloning them where the filesystem supports it, or otherwise copying.
+ * Optionally, outputs are restored as hard links to the cached files; the
+ * cached files are read-only, so this is only safe when no tool modifies
+ * its outputs in place. When the cache grows past its maximum size, the
+ * least recently used entries are removed.
+ *
+ * Multiple processes can share a cache: files are written atomically, and
+ * the statistics are updated under a lock. A single instance must only be
+ * used from one thread, since it remembers the digests of files it reads.
+ *
+ * Inputs are read through the filesystem passed in. Outputs, however, are
+ * stored and restored directly on disk, since cloning, hard links, and
+ * permissions aren't part of the filesystem interface; so the cache only
+ * supports builds using the default filesystem.
+ */
+class ActionCache {
+public:
+    /*
+     * Counts of cache activity, since the statistics were last reset.
+     */
+    struct Statistics {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t stores;
+        uint64_t evictions;
+        uint64_t size;
+    };
+
+private:
+    struct Digest {
+        uint64_t    modified;
+        uint64_t    size;
+        std::string digest;
+    };
+
+private:
+    std::string                                     _path;
+    uint64_t                                        _maximumSize;
+    bool                                            _hardlink;
+    mutable std::unordered_map<std::string, Digest> _digests;
+
+public:
+    ActionCache(std::string const &path, uint64_t maximumSize, bool hardlink);
+
+public:
+    /*
+     * The directory containing the cache.
+     */
+    std::string const &path() const
+    { return _path; }
+
+    /*
+     * The size the cache is trimmed to stay within, in bytes.
+     */
+    uint64_t maximumSize() const
+    { return _maximumSize; }
+
+    /*
+     * If outputs are restored as hard links to the cached files.
+     */
+    bool hardlink() const
+    { return _hardlink; }
+
+public:
+    /*
+     * The key for an invocation, or nothing if it can't be cached. Only
+     * invocations whose outputs are all files can be cached; scripts and
+     * invocations with inputs that are directories or might not exist are
+     * always run.
+     */
+    ext::optional<std::string>
+    key(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation) const;
+
+    /*
+     * Restores the outputs of an invocation, if a run with the same key
+     * and the same discovered inputs was stored. Counts a hit or a miss.
+     * The outputs are written on disk, not through the filesystem. If set,
+     * `error` is set to the error output of the stored run.
+     */
+    bool
+    restore(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation, std::string const &key, std::string *error = nullptr) const;
+
+    /*
+     * Stores the outputs of an invocation that ran successfully, having
+     * started at the given time in nanoseconds since the epoch. Nothing is
+     * stored if an input was modified after that time. The outputs are
+     * read from disk, not through the filesystem. The error output of the
+     * run is stored with them.
+     */
+    bool
+    store(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation, std::string const &key, uint64_t started, std::string const &error = std::string()) const;
+
+public:
+    /*
+     * Removes the least recently used entries until the cache is within
+     * the given size, in bytes.
+     */
+    bool
+    evict(uint64_t size) const;
+
+    /*
+     * The statistics recorded in the cache, by every process using it.
+     */
+    Statistics
+    statistics() const;
+
+    /*
+     * Resets the hit, miss, store, and eviction counts.
+     */
+    bool
+    resetStatistics() const;
+
+private:
+    std::string
+    digest(libutil::Filesystem const *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * The default cache location, in the user's cache directory.
+     */
+    static ext::optional<std::string>
+    DefaultPath();
+
+    /*
+     * Opens the cache in a directory, creating it if needed.
+     */
+    static std::shared_ptr<ActionCache>
+    Open(std::string const &path, uint64_t maximumSize, bool hardlink = false);
+};
+
+}
+
+#endif // !__xcexecution_ActionCache_h
@@ -0,0 +1,101 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_BuildState_h
+#define __xcexecution_BuildState_h
+
+#include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/Tool/Invocation.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Persistent log of the invocations run for a target, used to skip the
+ * invocations that are already up to date. For each invocation that ran
+ * successfully, records a hash of its command, the modification times of
+ * its outputs, and the modification times of its inputs, including those
+ * discovered from its dependency info files after it ran.
+ *
+ * An invocation is up to date when its command, including the contents of
+ * its auxiliary files, is unchanged and none of those files have changed
+ * since. Invocations without outputs, scripts, and invocations with phony
+ * inputs always run. The log is stored in the temporary directory of each
+ * target.
+ */
+class BuildState {
+public:
+    /*
+     * A file and its modification time when the invocation was recorded.
+     */
+    typedef std::pair<std::string, uint64_t> File;
+
+    struct Record {
+        std::string       command;
+        std::vector<File> outputs;
+        std::vector<File> inputs;
+    };
+
+private:
+    std::string                             _path;
+    std::unordered_map<std::string, Record> _records;
+    bool                                    _modified;
+
+public:
+    explicit BuildState(std::string const &path);
+
+public:
+    /*
+     * If the invocation can be skipped: it ran before with the same
+     * command, and neither its inputs nor its outputs have changed.
+     */
+    bool upToDate(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation) const;
+
+    /*
+     * Records an invocation that ran successfully, having started at the
+     * given time in nanoseconds since the epoch. Files modified after that
+     * time are not trusted, so the invocation will run again.
+     */
+    void record(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation, uint64_t started);
+
+    /*
+     * Forgets an invocation, so it runs in the next build.
+     */
+    void remove(pbxbuild::Tool::Invocation const &invocation);
+
+public:
+    /*
+     * Writes the log, if any invocations were recorded or removed.
+     */
+    bool store(libutil::Filesystem *filesystem);
+
+public:
+    /*
+     * The current time, in nanoseconds since the epoch.
+     */
+    static uint64_t
+    Now();
+
+    /*
+     * Loads the log for a target, or starts an empty one.
+     */
+    static BuildState
+    Load(libutil::Filesystem const *filesystem, pbxbuild::Target::Environment const &targetEnvironment);
+};
+
+}
+
+#endif // !__xcexecution_BuildState_h
@@ -0,0 +1,45 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_DiscoveredInputs_h
+#define __xcexecution_DiscoveredInputs_h
+
+#include <pbxbuild/Tool/Invocation.h>
+
+#include <string>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Inputs of an invocation that are only known once it has run, read from
+ * the dependency info files it wrote.
+ */
+class DiscoveredInputs {
+private:
+    DiscoveredInputs();
+    ~DiscoveredInputs();
+
+public:
+    /*
+     * Reads the inputs from each of the invocation's dependency info files,
+     * as absolute paths. Files a tool looked for but did not find are
+     * included, since creating one would change the result. Fails if any
+     * dependency info file can't be read.
+     */
+    static ext::optional<std::vector<std::string>>
+    Load(libutil::Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation);
+};
+
+}
+
+#endif // !__xcexecution_DiscoveredInputs_h
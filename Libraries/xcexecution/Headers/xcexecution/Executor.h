@@ -12,8 +12,13 @@
 
 #include <xcformatter/Formatter.h>
 #include <pbxbuild/DirectedGraph.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/Tool/Invocation.h>
 
 #include <memory>
+#include <string>
+#include <vector>
+#include <ext/optional>
 
 namespace libutil { class Filesystem; }
 
@@ -26,6 +31,7 @@ namespace Target { class Environment; }
 namespace xcexecution {
 
 class Parameters;
+class PlanCache;
 
 /*
  * Abstract executor for builds. The executor is responsible for creating
@@ -52,6 +58,38 @@ public:
         libutil::Filesystem *filesystem,
         pbxbuild::Build::Environment const &buildEnvironment,
         Parameters const &buildParameters) = 0;
+
+protected:
+    /*
+     * The result of planning a single target. The target environment is
+     * missing if it could not be created for the target.
+     */
+    struct TargetPlan {
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment;
+        std::vector<pbxbuild::Tool::Invocation>      invocations;
+    };
+
+    /*
+     * Creates the environment and invocations for each target. Targets are
+     * planned independently on up to `jobs` threads, or one per processor if
+     * `jobs` is zero; the plans are returned in the order of `targets`. If a
+     * plan cache is provided, cached plans are used and new plans are stored.
+     */
+    std::vector<TargetPlan> planTargets(
+        libutil::Filesystem *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &targets,
+        PlanCache const *planCache,
+        size_t jobs) const;
+
+    /*
+     * The paths where running invocations can create directories, so the
+     * directory trees containing them can be walked again. An invocation
+     * declaring no outputs could create them anywhere.
+     */
+    static std::vector<std::string>
+    CreatedPaths(std::vector<pbxbuild::Tool::Invocation> const &invocations);
 };
 
 }
@@ -16,12 +16,19 @@ namespace ninja { class Writer; }
 
 namespace xcexecution {
 
+class ActionCache;
+
 /*
- * Concrete executor that generates Ninja files.
+ * Concrete executor that generates Ninja files. With an action cache, each
+ * invocation is run through `action-cache-tool`, which restores its outputs
+ * from the cache when possible.
  */
 class NinjaExecutor : public Executor {
+private:
+    std::shared_ptr<ActionCache> _actionCache;
+
 public:
-    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, std::shared_ptr<ActionCache> const &actionCache);
     ~NinjaExecutor();
 
 public:
@@ -58,7 +65,7 @@ private:
 
 public:
     static std::unique_ptr<NinjaExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, std::shared_ptr<ActionCache> const &actionCache = nullptr);
 };
 
 }
@@ -0,0 +1,95 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_ParallelExecutor_h
+#define __xcexecution_ParallelExecutor_h
+
+#include <xcexecution/Executor.h>
+#include <builtin/Registry.h>
+
+#include <functional>
+
+namespace xcexecution {
+
+/*
+ * In-process executor that runs invocations as soon as the invocations that
+ * produce their inputs have finished, keeping up to `jobs` invocations running
+ * at once. Independent targets are built at the same time, and each target is
+ * planned once the targets it depends on have finished. Unlike the simple
+ * executor, incremental builds are not supported.
+ */
+class ParallelExecutor : public Executor {
+private:
+    builtin::Registry _builtins;
+    size_t            _jobs;
+
+public:
+    ParallelExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs);
+    ~ParallelExecutor();
+
+public:
+    /*
+     * The maximum number of invocations running at once.
+     */
+    size_t jobs() const
+    { return _jobs; }
+
+public:
+    virtual bool build(
+        libutil::Filesystem *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        Parameters const &buildParameters);
+
+public:
+    /*
+     * Runs planned invocations, starting each target once the targets it
+     * depends on in the target graph have finished. Returns the invocations
+     * that failed, if any.
+     */
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> buildTargets(
+        libutil::Filesystem *filesystem,
+        pbxbuild::Build::Context const &buildContext,
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<std::pair<pbxproj::PBX::Target::shared_ptr, std::vector<pbxbuild::Tool::Invocation>>> const &targetInvocations);
+
+private:
+    class TargetBuild;
+    class InvocationJob;
+
+private:
+    bool writeAuxiliaryFiles(
+        libutil::Filesystem *filesystem,
+        pbxproj::PBX::Target::shared_ptr const &target,
+        std::vector<pbxbuild::Tool::Invocation> const &invocations);
+    bool performInvocation(
+        libutil::Filesystem *filesystem,
+        pbxbuild::Tool::Invocation const &invocation);
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> runTargetBuilds(
+        libutil::Filesystem *filesystem,
+        pbxbuild::Build::Context const &buildContext,
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<std::unique_ptr<TargetBuild>> const &targetBuilds,
+        std::function<bool(std::vector<TargetBuild *> const &)> const &plan);
+
+private:
+    static bool
+    CreateJobs(TargetBuild *targetBuild);
+
+public:
+    /*
+     * Creates a parallel executor. If `jobs` is zero, the number of jobs
+     * defaults to the number of processors available.
+     */
+    static std::unique_ptr<ParallelExecutor>
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs);
+};
+
+}
+
+#endif // !__xcexecution_ParallelExecutor_h
@@ -0,0 +1,113 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_PlanCache_h
+#define __xcexecution_PlanCache_h
+
+#include <xcexecution/Parameters.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Build/DirectoryTreeCache.h>
+#include <pbxbuild/Build/Environment.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/Tool/Invocation.h>
+
+#include <string>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Persistent cache of the invocations planned for each target. Planning a
+ * target is skipped when none of the inputs it was planned from have changed:
+ * the workspace, project, and scheme files, the specifications, the target's
+ * configuration files and SDK, and the build parameters and environment.
+ *
+ * Planning also depends on what is on disk. Each plan records the expanded
+ * search paths, the directories below every recursive (`**`) search path
+ * walked so far in the build, the file type of each input not produced by
+ * the plan, and the path found for each tool. A plan is only used if these
+ * are all still the same. Checking them needs the target's environment, so
+ * the environment is still created for every target.
+ *
+ * Plans are stored under the intermediates directory of each target.
+ */
+class PlanCache {
+public:
+    /*
+     * The parts of a target's environment that its plan depends on.
+     */
+    struct TargetInputs {
+        /* Where the plan for the target is stored. */
+        std::string              path;
+        /* Hash of the inputs shared by the target's plans, from its settings. */
+        std::string              key;
+        /* The directories to search for tools. */
+        std::vector<std::string> executablePaths;
+        /* The specification domains to resolve file types in. */
+        std::vector<std::string> specDomains;
+    };
+
+private:
+    std::string                         _key;
+    pbxspec::Manager::shared_ptr        _specManager;
+    pbxbuild::Build::DirectoryTreeCache *_directoryTreeCache;
+
+public:
+    PlanCache(std::string const &key, pbxspec::Manager::shared_ptr const &specManager, pbxbuild::Build::DirectoryTreeCache *directoryTreeCache);
+
+public:
+    /*
+     * The hash of all inputs shared by every target in the build.
+     */
+    std::string const &key() const
+    { return _key; }
+
+public:
+    /*
+     * The inputs for a target's plan. Expands the target's search paths.
+     */
+    TargetInputs
+    targetInputs(
+        libutil::Filesystem const *filesystem,
+        pbxproj::PBX::Target::shared_ptr const &target,
+        pbxbuild::Target::Environment const &targetEnvironment) const;
+
+    /*
+     * Loads the cached invocations for a target. Returns nothing if there
+     * is no cached plan or if any of its inputs have changed.
+     */
+    ext::optional<std::vector<pbxbuild::Tool::Invocation>>
+    load(libutil::Filesystem const *filesystem, TargetInputs const &targetInputs) const;
+
+    /*
+     * Stores the planned invocations for a target, along with what was on
+     * disk when they were planned.
+     */
+    bool
+    store(libutil::Filesystem *filesystem, TargetInputs const &targetInputs, std::vector<pbxbuild::Tool::Invocation> const &invocations) const;
+
+public:
+    /*
+     * Creates a plan cache for a build, hashing the inputs shared by every
+     * target in the build.
+     */
+    static PlanCache
+    Create(
+        libutil::Filesystem const *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        Parameters const &buildParameters);
+};
+
+}
+
+#endif // !__xcexecution_PlanCache_h
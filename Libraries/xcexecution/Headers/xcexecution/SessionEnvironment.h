@@ -0,0 +1,41 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_SessionEnvironment_h
+#define __xcexecution_SessionEnvironment_h
+
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace xcexecution {
+
+/*
+ * Environment variables that describe the shell session a build runs in,
+ * such as the terminal and the current directory, rather than the build.
+ * Caches leave them out of their keys, so the same build started from
+ * another shell still finds what it stored.
+ */
+class SessionEnvironment {
+private:
+    SessionEnvironment();
+    ~SessionEnvironment();
+
+public:
+    /*
+     * The variables of an environment that don't describe the session,
+     * sorted by name.
+     */
+    static std::map<std::string, std::string>
+    Remove(std::unordered_map<std::string, std::string> const &environment);
+};
+
+}
+
+#endif // !__xcexecution_SessionEnvironment_h
@@ -15,16 +15,23 @@
 
 namespace xcexecution {
 
+class ActionCache;
+class BuildState;
+
 /*
- * Simple executor that simply runs invocations in sequence. Advanced features
- * like incremental builds, dependency info, and such are not supported.
+ * Simple executor that simply runs invocations in sequence. Invocations that
+ * are up to date since the last build, according to the build state of each
+ * target, are skipped. With an action cache, invocations that ran before
+ * with the same inputs have their outputs restored from the cache instead.
  */
 class SimpleExecutor : public Executor {
 private:
-    builtin::Registry _builtins;
+    builtin::Registry            _builtins;
+    std::shared_ptr<ActionCache> _actionCache;
+    size_t                       _jobs;
 
 public:
-    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, std::shared_ptr<ActionCache> const &actionCache, size_t jobs);
     ~SimpleExecutor();
 
 public:
@@ -44,7 +51,8 @@ private:
         pbxproj::PBX::Target::shared_ptr const &target,
         pbxbuild::Target::Environment const &targetEnvironment,
         std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
-        bool createProductStructure);
+        bool createProductStructure,
+        BuildState *buildState);
     std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> buildTarget(
         libutil::Filesystem *filesystem,
         pbxproj::PBX::Target::shared_ptr const &target,
@@ -52,8 +60,13 @@ private:
         std::vector<pbxbuild::Tool::Invocation> const &invocations);
 
 public:
+    /*
+     * Creates a simple executor. Invocations always run one at a time, but
+     * targets are planned on up to `jobs` threads, or one per processor if
+     * `jobs` is zero.
+     */
     static std::unique_ptr<SimpleExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, std::shared_ptr<ActionCache> const &actionCache = nullptr, size_t jobs = 0);
 };
 
 }
@@ -0,0 +1,767 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/DiscoveredInputs.h>
+#include <xcexecution/SessionEnvironment.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/SysUtil.h>
+#include <libutil/md5.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <sys/clonefile.h>
+#elif defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+using xcexecution::ActionCache;
+using xcexecution::DiscoveredInputs;
+using xcexecution::SessionEnvironment;
+using pbxbuild::Tool::Invocation;
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::SysUtil;
+
+/*
+ * Bump when the format of the cache or the meaning of its keys changes.
+ */
+static char const ActionCacheVersion[] = "2";
+
+/*
+ * Runs recorded for each key, for example with different headers. The most
+ * recently stored are kept.
+ */
+static size_t const MaximumEntries = 8;
+
+/*
+ * Digest recorded for an input that did not exist.
+ */
+static char const MissingDigest[] = "-";
+
+/*
+ * The cache itself is always on disk, whatever filesystem the build uses.
+ */
+static DefaultFilesystem Storage;
+
+ActionCache::
+ActionCache(std::string const &path, uint64_t maximumSize, bool hardlink) :
+    _path       (path),
+    _maximumSize(maximumSize),
+    _hardlink   (hardlink)
+{
+}
+
+static std::string
+FinishDigest(md5_state_t *state)
+{
+    uint8_t digest[16];
+    md5_finish(state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+    return ss.str();
+}
+
+static void
+AppendHash(md5_state_t *state, std::string const &value)
+{
+    /* Include the trailing NUL terminator to separate values. */
+    md5_append(state, reinterpret_cast<const md5_byte_t *>(value.c_str()), value.size() + 1);
+}
+
+static void
+AppendHash(md5_state_t *state, std::vector<std::string> const &values)
+{
+    AppendHash(state, std::to_string(values.size()));
+    for (std::string const &value : values) {
+        AppendHash(state, value);
+    }
+}
+
+static std::string
+ContentsDigest(std::vector<uint8_t> const &contents)
+{
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(contents.data()), contents.size());
+    return FinishDigest(&state);
+}
+
+static std::string
+ObjectPath(std::string const &cache, std::string const &name)
+{
+    return cache + "/objects/" + name.substr(0, 2) + "/" + name;
+}
+
+static std::string
+ActionPath(std::string const &cache, std::string const &key)
+{
+    return cache + "/actions/" + key.substr(0, 2) + "/" + key;
+}
+
+static std::string
+TemporaryPath(std::string const &path)
+{
+    static std::atomic<unsigned long> counter(0);
+    return path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+}
+
+/*
+ * Marks a cache entry as just used, for eviction.
+ */
+static void
+Touch(std::string const &path)
+{
+    ::utimes(path.c_str(), nullptr);
+}
+
+/*
+ * Creates a copy of a file that shares its storage, if the filesystem
+ * supports that. The new file must not exist.
+ */
+static bool
+CloneFile(std::string const &from, std::string const &to)
+{
+#if defined(__APPLE__)
+    return (::clonefile(from.c_str(), to.c_str(), 0) == 0);
+#elif defined(__linux__) && defined(FICLONE)
+    int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+
+    int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    bool result = (::ioctl(out, FICLONE, in) == 0);
+    ::close(out);
+    ::close(in);
+
+    if (!result) {
+        ::unlink(to.c_str());
+    }
+    return result;
+#else
+    return false;
+#endif
+}
+
+/*
+ * Creates a new file with the same contents as another, sharing storage
+ * where possible. The new file must not exist.
+ */
+static bool
+CopyFile(std::string const &from, std::string const &to)
+{
+    if (CloneFile(from, to)) {
+        return true;
+    }
+
+    std::vector<uint8_t> contents;
+    return (Storage.read(&contents, from) && Storage.write(contents, to));
+}
+
+/*
+ * Reads a list of alternating strings from a property list array.
+ */
+static bool
+DeserializePairs(plist::Array const *array, std::vector<std::pair<std::string, std::string>> *pairs)
+{
+    if (array == nullptr || array->count() % 2 != 0) {
+        return false;
+    }
+
+    for (size_t n = 0; n < array->count(); n += 2) {
+        auto first = array->value<plist::String>(n);
+        auto second = array->value<plist::String>(n + 1);
+        if (first == nullptr || second == nullptr) {
+            return false;
+        }
+
+        pairs->push_back({ first->value(), second->value() });
+    }
+
+    return true;
+}
+
+static std::unique_ptr<plist::Array>
+SerializePairs(std::vector<std::pair<std::string, std::string>> const &pairs)
+{
+    auto array = plist::Array::New();
+    for (auto const &pair : pairs) {
+        array->append(plist::String::New(pair.first));
+        array->append(plist::String::New(pair.second));
+    }
+    return array;
+}
+
+namespace {
+
+/*
+ * A stored run of an invocation: the discovered inputs and their digests,
+ * the outputs and the objects holding their contents, and what the run
+ * wrote to standard error.
+ */
+struct Entry {
+    std::vector<std::pair<std::string, std::string>> inputs;
+    std::vector<std::pair<std::string, std::string>> outputs;
+    std::string                                      error;
+};
+
+}
+
+static std::vector<Entry>
+LoadEntries(std::string const &path)
+{
+    std::vector<Entry> entries;
+
+    std::vector<uint8_t> contents;
+    if (!Storage.read(&contents, path)) {
+        return entries;
+    }
+
+    std::unique_ptr<plist::Object> object = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create()).first;
+    auto array = plist::CastTo<plist::Array>(object.get());
+    if (array == nullptr) {
+        return entries;
+    }
+
+    for (size_t n = 0; n < array->count(); n++) {
+        auto dict = array->value<plist::Dictionary>(n);
+        if (dict == nullptr) {
+            continue;
+        }
+
+        auto error = dict->value<plist::String>("Error");
+        if (error == nullptr) {
+            continue;
+        }
+
+        Entry entry;
+        entry.error = error->value();
+        if (DeserializePairs(dict->value<plist::Array>("Inputs"), &entry.inputs) &&
+            DeserializePairs(dict->value<plist::Array>("Outputs"), &entry.outputs)) {
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    return entries;
+}
+
+static ext::optional<uint64_t>
+StoreEntries(std::string const &path, std::vector<Entry> const &entries)
+{
+    auto array = plist::Array::New();
+    for (Entry const &entry : entries) {
+        auto dict = plist::Dictionary::New();
+        dict->set("Inputs", SerializePairs(entry.inputs));
+        dict->set("Outputs", SerializePairs(entry.outputs));
+        dict->set("Error", plist::String::New(entry.error));
+        array->append(std::move(dict));
+    }
+
+    auto serialized = plist::Format::Binary::Serialize(array.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        return ext::nullopt;
+    }
+
+    std::string directory = FSUtil::GetDirectoryName(path);
+    if (!Storage.isDirectory(directory) && !Storage.createDirectory(directory)) {
+        return ext::nullopt;
+    }
+
+    if (!Storage.write(*serialized.first, path)) {
+        return ext::nullopt;
+    }
+
+    return static_cast<uint64_t>(serialized.first->size());
+}
+
+/*
+ * Reads and optionally updates the statistics file, holding a lock on it.
+ */
+static bool
+AccessStatistics(std::string const &cache, bool update, std::function<void(ActionCache::Statistics *)> const &access)
+{
+    std::string path = cache + "/statistics";
+
+    int fd = ::open(path.c_str(), (update ? O_RDWR | O_CREAT : O_RDONLY) | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (::flock(fd, update ? LOCK_EX : LOCK_SH) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    ActionCache::Statistics statistics = { 0, 0, 0, 0, 0 };
+
+    std::vector<uint8_t> contents;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        contents.resize(static_cast<size_t>(st.st_size));
+        if (::pread(fd, contents.data(), contents.size(), 0) != static_cast<ssize_t>(contents.size())) {
+            contents.clear();
+        }
+    }
+
+    std::unique_ptr<plist::Object> object = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create()).first;
+    if (auto dict = plist::CastTo<plist::Dictionary>(object.get())) {
+        for (auto const &field : std::vector<std::pair<char const *, uint64_t *>>({
+            { "Hits", &statistics.hits },
+            { "Misses", &statistics.misses },
+            { "Stores", &statistics.stores },
+            { "Evictions", &statistics.evictions },
+            { "Size", &statistics.size },
+        })) {
+            if (auto value = dict->value<plist::Integer>(field.first)) {
+                *field.second = static_cast<uint64_t>(value->value());
+            }
+        }
+    }
+
+    access(&statistics);
+
+    bool result = true;
+    if (update) {
+        auto dict = plist::Dictionary::New();
+        dict->set("Hits", plist::Integer::New(static_cast<int64_t>(statistics.hits)));
+        dict->set("Misses", plist::Integer::New(static_cast<int64_t>(statistics.misses)));
+        dict->set("Stores", plist::Integer::New(static_cast<int64_t>(statistics.stores)));
+        dict->set("Evictions", plist::Integer::New(static_cast<int64_t>(statistics.evictions)));
+        dict->set("Size", plist::Integer::New(static_cast<int64_t>(statistics.size)));
+
+        auto serialized = plist::Format::Binary::Serialize(dict.get(), plist::Format::Binary::Create());
+        result = (serialized.first != nullptr &&
+            ::pwrite(fd, serialized.first->data(), serialized.first->size(), 0) == static_cast<ssize_t>(serialized.first->size()) &&
+            ::ftruncate(fd, static_cast<off_t>(serialized.first->size())) == 0);
+    }
+
+    ::close(fd);
+    return result;
+}
+
+/*
+ * The files an invocation produces: its outputs, and the dependency info
+ * files read after it runs.
+ */
+static std::vector<std::string>
+InvocationOutputs(Invocation const &invocation)
+{
+    std::vector<std::string> outputs;
+    std::unordered_set<std::string> seen;
+
+    for (std::string const &output : invocation.outputs()) {
+        std::string path = FSUtil::ResolveRelativePath(output, invocation.workingDirectory());
+        if (seen.insert(path).second) {
+            outputs.push_back(path);
+        }
+    }
+
+    for (Invocation::DependencyInfo const &info : invocation.dependencyInfo()) {
+        /* Directory dependency info is an input, not a file the tool writes. */
+        if (info.format() == dependency::DependencyInfoFormat::Directory) {
+            continue;
+        }
+
+        std::string path = FSUtil::ResolveRelativePath(info.path(), invocation.workingDirectory());
+        if (seen.insert(path).second) {
+            outputs.push_back(path);
+        }
+    }
+
+    return outputs;
+}
+
+std::string ActionCache::
+digest(Filesystem const *filesystem, std::string const &path) const
+{
+    /* The same headers are inputs to many invocations. */
+    uint64_t modified;
+    uint64_t size;
+    bool status = filesystem->fileStatus(path, &modified, &size);
+    if (status) {
+        auto it = _digests.find(path);
+        if (it != _digests.end() && it->second.modified == modified && it->second.size == size) {
+            return it->second.digest;
+        }
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return MissingDigest;
+    }
+
+    std::string result = ContentsDigest(contents);
+    if (status) {
+        _digests[path] = { modified, size, result };
+    }
+    return result;
+}
+
+ext::optional<std::string> ActionCache::
+key(Filesystem const *filesystem, Invocation const &invocation) const
+{
+    /* Scripts can read files they don't declare; script phases' inputs might not exist. */
+    if (invocation.outputs().empty() || !invocation.phonyInputs().empty() || invocation.executable().path() == "/bin/sh") {
+        return ext::nullopt;
+    }
+
+    md5_state_t state;
+    md5_init(&state);
+
+    AppendHash(&state, std::string(ActionCacheVersion));
+    AppendHash(&state, invocation.executable().path());
+    AppendHash(&state, invocation.executable().builtin());
+    AppendHash(&state, invocation.arguments());
+    AppendHash(&state, invocation.workingDirectory());
+
+    /*
+     * Hashing the tool itself would be too slow; a new version of it will
+     * have a different size or modification time.
+     */
+    uint64_t executableModified = 0;
+    uint64_t executableSize = 0;
+    filesystem->fileStatus(invocation.executable().path(), &executableModified, &executableSize);
+    AppendHash(&state, std::to_string(executableModified));
+    AppendHash(&state, std::to_string(executableSize));
+
+    std::map<std::string, std::string> environment = SessionEnvironment::Remove(invocation.environment());
+    AppendHash(&state, std::to_string(environment.size()));
+    for (auto const &entry : environment) {
+        AppendHash(&state, entry.first);
+        AppendHash(&state, entry.second);
+    }
+
+    AppendHash(&state, InvocationOutputs(invocation));
+
+    for (Invocation::DependencyInfo const &info : invocation.dependencyInfo()) {
+        std::string format;
+        dependency::DependencyInfoFormats::Name(info.format(), &format);
+        AppendHash(&state, format);
+        AppendHash(&state, info.path());
+    }
+
+    /* Auxiliary files may be used without being declared as inputs. */
+    for (Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+        AppendHash(&state, auxiliaryFile.path());
+        AppendHash(&state, ContentsDigest(auxiliaryFile.contents()));
+    }
+
+    for (std::vector<std::string> const *inputs : { &invocation.inputs(), &invocation.inputDependencies() }) {
+        AppendHash(&state, std::to_string(inputs->size()));
+        for (std::string const &input : *inputs) {
+            std::string path = FSUtil::ResolveRelativePath(input, invocation.workingDirectory());
+            if (filesystem->isDirectory(path)) {
+                return ext::nullopt;
+            }
+
+            AppendHash(&state, path);
+            AppendHash(&state, digest(filesystem, path));
+        }
+    }
+
+    return FinishDigest(&state);
+}
+
+bool ActionCache::
+restore(Filesystem const *filesystem, Invocation const &invocation, std::string const &key, std::string *error) const
+{
+    std::string actionPath = ActionPath(_path, key);
+
+    for (Entry const &entry : LoadEntries(actionPath)) {
+        bool match = true;
+        for (auto const &input : entry.inputs) {
+            if (digest(filesystem, input.first) != input.second) {
+                match = false;
+                break;
+            }
+        }
+        for (auto const &output : entry.outputs) {
+            if (!match || !Storage.exists(ObjectPath(_path, output.second))) {
+                match = false;
+                break;
+            }
+        }
+        if (!match) {
+            continue;
+        }
+
+        for (auto const &output : entry.outputs) {
+            std::string objectPath = ObjectPath(_path, output.second);
+            bool executable = (output.second.back() == 'x');
+
+            /* Replace, rather than write through, any existing output. */
+            if (::unlink(output.first.c_str()) != 0 && errno != ENOENT) {
+                return false;
+            }
+
+            /* A hard link shares the read-only object, and its permissions. */
+            bool linked = (_hardlink && ::link(objectPath.c_str(), output.first.c_str()) == 0);
+            if (!linked && (!CopyFile(objectPath, output.first) || ::chmod(output.first.c_str(), executable ? 0755 : 0644) != 0)) {
+                return false;
+            }
+
+            Touch(objectPath);
+        }
+
+        if (error != nullptr) {
+            *error = entry.error;
+        }
+
+        Touch(actionPath);
+        AccessStatistics(_path, true, [](Statistics *statistics) {
+            statistics->hits++;
+        });
+        return true;
+    }
+
+    AccessStatistics(_path, true, [](Statistics *statistics) {
+        statistics->misses++;
+    });
+    return false;
+}
+
+bool ActionCache::
+store(Filesystem const *filesystem, Invocation const &invocation, std::string const &key, uint64_t started, std::string const &error) const
+{
+    ext::optional<std::vector<std::string>> discoveredInputs = DiscoveredInputs::Load(filesystem, invocation);
+    if (!discoveredInputs) {
+        return false;
+    }
+
+    /*
+     * An input that changed while the invocation ran might not match what
+     * it produced, so don't store it under either version.
+     */
+    std::vector<std::string> const &discovered = *discoveredInputs;
+    std::vector<std::string> inputs;
+    for (std::vector<std::string> const *list : { &invocation.inputs(), &invocation.inputDependencies(), &discovered }) {
+        for (std::string const &input : *list) {
+            inputs.push_back(FSUtil::ResolveRelativePath(input, invocation.workingDirectory()));
+        }
+    }
+    for (std::string const &input : inputs) {
+        uint64_t modified;
+        uint64_t size;
+        if (filesystem->fileStatus(input, &modified, &size) && modified >= started) {
+            return false;
+        }
+    }
+
+    Entry entry;
+    entry.error = error;
+
+    /* Declared inputs are part of the key already. */
+    std::unordered_set<std::string> seen = std::unordered_set<std::string>(inputs.begin(), inputs.begin() + (inputs.size() - discoveredInputs->size()));
+    for (std::string const &input : *discoveredInputs) {
+        std::string path = FSUtil::ResolveRelativePath(input, invocation.workingDirectory());
+        if (seen.insert(path).second) {
+            entry.inputs.push_back({ path, digest(filesystem, path) });
+        }
+    }
+
+    uint64_t added = 0;
+    for (std::string const &output : InvocationOutputs(invocation)) {
+        struct stat st;
+        if (::stat(output.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            return false;
+        }
+
+        std::vector<uint8_t> contents;
+        if (!Storage.read(&contents, output)) {
+            return false;
+        }
+
+        bool executable = ((st.st_mode & S_IXUSR) != 0);
+        std::string name = ContentsDigest(contents) + (executable ? "x" : "");
+        std::string objectPath = ObjectPath(_path, name);
+
+        if (Storage.exists(objectPath)) {
+            Touch(objectPath);
+        } else {
+            std::string directory = FSUtil::GetDirectoryName(objectPath);
+            if (!Storage.isDirectory(directory) && !Storage.createDirectory(directory)) {
+                return false;
+            }
+
+            /* Never link: the output could later be modified in place. */
+            std::string temporaryPath = TemporaryPath(objectPath);
+            if (!CopyFile(output, temporaryPath) ||
+                ::chmod(temporaryPath.c_str(), executable ? 0555 : 0444) != 0 ||
+                ::rename(temporaryPath.c_str(), objectPath.c_str()) != 0) {
+                ::unlink(temporaryPath.c_str());
+                return false;
+            }
+
+            added += contents.size();
+        }
+
+        entry.outputs.push_back({ output, name });
+    }
+
+    /*
+     * Keep the other recent runs, most recent first.
+     */
+    std::string actionPath = ActionPath(_path, key);
+    std::vector<Entry> entries = LoadEntries(actionPath);
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](Entry const &existing) {
+        return existing.inputs == entry.inputs;
+    }), entries.end());
+    entries.insert(entries.begin(), std::move(entry));
+    if (entries.size() > MaximumEntries) {
+        entries.resize(MaximumEntries);
+    }
+
+    ext::optional<uint64_t> actionSize = StoreEntries(actionPath, entries);
+    if (!actionSize) {
+        return false;
+    }
+    added += *actionSize;
+
+    uint64_t size = 0;
+    AccessStatistics(_path, true, [&](Statistics *statistics) {
+        statistics->stores++;
+        statistics->size += added;
+        size = statistics->size;
+    });
+
+    /* Trim well below the limit, so eviction doesn't run on every store. */
+    if (size > _maximumSize) {
+        evict(_maximumSize / 4 * 3);
+    }
+
+    return true;
+}
+
+bool ActionCache::
+evict(uint64_t size) const
+{
+    struct File {
+        std::string path;
+        time_t      used;
+        uint64_t    size;
+    };
+
+    std::vector<File> files;
+    uint64_t total = 0;
+
+    for (char const *kind : { "objects", "actions" }) {
+        std::string root = _path + "/" + kind;
+        Storage.enumerateDirectory(root, [&](std::string const &prefix) {
+            std::string directory = root + "/" + prefix;
+            Storage.enumerateDirectory(directory, [&](std::string const &name) {
+                std::string path = directory + "/" + name;
+
+                struct stat st;
+                if (::lstat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+                    files.push_back({ path, st.st_mtime, static_cast<uint64_t>(st.st_size) });
+                    total += static_cast<uint64_t>(st.st_size);
+                }
+            });
+        });
+    }
+
+    std::sort(files.begin(), files.end(), [](File const &a, File const &b) {
+        return a.used < b.used;
+    });
+
+    /* Entries whose objects were removed are misses, and are dropped later. */
+    uint64_t evictions = 0;
+    for (File const &file : files) {
+        if (total <= size) {
+            break;
+        }
+
+        if (::unlink(file.path.c_str()) == 0) {
+            total -= file.size;
+            evictions++;
+        }
+    }
+
+    return AccessStatistics(_path, true, [&](Statistics *statistics) {
+        statistics->evictions += evictions;
+        statistics->size = total;
+    });
+}
+
+ActionCache::Statistics ActionCache::
+statistics() const
+{
+    Statistics result = { 0, 0, 0, 0, 0 };
+    AccessStatistics(_path, false, [&](Statistics *statistics) {
+        result = *statistics;
+    });
+    return result;
+}
+
+bool ActionCache::
+resetStatistics() const
+{
+    return AccessStatistics(_path, true, [](Statistics *statistics) {
+        statistics->hits = 0;
+        statistics->misses = 0;
+        statistics->stores = 0;
+        statistics->evictions = 0;
+    });
+}
+
+ext::optional<std::string> ActionCache::
+DefaultPath()
+{
+    ext::optional<std::string> directory = SysUtil::GetCacheDirectory();
+    if (!directory) {
+        return ext::nullopt;
+    }
+
+    return *directory + "/ActionCache";
+}
+
+std::shared_ptr<ActionCache> ActionCache::
+Open(std::string const &path, uint64_t maximumSize, bool hardlink)
+{
+    for (std::string const &directory : { path + "/objects", path + "/actions" }) {
+        if (!Storage.isDirectory(directory) && !Storage.createDirectory(directory)) {
+            return nullptr;
+        }
+    }
+
+    return std::make_shared<ActionCache>(path, maximumSize, hardlink);
+}
@@ -0,0 +1,354 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/BuildState.h>
+#include <xcexecution/DiscoveredInputs.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/md5.h>
+
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+
+using xcexecution::BuildState;
+using xcexecution::DiscoveredInputs;
+using pbxbuild::Tool::Invocation;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+/*
+ * Bump when the format of the log or the meaning of its records changes.
+ */
+static char const BuildStateVersion[] = "2";
+
+/*
+ * Modification time recorded for a file that did not exist.
+ */
+static uint64_t const MissingModified = 0;
+
+/*
+ * Modification time recorded for a file that changed while the invocation
+ * was running. Never matches, so the invocation runs again.
+ */
+static uint64_t const StaleModified = UINT64_MAX;
+
+BuildState::
+BuildState(std::string const &path) :
+    _path    (path),
+    _modified(false)
+{
+}
+
+static uint64_t
+Modified(Filesystem const *filesystem, std::string const &path)
+{
+    uint64_t modified;
+    uint64_t size;
+    if (!filesystem->fileStatus(path, &modified, &size)) {
+        return MissingModified;
+    }
+
+    return modified;
+}
+
+static void
+AppendHash(md5_state_t *state, std::string const &value)
+{
+    /* Include the trailing NUL terminator to separate values. */
+    md5_append(state, reinterpret_cast<const md5_byte_t *>(value.c_str()), value.size() + 1);
+}
+
+static void
+AppendHash(md5_state_t *state, std::vector<std::string> const &values)
+{
+    AppendHash(state, std::to_string(values.size()));
+    for (std::string const &value : values) {
+        AppendHash(state, value);
+    }
+}
+
+/*
+ * Hashes everything about an invocation that affects what it produces,
+ * other than the contents of its inputs.
+ */
+static std::string
+CommandHash(Invocation const &invocation)
+{
+    md5_state_t state;
+    md5_init(&state);
+
+    AppendHash(&state, std::string(BuildStateVersion));
+    AppendHash(&state, invocation.executable().path());
+    AppendHash(&state, invocation.executable().builtin());
+    AppendHash(&state, invocation.arguments());
+    AppendHash(&state, invocation.workingDirectory());
+
+    std::map<std::string, std::string> environment = std::map<std::string, std::string>(invocation.environment().begin(), invocation.environment().end());
+    AppendHash(&state, std::to_string(environment.size()));
+    for (auto const &entry : environment) {
+        AppendHash(&state, entry.first);
+        AppendHash(&state, entry.second);
+    }
+
+    AppendHash(&state, invocation.inputs());
+    AppendHash(&state, invocation.outputs());
+    AppendHash(&state, invocation.inputDependencies());
+
+    /* Auxiliary files are written before each build, so their times change. */
+    AppendHash(&state, std::to_string(invocation.auxiliaryFiles().size()));
+    for (Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+        AppendHash(&state, auxiliaryFile.path());
+        AppendHash(&state, std::to_string(auxiliaryFile.contents().size()));
+        md5_append(&state, reinterpret_cast<const md5_byte_t *>(auxiliaryFile.contents().data()), auxiliaryFile.contents().size());
+        AppendHash(&state, auxiliaryFile.executable() ? "YES" : "NO");
+    }
+
+    for (Invocation::DependencyInfo const &info : invocation.dependencyInfo()) {
+        std::string format;
+        dependency::DependencyInfoFormats::Name(info.format(), &format);
+        AppendHash(&state, format);
+        AppendHash(&state, info.path());
+    }
+
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+    return ss.str();
+}
+
+/*
+ * If the files an invocation uses are all known, so its record can be
+ * trusted. Scripts can read files they don't declare, and the inputs of
+ * script phases might not exist, so those invocations always run.
+ */
+static bool
+Trackable(Invocation const &invocation)
+{
+    return !invocation.outputs().empty() && invocation.phonyInputs().empty() && invocation.executable().path() != "/bin/sh";
+}
+
+bool BuildState::
+upToDate(Filesystem const *filesystem, Invocation const &invocation) const
+{
+    if (!Trackable(invocation)) {
+        return false;
+    }
+
+    auto it = _records.find(invocation.outputs().front());
+    if (it == _records.end()) {
+        return false;
+    }
+
+    Record const &record = it->second;
+    if (record.command != CommandHash(invocation)) {
+        return false;
+    }
+
+    for (File const &output : record.outputs) {
+        if (output.second == MissingModified || output.second == StaleModified || Modified(filesystem, output.first) != output.second) {
+            return false;
+        }
+    }
+
+    for (File const &input : record.inputs) {
+        if (input.second == StaleModified || Modified(filesystem, input.first) != input.second) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BuildState::
+record(Filesystem const *filesystem, Invocation const &invocation, uint64_t started)
+{
+    if (!Trackable(invocation)) {
+        remove(invocation);
+        return;
+    }
+
+    ext::optional<std::vector<std::string>> discoveredInputs = DiscoveredInputs::Load(filesystem, invocation);
+    if (!discoveredInputs) {
+        /* Without the full set of inputs, the invocation can't be skipped. */
+        remove(invocation);
+        return;
+    }
+
+    std::vector<std::string> inputs;
+    inputs.insert(inputs.end(), invocation.inputs().begin(), invocation.inputs().end());
+    inputs.insert(inputs.end(), invocation.inputDependencies().begin(), invocation.inputDependencies().end());
+    inputs.insert(inputs.end(), discoveredInputs->begin(), discoveredInputs->end());
+
+    Record record;
+    record.command = CommandHash(invocation);
+
+    for (std::string const &output : invocation.outputs()) {
+        record.outputs.push_back({ output, Modified(filesystem, output) });
+    }
+
+    std::unordered_set<std::string> seen;
+    for (std::string const &input : inputs) {
+        std::string path = FSUtil::ResolveRelativePath(input, invocation.workingDirectory());
+        if (!seen.insert(path).second) {
+            continue;
+        }
+
+        uint64_t modified = Modified(filesystem, path);
+        if (modified != MissingModified && modified >= started) {
+            modified = StaleModified;
+        }
+        record.inputs.push_back({ path, modified });
+    }
+
+    _records[invocation.outputs().front()] = std::move(record);
+    _modified = true;
+}
+
+void BuildState::
+remove(Invocation const &invocation)
+{
+    if (!invocation.outputs().empty() && _records.erase(invocation.outputs().front()) > 0) {
+        _modified = true;
+    }
+}
+
+static std::unique_ptr<plist::Array>
+SerializeFiles(std::vector<BuildState::File> const &files)
+{
+    auto array = plist::Array::New();
+    for (BuildState::File const &file : files) {
+        array->append(plist::String::New(file.first));
+        array->append(plist::Integer::New(static_cast<int64_t>(file.second)));
+    }
+    return array;
+}
+
+static bool
+DeserializeFiles(plist::Array const *array, std::vector<BuildState::File> *files)
+{
+    if (array == nullptr || array->count() % 2 != 0) {
+        return false;
+    }
+
+    files->reserve(array->count() / 2);
+    for (size_t n = 0; n < array->count(); n += 2) {
+        auto path = array->value<plist::String>(n);
+        auto modified = array->value<plist::Integer>(n + 1);
+        if (path == nullptr || modified == nullptr) {
+            return false;
+        }
+
+        files->push_back({ path->value(), static_cast<uint64_t>(modified->value()) });
+    }
+
+    return true;
+}
+
+bool BuildState::
+store(Filesystem *filesystem)
+{
+    if (!_modified) {
+        return true;
+    }
+
+    auto records = plist::Dictionary::New();
+    for (auto const &entry : _records) {
+        auto dict = plist::Dictionary::New();
+        dict->set("Command", plist::String::New(entry.second.command));
+        dict->set("Outputs", SerializeFiles(entry.second.outputs));
+        dict->set("Inputs", SerializeFiles(entry.second.inputs));
+        records->set(entry.first, std::move(dict));
+    }
+
+    auto state = plist::Dictionary::New();
+    state->set("Version", plist::String::New(BuildStateVersion));
+    state->set("Records", std::move(records));
+
+    auto serialized = plist::Format::Binary::Serialize(state.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        return false;
+    }
+
+    std::string directory = FSUtil::GetDirectoryName(_path);
+    if (!filesystem->isDirectory(directory) && !filesystem->createDirectory(directory)) {
+        return false;
+    }
+
+    if (!filesystem->write(*serialized.first, _path)) {
+        return false;
+    }
+
+    _modified = false;
+    return true;
+}
+
+uint64_t BuildState::
+Now()
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+BuildState BuildState::
+Load(Filesystem const *filesystem, pbxbuild::Target::Environment const &targetEnvironment)
+{
+    std::string temporaryDirectory = targetEnvironment.environment().resolve("TARGET_TEMP_DIR");
+    BuildState buildState = BuildState(temporaryDirectory + "/BuildState.plist");
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->exists(buildState._path) || !filesystem->read(&contents, buildState._path)) {
+        return buildState;
+    }
+
+    std::unique_ptr<plist::Object> object = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create()).first;
+    auto state = plist::CastTo<plist::Dictionary>(object.get());
+    if (state == nullptr) {
+        return buildState;
+    }
+
+    /* Records from another version are dropped, not misread. */
+    auto version = state->value<plist::String>("Version");
+    auto records = state->value<plist::Dictionary>("Records");
+    if (version == nullptr || version->value() != BuildStateVersion || records == nullptr) {
+        return buildState;
+    }
+
+    for (size_t n = 0; n < records->count(); n++) {
+        auto dict = records->value<plist::Dictionary>(n);
+        if (dict == nullptr) {
+            continue;
+        }
+
+        auto command = dict->value<plist::String>("Command");
+        Record record;
+        if (command == nullptr ||
+            !DeserializeFiles(dict->value<plist::Array>("Outputs"), &record.outputs) ||
+            !DeserializeFiles(dict->value<plist::Array>("Inputs"), &record.inputs)) {
+            continue;
+        }
+
+        record.command = command->value();
+        buildState._records.insert({ records->key(n), std::move(record) });
+    }
+
+    return buildState;
+}
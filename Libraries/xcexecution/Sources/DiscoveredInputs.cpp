@@ -0,0 +1,90 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/DiscoveredInputs.h>
+#include <dependency/BinaryDependencyInfo.h>
+#include <dependency/DirectoryDependencyInfo.h>
+#include <dependency/MakefileDependencyInfo.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+using xcexecution::DiscoveredInputs;
+using pbxbuild::Tool::Invocation;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+static bool
+LoadDependencyInfo(Filesystem const *filesystem, Invocation::DependencyInfo const &info, std::string const &path, std::vector<std::string> *inputs)
+{
+    std::vector<dependency::DependencyInfo> dependencyInfo;
+    switch (info.format()) {
+        case dependency::DependencyInfoFormat::Binary: {
+            std::vector<uint8_t> contents;
+            if (!filesystem->read(&contents, path)) {
+                return false;
+            }
+
+            auto binaryInfo = dependency::BinaryDependencyInfo::Deserialize(contents);
+            if (!binaryInfo) {
+                return false;
+            }
+
+            dependencyInfo.push_back(binaryInfo->dependencyInfo());
+            inputs->insert(inputs->end(), binaryInfo->missing().begin(), binaryInfo->missing().end());
+            break;
+        }
+        case dependency::DependencyInfoFormat::Directory: {
+            auto directoryInfo = dependency::DirectoryDependencyInfo::Deserialize(filesystem, path);
+            if (!directoryInfo) {
+                return false;
+            }
+
+            dependencyInfo.push_back(directoryInfo->dependencyInfo());
+            break;
+        }
+        case dependency::DependencyInfoFormat::Makefile: {
+            std::vector<uint8_t> contents;
+            if (!filesystem->read(&contents, path)) {
+                return false;
+            }
+
+            auto makefileInfo = dependency::MakefileDependencyInfo::Deserialize(std::string(contents.begin(), contents.end()));
+            if (!makefileInfo) {
+                return false;
+            }
+
+            dependencyInfo = makefileInfo->dependencyInfo();
+            break;
+        }
+    }
+
+    for (dependency::DependencyInfo const &entry : dependencyInfo) {
+        inputs->insert(inputs->end(), entry.inputs().begin(), entry.inputs().end());
+    }
+
+    return true;
+}
+
+ext::optional<std::vector<std::string>> DiscoveredInputs::
+Load(Filesystem const *filesystem, Invocation const &invocation)
+{
+    std::vector<std::string> inputs;
+    for (Invocation::DependencyInfo const &info : invocation.dependencyInfo()) {
+        std::string path = FSUtil::ResolveRelativePath(info.path(), invocation.workingDirectory());
+        if (!LoadDependencyInfo(filesystem, info, path, &inputs)) {
+            return ext::nullopt;
+        }
+    }
+
+    for (std::string &input : inputs) {
+        input = FSUtil::ResolveRelativePath(input, invocation.workingDirectory());
+    }
+
+    return inputs;
+}
@@ -8,8 +8,19 @@
  */
 
 #include <xcexecution/Executor.h>
+#include <xcexecution/PlanCache.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Phase/Environment.h>
+#include <pbxbuild/Phase/PhaseInvocations.h>
+#include <libutil/FSUtil.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 using xcexecution::Executor;
+using xcexecution::PlanCache;
+using libutil::FSUtil;
 
 Executor::
 Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate) :
@@ -23,3 +34,103 @@ Executor::
 ~Executor()
 {
 }
+
+std::vector<Executor::TargetPlan> Executor::
+planTargets(
+    libutil::Filesystem *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &targets,
+    PlanCache const *planCache,
+    size_t jobs) const
+{
+    std::vector<TargetPlan> plans = std::vector<TargetPlan>(targets.size());
+
+    auto plan = [&](size_t index) {
+        pbxproj::PBX::Target::shared_ptr const &target = targets[index];
+        TargetPlan *targetPlan = &plans[index];
+
+        targetPlan->targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        if (!targetPlan->targetEnvironment) {
+            return;
+        }
+
+        ext::optional<PlanCache::TargetInputs> targetInputs;
+        if (planCache != nullptr) {
+            targetInputs = planCache->targetInputs(filesystem, target, *targetPlan->targetEnvironment);
+            if (ext::optional<std::vector<pbxbuild::Tool::Invocation>> invocations = planCache->load(filesystem, *targetInputs)) {
+                targetPlan->invocations = std::move(*invocations);
+                return;
+            }
+        }
+
+        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetPlan->targetEnvironment);
+        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+        targetPlan->invocations = phaseInvocations.invocations();
+
+        if (planCache != nullptr && !_dryRun) {
+            /* Failing to cache the plan only makes the next build slower. */
+            planCache->store(filesystem, *targetInputs, targetPlan->invocations);
+        }
+    };
+
+    if (jobs == 0) {
+        jobs = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    jobs = std::min(jobs, targets.size());
+
+    if (jobs <= 1) {
+        for (size_t n = 0; n < targets.size(); n++) {
+            plan(n);
+        }
+    } else {
+        /*
+         * Each thread takes the next unplanned target. Plans are written to
+         * their target's slot, so the result does not depend on scheduling.
+         */
+        std::atomic<size_t> next = ATOMIC_VAR_INIT(0);
+
+        std::vector<std::thread> threads;
+        for (size_t n = 0; n < jobs; n++) {
+            threads.push_back(std::thread([&]() {
+                for (size_t index = next++; index < targets.size(); index = next++) {
+                    plan(index);
+                }
+            }));
+        }
+
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    return plans;
+}
+
+std::vector<std::string> Executor::
+CreatedPaths(std::vector<pbxbuild::Tool::Invocation> const &invocations)
+{
+    std::vector<std::string> paths;
+
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        if (invocation.executable().path().empty()) {
+            continue;
+        }
+
+        if (invocation.outputs().empty()) {
+            return { "/" };
+        }
+
+        for (std::string const &output : invocation.outputs()) {
+            paths.push_back(FSUtil::ResolveRelativePath(output, invocation.workingDirectory()));
+        }
+        for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+            paths.push_back(FSUtil::ResolveRelativePath(dependencyInfo.path(), invocation.workingDirectory()));
+        }
+        for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+            paths.push_back(auxiliaryFile.path());
+        }
+    }
+
+    return paths;
+}
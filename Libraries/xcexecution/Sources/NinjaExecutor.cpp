@@ -8,6 +8,7 @@
  */
 
 #include <xcexecution/NinjaExecutor.h>
+#include <xcexecution/ActionCache.h>
 
 #include <xcexecution/Parameters.h>
 #include <pbxbuild/Phase/Environment.h>
@@ -36,8 +37,9 @@ using libutil::Subprocess;
 using libutil::SysUtil;
 
 NinjaExecutor::
-NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate) :
-    Executor(formatter, dryRun, generate)
+NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, std::shared_ptr<ActionCache> const &actionCache) :
+    Executor    (formatter, dryRun, generate),
+    _actionCache(actionCache)
 {
 }
 
@@ -450,11 +452,21 @@ buildAction(
      */
     std::vector<std::string> inputPaths = buildContext.workspaceContext().loadedFilePaths();
 
+    /*
+     * Resolve each target and generate its invocations. The targets are independent
+     * at this point, so they are planned concurrently.
+     */
+    std::vector<pbxproj::PBX::Target::shared_ptr> targets = std::vector<pbxproj::PBX::Target::shared_ptr>(targetGraph.nodes().begin(), targetGraph.nodes().end());
+    std::vector<TargetPlan> plans = planTargets(filesystem, buildEnvironment, buildContext, targets, nullptr, 0);
+
     /*
      * Go over each target and write out Ninja targets for the start and end of each.
      * Don't bother topologically sorting the targets now, since Ninja will do that for us.
      */
-    for (pbxproj::PBX::Target::shared_ptr const &target : targetGraph.nodes()) {
+    for (size_t n = 0; n < targets.size(); n++) {
+        pbxproj::PBX::Target::shared_ptr const &target = targets[n];
+        ext::optional<pbxbuild::Target::Environment> const &targetEnvironment = plans[n].targetEnvironment;
+        std::vector<pbxbuild::Tool::Invocation> const &invocations = plans[n].invocations;
 
         /*
          * Beginning target depends on finishing the targets before that. This is implemented
@@ -473,18 +485,11 @@ buildAction(
          * previous targets.
          */
 
-        /*
-         * Resolve this target and generate its invocations.
-         */
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
         if (!targetEnvironment) {
             fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
             continue;
         }
 
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
-
         /*
          * As described above, the target's begin depends on all of the target dependencies.
          */
@@ -503,7 +508,7 @@ buildAction(
         /*
          * Write out the Ninja file to build this target.
          */
-        if (!buildTargetInvocations(filesystem, target, *targetEnvironment, phaseInvocations.invocations())) {
+        if (!buildTargetInvocations(filesystem, target, *targetEnvironment, invocations)) {
             fprintf(stderr, "error: failed to build target ninja\n");
             return false;
         }
@@ -518,7 +523,7 @@ buildAction(
          * As described above, the target's finish depends on all of the invocation outputs.
          */
         std::unordered_set<std::string> invocationOutputs;
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
+        for (pbxbuild::Tool::Invocation const &invocation : invocations) {
             if (invocation.executable().path().empty()) {
                 /* No outputs. */
                 continue;
@@ -534,7 +539,7 @@ buildAction(
          * However, avoid adding the phony invocation if a real output *does* include
          * the phony input, to avoid Ninja complaining about duplicate rules.
          */
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
+        for (pbxbuild::Tool::Invocation const &invocation : invocations) {
             for (std::string const &phonyInput : invocation.phonyInputs()) {
                 if (invocationOutputs.find(phonyInput) == invocationOutputs.end()) {
                     writer.build({ ninja::Value::String(phonyInput) }, "phony", { });
@@ -597,6 +602,12 @@ NinjaDependencyInfoExecutable()
     return LocalExecutable("dependency-info-tool");
 }
 
+static std::string
+NinjaActionCacheExecutable()
+{
+    return LocalExecutable("action-cache-tool");
+}
+
 bool NinjaExecutor::
 buildTargetAuxiliaryFiles(
     Filesystem *filesystem,
@@ -674,6 +685,53 @@ buildTargetInvocations(
             exec += " " + Escape::Shell(arg);
         }
 
+        /*
+         * Run the invocation through the action cache, if enabled. The cache
+         * needs the files the invocation reads and writes to key and restore
+         * it. Invocations with phony inputs always run, so aren't wrapped.
+         */
+        if (_actionCache != nullptr && !invocation.outputs().empty() && invocation.phonyInputs().empty()) {
+            std::vector<std::string> actionCacheArguments = {
+                "--cache", _actionCache->path(),
+                "--maximum-size", std::to_string(_actionCache->maximumSize()),
+            };
+            if (_actionCache->hardlink()) {
+                actionCacheArguments.push_back("--hardlink");
+            }
+
+            for (std::string const &input : invocation.inputs()) {
+                actionCacheArguments.push_back("--input");
+                actionCacheArguments.push_back(input);
+            }
+            for (std::string const &inputDependency : invocation.inputDependencies()) {
+                actionCacheArguments.push_back("--input-dependency");
+                actionCacheArguments.push_back(inputDependency);
+            }
+            for (std::string const &output : invocation.outputs()) {
+                actionCacheArguments.push_back("--output");
+                actionCacheArguments.push_back(output);
+            }
+            for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+                std::string formatName;
+                if (!dependency::DependencyInfoFormats::Name(dependencyInfo.format(), &formatName)) {
+                    return false;
+                }
+
+                actionCacheArguments.push_back("--dependency-info");
+                actionCacheArguments.push_back(formatName + ":" + dependencyInfo.path());
+            }
+            for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+                actionCacheArguments.push_back("--auxiliary-file");
+                actionCacheArguments.push_back(auxiliaryFile.path());
+            }
+
+            std::string actionCacheExec = Escape::Shell(NinjaActionCacheExecutable());
+            for (std::string const &arg : actionCacheArguments) {
+                actionCacheExec += " " + Escape::Shell(arg);
+            }
+            exec = actionCacheExec + " -- " + exec;
+        }
+
         /*
          * Build the invocation environment. To set the environment, we use standard shell syntax.
          * Use `env` to avoid Bash-specific limitations on environment variables. Specifically, some
@@ -808,11 +866,12 @@ buildTargetInvocations(
 }
 
 std::unique_ptr<NinjaExecutor> NinjaExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, std::shared_ptr<ActionCache> const &actionCache)
 {
     return std::unique_ptr<NinjaExecutor>(new NinjaExecutor(
         formatter,
         dryRun,
-        generate
+        generate,
+        actionCache
     ));
 }
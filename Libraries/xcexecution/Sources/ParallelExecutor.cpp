@@ -0,0 +1,626 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ParallelExecutor.h>
+
+#include <xcexecution/Parameters.h>
+#include <xcexecution/PlanCache.h>
+#include <builtin/Driver.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Subprocess.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using xcexecution::ParallelExecutor;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Subprocess;
+
+/*
+ * A single invocation in the build graph. Tracks the number of invocations
+ * that must finish before it can run, and the invocations waiting on it.
+ */
+class ParallelExecutor::InvocationJob {
+public:
+    TargetBuild                      *target;
+    pbxbuild::Tool::Invocation const *invocation;
+
+public:
+    size_t                            waiting;
+    std::vector<InvocationJob *>      dependents;
+
+public:
+    bool                              success;
+
+public:
+    InvocationJob(TargetBuild *target, pbxbuild::Tool::Invocation const *invocation) :
+        target    (target),
+        invocation(invocation),
+        waiting   (0),
+        success   (false)
+    {
+    }
+};
+
+/*
+ * A target in the build. Tracks the number of targets that must finish before
+ * it can start, and the number of its invocations that have not yet finished.
+ * Its invocations are planned once the targets it depends on have finished.
+ */
+class ParallelExecutor::TargetBuild {
+public:
+    pbxproj::PBX::Target::shared_ptr            target;
+    std::vector<pbxbuild::Tool::Invocation>     invocations;
+    std::vector<std::unique_ptr<InvocationJob>> jobs;
+
+public:
+    size_t                                      waiting;
+    std::vector<TargetBuild *>                  dependents;
+
+public:
+    bool                                        planned;
+    size_t                                      remaining;
+    size_t                                      remainingStructure;
+
+public:
+    explicit TargetBuild(pbxproj::PBX::Target::shared_ptr const &target) :
+        target            (target),
+        waiting           (0),
+        planned           (false),
+        remaining         (0),
+        remainingStructure(0)
+    {
+    }
+};
+
+ParallelExecutor::
+ParallelExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs) :
+    Executor (formatter, dryRun, false),
+    _builtins(builtins),
+    _jobs    (jobs)
+{
+}
+
+ParallelExecutor::
+~ParallelExecutor()
+{
+}
+
+static ext::optional<pbxbuild::DirectedGraph<pbxbuild::Tool::Invocation const *>>
+InvocationGraph(std::vector<pbxbuild::Tool::Invocation> const &invocations)
+{
+    std::unordered_map<std::string, pbxbuild::Tool::Invocation const *> outputToInvocation;
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        for (std::string const &output : invocation.outputs()) {
+            outputToInvocation.insert({ output, &invocation });
+        }
+    }
+
+    /* Product structure is always created before anything else in the target. */
+    std::unordered_set<pbxbuild::Tool::Invocation const *> structureInvocations;
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        if (invocation.createsProductStructure()) {
+            structureInvocations.insert(&invocation);
+        }
+    }
+
+    pbxbuild::DirectedGraph<pbxbuild::Tool::Invocation const *> graph;
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        if (invocation.createsProductStructure()) {
+            std::unordered_set<pbxbuild::Tool::Invocation const *> emptySet;
+            graph.insert(&invocation, emptySet);
+        } else {
+            graph.insert(&invocation, structureInvocations);
+        }
+
+        for (std::vector<std::string> const *paths : { &invocation.inputs(), &invocation.phonyInputs(), &invocation.inputDependencies() }) {
+            for (std::string const &path : *paths) {
+                auto it = outputToInvocation.find(path);
+                if (it != outputToInvocation.end() && it->second != &invocation) {
+                    graph.insert(&invocation, { it->second });
+                }
+            }
+        }
+    }
+
+    if (!graph.ordered()) {
+        return ext::nullopt;
+    }
+
+    return graph;
+}
+
+bool ParallelExecutor::
+build(
+    libutil::Filesystem *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    Parameters const &buildParameters)
+{
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext = buildParameters.loadWorkspace(filesystem, buildEnvironment, FSUtil::GetCurrentDirectory());
+    if (!workspaceContext) {
+        return false;
+    }
+
+    ext::optional<pbxbuild::Build::Context> buildContext = buildParameters.createBuildContext(*workspaceContext);
+    if (!buildContext) {
+        return false;
+    }
+
+    xcformatter::Formatter::Print(_formatter->begin(*buildContext));
+
+    ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph = buildParameters.resolveDependencies(buildEnvironment, *buildContext);
+    if (!targetGraph) {
+        return false;
+    }
+
+    ext::optional<std::vector<pbxproj::PBX::Target::shared_ptr>> orderedTargets = targetGraph->ordered();
+    if (!orderedTargets) {
+        fprintf(stderr, "error: cycle detected in target dependencies\n");
+        return false;
+    }
+
+    xcexecution::PlanCache planCache = xcexecution::PlanCache::Create(filesystem, buildEnvironment, *buildContext, buildParameters);
+
+    std::vector<std::unique_ptr<TargetBuild>> targetBuilds;
+    for (pbxproj::PBX::Target::shared_ptr const &target : *orderedTargets) {
+        targetBuilds.push_back(std::unique_ptr<TargetBuild>(new TargetBuild(target)));
+    }
+
+    /*
+     * Plan targets only once the targets they depend on are built: search
+     * paths and file types in the plan can depend on their outputs. Targets
+     * that become ready together are planned together, using the same number
+     * of threads as the build itself.
+     */
+    auto plan = [&](std::vector<TargetBuild *> const &readyTargets) -> bool {
+        std::vector<pbxproj::PBX::Target::shared_ptr> targets;
+        for (TargetBuild *targetBuild : readyTargets) {
+            targets.push_back(targetBuild->target);
+        }
+
+        std::vector<TargetPlan> plans = planTargets(filesystem, buildEnvironment, *buildContext, targets, &planCache, _jobs);
+        for (size_t n = 0; n < readyTargets.size(); n++) {
+            if (!plans[n].targetEnvironment) {
+                fprintf(stderr, "error: couldn't create target environment for %s\n", targets[n]->name().c_str());
+                return false;
+            }
+
+            readyTargets[n]->invocations = std::move(plans[n].invocations);
+            if (!CreateJobs(readyTargets[n])) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    auto result = runTargetBuilds(filesystem, *buildContext, *targetGraph, targetBuilds, plan);
+    if (!result.first) {
+        xcformatter::Formatter::Print(_formatter->failure(*buildContext, result.second));
+        return false;
+    }
+
+    xcformatter::Formatter::Print(_formatter->success(*buildContext));
+    return true;
+}
+
+bool ParallelExecutor::
+writeAuxiliaryFiles(
+    Filesystem *filesystem,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    std::vector<pbxbuild::Tool::Invocation> const &invocations)
+{
+    xcformatter::Formatter::Print(_formatter->beginWriteAuxiliaryFiles(target));
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+            std::string directory = FSUtil::GetDirectoryName(auxiliaryFile.path());
+            if (!filesystem->isDirectory(directory)) {
+                xcformatter::Formatter::Print(_formatter->createAuxiliaryDirectory(directory));
+
+                if (!_dryRun) {
+                    if (!filesystem->createDirectory(directory)) {
+                        return false;
+                    }
+                }
+            }
+
+            xcformatter::Formatter::Print(_formatter->writeAuxiliaryFile(auxiliaryFile.path()));
+
+            if (!_dryRun) {
+                if (!filesystem->write(auxiliaryFile.contents(), auxiliaryFile.path())) {
+                    return false;
+                }
+            }
+
+            if (auxiliaryFile.executable() && !filesystem->isExecutable(auxiliaryFile.path())) {
+                xcformatter::Formatter::Print(_formatter->setAuxiliaryExecutable(auxiliaryFile.path()));
+
+                if (!_dryRun) {
+                    // FIXME: This should use the filesystem.
+                    if (::chmod(auxiliaryFile.path().c_str(), S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) != 0) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    xcformatter::Formatter::Print(_formatter->finishWriteAuxiliaryFiles(target));
+
+    return true;
+}
+
+bool ParallelExecutor::
+performInvocation(
+    Filesystem *filesystem,
+    pbxbuild::Tool::Invocation const &invocation)
+{
+    if (!invocation.executable().builtin().empty()) {
+        /* Built-in tools share process state, so only run one at a time. */
+        static std::mutex builtinMutex;
+        std::lock_guard<std::mutex> lock(builtinMutex);
+
+        /* For built-in tools, run them in-process. */
+        std::shared_ptr<builtin::Driver> driver = _builtins.driver(invocation.executable().builtin());
+        if (driver == nullptr) {
+            return false;
+        }
+
+        return (driver->run(invocation.arguments(), invocation.environment(), filesystem, invocation.workingDirectory()) == 0);
+    } else {
+        /* External tool, run the tool externally. */
+        Subprocess process;
+        return (process.execute(invocation.executable().path(), invocation.arguments(), invocation.environment(), invocation.workingDirectory()) && process.exitcode() == 0);
+    }
+}
+
+/*
+ * Creates the jobs for a target's planned invocations. Jobs point into the
+ * target's own invocations, which must no longer move.
+ */
+bool ParallelExecutor::
+CreateJobs(TargetBuild *targetBuild)
+{
+    ext::optional<pbxbuild::DirectedGraph<pbxbuild::Tool::Invocation const *>> invocationGraph = InvocationGraph(targetBuild->invocations);
+    if (!invocationGraph) {
+        fprintf(stderr, "error: cycle detected building invocation graph\n");
+        return false;
+    }
+
+    std::unordered_map<pbxbuild::Tool::Invocation const *, InvocationJob *> invocationToJob;
+    for (pbxbuild::Tool::Invocation const &invocation : targetBuild->invocations) {
+        std::unique_ptr<InvocationJob> job = std::unique_ptr<InvocationJob>(new InvocationJob(targetBuild, &invocation));
+        invocationToJob.insert({ &invocation, job.get() });
+
+        if (invocation.createsProductStructure()) {
+            targetBuild->remainingStructure++;
+        }
+        targetBuild->remaining++;
+        targetBuild->jobs.push_back(std::move(job));
+    }
+
+    for (std::unique_ptr<InvocationJob> const &job : targetBuild->jobs) {
+        for (pbxbuild::Tool::Invocation const *dependency : invocationGraph->adjacent(job->invocation)) {
+            invocationToJob.at(dependency)->dependents.push_back(job.get());
+            job->waiting++;
+        }
+    }
+
+    targetBuild->planned = true;
+    return true;
+}
+
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> ParallelExecutor::
+buildTargets(
+    Filesystem *filesystem,
+    pbxbuild::Build::Context const &buildContext,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<std::pair<pbxproj::PBX::Target::shared_ptr, std::vector<pbxbuild::Tool::Invocation>>> const &targetInvocations)
+{
+    std::vector<std::unique_ptr<TargetBuild>> targetBuilds;
+    for (auto const &entry : targetInvocations) {
+        std::unique_ptr<TargetBuild> targetBuild = std::unique_ptr<TargetBuild>(new TargetBuild(entry.first));
+        targetBuild->invocations = entry.second;
+        if (!CreateJobs(targetBuild.get())) {
+            return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+        }
+
+        targetBuilds.push_back(std::move(targetBuild));
+    }
+
+    return runTargetBuilds(filesystem, buildContext, targetGraph, targetBuilds, nullptr);
+}
+
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> ParallelExecutor::
+runTargetBuilds(
+    Filesystem *filesystem,
+    pbxbuild::Build::Context const &buildContext,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<std::unique_ptr<TargetBuild>> const &targetBuilds,
+    std::function<bool(std::vector<TargetBuild *> const &)> const &plan)
+{
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, TargetBuild *> targetToBuild;
+    for (std::unique_ptr<TargetBuild> const &targetBuild : targetBuilds) {
+        targetToBuild.insert({ targetBuild->target, targetBuild.get() });
+    }
+
+    for (std::unique_ptr<TargetBuild> const &targetBuild : targetBuilds) {
+        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(targetBuild->target)) {
+            auto it = targetToBuild.find(dependency);
+            if (it != targetToBuild.end()) {
+                it->second->dependents.push_back(targetBuild.get());
+                targetBuild->waiting++;
+            }
+        }
+    }
+
+    /*
+     * Jobs are handed to the workers through `pending`; the workers hand them
+     * back through `finished`. All formatter output and graph bookkeeping
+     * happens on this thread; the workers only run the invocations.
+     */
+    std::mutex                  mutex;
+    std::condition_variable     pendingCondition;
+    std::condition_variable     finishedCondition;
+    std::deque<InvocationJob *> pending;
+    std::deque<InvocationJob *> finished;
+    bool                        shutdown = false;
+
+    std::vector<std::thread> workers;
+    if (!_dryRun) {
+        for (size_t i = 0; i < _jobs; ++i) {
+            workers.push_back(std::thread([&]() {
+                for (;;) {
+                    InvocationJob *job;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        pendingCondition.wait(lock, [&]{ return shutdown || !pending.empty(); });
+                        if (pending.empty()) {
+                            return;
+                        }
+
+                        job = pending.front();
+                        pending.pop_front();
+                    }
+
+                    job->success = performInvocation(filesystem, *job->invocation);
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        finished.push_back(job);
+                    }
+                    finishedCondition.notify_one();
+                }
+            }));
+        }
+    }
+
+    std::deque<TargetBuild *>   readyTargets;
+    std::deque<InvocationJob *> readyJobs;
+    std::deque<InvocationJob *> completedJobs;
+    size_t                      running = 0;
+
+    std::vector<pbxbuild::Tool::Invocation> failingInvocations;
+    bool failed = false;
+
+    for (std::unique_ptr<TargetBuild> const &targetBuild : targetBuilds) {
+        if (targetBuild->waiting == 0) {
+            readyTargets.push_back(targetBuild.get());
+        }
+    }
+
+    auto finishStructure = [&](TargetBuild *targetBuild) {
+        xcformatter::Formatter::Print(_formatter->finishCreateProductStructure(targetBuild->target));
+    };
+
+    auto finishTarget = [&](TargetBuild *targetBuild) {
+        xcformatter::Formatter::Print(_formatter->finishTarget(buildContext, targetBuild->target));
+
+        /* Trees the target created directories in are walked again when planning. */
+        if (plan) {
+            buildContext.directoryTreeCache()->invalidate(CreatedPaths(targetBuild->invocations));
+        }
+
+        for (TargetBuild *dependent : targetBuild->dependents) {
+            if (--dependent->waiting == 0) {
+                readyTargets.push_back(dependent);
+            }
+        }
+    };
+
+    while (!failed || running > 0) {
+        /*
+         * Start any targets that have all of their dependencies built.
+         */
+        while (!failed && !readyTargets.empty()) {
+            TargetBuild *targetBuild = readyTargets.front();
+
+            /* Plan every ready target that hasn't been planned together. */
+            if (!targetBuild->planned) {
+                std::vector<TargetBuild *> unplanned;
+                std::copy_if(readyTargets.begin(), readyTargets.end(), std::back_inserter(unplanned), [](TargetBuild *ready) {
+                    return !ready->planned;
+                });
+
+                if (!plan(unplanned)) {
+                    failed = true;
+                    break;
+                }
+            }
+
+            readyTargets.pop_front();
+
+            xcformatter::Formatter::Print(_formatter->beginTarget(buildContext, targetBuild->target));
+            xcformatter::Formatter::Print(_formatter->beginCheckDependencies(targetBuild->target));
+            xcformatter::Formatter::Print(_formatter->finishCheckDependencies(targetBuild->target));
+
+            if (!writeAuxiliaryFiles(filesystem, targetBuild->target, targetBuild->invocations)) {
+                xcformatter::Formatter::Print(_formatter->finishTarget(buildContext, targetBuild->target));
+                failed = true;
+                break;
+            }
+
+            xcformatter::Formatter::Print(_formatter->beginCreateProductStructure(targetBuild->target));
+            if (targetBuild->remainingStructure == 0) {
+                finishStructure(targetBuild);
+            }
+
+            if (targetBuild->remaining == 0) {
+                finishTarget(targetBuild);
+                continue;
+            }
+
+            for (std::unique_ptr<InvocationJob> const &job : targetBuild->jobs) {
+                if (job->waiting == 0) {
+                    readyJobs.push_back(job.get());
+                }
+            }
+        }
+
+        /*
+         * Dispatch ready invocations until the job limit is reached. Phony
+         * invocations and dry runs complete without running anything.
+         */
+        while (!failed && !readyJobs.empty() && running < _jobs) {
+            InvocationJob *job = readyJobs.front();
+            readyJobs.pop_front();
+
+            pbxbuild::Tool::Invocation const &invocation = *job->invocation;
+
+            // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
+            if (invocation.executable().path().empty()) {
+                job->success = true;
+                completedJobs.push_back(job);
+                continue;
+            }
+
+            xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, invocation.executable().displayName(), invocation.createsProductStructure()));
+
+            if (_dryRun) {
+                job->success = true;
+                completedJobs.push_back(job);
+                continue;
+            }
+
+            bool createdDirectories = true;
+            for (std::string const &output : invocation.outputs()) {
+                if (!filesystem->createDirectory(FSUtil::GetDirectoryName(output))) {
+                    createdDirectories = false;
+                    break;
+                }
+            }
+
+            if (!createdDirectories) {
+                job->success = false;
+                completedJobs.push_back(job);
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.push_back(job);
+            }
+            pendingCondition.notify_one();
+            running++;
+        }
+
+        /*
+         * Wait for a running invocation to finish if nothing else can proceed.
+         */
+        if (completedJobs.empty() && (failed || readyTargets.empty())) {
+            if (running == 0) {
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            finishedCondition.wait(lock, [&]{ return !finished.empty(); });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running -= finished.size();
+            completedJobs.insert(completedJobs.end(), finished.begin(), finished.end());
+            finished.clear();
+        }
+
+        /*
+         * Release the invocations and targets waiting on finished invocations.
+         */
+        while (!completedJobs.empty()) {
+            InvocationJob *job = completedJobs.front();
+            completedJobs.pop_front();
+
+            TargetBuild *targetBuild = job->target;
+            pbxbuild::Tool::Invocation const &invocation = *job->invocation;
+
+            if (!invocation.executable().path().empty()) {
+                xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, invocation.executable().displayName(), invocation.createsProductStructure()));
+            }
+
+            if (!job->success) {
+                if (!failed) {
+                    xcformatter::Formatter::Print(_formatter->finishTarget(buildContext, targetBuild->target));
+                }
+                failingInvocations.push_back(invocation);
+                failed = true;
+                continue;
+            }
+
+            for (InvocationJob *dependent : job->dependents) {
+                if (--dependent->waiting == 0) {
+                    readyJobs.push_back(dependent);
+                }
+            }
+
+            if (invocation.createsProductStructure() && --targetBuild->remainingStructure == 0) {
+                finishStructure(targetBuild);
+            }
+
+            if (--targetBuild->remaining == 0) {
+                finishTarget(targetBuild);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutdown = true;
+    }
+    pendingCondition.notify_all();
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    return std::make_pair(!failed, failingInvocations);
+}
+
+std::unique_ptr<ParallelExecutor> ParallelExecutor::
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs)
+{
+    if (jobs == 0) {
+        jobs = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    return std::unique_ptr<ParallelExecutor>(new ParallelExecutor(
+        formatter,
+        dryRun,
+        builtins,
+        jobs
+    ));
+}
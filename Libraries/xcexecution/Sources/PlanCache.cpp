@@ -0,0 +1,587 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/PlanCache.h>
+#include <xcexecution/SessionEnvironment.h>
+#include <pbxbuild/WorkspaceContext.h>
+#include <pbxbuild/FileTypeResolver.h>
+#include <pbxbuild/Tool/SearchPaths.h>
+#include <plist/Array.h>
+#include <plist/Boolean.h>
+#include <plist/Data.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/SysUtil.h>
+#include <libutil/md5.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+
+using xcexecution::PlanCache;
+using xcexecution::SessionEnvironment;
+using pbxbuild::Tool::Invocation;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::SysUtil;
+
+/*
+ * Bump when the format of the cached plans or the planning itself changes.
+ */
+static char const PlanCacheVersion[] = "2";
+
+namespace {
+
+class Hasher {
+private:
+    md5_state_t _state;
+
+public:
+    Hasher()
+    { md5_init(&_state); }
+
+public:
+    void append(std::string const &value)
+    {
+        /* Include the trailing NUL terminator to separate values. */
+        md5_append(&_state, reinterpret_cast<const md5_byte_t *>(value.c_str()), value.size() + 1);
+    }
+
+    void append(std::vector<uint8_t> const &value)
+    {
+        append(std::to_string(value.size()));
+        md5_append(&_state, reinterpret_cast<const md5_byte_t *>(value.data()), value.size());
+    }
+
+    /*
+     * Appends a file's path and contents. Missing files hash differently
+     * from empty files.
+     */
+    void appendFile(Filesystem const *filesystem, std::string const &path)
+    {
+        append(path);
+
+        std::vector<uint8_t> contents;
+        if (filesystem->read(&contents, path)) {
+            append(contents);
+        } else {
+            append(std::string("<missing>"));
+        }
+    }
+
+public:
+    std::string finish()
+    {
+        uint8_t digest[16];
+        md5_finish(&_state, reinterpret_cast<md5_byte_t *>(&digest));
+
+        std::ostringstream ss;
+        ss << std::hex << std::setfill('0');
+        for (uint8_t c : digest) {
+            ss << std::setw(2) << static_cast<int>(c);
+        }
+        return ss.str();
+    }
+};
+
+}
+
+PlanCache::
+PlanCache(std::string const &key, pbxspec::Manager::shared_ptr const &specManager, pbxbuild::Build::DirectoryTreeCache *directoryTreeCache) :
+    _key               (key),
+    _specManager       (specManager),
+    _directoryTreeCache(directoryTreeCache)
+{
+}
+
+static std::string
+PlanPath(pbxproj::PBX::Target::shared_ptr const &target, pbxbuild::Target::Environment const &targetEnvironment)
+{
+    /* The temporary directory differs for each configuration and platform. */
+    std::string temporaryDirectory = targetEnvironment.environment().resolve("TARGET_TEMP_DIR");
+
+    Hasher hasher;
+    hasher.append(target->project()->projectFile());
+    hasher.append(target->blueprintIdentifier());
+    hasher.append(temporaryDirectory);
+
+    std::string intermediatesDirectory = targetEnvironment.environment().resolve("OBJROOT");
+    return intermediatesDirectory + "/PlanCache/" + hasher.finish() + ".plist";
+}
+
+PlanCache::TargetInputs PlanCache::
+targetInputs(
+    Filesystem const *filesystem,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    pbxbuild::Target::Environment const &targetEnvironment) const
+{
+    Hasher hasher;
+    hasher.append(_key);
+
+    if (targetEnvironment.sdk() != nullptr) {
+        hasher.append(targetEnvironment.sdk()->path());
+        hasher.append(targetEnvironment.sdk()->version());
+        hasher.appendFile(filesystem, targetEnvironment.sdk()->path() + "/SDKSettings.plist");
+    }
+
+    for (pbxsetting::XC::Config::shared_ptr const &config : { targetEnvironment.projectConfigurationFile(), targetEnvironment.targetConfigurationFile() }) {
+        if (config == nullptr) {
+            hasher.append(std::string());
+            continue;
+        }
+
+        for (std::string const &path : config->includedPaths()) {
+            hasher.appendFile(filesystem, path);
+        }
+    }
+
+    /*
+     * The search paths depend on which directories exist in the SDK and
+     * below recursive search paths.
+     */
+    pbxbuild::Tool::SearchPaths searchPaths = pbxbuild::Tool::SearchPaths::Create(targetEnvironment.environment(), targetEnvironment.workingDirectory(), _directoryTreeCache);
+    for (std::vector<std::string> const *paths : { &searchPaths.headerSearchPaths(), &searchPaths.userHeaderSearchPaths(), &searchPaths.frameworkSearchPaths(), &searchPaths.librarySearchPaths() }) {
+        hasher.append(std::to_string(paths->size()));
+        for (std::string const &path : *paths) {
+            hasher.append(path);
+        }
+    }
+
+    for (std::string const &path : targetEnvironment.executablePaths()) {
+        hasher.append(path);
+    }
+
+    TargetInputs targetInputs;
+    targetInputs.path = PlanPath(target, targetEnvironment);
+    targetInputs.key = hasher.finish();
+    targetInputs.executablePaths = targetEnvironment.executablePaths();
+    targetInputs.specDomains = targetEnvironment.specDomains();
+    return targetInputs;
+}
+
+static std::unique_ptr<plist::Array>
+SerializeStrings(std::vector<std::string> const &strings)
+{
+    auto array = plist::Array::New();
+    for (std::string const &string : strings) {
+        array->append(plist::String::New(string));
+    }
+    return array;
+}
+
+static std::vector<std::string>
+DeserializeStrings(plist::Array const *array)
+{
+    std::vector<std::string> strings;
+    if (array != nullptr) {
+        strings.reserve(array->count());
+        for (size_t n = 0; n < array->count(); n++) {
+            if (auto string = array->value<plist::String>(n)) {
+                strings.push_back(string->value());
+            }
+        }
+    }
+    return strings;
+}
+
+static std::unique_ptr<plist::Dictionary>
+SerializeInvocation(Invocation const &invocation)
+{
+    auto dict = plist::Dictionary::New();
+
+    dict->set("ExecutablePath", plist::String::New(invocation.executable().path()));
+    dict->set("ExecutableBuiltin", plist::String::New(invocation.executable().builtin()));
+    dict->set("Arguments", SerializeStrings(invocation.arguments()));
+
+    /* Sort the environment so identical plans serialize identically. */
+    std::map<std::string, std::string> environment = std::map<std::string, std::string>(invocation.environment().begin(), invocation.environment().end());
+    auto environmentDict = plist::Dictionary::New();
+    for (auto const &entry : environment) {
+        environmentDict->set(entry.first, plist::String::New(entry.second));
+    }
+    dict->set("Environment", std::move(environmentDict));
+    dict->set("WorkingDirectory", plist::String::New(invocation.workingDirectory()));
+
+    dict->set("Inputs", SerializeStrings(invocation.inputs()));
+    dict->set("Outputs", SerializeStrings(invocation.outputs()));
+    dict->set("PhonyInputs", SerializeStrings(invocation.phonyInputs()));
+    dict->set("InputDependencies", SerializeStrings(invocation.inputDependencies()));
+    dict->set("OrderDependencies", SerializeStrings(invocation.orderDependencies()));
+
+    auto dependencyInfo = plist::Array::New();
+    for (Invocation::DependencyInfo const &info : invocation.dependencyInfo()) {
+        std::string format;
+        if (!dependency::DependencyInfoFormats::Name(info.format(), &format)) {
+            return nullptr;
+        }
+
+        auto infoDict = plist::Dictionary::New();
+        infoDict->set("Format", plist::String::New(format));
+        infoDict->set("Path", plist::String::New(info.path()));
+        dependencyInfo->append(std::move(infoDict));
+    }
+    dict->set("DependencyInfo", std::move(dependencyInfo));
+
+    auto auxiliaryFiles = plist::Array::New();
+    for (Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+        auto fileDict = plist::Dictionary::New();
+        fileDict->set("Path", plist::String::New(auxiliaryFile.path()));
+        fileDict->set("Contents", plist::Data::New(auxiliaryFile.contents()));
+        fileDict->set("Executable", plist::Boolean::New(auxiliaryFile.executable()));
+        auxiliaryFiles->append(std::move(fileDict));
+    }
+    dict->set("AuxiliaryFiles", std::move(auxiliaryFiles));
+
+    dict->set("LogMessage", plist::String::New(invocation.logMessage()));
+    dict->set("ShowEnvironmentInLog", plist::Boolean::New(invocation.showEnvironmentInLog()));
+    dict->set("CreatesProductStructure", plist::Boolean::New(invocation.createsProductStructure()));
+
+    return dict;
+}
+
+static ext::optional<Invocation>
+DeserializeInvocation(plist::Dictionary const *dict)
+{
+    auto executablePath = dict->value<plist::String>("ExecutablePath");
+    auto executableBuiltin = dict->value<plist::String>("ExecutableBuiltin");
+    auto environment = dict->value<plist::Dictionary>("Environment");
+    auto workingDirectory = dict->value<plist::String>("WorkingDirectory");
+    auto dependencyInfo = dict->value<plist::Array>("DependencyInfo");
+    auto auxiliaryFiles = dict->value<plist::Array>("AuxiliaryFiles");
+    auto logMessage = dict->value<plist::String>("LogMessage");
+    auto showEnvironmentInLog = dict->value<plist::Boolean>("ShowEnvironmentInLog");
+    auto createsProductStructure = dict->value<plist::Boolean>("CreatesProductStructure");
+    if (executablePath == nullptr || executableBuiltin == nullptr || environment == nullptr || workingDirectory == nullptr ||
+        dependencyInfo == nullptr || auxiliaryFiles == nullptr || logMessage == nullptr ||
+        showEnvironmentInLog == nullptr || createsProductStructure == nullptr) {
+        return ext::nullopt;
+    }
+
+    Invocation invocation;
+    invocation.executable() = Invocation::Executable(executablePath->value(), executableBuiltin->value());
+    invocation.arguments() = DeserializeStrings(dict->value<plist::Array>("Arguments"));
+    for (size_t n = 0; n < environment->count(); n++) {
+        if (auto value = environment->value<plist::String>(n)) {
+            invocation.environment().insert({ environment->key(n), value->value() });
+        }
+    }
+    invocation.workingDirectory() = workingDirectory->value();
+
+    invocation.inputs() = DeserializeStrings(dict->value<plist::Array>("Inputs"));
+    invocation.outputs() = DeserializeStrings(dict->value<plist::Array>("Outputs"));
+    invocation.phonyInputs() = DeserializeStrings(dict->value<plist::Array>("PhonyInputs"));
+    invocation.inputDependencies() = DeserializeStrings(dict->value<plist::Array>("InputDependencies"));
+    invocation.orderDependencies() = DeserializeStrings(dict->value<plist::Array>("OrderDependencies"));
+
+    for (size_t n = 0; n < dependencyInfo->count(); n++) {
+        auto infoDict = dependencyInfo->value<plist::Dictionary>(n);
+        if (infoDict == nullptr) {
+            return ext::nullopt;
+        }
+
+        auto format = infoDict->value<plist::String>("Format");
+        auto path = infoDict->value<plist::String>("Path");
+        dependency::DependencyInfoFormat dependencyInfoFormat;
+        if (format == nullptr || path == nullptr || !dependency::DependencyInfoFormats::Parse(format->value(), &dependencyInfoFormat)) {
+            return ext::nullopt;
+        }
+
+        invocation.dependencyInfo().push_back(Invocation::DependencyInfo(dependencyInfoFormat, path->value()));
+    }
+
+    for (size_t n = 0; n < auxiliaryFiles->count(); n++) {
+        auto fileDict = auxiliaryFiles->value<plist::Dictionary>(n);
+        if (fileDict == nullptr) {
+            return ext::nullopt;
+        }
+
+        auto path = fileDict->value<plist::String>("Path");
+        auto contents = fileDict->value<plist::Data>("Contents");
+        auto executable = fileDict->value<plist::Boolean>("Executable");
+        if (path == nullptr || contents == nullptr || executable == nullptr) {
+            return ext::nullopt;
+        }
+
+        invocation.auxiliaryFiles().push_back(Invocation::AuxiliaryFile(path->value(), contents->value(), executable->value()));
+    }
+
+    invocation.logMessage() = logMessage->value();
+    invocation.showEnvironmentInLog() = showEnvironmentInLog->value();
+    invocation.createsProductStructure() = createsProductStructure->value();
+
+    return invocation;
+}
+
+static std::string
+TreeDigest(pbxbuild::Build::DirectoryTreeCache::Directories const &directories)
+{
+    Hasher hasher;
+    for (std::string const &directory : *directories) {
+        hasher.append(directory);
+    }
+    return hasher.finish();
+}
+
+static std::string
+InputType(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &specDomains, std::string const &path)
+{
+    pbxspec::PBX::FileType::shared_ptr fileType = pbxbuild::FileTypeResolver::Resolve(specManager, specDomains, path);
+    return (fileType != nullptr ? fileType->identifier() : std::string());
+}
+
+/*
+ * Records what planning found on disk: the trees below the recursive search
+ * paths, the type of each input that isn't produced by the plan itself, and
+ * the path found for each tool.
+ */
+static std::unique_ptr<plist::Dictionary>
+SerializeDependencies(
+    pbxspec::Manager::shared_ptr const &specManager,
+    pbxbuild::Build::DirectoryTreeCache *directoryTreeCache,
+    PlanCache::TargetInputs const &targetInputs,
+    std::vector<Invocation> const &invocations)
+{
+    auto trees = plist::Array::New();
+    if (directoryTreeCache != nullptr) {
+        for (auto const &root : directoryTreeCache->roots()) {
+            auto tree = plist::Dictionary::New();
+            tree->set("Root", plist::String::New(root.first));
+            tree->set("Included", SerializeStrings(root.second.included()));
+            tree->set("Excluded", SerializeStrings(root.second.excluded()));
+            tree->set("FollowSymlinks", plist::Boolean::New(root.second.followSymlinks()));
+            tree->set("Digest", plist::String::New(TreeDigest(directoryTreeCache->directories(root.first, root.second))));
+            trees->append(std::move(tree));
+        }
+    }
+
+    std::unordered_set<std::string> outputs;
+    for (Invocation const &invocation : invocations) {
+        outputs.insert(invocation.outputs().begin(), invocation.outputs().end());
+    }
+
+    /* Sorted so identical plans serialize identically. */
+    std::map<std::string, std::string> inputTypes;
+    std::map<std::string, std::string> executables;
+    for (Invocation const &invocation : invocations) {
+        for (std::string const &input : invocation.inputs()) {
+            if (outputs.find(input) == outputs.end() && inputTypes.find(input) == inputTypes.end()) {
+                inputTypes.insert({ input, InputType(specManager, targetInputs.specDomains, input) });
+            }
+        }
+
+        if (invocation.executable().builtin().empty() && !invocation.executable().path().empty()) {
+            std::string name = FSUtil::GetBaseName(invocation.executable().path());
+            if (executables.find(name) == executables.end()) {
+                executables.insert({ name, FSUtil::FindExecutable(name, targetInputs.executablePaths) });
+            }
+        }
+    }
+
+    auto inputTypesDict = plist::Dictionary::New();
+    for (auto const &entry : inputTypes) {
+        inputTypesDict->set(entry.first, plist::String::New(entry.second));
+    }
+
+    auto executablesDict = plist::Dictionary::New();
+    for (auto const &entry : executables) {
+        executablesDict->set(entry.first, plist::String::New(entry.second));
+    }
+
+    auto dependencies = plist::Dictionary::New();
+    dependencies->set("Trees", std::move(trees));
+    dependencies->set("InputTypes", std::move(inputTypesDict));
+    dependencies->set("Executables", std::move(executablesDict));
+    return dependencies;
+}
+
+/*
+ * Checks that what planning found on disk is still there.
+ */
+static bool
+DependenciesMatch(
+    pbxspec::Manager::shared_ptr const &specManager,
+    pbxbuild::Build::DirectoryTreeCache *directoryTreeCache,
+    PlanCache::TargetInputs const &targetInputs,
+    plist::Dictionary const *dependencies)
+{
+    auto trees = dependencies->value<plist::Array>("Trees");
+    auto inputTypes = dependencies->value<plist::Dictionary>("InputTypes");
+    auto executables = dependencies->value<plist::Dictionary>("Executables");
+    if (trees == nullptr || inputTypes == nullptr || executables == nullptr) {
+        return false;
+    }
+
+    for (size_t n = 0; n < trees->count(); n++) {
+        auto tree = trees->value<plist::Dictionary>(n);
+        if (tree == nullptr || directoryTreeCache == nullptr) {
+            return false;
+        }
+
+        auto root = tree->value<plist::String>("Root");
+        auto followSymlinks = tree->value<plist::Boolean>("FollowSymlinks");
+        auto digest = tree->value<plist::String>("Digest");
+        if (root == nullptr || followSymlinks == nullptr || digest == nullptr) {
+            return false;
+        }
+
+        pbxbuild::Build::DirectoryTreeCache::Filter filter = pbxbuild::Build::DirectoryTreeCache::Filter(
+            DeserializeStrings(tree->value<plist::Array>("Included")),
+            DeserializeStrings(tree->value<plist::Array>("Excluded")),
+            followSymlinks->value());
+        if (TreeDigest(directoryTreeCache->directories(root->value(), filter)) != digest->value()) {
+            return false;
+        }
+    }
+
+    for (size_t n = 0; n < inputTypes->count(); n++) {
+        auto type = inputTypes->value<plist::String>(n);
+        if (type == nullptr || InputType(specManager, targetInputs.specDomains, inputTypes->key(n)) != type->value()) {
+            return false;
+        }
+    }
+
+    for (size_t n = 0; n < executables->count(); n++) {
+        auto path = executables->value<plist::String>(n);
+        if (path == nullptr || FSUtil::FindExecutable(executables->key(n), targetInputs.executablePaths) != path->value()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ext::optional<std::vector<Invocation>> PlanCache::
+load(Filesystem const *filesystem, TargetInputs const &targetInputs) const
+{
+    std::string const &path = targetInputs.path;
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->exists(path) || !filesystem->read(&contents, path)) {
+        return ext::nullopt;
+    }
+
+    std::unique_ptr<plist::Object> object = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create()).first;
+    auto plan = plist::CastTo<plist::Dictionary>(object.get());
+    if (plan == nullptr) {
+        return ext::nullopt;
+    }
+
+    /*
+     * Any change to the inputs of the plan invalidates it.
+     */
+    auto key = plan->value<plist::String>("Key");
+    if (key == nullptr || key->value() != targetInputs.key) {
+        return ext::nullopt;
+    }
+
+    auto dependencies = plan->value<plist::Dictionary>("Dependencies");
+    if (dependencies == nullptr || !DependenciesMatch(_specManager, _directoryTreeCache, targetInputs, dependencies)) {
+        return ext::nullopt;
+    }
+
+    auto invocationsArray = plan->value<plist::Array>("Invocations");
+    if (invocationsArray == nullptr) {
+        return ext::nullopt;
+    }
+
+    std::vector<Invocation> invocations;
+    invocations.reserve(invocationsArray->count());
+    for (size_t n = 0; n < invocationsArray->count(); n++) {
+        auto dict = invocationsArray->value<plist::Dictionary>(n);
+        if (dict == nullptr) {
+            return ext::nullopt;
+        }
+
+        ext::optional<Invocation> invocation = DeserializeInvocation(dict);
+        if (!invocation) {
+            return ext::nullopt;
+        }
+
+        invocations.push_back(std::move(*invocation));
+    }
+
+    return invocations;
+}
+
+bool PlanCache::
+store(Filesystem *filesystem, TargetInputs const &targetInputs, std::vector<Invocation> const &invocations) const
+{
+    std::string const &path = targetInputs.path;
+
+    auto invocationsArray = plist::Array::New();
+    for (Invocation const &invocation : invocations) {
+        std::unique_ptr<plist::Dictionary> dict = SerializeInvocation(invocation);
+        if (dict == nullptr) {
+            return false;
+        }
+
+        invocationsArray->append(std::move(dict));
+    }
+
+    auto plan = plist::Dictionary::New();
+    plan->set("Key", plist::String::New(targetInputs.key));
+    plan->set("Dependencies", SerializeDependencies(_specManager, _directoryTreeCache, targetInputs, invocations));
+    plan->set("Invocations", std::move(invocationsArray));
+
+    auto serialized = plist::Format::Binary::Serialize(plan.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        return false;
+    }
+
+    std::string directory = FSUtil::GetDirectoryName(path);
+    if (!filesystem->isDirectory(directory) && !filesystem->createDirectory(directory)) {
+        return false;
+    }
+
+    return filesystem->write(*serialized.first, path);
+}
+
+PlanCache PlanCache::
+Create(
+    Filesystem const *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    Parameters const &buildParameters)
+{
+    Hasher hasher;
+    hasher.append(std::string(PlanCacheVersion));
+    hasher.append(buildParameters.canonicalHash());
+
+    /*
+     * The process environment is the base of every build setting, except
+     * for the variables that only describe the shell the build ran from.
+     */
+    for (auto const &entry : SessionEnvironment::Remove(SysUtil::EnvironmentVariables())) {
+        hasher.append(entry.first);
+        hasher.append(entry.second);
+    }
+
+    /*
+     * The workspace, project, and scheme files. Sorted for a stable order.
+     */
+    std::vector<std::string> loadedFilePaths = buildContext.workspaceContext().loadedFilePaths();
+    std::sort(loadedFilePaths.begin(), loadedFilePaths.end());
+    for (std::string const &path : loadedFilePaths) {
+        hasher.appendFile(filesystem, path);
+    }
+
+    /*
+     * The specifications and build rules, in load order.
+     */
+    for (std::string const &path : buildEnvironment.specManager()->loadedFilePaths()) {
+        hasher.appendFile(filesystem, path);
+    }
+
+    return PlanCache(hasher.finish(), buildEnvironment.specManager(), buildContext.directoryTreeCache());
+}
@@ -0,0 +1,36 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/SessionEnvironment.h>
+
+using xcexecution::SessionEnvironment;
+
+static char const *const SessionVariables[] = {
+    "DISPLAY",
+    "OLDPWD",
+    "PWD",
+    "SHLVL",
+    "SSH_AUTH_SOCK",
+    "TERM",
+    "TERM_PROGRAM",
+    "TERM_PROGRAM_VERSION",
+    "TERM_SESSION_ID",
+    "TMPDIR",
+    "_",
+};
+
+std::map<std::string, std::string> SessionEnvironment::
+Remove(std::unordered_map<std::string, std::string> const &environment)
+{
+    std::map<std::string, std::string> result = std::map<std::string, std::string>(environment.begin(), environment.end());
+    for (char const *name : SessionVariables) {
+        result.erase(name);
+    }
+    return result;
+}
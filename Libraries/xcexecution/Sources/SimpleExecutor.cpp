@@ -9,26 +9,35 @@
 
 #include <xcexecution/SimpleExecutor.h>
 
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/BuildState.h>
 #include <xcexecution/Parameters.h>
+#include <xcexecution/PlanCache.h>
 #include <builtin/Driver.h>
-#include <pbxbuild/Phase/Environment.h>
-#include <pbxbuild/Phase/PhaseInvocations.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 #include <libutil/Subprocess.h>
 
+#include <algorithm>
+#include <cstdio>
+
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 using xcexecution::SimpleExecutor;
+using xcexecution::ActionCache;
+using xcexecution::BuildState;
 using libutil::Filesystem;
 using libutil::FSUtil;
 using libutil::Subprocess;
 
 SimpleExecutor::
-SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins) :
-    Executor (formatter, dryRun, false),
-    _builtins(builtins)
+SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, std::shared_ptr<ActionCache> const &actionCache, size_t jobs) :
+    Executor    (formatter, dryRun, false),
+    _builtins   (builtins),
+    _actionCache(actionCache),
+    _jobs       (jobs)
 {
 }
 
@@ -37,6 +46,38 @@ SimpleExecutor::
 {
 }
 
+/*
+ * Groups targets by the longest chain of dependencies below them, keeping
+ * the build order within each group. Targets only depend on targets in
+ * earlier groups.
+ */
+static std::vector<std::vector<pbxproj::PBX::Target::shared_ptr>>
+TargetLevels(
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets)
+{
+    std::vector<std::vector<pbxproj::PBX::Target::shared_ptr>> levels;
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, size_t> targetLevels;
+
+    for (pbxproj::PBX::Target::shared_ptr const &target : orderedTargets) {
+        size_t level = 0;
+        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
+            auto it = targetLevels.find(dependency);
+            if (it != targetLevels.end()) {
+                level = std::max(level, it->second + 1);
+            }
+        }
+
+        targetLevels.insert({ target, level });
+        if (level >= levels.size()) {
+            levels.resize(level + 1);
+        }
+        levels[level].push_back(target);
+    }
+
+    return levels;
+}
+
 bool SimpleExecutor::
 build(
     libutil::Filesystem *filesystem,
@@ -66,29 +107,44 @@ build(
         return false;
     }
 
-    for (pbxproj::PBX::Target::shared_ptr const &target : *orderedTargets) {
-        xcformatter::Formatter::Print(_formatter->beginTarget(*buildContext, target));
+    xcexecution::PlanCache planCache = xcexecution::PlanCache::Create(filesystem, buildEnvironment, *buildContext, buildParameters);
 
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(buildEnvironment, target);
-        if (!targetEnvironment) {
-            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            continue;
-        }
+    /*
+     * Plan targets only once the targets they depend on are built: search
+     * paths and file types in the plan can depend on their outputs. Targets
+     * in the same level of the target graph don't depend on each other, so
+     * each level is planned together.
+     */
+    for (std::vector<pbxproj::PBX::Target::shared_ptr> const &level : TargetLevels(*targetGraph, *orderedTargets)) {
+        std::vector<TargetPlan> plans = planTargets(filesystem, buildEnvironment, *buildContext, level, &planCache, _jobs);
 
-        xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, *buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
-        xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
+        for (size_t n = 0; n < level.size(); n++) {
+            pbxproj::PBX::Target::shared_ptr const &target = level[n];
+            TargetPlan const &plan = plans[n];
+
+            xcformatter::Formatter::Print(_formatter->beginTarget(*buildContext, target));
+
+            if (!plan.targetEnvironment) {
+                fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+                xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+                continue;
+            }
+
+            xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
+            xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
+
+            auto result = buildTarget(filesystem, target, *plan.targetEnvironment, plan.invocations);
+            if (!result.first) {
+                xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+                xcformatter::Formatter::Print(_formatter->failure(*buildContext, result.second));
+                return false;
+            }
+
+            /* Trees the target created directories in are walked again. */
+            buildContext->directoryTreeCache()->invalidate(CreatedPaths(plan.invocations));
 
-        auto result = buildTarget(filesystem, target, *targetEnvironment, phaseInvocations.invocations());
-        if (!result.first) {
             xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            xcformatter::Formatter::Print(_formatter->failure(*buildContext, result.second));
-            return false;
         }
-
-        xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
     }
 
     xcformatter::Formatter::Print(_formatter->success(*buildContext));
@@ -143,6 +199,42 @@ SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
     return result;
 }
 
+/*
+ * Runs a built-in tool in-process. If `error` is set, what the tool writes
+ * to standard error is kept there instead, by redirecting it to a file.
+ */
+static int
+RunBuiltin(builtin::Driver *driver, pbxbuild::Tool::Invocation const &invocation, Filesystem *filesystem, std::string *error)
+{
+    FILE *file = (error != nullptr ? ::tmpfile() : nullptr);
+    int saved = (file != nullptr ? ::dup(STDERR_FILENO) : -1);
+    if (saved == -1) {
+        if (file != nullptr) {
+            ::fclose(file);
+        }
+        return driver->run(invocation.arguments(), invocation.environment(), filesystem, invocation.workingDirectory());
+    }
+
+    ::fflush(stderr);
+    ::dup2(::fileno(file), STDERR_FILENO);
+
+    int exitcode = driver->run(invocation.arguments(), invocation.environment(), filesystem, invocation.workingDirectory());
+
+    ::fflush(stderr);
+    ::dup2(saved, STDERR_FILENO);
+    ::close(saved);
+
+    ::rewind(file);
+    char buffer[4096];
+    size_t read;
+    while ((read = ::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        error->append(buffer, read);
+    }
+    ::fclose(file);
+
+    return exitcode;
+}
+
 bool SimpleExecutor::
 writeAuxiliaryFiles(
     Filesystem *filesystem,
@@ -167,7 +259,10 @@ writeAuxiliaryFiles(
             xcformatter::Formatter::Print(_formatter->writeAuxiliaryFile(auxiliaryFile.path()));
 
             if (!_dryRun) {
-                if (!filesystem->write(auxiliaryFile.contents(), auxiliaryFile.path())) {
+                /* Rewriting unchanged contents would make its users out of date. */
+                std::vector<uint8_t> contents;
+                bool unchanged = (filesystem->exists(auxiliaryFile.path()) && filesystem->read(&contents, auxiliaryFile.path()) && contents == auxiliaryFile.contents());
+                if (!unchanged && !filesystem->write(auxiliaryFile.contents(), auxiliaryFile.path())) {
                     return false;
                 }
             }
@@ -195,7 +290,8 @@ performInvocations(
     pbxproj::PBX::Target::shared_ptr const &target,
     pbxbuild::Target::Environment const &targetEnvironment,
     std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
-    bool createProductStructure)
+    bool createProductStructure,
+    BuildState *buildState)
 {
     for (pbxbuild::Tool::Invocation const &invocation : orderedInvocations) {
         // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
@@ -207,6 +303,10 @@ performInvocations(
             continue;
         }
 
+        if (buildState->upToDate(filesystem, invocation)) {
+            continue;
+        }
+
         std::map<std::string, std::string> sortedEnvironment = std::map<std::string, std::string>(invocation.environment().begin(), invocation.environment().end());
 
         xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, invocation.executable().displayName(), createProductStructure));
@@ -220,26 +320,54 @@ performInvocations(
                 }
             }
 
-            if (!invocation.executable().builtin().empty()) {
-                /* For built-in tools, run them in-process. */
-                std::shared_ptr<builtin::Driver> driver = _builtins.driver(invocation.executable().builtin());
-                if (driver == nullptr) {
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, invocation.executable().displayName(), createProductStructure));
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
-                }
+            /* Forget the last run, in case this one fails. */
+            buildState->remove(invocation);
+            uint64_t started = BuildState::Now();
 
-                if (driver->run(invocation.arguments(), invocation.environment(), filesystem, invocation.workingDirectory()) != 0) {
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, invocation.executable().displayName(), createProductStructure));
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
-                }
+            ext::optional<std::string> cacheKey;
+            if (_actionCache != nullptr) {
+                cacheKey = _actionCache->key(filesystem, invocation);
+            }
+
+            /* Warnings from a restored run are shown again. */
+            std::string error;
+            bool restored = (cacheKey && _actionCache->restore(filesystem, invocation, *cacheKey, &error));
+            if (restored) {
+                fputs(error.c_str(), stderr);
             } else {
-                /* External tool, run the tool externally. */
-                Subprocess process;
-                if (!process.execute(invocation.executable().path(), invocation.arguments(), invocation.environment(), invocation.workingDirectory()) || process.exitcode() != 0) {
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, invocation.executable().displayName(), createProductStructure));
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+                if (!invocation.executable().builtin().empty()) {
+                    /* For built-in tools, run them in-process. */
+                    std::shared_ptr<builtin::Driver> driver = _builtins.driver(invocation.executable().builtin());
+                    if (driver == nullptr) {
+                        xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, invocation.executable().displayName(), createProductStructure));
+                        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+                    }
+
+                    int exitcode = RunBuiltin(driver.get(), invocation, filesystem, cacheKey ? &error : nullptr);
+                    fputs(error.c_str(), stderr);
+                    if (exitcode != 0) {
+                        xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, invocation.executable().displayName(), createProductStructure));
+                        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+                    }
+                } else {
+                    /* External tool, run the tool externally. */
+                    Subprocess process;
+                    bool launched = (process.launch(invocation.executable().path(), invocation.arguments(), invocation.environment(), invocation.workingDirectory(), nullptr, false, static_cast<bool>(cacheKey)) && process.wait());
+                    error = process.error();
+                    fputs(error.c_str(), stderr);
+                    if (!launched || process.exitcode() != 0) {
+                        xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, invocation.executable().displayName(), createProductStructure));
+                        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+                    }
+                }
+
+                if (cacheKey) {
+                    /* Not every run can be stored; those just run again next time. */
+                    _actionCache->store(filesystem, invocation, *cacheKey, started, error);
                 }
             }
+
+            buildState->record(filesystem, invocation, started);
         }
 
         xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, invocation.executable().displayName(), createProductStructure));
@@ -265,14 +393,23 @@ buildTarget(
         return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
     }
 
+    /*
+     * Whatever ran is recorded, even if the build fails partway through.
+     */
+    BuildState buildState = BuildState::Load(filesystem, targetEnvironment);
+
     xcformatter::Formatter::Print(_formatter->beginCreateProductStructure(target));
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> structureResult = performInvocations(filesystem, target, targetEnvironment, *orderedInvocations, true);
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> structureResult = performInvocations(filesystem, target, targetEnvironment, *orderedInvocations, true, &buildState);
     xcformatter::Formatter::Print(_formatter->finishCreateProductStructure(target));
     if (!structureResult.first) {
+        buildState.store(filesystem);
         return structureResult;
     }
 
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> invocationsResult = performInvocations(filesystem, target, targetEnvironment, *orderedInvocations, false);
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> invocationsResult = performInvocations(filesystem, target, targetEnvironment, *orderedInvocations, false, &buildState);
+    if (!buildState.store(filesystem)) {
+        fprintf(stderr, "warning: unable to write build state for %s\n", target->name().c_str());
+    }
     if (!invocationsResult.first) {
         return invocationsResult;
     }
@@ -281,11 +418,13 @@ buildTarget(
 }
 
 std::unique_ptr<SimpleExecutor> SimpleExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, std::shared_ptr<ActionCache> const &actionCache, size_t jobs)
 {
     return std::unique_ptr<SimpleExecutor>(new SimpleExecutor(
         formatter,
         dryRun,
-        builtins
+        builtins,
+        actionCache,
+        jobs
     ));
 }
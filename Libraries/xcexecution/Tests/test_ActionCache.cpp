@@ -0,0 +1,412 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/BuildState.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/test/TemporaryDirectory.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using xcexecution::ActionCache;
+using xcexecution::BuildState;
+using pbxbuild::Tool::Invocation;
+using libutil::DefaultFilesystem;
+using libutil::test::TemporaryDirectory;
+
+static void
+WriteFile(std::string const &path, std::string const &contents, mode_t mode = 0644)
+{
+    ::unlink(path.c_str());
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode);
+    ASSERT_NE(-1, fd);
+    EXPECT_EQ(static_cast<ssize_t>(contents.size()), ::write(fd, contents.data(), contents.size()));
+    ::close(fd);
+}
+
+static std::string
+ReadFile(std::string const &path)
+{
+    DefaultFilesystem filesystem;
+    std::vector<uint8_t> contents;
+    if (!filesystem.read(&contents, path)) {
+        return std::string();
+    }
+    return std::string(contents.begin(), contents.end());
+}
+
+/*
+ * Fills a directory with:
+ *
+ *   input.c
+ *   header.h
+ *   input.d (input.o depends on input.c and header.h)
+ */
+static void
+CreateRoot(std::string const &root)
+{
+    WriteFile(root + "/input.c", "#include \"header.h\"");
+    WriteFile(root + "/header.h", "int one;");
+    WriteFile(root + "/input.d", root + "/input.o: " + root + "/input.c " + root + "/header.h\n");
+}
+
+/*
+ * Marks every file in a directory as last used long ago.
+ */
+static void
+Age(DefaultFilesystem const *filesystem, std::string const &path)
+{
+    struct timeval times[2] = { { 946684800, 0 }, { 946684800, 0 } };
+    filesystem->enumerateRecursive(path, [&](std::string const &file) -> bool {
+        if (!filesystem->isDirectory(file)) {
+            EXPECT_EQ(0, ::utimes(file.c_str(), times));
+        }
+        return true;
+    });
+}
+
+/*
+ * Compiles an input, discovering the header it includes.
+ */
+static Invocation
+CompileInvocation(std::string const &root, std::string const &name = "input")
+{
+    Invocation invocation;
+    invocation.executable() = Invocation::Executable::Builtin("builtin-compile");
+    invocation.arguments() = { "-c", root + "/" + name + ".c", "-o", root + "/" + name + ".o" };
+    invocation.environment() = { { "PATH", "/usr/bin" }, { "PWD", root }, { "TERM", "xterm" } };
+    invocation.workingDirectory() = root;
+    invocation.inputs() = { root + "/" + name + ".c" };
+    invocation.outputs() = { root + "/" + name + ".o" };
+    invocation.dependencyInfo() = { Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, root + "/" + name + ".d") };
+    return invocation;
+}
+
+/*
+ * Runs an invocation, by writing its output, and stores the run.
+ */
+static bool
+Store(DefaultFilesystem const *filesystem, ActionCache const *cache, Invocation const &invocation, std::string const &output, mode_t mode = 0644)
+{
+    ext::optional<std::string> key = cache->key(filesystem, invocation);
+    if (!key) {
+        return false;
+    }
+
+    uint64_t started = BuildState::Now();
+    WriteFile(invocation.outputs().front(), output, mode);
+    return cache->store(filesystem, invocation, *key, started);
+}
+
+/*
+ * Removes the outputs of an invocation, then restores them from the cache.
+ */
+static bool
+Restore(DefaultFilesystem const *filesystem, ActionCache const *cache, Invocation const &invocation)
+{
+    ext::optional<std::string> key = cache->key(filesystem, invocation);
+    if (!key) {
+        return false;
+    }
+
+    ::unlink(invocation.outputs().front().c_str());
+    return cache->restore(filesystem, invocation, *key);
+}
+
+TEST(ActionCache, KeyIgnoresSessionEnvironment)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, cache);
+
+    Invocation invocation = CompileInvocation(root);
+    ext::optional<std::string> key = cache->key(&filesystem, invocation);
+    ASSERT_NE(ext::nullopt, key);
+
+    /* Variables describing the terminal or shell don't affect the key. */
+    Invocation session = invocation;
+    session.environment()["PWD"] = "/";
+    session.environment()["TERM"] = "dumb";
+    session.environment()["SHLVL"] = "2";
+    EXPECT_EQ(key, cache->key(&filesystem, session));
+
+    /* Other variables do. */
+    Invocation environment = invocation;
+    environment.environment()["PATH"] = "/bin";
+    EXPECT_NE(key, cache->key(&filesystem, environment));
+
+    /* As do the contents of declared inputs. */
+    WriteFile(root + "/input.c", "int main;");
+    EXPECT_NE(key, cache->key(&filesystem, invocation));
+}
+
+TEST(ActionCache, Uncacheable)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, cache);
+
+    Invocation script = CompileInvocation(root);
+    script.executable() = Invocation::Executable::Absolute("/bin/sh");
+    EXPECT_EQ(ext::nullopt, cache->key(&filesystem, script));
+
+    Invocation phony = CompileInvocation(root);
+    phony.phonyInputs() = { root + "/missing" };
+    EXPECT_EQ(ext::nullopt, cache->key(&filesystem, phony));
+
+    Invocation directory = CompileInvocation(root);
+    directory.inputs() = { root + "/Cache" };
+    EXPECT_EQ(ext::nullopt, cache->key(&filesystem, directory));
+}
+
+TEST(ActionCache, HitAndMiss)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, cache);
+
+    Invocation invocation = CompileInvocation(root);
+
+    /* Nothing stored yet. */
+    EXPECT_FALSE(Restore(&filesystem, cache.get(), invocation));
+    EXPECT_FALSE(filesystem.exists(root + "/input.o"));
+
+    EXPECT_TRUE(Store(&filesystem, cache.get(), invocation, "one"));
+    EXPECT_TRUE(Restore(&filesystem, cache.get(), invocation));
+    EXPECT_EQ("one", ReadFile(root + "/input.o"));
+
+    /* A restored output can be modified without changing the cache. */
+    WriteFile(root + "/input.o", "modified");
+    EXPECT_TRUE(Restore(&filesystem, cache.get(), invocation));
+    EXPECT_EQ("one", ReadFile(root + "/input.o"));
+
+    /* A changed input is a different key. */
+    WriteFile(root + "/input.c", "int main;");
+    EXPECT_FALSE(Restore(&filesystem, cache.get(), invocation));
+}
+
+TEST(ActionCache, ErrorOutput)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, cache);
+
+    Invocation invocation = CompileInvocation(root);
+    ext::optional<std::string> key = cache->key(&filesystem, invocation);
+    ASSERT_NE(ext::nullopt, key);
+
+    /* Warnings from the stored run are returned when it's restored. */
+    uint64_t started = BuildState::Now();
+    WriteFile(root + "/input.o", "one");
+    EXPECT_TRUE(cache->store(&filesystem, invocation, *key, started, "warning: unused variable\n"));
+
+    std::string error;
+    EXPECT_TRUE(cache->restore(&filesystem, invocation, *key, &error));
+    EXPECT_EQ("warning: unused variable\n", error);
+
+    /* A run without any replaces it. */
+    EXPECT_TRUE(cache->store(&filesystem, invocation, *key, started));
+    EXPECT_TRUE(cache->restore(&filesystem, invocation, *key, &error));
+    EXPECT_EQ("", error);
+}
+
+TEST(ActionCache, ChangedDiscoveredHeader)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, cache);
+
+    Invocation invocation = CompileInvocation(root);
+    EXPECT_TRUE(Store(&filesystem, cache.get(), invocation, "one"));
+
+    /* The header isn't a declared input, so the key is the same, but the run doesn't match. */
+    ext::optional<std::string> key = cache->key(&filesystem, invocation);
+    WriteFile(root + "/header.h", "int two;");
+    EXPECT_EQ(key, cache->key(&filesystem, invocation));
+    EXPECT_FALSE(Restore(&filesystem, cache.get(), invocation));
+
+    WriteFile(root + "/header.h", "int one;");
+    EXPECT_TRUE(Restore(&filesystem, cache.get(), invocation));
+    EXPECT_EQ("one", ReadFile(root + "/input.o"));
+}
+
+TEST(ActionCache, MultipleEntries)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, cache);
+
+    /* Runs with each version of the header are kept under the same key. */
+    Invocation invocation = CompileInvocation(root);
+    EXPECT_TRUE(Store(&filesystem, cache.get(), invocation, "one"));
+    WriteFile(root + "/header.h", "int two;");
+    EXPECT_TRUE(Store(&filesystem, cache.get(), invocation, "two"));
+
+    WriteFile(root + "/header.h", "int one;");
+    EXPECT_TRUE(Restore(&filesystem, cache.get(), invocation));
+    EXPECT_EQ("one", ReadFile(root + "/input.o"));
+
+    WriteFile(root + "/header.h", "int two;");
+    EXPECT_TRUE(Restore(&filesystem, cache.get(), invocation));
+    EXPECT_EQ("two", ReadFile(root + "/input.o"));
+
+    WriteFile(root + "/header.h", "int three;");
+    EXPECT_FALSE(Restore(&filesystem, cache.get(), invocation));
+}
+
+TEST(ActionCache, ExecutableBit)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+
+    for (bool hardlink : { false, true }) {
+        std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX, hardlink);
+        ASSERT_NE(nullptr, cache);
+
+        Invocation executable = CompileInvocation(root);
+        EXPECT_TRUE(Store(&filesystem, cache.get(), executable, "binary", 0755));
+        EXPECT_TRUE(Restore(&filesystem, cache.get(), executable));
+        EXPECT_TRUE(filesystem.isExecutable(root + "/input.o"));
+
+        /* The same contents without the executable bit are a separate object. */
+        WriteFile(root + "/input.c", "int main;");
+        EXPECT_TRUE(Store(&filesystem, cache.get(), executable, "binary", 0644));
+        EXPECT_TRUE(Restore(&filesystem, cache.get(), executable));
+        EXPECT_FALSE(filesystem.isExecutable(root + "/input.o"));
+
+        WriteFile(root + "/input.c", "#include \"header.h\"");
+    }
+}
+
+TEST(ActionCache, EvictLeastRecentlyUsed)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, cache);
+
+    WriteFile(root + "/other.c", "int other;");
+    WriteFile(root + "/other.d", root + "/other.o: " + root + "/other.c\n");
+
+    Invocation old = CompileInvocation(root);
+    Invocation recent = CompileInvocation(root, "other");
+
+    EXPECT_TRUE(Store(&filesystem, cache.get(), old, "old"));
+    uint64_t oldSize = cache->statistics().size;
+
+    /* Everything stored so far was last used long ago. */
+    Age(&filesystem, root + "/Cache");
+
+    EXPECT_TRUE(Store(&filesystem, cache.get(), recent, "recent"));
+    uint64_t size = cache->statistics().size;
+    EXPECT_GT(size, oldSize);
+
+    EXPECT_TRUE(cache->evict(size - oldSize));
+    EXPECT_LE(cache->statistics().size, size - oldSize);
+    EXPECT_LT(0u, cache->statistics().evictions);
+
+    EXPECT_FALSE(Restore(&filesystem, cache.get(), old));
+    EXPECT_TRUE(Restore(&filesystem, cache.get(), recent));
+    EXPECT_EQ("recent", ReadFile(root + "/other.o"));
+}
+
+TEST(ActionCache, EvictWhenFull)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+
+    /* Stores past the maximum size trim the cache. */
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", 1);
+    ASSERT_NE(nullptr, cache);
+
+    Invocation invocation = CompileInvocation(root);
+    EXPECT_TRUE(Store(&filesystem, cache.get(), invocation, "one"));
+    EXPECT_EQ(0u, cache->statistics().size);
+    EXPECT_FALSE(Restore(&filesystem, cache.get(), invocation));
+}
+
+TEST(ActionCache, Statistics)
+{
+    DefaultFilesystem filesystem;
+    TemporaryDirectory temporary("test_ActionCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+    std::shared_ptr<ActionCache> cache = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, cache);
+
+    ActionCache::Statistics statistics = cache->statistics();
+    EXPECT_EQ(0u, statistics.hits);
+    EXPECT_EQ(0u, statistics.misses);
+    EXPECT_EQ(0u, statistics.stores);
+    EXPECT_EQ(0u, statistics.size);
+
+    Invocation invocation = CompileInvocation(root);
+    EXPECT_FALSE(Restore(&filesystem, cache.get(), invocation));
+    EXPECT_TRUE(Store(&filesystem, cache.get(), invocation, "one"));
+    EXPECT_TRUE(Restore(&filesystem, cache.get(), invocation));
+    EXPECT_TRUE(Restore(&filesystem, cache.get(), invocation));
+
+    /* Shared by every instance using the cache. */
+    std::shared_ptr<ActionCache> other = ActionCache::Open(root + "/Cache", UINT64_MAX);
+    ASSERT_NE(nullptr, other);
+
+    statistics = other->statistics();
+    EXPECT_EQ(2u, statistics.hits);
+    EXPECT_EQ(1u, statistics.misses);
+    EXPECT_EQ(1u, statistics.stores);
+    EXPECT_EQ(0u, statistics.evictions);
+    EXPECT_LT(0u, statistics.size);
+
+    /* Resetting keeps the size, which describes the cache, not its use. */
+    EXPECT_TRUE(other->resetStatistics());
+    ActionCache::Statistics reset = cache->statistics();
+    EXPECT_EQ(0u, reset.hits);
+    EXPECT_EQ(0u, reset.misses);
+    EXPECT_EQ(0u, reset.stores);
+    EXPECT_EQ(statistics.size, reset.size);
+}
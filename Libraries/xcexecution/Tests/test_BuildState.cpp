@@ -0,0 +1,222 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/BuildState.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::BuildState;
+using pbxbuild::Tool::Invocation;
+using libutil::MemoryFilesystem;
+
+/* Nanoseconds in a second, for modification times. */
+static uint64_t const Second = 1000000000ull;
+
+/* The directory containing the files built. */
+static std::string const Root = "/Project";
+
+/*
+ * A file written at 1000 seconds after the epoch.
+ */
+static MemoryFilesystem::Entry
+File(std::string const &name, std::string const &contents)
+{
+    MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, std::vector<uint8_t>(contents.begin(), contents.end()));
+    file.modified() = 1000 * Second;
+    return file;
+}
+
+/*
+ * A filesystem with a directory containing:
+ *
+ *   input.c
+ *   header.h
+ *   input.o
+ *   input.d (input.o depends on input.c and header.h)
+ */
+static MemoryFilesystem
+CreateFilesystem()
+{
+    return MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Project", {
+            File("input.c", "#include \"header.h\""),
+            File("header.h", ""),
+            File("input.o", ""),
+            File("input.d", Root + "/input.o: " + Root + "/input.c " + Root + "/header.h\n"),
+        }),
+    });
+}
+
+/*
+ * Writes a file, which is then newer than any file the filesystem started with.
+ */
+static void
+WriteFile(MemoryFilesystem *filesystem, std::string const &path, std::string const &contents)
+{
+    EXPECT_TRUE(filesystem->write(std::vector<uint8_t>(contents.begin(), contents.end()), path));
+}
+
+/*
+ * Compiles the input, discovering the header it includes.
+ */
+static Invocation
+CompileInvocation()
+{
+    Invocation invocation;
+    invocation.executable() = Invocation::Executable::Absolute("/usr/bin/cc");
+    invocation.arguments() = { "-c", Root + "/input.c", "-o", Root + "/input.o", "-MD" };
+    invocation.workingDirectory() = Root;
+    invocation.inputs() = { Root + "/input.c" };
+    invocation.outputs() = { Root + "/input.o" };
+    invocation.dependencyInfo() = { Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, Root + "/input.d") };
+    return invocation;
+}
+
+/*
+ * A script phase, as resolved for a Run Script build phase.
+ */
+static Invocation
+ScriptInvocation()
+{
+    Invocation invocation;
+    invocation.executable() = Invocation::Executable::Absolute("/bin/sh");
+    invocation.arguments() = { "-c", Root + "/Script.sh" };
+    invocation.workingDirectory() = Root;
+    invocation.phonyInputs() = { Root + "/input.c" };
+    invocation.outputs() = { Root + "/input.o" };
+    invocation.auxiliaryFiles() = { Invocation::AuxiliaryFile(Root + "/Script.sh", "cp input.c input.o", true) };
+    return invocation;
+}
+
+/*
+ * Records an invocation as having run, starting after every file was written.
+ */
+static BuildState
+Recorded(MemoryFilesystem const *filesystem, Invocation const &invocation)
+{
+    BuildState buildState = BuildState(Root + "/BuildState.plist");
+    buildState.record(filesystem, invocation, 2000 * Second);
+    return buildState;
+}
+
+TEST(BuildState, NoOpRebuild)
+{
+    MemoryFilesystem filesystem = CreateFilesystem();
+    Invocation invocation = CompileInvocation();
+
+    BuildState buildState = BuildState(Root + "/BuildState.plist");
+    EXPECT_FALSE(buildState.upToDate(&filesystem, invocation));
+
+    buildState.record(&filesystem, invocation, 2000 * Second);
+    EXPECT_TRUE(buildState.upToDate(&filesystem, invocation));
+
+    /* Storing the log changes nothing the invocation uses. */
+    EXPECT_TRUE(buildState.store(&filesystem));
+    EXPECT_TRUE(filesystem.exists(Root + "/BuildState.plist"));
+    EXPECT_TRUE(buildState.upToDate(&filesystem, invocation));
+
+    /* Forgotten invocations run. */
+    buildState.remove(invocation);
+    EXPECT_FALSE(buildState.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildState, ChangedInput)
+{
+    MemoryFilesystem filesystem = CreateFilesystem();
+    Invocation invocation = CompileInvocation();
+
+    BuildState buildState = Recorded(&filesystem, invocation);
+    WriteFile(&filesystem, Root + "/input.c", "int main;");
+    EXPECT_FALSE(buildState.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildState, ChangedHeader)
+{
+    MemoryFilesystem filesystem = CreateFilesystem();
+    Invocation invocation = CompileInvocation();
+
+    /* The header is only known from the dependency info. */
+    BuildState buildState = Recorded(&filesystem, invocation);
+    WriteFile(&filesystem, Root + "/header.h", "int x;");
+    EXPECT_FALSE(buildState.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildState, ChangedCommand)
+{
+    MemoryFilesystem filesystem = CreateFilesystem();
+    Invocation invocation = CompileInvocation();
+
+    BuildState buildState = Recorded(&filesystem, invocation);
+
+    Invocation arguments = invocation;
+    arguments.arguments().push_back("-O2");
+    EXPECT_FALSE(buildState.upToDate(&filesystem, arguments));
+
+    Invocation environment = invocation;
+    environment.environment().insert({ "CC_FLAGS", "-O2" });
+    EXPECT_FALSE(buildState.upToDate(&filesystem, environment));
+
+    EXPECT_TRUE(buildState.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildState, MissingOutput)
+{
+    MemoryFilesystem filesystem = CreateFilesystem();
+    Invocation invocation = CompileInvocation();
+
+    BuildState buildState = Recorded(&filesystem, invocation);
+    EXPECT_TRUE(filesystem.removeFile(Root + "/input.o"));
+    EXPECT_FALSE(buildState.upToDate(&filesystem, invocation));
+
+    /* An output that didn't exist when recorded can't be trusted either. */
+    buildState.record(&filesystem, invocation, 2000 * Second);
+    WriteFile(&filesystem, Root + "/input.o", "");
+    EXPECT_FALSE(buildState.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildState, InputEditedDuringRun)
+{
+    MemoryFilesystem filesystem = CreateFilesystem();
+    Invocation invocation = CompileInvocation();
+
+    /* The input was written after the invocation started, so may not have been seen. */
+    BuildState buildState = BuildState(Root + "/BuildState.plist");
+    buildState.record(&filesystem, invocation, 500 * Second);
+    EXPECT_FALSE(buildState.upToDate(&filesystem, invocation));
+}
+
+TEST(BuildState, ScriptPhase)
+{
+    MemoryFilesystem filesystem = CreateFilesystem();
+    Invocation invocation = ScriptInvocation();
+
+    /* Scripts can use files they don't declare, so always run. */
+    BuildState buildState = Recorded(&filesystem, invocation);
+    EXPECT_FALSE(buildState.upToDate(&filesystem, invocation));
+
+    /* Nothing is remembered for them. */
+    EXPECT_TRUE(buildState.store(&filesystem));
+    EXPECT_FALSE(filesystem.exists(Root + "/BuildState.plist"));
+}
+
+TEST(BuildState, ChangedAuxiliaryFile)
+{
+    MemoryFilesystem filesystem = CreateFilesystem();
+
+    /* A tool reading a file written for it, which isn't a declared input. */
+    Invocation invocation = CompileInvocation();
+    invocation.auxiliaryFiles() = { Invocation::AuxiliaryFile(Root + "/input.LinkFileList", Root + "/input.c\n", false) };
+
+    BuildState buildState = Recorded(&filesystem, invocation);
+    EXPECT_TRUE(buildState.upToDate(&filesystem, invocation));
+
+    Invocation changed = invocation;
+    changed.auxiliaryFiles() = { Invocation::AuxiliaryFile(Root + "/input.LinkFileList", Root + "/header.h\n", false) };
+    EXPECT_FALSE(buildState.upToDate(&filesystem, changed));
+}
@@ -0,0 +1,175 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/ParallelExecutor.h>
+#include <xcformatter/DefaultFormatter.h>
+#include <builtin/Driver.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxsetting/Environment.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <algorithm>
+#include <mutex>
+
+using xcexecution::ParallelExecutor;
+using pbxbuild::Tool::Invocation;
+using libutil::MemoryFilesystem;
+
+/*
+ * Records the first argument of each run, failing if it is "fail".
+ */
+class RecordDriver : public builtin::Driver {
+public:
+    std::mutex               mutex;
+    std::vector<std::string> runs;
+
+public:
+    virtual std::string name()
+    { return "record"; }
+
+    virtual int run(std::vector<std::string> const &args, std::unordered_map<std::string, std::string> const &environment, libutil::Filesystem *filesystem, std::string const &workingDirectory)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        runs.push_back(args.front());
+        return (args.size() > 1 && args[1] == "fail" ? 1 : 0);
+    }
+
+public:
+    size_t index(std::string const &name)
+    {
+        return std::find(runs.begin(), runs.end(), name) - runs.begin();
+    }
+};
+
+static Invocation
+RecordInvocation(std::string const &name, std::vector<std::string> const &inputs, bool fail = false)
+{
+    Invocation invocation;
+    invocation.executable() = Invocation::Executable::Builtin("record");
+    invocation.arguments() = { name };
+    if (fail) {
+        invocation.arguments().push_back("fail");
+    }
+    invocation.workingDirectory() = "/";
+    invocation.inputs() = inputs;
+    invocation.outputs() = { "/Build/" + name };
+    return invocation;
+}
+
+/*
+ * A project containing an aggregate target for each name.
+ */
+static MemoryFilesystem
+ProjectFilesystem(std::vector<std::string> const &names)
+{
+    std::string objects;
+    std::string targets;
+    for (std::string const &name : names) {
+        objects += name + " = { isa = PBXAggregateTarget; name = " + name + "; buildPhases = (); dependencies = (); };";
+        targets += name + ",";
+    }
+
+    std::string contents = "{ \
+        archiveVersion = 1; \
+        objectVersion = 46; \
+        objects = { \
+            P = { isa = PBXProject; mainGroup = G; targets = (" + targets + "); }; \
+            G = { isa = PBXGroup; children = (); sourceTree = \"<group>\"; }; \
+            " + objects + " \
+        }; \
+        rootObject = P; \
+    }";
+
+    return MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Project.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", std::vector<uint8_t>(contents.begin(), contents.end())),
+        }),
+        MemoryFilesystem::Entry::Directory("Build", { }),
+    });
+}
+
+static std::pair<bool, std::vector<Invocation>>
+Build(
+    MemoryFilesystem *filesystem,
+    pbxproj::PBX::Project::shared_ptr const &project,
+    std::shared_ptr<RecordDriver> const &driver,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<std::pair<pbxproj::PBX::Target::shared_ptr, std::vector<Invocation>>> const &targetInvocations)
+{
+    pbxbuild::WorkspaceContext workspaceContext = pbxbuild::WorkspaceContext::Project(filesystem, pbxsetting::Environment(), project);
+    pbxbuild::Build::Context buildContext = pbxbuild::Build::Context(workspaceContext, nullptr, nullptr, "build", "Debug", false, { });
+
+    std::unique_ptr<ParallelExecutor> executor = ParallelExecutor::Create(xcformatter::DefaultFormatter::Create(false), false, builtin::Registry::Create({ driver }), 4);
+    return executor->buildTargets(filesystem, buildContext, targetGraph, targetInvocations);
+}
+
+TEST(ParallelExecutor, DependencyOrder)
+{
+    /*
+     * B depends on A; C is independent. Within A, a2 uses the output of a1.
+     */
+    auto filesystem = ProjectFilesystem({ "A", "B", "C" });
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/Project.xcodeproj");
+    ASSERT_NE(nullptr, project);
+
+    pbxproj::PBX::Target::shared_ptr A = project->targets()[0];
+    pbxproj::PBX::Target::shared_ptr B = project->targets()[1];
+    pbxproj::PBX::Target::shared_ptr C = project->targets()[2];
+
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> targetGraph;
+    targetGraph.insert(A, { });
+    targetGraph.insert(B, { A });
+    targetGraph.insert(C, { });
+
+    auto driver = std::make_shared<RecordDriver>();
+    auto result = Build(&filesystem, project, driver, targetGraph, {
+        { A, { RecordInvocation("a2", { "/Build/a1" }), RecordInvocation("a1", { }) } },
+        { B, { RecordInvocation("b1", { }) } },
+        { C, { RecordInvocation("c1", { }) } },
+    });
+
+    EXPECT_TRUE(result.first);
+    EXPECT_TRUE(result.second.empty());
+
+    ASSERT_EQ(4, driver->runs.size());
+    EXPECT_LT(driver->index("a1"), driver->index("a2"));
+    EXPECT_LT(driver->index("a2"), driver->index("b1"));
+    EXPECT_LT(driver->index("c1"), driver->runs.size());
+}
+
+TEST(ParallelExecutor, FailurePropagation)
+{
+    /*
+     * a1 fails, so neither a2, which uses its output, nor B, which depends
+     * on A, can run.
+     */
+    auto filesystem = ProjectFilesystem({ "A", "B" });
+    pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(&filesystem, "/Project.xcodeproj");
+    ASSERT_NE(nullptr, project);
+
+    pbxproj::PBX::Target::shared_ptr A = project->targets()[0];
+    pbxproj::PBX::Target::shared_ptr B = project->targets()[1];
+
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> targetGraph;
+    targetGraph.insert(A, { });
+    targetGraph.insert(B, { A });
+
+    auto driver = std::make_shared<RecordDriver>();
+    auto result = Build(&filesystem, project, driver, targetGraph, {
+        { A, { RecordInvocation("a1", { }, true), RecordInvocation("a2", { "/Build/a1" }) } },
+        { B, { RecordInvocation("b1", { }) } },
+    });
+
+    EXPECT_FALSE(result.first);
+    ASSERT_EQ(1, result.second.size());
+    EXPECT_EQ(std::vector<std::string>({ "a1", "fail" }), result.second.front().arguments());
+
+    EXPECT_EQ(std::vector<std::string>({ "a1" }), driver->runs);
+}
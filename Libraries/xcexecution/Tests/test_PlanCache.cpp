@@ -0,0 +1,218 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/PlanCache.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/MemoryFilesystem.h>
+#include <libutil/test/TemporaryDirectory.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using xcexecution::PlanCache;
+using pbxbuild::Build::DirectoryTreeCache;
+using pbxbuild::Tool::Invocation;
+using libutil::DefaultFilesystem;
+using libutil::MemoryFilesystem;
+using libutil::test::TemporaryDirectory;
+
+/*
+ * A build of a single target, with the caches a build would have. Each build
+ * starts with fresh caches, since they remember what they found on disk.
+ */
+class TestBuild {
+public:
+    pbxspec::Manager::shared_ptr specManager;
+    DirectoryTreeCache           directoryTreeCache;
+    PlanCache                    planCache;
+    PlanCache::TargetInputs      targetInputs;
+
+public:
+    explicit TestBuild(std::string const &root, std::string const &key = "key") :
+        specManager(SpecManager()),
+        planCache  (key, specManager, &directoryTreeCache)
+    {
+        targetInputs.path = root + "/Plans/Target.plist";
+        targetInputs.key = planCache.key();
+        targetInputs.executablePaths = { root + "/bin1", root + "/bin2" };
+        targetInputs.specDomains = { "test" };
+    }
+
+private:
+    /*
+     * A file type for text files, and another for directories with the same
+     * extension, so a file's type depends on what is on disk.
+     */
+    static pbxspec::Manager::shared_ptr
+    SpecManager()
+    {
+        std::string contents = "( \
+            { Type = FileType; Identifier = test.text; Extensions = (txt); }, \
+            { Type = FileType; Identifier = test.folder; Extensions = (txt); IsFolder = YES; }, \
+        )";
+
+        auto filesystem = MemoryFilesystem({
+            MemoryFilesystem::Entry::File("Types.xcspec", std::vector<uint8_t>(contents.begin(), contents.end())),
+        });
+
+        pbxspec::Manager::shared_ptr specManager = pbxspec::Manager::Create();
+        specManager->registerDomains(&filesystem, { { "test", "/Types.xcspec" } });
+        return specManager;
+    }
+};
+
+/*
+ * Fills a directory with:
+ *
+ *   bin1/
+ *   bin2/tool (executable)
+ *   input.txt
+ *   tree/a/
+ */
+static void
+CreateRoot(std::string const &root)
+{
+    DefaultFilesystem filesystem;
+    EXPECT_TRUE(filesystem.createDirectory(root + "/bin1"));
+    EXPECT_TRUE(filesystem.createDirectory(root + "/bin2"));
+    EXPECT_TRUE(filesystem.write(std::vector<uint8_t>(), root + "/bin2/tool"));
+    EXPECT_EQ(0, ::chmod((root + "/bin2/tool").c_str(), 0755));
+    EXPECT_TRUE(filesystem.write(std::vector<uint8_t>(), root + "/input.txt"));
+    EXPECT_TRUE(filesystem.createDirectory(root + "/tree/a"));
+}
+
+/*
+ * Compiles the input with the tool, and links the result.
+ */
+static std::vector<Invocation>
+Invocations(std::string const &root)
+{
+    Invocation compile;
+    compile.executable() = Invocation::Executable::Absolute(root + "/bin2/tool");
+    compile.arguments() = { "-c", root + "/input.txt", "-o", root + "/input.o" };
+    compile.inputs() = { root + "/input.txt" };
+    compile.outputs() = { root + "/input.o" };
+
+    Invocation link;
+    link.executable() = Invocation::Executable::Builtin("builtin-link");
+    link.arguments() = { root + "/input.o" };
+    link.inputs() = { root + "/input.o" };
+    link.outputs() = { root + "/output" };
+
+    return { compile, link };
+}
+
+/*
+ * Plans the target in a new build: walks a recursive search path, then
+ * stores the invocations.
+ */
+static void
+Plan(std::string const &root)
+{
+    DefaultFilesystem filesystem;
+    TestBuild build(root);
+    build.directoryTreeCache.directories(root + "/tree", DirectoryTreeCache::Filter({ }, { }, false));
+    EXPECT_TRUE(build.planCache.store(&filesystem, build.targetInputs, Invocations(root)));
+}
+
+/*
+ * Loads the target's plan in a new build.
+ */
+static ext::optional<std::vector<Invocation>>
+Load(std::string const &root, std::string const &key = "key")
+{
+    DefaultFilesystem filesystem;
+    TestBuild build(root, key);
+    return build.planCache.load(&filesystem, build.targetInputs);
+}
+
+TEST(PlanCache, Hit)
+{
+    TemporaryDirectory temporary("test_PlanCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+
+    Plan(root);
+
+    ext::optional<std::vector<Invocation>> invocations = Load(root);
+    ASSERT_NE(ext::nullopt, invocations);
+    ASSERT_EQ(2, invocations->size());
+
+    std::vector<Invocation> expected = Invocations(root);
+    for (size_t n = 0; n < expected.size(); n++) {
+        EXPECT_EQ(expected[n].executable().path(), (*invocations)[n].executable().path());
+        EXPECT_EQ(expected[n].executable().builtin(), (*invocations)[n].executable().builtin());
+        EXPECT_EQ(expected[n].arguments(), (*invocations)[n].arguments());
+        EXPECT_EQ(expected[n].inputs(), (*invocations)[n].inputs());
+        EXPECT_EQ(expected[n].outputs(), (*invocations)[n].outputs());
+    }
+
+    /* Producing an output the plan uses as an input changes nothing. */
+    ::close(::creat((root + "/input.o").c_str(), 0644));
+    EXPECT_NE(ext::nullopt, Load(root));
+}
+
+TEST(PlanCache, Miss)
+{
+    TemporaryDirectory temporary("test_PlanCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+
+    /* Nothing stored yet. */
+    EXPECT_EQ(ext::nullopt, Load(root));
+
+    /* Stored for different settings. */
+    Plan(root);
+    EXPECT_EQ(ext::nullopt, Load(root, "other"));
+}
+
+TEST(PlanCache, InvalidatedByTree)
+{
+    TemporaryDirectory temporary("test_PlanCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+
+    Plan(root);
+
+    ::mkdir((root + "/tree/b").c_str(), 0755);
+    EXPECT_EQ(ext::nullopt, Load(root));
+}
+
+TEST(PlanCache, InvalidatedByInputType)
+{
+    TemporaryDirectory temporary("test_PlanCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+
+    Plan(root);
+
+    ::unlink((root + "/input.txt").c_str());
+    ::mkdir((root + "/input.txt").c_str(), 0755);
+    EXPECT_EQ(ext::nullopt, Load(root));
+}
+
+TEST(PlanCache, InvalidatedByExecutable)
+{
+    TemporaryDirectory temporary("test_PlanCache");
+    std::string const &root = temporary.path();
+    ASSERT_FALSE(root.empty());
+    CreateRoot(root);
+
+    Plan(root);
+
+    /* A tool with the same name earlier in the executable paths. */
+    ::close(::creat((root + "/bin1/tool").c_str(), 0755));
+    EXPECT_EQ(ext::nullopt, Load(root));
+}
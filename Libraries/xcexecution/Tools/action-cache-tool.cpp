@@ -0,0 +1,380 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/BuildState.h>
+#include <pbxbuild/Tool/Invocation.h>
+#include <libutil/Options.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Subprocess.h>
+
+#include <cstdlib>
+
+extern char **environ;
+
+using xcexecution::ActionCache;
+using xcexecution::BuildState;
+using pbxbuild::Tool::Invocation;
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Subprocess;
+
+class Options {
+private:
+    bool        _help;
+    bool        _version;
+
+private:
+    std::string _cache;
+    std::string _maximumSize;
+    bool        _hardlink;
+    bool        _statistics;
+    bool        _resetStatistics;
+
+private:
+    std::vector<std::string> _inputs;
+    std::vector<std::string> _inputDependencies;
+    std::vector<std::string> _outputs;
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> _dependencyInfo;
+    std::vector<std::string> _auxiliaryFiles;
+
+private:
+    std::vector<std::string> _command;
+
+public:
+    Options();
+    ~Options();
+
+public:
+    bool help() const
+    { return _help; }
+    bool version() const
+    { return _version; }
+
+public:
+    std::string const &cache() const
+    { return _cache; }
+    std::string const &maximumSize() const
+    { return _maximumSize; }
+    bool hardlink() const
+    { return _hardlink; }
+    bool statistics() const
+    { return _statistics; }
+    bool resetStatistics() const
+    { return _resetStatistics; }
+
+public:
+    std::vector<std::string> const &inputs() const
+    { return _inputs; }
+    std::vector<std::string> const &inputDependencies() const
+    { return _inputDependencies; }
+    std::vector<std::string> const &outputs() const
+    { return _outputs; }
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> const &dependencyInfo() const
+    { return _dependencyInfo; }
+    std::vector<std::string> const &auxiliaryFiles() const
+    { return _auxiliaryFiles; }
+
+public:
+    std::vector<std::string> const &command() const
+    { return _command; }
+
+private:
+    friend class libutil::Options;
+    std::pair<bool, std::string>
+    parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it);
+};
+
+Options::
+Options() :
+    _help           (false),
+    _version        (false),
+    _hardlink       (false),
+    _statistics     (false),
+    _resetStatistics(false)
+{
+}
+
+Options::
+~Options()
+{
+}
+
+static std::pair<bool, std::string>
+NextStringList(std::vector<std::string> *result, std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string value;
+    std::pair<bool, std::string> success = libutil::Options::NextString(&value, args, it);
+    if (success.first) {
+        result->push_back(value);
+    }
+    return success;
+}
+
+std::pair<bool, std::string> Options::
+parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string const &arg = **it;
+
+    if (arg == "-h" || arg == "--help") {
+        return libutil::Options::MarkBool(&_help, arg, it);
+    } else if (arg == "-v" || arg == "--version") {
+        return libutil::Options::MarkBool(&_version, arg, it);
+    } else if (arg == "--cache") {
+        return libutil::Options::NextString(&_cache, args, it);
+    } else if (arg == "--maximum-size") {
+        return libutil::Options::NextString(&_maximumSize, args, it);
+    } else if (arg == "--hardlink") {
+        return libutil::Options::MarkBool(&_hardlink, arg, it);
+    } else if (arg == "--stats") {
+        return libutil::Options::MarkBool(&_statistics, arg, it);
+    } else if (arg == "--reset-stats") {
+        return libutil::Options::MarkBool(&_resetStatistics, arg, it);
+    } else if (arg == "--input") {
+        return NextStringList(&_inputs, args, it);
+    } else if (arg == "--input-dependency") {
+        return NextStringList(&_inputDependencies, args, it);
+    } else if (arg == "--output") {
+        return NextStringList(&_outputs, args, it);
+    } else if (arg == "--auxiliary-file") {
+        return NextStringList(&_auxiliaryFiles, args, it);
+    } else if (arg == "--dependency-info") {
+        std::string value;
+        std::pair<bool, std::string> success = libutil::Options::NextString(&value, args, it);
+        if (!success.first) {
+            return success;
+        }
+
+        std::string::size_type offset = value.find(':');
+        if (offset == std::string::npos || offset == 0 || offset == value.size() - 1) {
+            return std::make_pair(false, "unknown dependency info " + value + " (use format:/path/to/info)");
+        }
+
+        dependency::DependencyInfoFormat format;
+        if (!dependency::DependencyInfoFormats::Parse(value.substr(0, offset), &format)) {
+            return std::make_pair(false, "unknown format " + value.substr(0, offset));
+        }
+
+        _dependencyInfo.push_back({ format, value.substr(offset + 1) });
+        return std::make_pair(true, std::string());
+    } else if (arg == "--") {
+        /* The rest of the arguments are the command to run. */
+        _command = std::vector<std::string>(*it + 1, args.end());
+        *it = args.end() - 1;
+        return std::make_pair(true, std::string());
+    } else {
+        return std::make_pair(false, "unknown argument " + arg);
+    }
+}
+
+static int
+Help(std::string const &error = std::string())
+{
+    if (!error.empty()) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        fprintf(stderr, "\n");
+    }
+
+    fprintf(stderr, "Usage: action-cache-tool [options] -- command [arguments]\n\n");
+    fprintf(stderr, "Runs a command, restoring its outputs from a cache if possible.\n\n");
+
+#define INDENT "  "
+    fprintf(stderr, "Information:\n");
+    fprintf(stderr, INDENT "-h, --help\n");
+    fprintf(stderr, INDENT "-v, --version\n");
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "Cache Options:\n");
+    fprintf(stderr, INDENT "--cache\n");
+    fprintf(stderr, INDENT "--maximum-size\n");
+    fprintf(stderr, INDENT "--hardlink\n");
+    fprintf(stderr, INDENT "--stats\n");
+    fprintf(stderr, INDENT "--reset-stats\n");
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "Command Options:\n");
+    fprintf(stderr, INDENT "--input\n");
+    fprintf(stderr, INDENT "--input-dependency\n");
+    fprintf(stderr, INDENT "--output\n");
+    fprintf(stderr, INDENT "--dependency-info\n");
+    fprintf(stderr, INDENT "--auxiliary-file\n");
+    fprintf(stderr, "\n");
+#undef INDENT
+
+    return (error.empty() ? 0 : -1);
+}
+
+static int
+Version()
+{
+    printf("action-cache-tool version 1 (xcbuild)\n");
+    return 0;
+}
+
+static int
+Statistics(ActionCache const *actionCache)
+{
+    ActionCache::Statistics statistics = actionCache->statistics();
+    uint64_t lookups = statistics.hits + statistics.misses;
+
+    printf("Hits: %llu\n", static_cast<unsigned long long>(statistics.hits));
+    printf("Misses: %llu\n", static_cast<unsigned long long>(statistics.misses));
+    printf("Hit rate: %.1f%%\n", (lookups > 0 ? 100.0 * statistics.hits / lookups : 0.0));
+    printf("Stores: %llu\n", static_cast<unsigned long long>(statistics.stores));
+    printf("Evictions: %llu\n", static_cast<unsigned long long>(statistics.evictions));
+    printf("Size: %.1f MB\n", statistics.size / (1024.0 * 1024.0));
+    return 0;
+}
+
+/*
+ * Reconstructs the invocation the command was generated from. The working
+ * directory and environment are those the command is run with.
+ */
+static bool
+CreateInvocation(Filesystem const *filesystem, Options const &options, Invocation *invocation)
+{
+    invocation->executable() = Invocation::Executable::Absolute(options.command().front());
+    invocation->arguments() = std::vector<std::string>(options.command().begin() + 1, options.command().end());
+    invocation->workingDirectory() = FSUtil::GetCurrentDirectory();
+
+    for (char **variable = environ; *variable != nullptr; variable++) {
+        std::string entry = *variable;
+        std::string::size_type offset = entry.find('=');
+        if (offset != std::string::npos) {
+            invocation->environment().insert({ entry.substr(0, offset), entry.substr(offset + 1) });
+        }
+    }
+
+    invocation->inputs() = options.inputs();
+    invocation->inputDependencies() = options.inputDependencies();
+    invocation->outputs() = options.outputs();
+
+    for (std::pair<dependency::DependencyInfoFormat, std::string> const &dependencyInfo : options.dependencyInfo()) {
+        invocation->dependencyInfo().push_back(Invocation::DependencyInfo(dependencyInfo.first, dependencyInfo.second));
+    }
+
+    /* Auxiliary files are written before the command runs, so read them back. */
+    for (std::string const &path : options.auxiliaryFiles()) {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, path)) {
+            fprintf(stderr, "error: failed to read auxiliary file %s\n", path.c_str());
+            return false;
+        }
+
+        invocation->auxiliaryFiles().push_back(Invocation::AuxiliaryFile(path, contents, filesystem->isExecutable(path)));
+    }
+
+    return true;
+}
+
+int
+main(int argc, char **argv)
+{
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    std::vector<std::string> args = std::vector<std::string>(argv + 1, argv + argc);
+
+    /*
+     * Parse out the options, or print help & exit.
+     */
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, args);
+    if (!result.first) {
+        return Help(result.second);
+    }
+
+    /*
+     * Handle the basic options.
+     */
+    if (options.help()) {
+        return Help();
+    } else if (options.version()) {
+        return Version();
+    }
+
+    /*
+     * Open the cache.
+     */
+    std::string path = options.cache();
+    if (path.empty()) {
+        ext::optional<std::string> defaultPath = ActionCache::DefaultPath();
+        if (!defaultPath) {
+            return Help("missing cache directory");
+        }
+        path = *defaultPath;
+    }
+
+    uint64_t maximumSize = (options.maximumSize().empty() ? 0 : std::strtoull(options.maximumSize().c_str(), nullptr, 10));
+    if (maximumSize == 0) {
+        maximumSize = static_cast<uint64_t>(5120) * 1024 * 1024;
+    }
+
+    std::shared_ptr<ActionCache> actionCache = ActionCache::Open(path, maximumSize, options.hardlink());
+    if (actionCache == nullptr) {
+        fprintf(stderr, "error: unable to open action cache %s\n", path.c_str());
+        return -1;
+    }
+
+    /*
+     * Handle the statistics options.
+     */
+    if (options.resetStatistics() && !actionCache->resetStatistics()) {
+        fprintf(stderr, "error: unable to reset action cache statistics\n");
+        return -1;
+    }
+
+    if (options.statistics()) {
+        return Statistics(actionCache.get());
+    } else if (options.command().empty()) {
+        return (options.resetStatistics() ? 0 : Help("missing command"));
+    }
+
+    /*
+     * Restore the outputs if the command ran before with the same inputs.
+     */
+    Invocation invocation;
+    if (!CreateInvocation(&filesystem, options, &invocation)) {
+        return -1;
+    }
+
+    ext::optional<std::string> key = actionCache->key(&filesystem, invocation);
+    std::string error;
+    if (key && actionCache->restore(&filesystem, invocation, *key, &error)) {
+        fputs(error.c_str(), stderr);
+        return 0;
+    }
+
+    /*
+     * Otherwise, run the command, passing through its output. Standard
+     * error is kept to show again when the outputs are restored.
+     */
+    uint64_t started = BuildState::Now();
+
+    Subprocess process;
+    if (!process.launch(invocation.executable().path(), invocation.arguments(), invocation.environment(), invocation.workingDirectory(), nullptr, false, static_cast<bool>(key)) || !process.wait()) {
+        fprintf(stderr, "error: unable to run %s\n", invocation.executable().path().c_str());
+        return -1;
+    }
+
+    fputs(process.error().c_str(), stderr);
+    if (process.exitcode() != 0) {
+        return process.exitcode();
+    }
+
+    /*
+     * Store the outputs for next time.
+     */
+    if (key) {
+        actionCache->store(&filesystem, invocation, *key, started, process.error());
+    }
+
+    return 0;
+}
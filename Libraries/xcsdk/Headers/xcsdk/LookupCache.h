@@ -0,0 +1,105 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcsdk_LookupCache_h
+#define __xcsdk_LookupCache_h
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace xcsdk {
+
+/*
+ * Persistent cache of lookups in a developer root, such as the path to a
+ * tool in an SDK. Each entry records the files and directories its result
+ * was resolved from; it is valid while none of them have been modified,
+ * created, or removed since.
+ */
+class LookupCache {
+private:
+    struct File {
+        std::string path;
+        bool        exists;
+        uint64_t    modified;
+        uint64_t    size;
+    };
+
+    struct Entry {
+        std::vector<std::string> values;
+        std::vector<File>        files;
+    };
+
+private:
+    std::unordered_map<std::string, Entry> _entries;
+    bool                                   _modified;
+
+public:
+    LookupCache();
+    ~LookupCache();
+
+public:
+    /*
+     * If any entries were added since the cache was opened.
+     */
+    bool modified() const
+    { return _modified; }
+
+public:
+    /*
+     * The cached result for a key. Returns nothing if there's no entry or if
+     * any file the result was resolved from has changed.
+     */
+    ext::optional<std::vector<std::string>>
+    lookup(libutil::Filesystem const *filesystem, std::string const &key) const;
+
+    /*
+     * Caches the result for a key, with the files it was resolved from in
+     * their current state. Missing files are recorded as missing.
+     */
+    void
+    insert(
+        libutil::Filesystem const *filesystem,
+        std::string const &key,
+        std::vector<std::string> const &values,
+        std::vector<std::string> const &files);
+
+    /*
+     * Writes the cache to a file, creating its directory.
+     */
+    bool
+    write(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * Creates a key from its components.
+     */
+    static std::string
+    Key(std::vector<std::string> const &components);
+
+    /*
+     * Opens a cache file. A missing, outdated, or corrupt cache opens empty.
+     */
+    static std::unique_ptr<LookupCache>
+    Open(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * The default cache file. Returns nothing if there's no cache directory.
+     */
+    static ext::optional<std::string>
+    DefaultPath();
+};
+
+}
+
+#endif  // !__xcsdk_LookupCache_h
@@ -91,9 +91,10 @@ public:
 
 public:
     /*
-     * Load from a developer root. Returns nullptr on error.
+     * Load from a developer root. Returns nullptr on error. Property lists
+     * are read through the cache, if provided.
      */
-    static std::shared_ptr<Manager> Open(libutil::Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration);
+    static std::shared_ptr<Manager> Open(libutil::Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration, plist::Cache *cache = nullptr);
 };
 
 } }
@@ -19,6 +19,7 @@
 #include <vector>
 
 namespace libutil { class Filesystem; };
+namespace plist { class Cache; }
 namespace plist { class Dictionary; }
 
 namespace xcsdk { namespace SDK {
@@ -102,7 +103,7 @@ public:
     std::vector<std::string> executablePaths() const;
 
 public:
-    static Platform::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path);
+    static Platform::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path, plist::Cache *cache = nullptr);
 
 private:
     bool parse(plist::Dictionary const *dict);
@@ -14,6 +14,7 @@
 #include <string>
 
 namespace libutil { class Filesystem; };
+namespace plist { class Cache; }
 namespace plist { class Dictionary; }
 
 namespace xcsdk { namespace SDK {
@@ -42,7 +43,7 @@ public:
     { return _sourceVersion; }
 
 public:
-    static PlatformVersion::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    static PlatformVersion::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path, plist::Cache *cache = nullptr);
 
 private:
     bool parse(plist::Dictionary const *dict);
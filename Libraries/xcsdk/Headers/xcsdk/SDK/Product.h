@@ -14,6 +14,7 @@
 #include <string>
 
 namespace libutil { class Filesystem; };
+namespace plist { class Cache; }
 namespace plist { class Dictionary; }
 
 namespace xcsdk { namespace SDK {
@@ -45,7 +46,7 @@ public:
     { return _productCopyright; }
 
 public:
-    static Product::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    static Product::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path, plist::Cache *cache = nullptr);
 
 private:
     bool parse(plist::Dictionary const *dict);
@@ -19,6 +19,7 @@
 #include <vector>
 
 namespace libutil { class Filesystem; };
+namespace plist { class Cache; }
 namespace plist { class Dictionary; }
 
 namespace xcsdk { namespace SDK {
@@ -117,7 +118,7 @@ public:
     std::vector<std::string> executablePaths(Toolchain::vector const &overrideToolchains = { }) const;
 
 public:
-    static Target::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform>, std::string const &path);
+    static Target::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform>, std::string const &path, plist::Cache *cache = nullptr);
 
 private:
     bool parse(plist::Dictionary const *dict);
@@ -15,6 +15,7 @@
 #include <vector>
 
 namespace libutil { class Filesystem; };
+namespace plist { class Cache; }
 namespace plist { class Dictionary; }
 
 namespace xcsdk { namespace SDK {
@@ -54,7 +55,7 @@ public:
     std::vector<std::string> executablePaths() const;
 
 public:
-    static Toolchain::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path);
+    static Toolchain::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path, plist::Cache *cache = nullptr);
 
 public:
     static std::string DefaultIdentifier(void);
@@ -0,0 +1,218 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcsdk/LookupCache.h>
+#include <plist/Array.h>
+#include <plist/Boolean.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FileView.h>
+#include <libutil/FSUtil.h>
+#include <libutil/SysUtil.h>
+
+using xcsdk::LookupCache;
+using libutil::Filesystem;
+using libutil::FileView;
+using libutil::FSUtil;
+using libutil::SysUtil;
+
+/*
+ * Bump when the cache format or the meaning of any lookup changes.
+ */
+static int64_t const LookupCacheVersion = 1;
+
+LookupCache::
+LookupCache() :
+    _modified(false)
+{
+}
+
+LookupCache::
+~LookupCache()
+{
+}
+
+ext::optional<std::vector<std::string>> LookupCache::
+lookup(Filesystem const *filesystem, std::string const &key) const
+{
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+        return ext::nullopt;
+    }
+
+    for (File const &file : it->second.files) {
+        uint64_t modified = 0;
+        uint64_t size = 0;
+        bool exists = filesystem->fileStatus(file.path, &modified, &size);
+
+        if (exists != file.exists || (exists && (modified != file.modified || size != file.size))) {
+            return ext::nullopt;
+        }
+    }
+
+    return it->second.values;
+}
+
+void LookupCache::
+insert(Filesystem const *filesystem, std::string const &key, std::vector<std::string> const &values, std::vector<std::string> const &files)
+{
+    Entry entry;
+    entry.values = values;
+
+    for (std::string const &path : files) {
+        File file;
+        file.path = path;
+        file.modified = 0;
+        file.size = 0;
+        file.exists = filesystem->fileStatus(path, &file.modified, &file.size);
+        entry.files.push_back(file);
+    }
+
+    _entries[key] = std::move(entry);
+    _modified = true;
+}
+
+bool LookupCache::
+write(Filesystem *filesystem, std::string const &path) const
+{
+    auto entries = plist::Dictionary::New();
+    for (auto const &pair : _entries) {
+        auto values = plist::Array::New();
+        for (std::string const &value : pair.second.values) {
+            values->append(plist::String::New(value));
+        }
+
+        auto files = plist::Array::New();
+        for (File const &file : pair.second.files) {
+            auto dict = plist::Dictionary::New();
+            dict->set("Path", plist::String::New(file.path));
+            dict->set("Exists", plist::Boolean::New(file.exists));
+            dict->set("Modified", plist::Integer::New(static_cast<int64_t>(file.modified)));
+            dict->set("Size", plist::Integer::New(static_cast<int64_t>(file.size)));
+            files->append(std::move(dict));
+        }
+
+        auto entry = plist::Dictionary::New();
+        entry->set("Values", std::move(values));
+        entry->set("Files", std::move(files));
+        entries->set(pair.first, std::move(entry));
+    }
+
+    auto root = plist::Dictionary::New();
+    root->set("Version", plist::Integer::New(LookupCacheVersion));
+    root->set("Entries", std::move(entries));
+
+    auto serialized = plist::Format::Binary::Serialize(root.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        return false;
+    }
+
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path))) {
+        return false;
+    }
+
+    return filesystem->write(*serialized.first, path);
+}
+
+std::string LookupCache::
+Key(std::vector<std::string> const &components)
+{
+    std::string key;
+    for (std::string const &component : components) {
+        /* Include the length to keep components separate. */
+        key += std::to_string(component.size()) + ":" + component;
+    }
+    return key;
+}
+
+std::unique_ptr<LookupCache> LookupCache::
+Open(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<LookupCache> cache = std::unique_ptr<LookupCache>(new LookupCache());
+
+    std::unique_ptr<FileView> view = filesystem->map(path);
+    if (view == nullptr) {
+        return cache;
+    }
+
+    auto result = plist::Format::Binary::Deserialize(view->data(), view->size(), plist::Format::Binary::Create());
+    auto root = plist::CastTo<plist::Dictionary>(result.first.get());
+    if (root == nullptr) {
+        return cache;
+    }
+
+    auto version = root->value<plist::Integer>("Version");
+    auto entries = root->value<plist::Dictionary>("Entries");
+    if (version == nullptr || version->value() != LookupCacheVersion || entries == nullptr) {
+        return cache;
+    }
+
+    for (size_t n = 0; n < entries->count(); n++) {
+        auto dict = entries->value<plist::Dictionary>(n);
+        if (dict == nullptr) {
+            continue;
+        }
+
+        auto values = dict->value<plist::Array>("Values");
+        auto files = dict->value<plist::Array>("Files");
+        if (values == nullptr || files == nullptr) {
+            continue;
+        }
+
+        Entry entry;
+        bool valid = true;
+
+        for (size_t i = 0; i < values->count() && valid; i++) {
+            if (auto value = values->value<plist::String>(i)) {
+                entry.values.push_back(value->value());
+            } else {
+                valid = false;
+            }
+        }
+
+        for (size_t i = 0; i < files->count() && valid; i++) {
+            auto fileDict = files->value<plist::Dictionary>(i);
+            auto filePath = (fileDict != nullptr ? fileDict->value<plist::String>("Path") : nullptr);
+            auto fileExists = (fileDict != nullptr ? fileDict->value<plist::Boolean>("Exists") : nullptr);
+            auto fileModified = (fileDict != nullptr ? fileDict->value<plist::Integer>("Modified") : nullptr);
+            auto fileSize = (fileDict != nullptr ? fileDict->value<plist::Integer>("Size") : nullptr);
+            if (filePath == nullptr || fileExists == nullptr || fileModified == nullptr || fileSize == nullptr) {
+                valid = false;
+                break;
+            }
+
+            File file;
+            file.path = filePath->value();
+            file.exists = fileExists->value();
+            file.modified = static_cast<uint64_t>(fileModified->value());
+            file.size = static_cast<uint64_t>(fileSize->value());
+            entry.files.push_back(file);
+        }
+
+        if (valid) {
+            cache->_entries.insert({ entries->key(n), std::move(entry) });
+        }
+    }
+
+    return cache;
+}
+
+ext::optional<std::string> LookupCache::
+DefaultPath()
+{
+    ext::optional<std::string> directory = SysUtil::GetCacheDirectory();
+    if (!directory) {
+        return ext::nullopt;
+    }
+
+    return *directory + "/xcrun.cache";
+}
@@ -124,7 +124,7 @@ executablePaths() const
 }
 
 std::shared_ptr<Manager> Manager::
-Open(Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration)
+Open(Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration, plist::Cache *cache)
 {
     if (path.empty()) {
         fprintf(stderr, "error: empty path for sdk manager\n");
@@ -147,7 +147,7 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
                 return;
             }
 
-            auto toolchain = SDK::Toolchain::Open(filesystem, manager, toolchainsPath + "/" + filename);
+            auto toolchain = SDK::Toolchain::Open(filesystem, manager, toolchainsPath + "/" + filename, cache);
             if (toolchain != nullptr) {
                 toolchains.push_back(toolchain);
             }
@@ -168,7 +168,7 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
                 return;
             }
 
-            auto platform = SDK::Platform::Open(filesystem, manager, platformsPath + "/" + filename);
+            auto platform = SDK::Platform::Open(filesystem, manager, platformsPath + "/" + filename, cache);
             if (platform != nullptr) {
                 platforms.push_back(platform);
             }
@@ -12,9 +12,9 @@
 #include <pbxsetting/Type.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <plist/Cache.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 
 #include <algorithm>
 
@@ -235,7 +235,7 @@ parse(plist::Dictionary const *dict)
 }
 
 Platform::shared_ptr Platform::
-Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path)
+Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path, plist::Cache *cache)
 {
     if (path.empty()) {
         return nullptr;
@@ -251,20 +251,15 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
-    }
-
     //
-    // Parse property list
+    // Read and parse property list
     //
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
+    std::unique_ptr<plist::Object> object = plist::Cache::Read(cache, filesystem, settingsFileName);
+    if (object == nullptr) {
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(object.get());
     if (plist == nullptr) {
         return nullptr;
     }
@@ -287,7 +282,7 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
     //
     // Parse version information
     //
-    platform->_platformVersion = PlatformVersion::Open(filesystem, platform->_path);
+    platform->_platformVersion = PlatformVersion::Open(filesystem, platform->_path, cache);
 
     //
     // Lookup all the SDKs inside the platform
@@ -298,7 +293,7 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
             return;
         }
 
-        if (auto target = Target::Open(filesystem, manager, platform, sdksPath + "/" + filename)) {
+        if (auto target = Target::Open(filesystem, manager, platform, sdksPath + "/" + filename, cache)) {
             platform->_targets.push_back(target);
         }
     });
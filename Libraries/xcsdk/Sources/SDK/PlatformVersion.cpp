@@ -9,9 +9,9 @@
 
 #include <xcsdk/SDK/PlatformVersion.h>
 #include <libutil/Filesystem.h>
+#include <plist/Cache.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 
 using xcsdk::SDK::PlatformVersion;
 using libutil::Filesystem;
@@ -48,7 +48,7 @@ parse(plist::Dictionary const *dict)
 }
 
 PlatformVersion::shared_ptr PlatformVersion::
-Open(Filesystem const *filesystem, std::string const &path)
+Open(Filesystem const *filesystem, std::string const &path, plist::Cache *cache)
 {
     if (path.empty()) {
         return nullptr;
@@ -64,20 +64,15 @@ Open(Filesystem const *filesystem, std::string const &path)
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, versionFileName)) {
-        return nullptr;
-    }
-
     //
-    // Parse property list
+    // Read and parse property list
     //
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
+    std::unique_ptr<plist::Object> object = plist::Cache::Read(cache, filesystem, versionFileName);
+    if (object == nullptr) {
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(object.get());
     if (plist == nullptr) {
         return nullptr;
     }
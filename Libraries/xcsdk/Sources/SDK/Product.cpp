@@ -9,9 +9,9 @@
 
 #include <xcsdk/SDK/Product.h>
 #include <libutil/Filesystem.h>
+#include <plist/Cache.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 
 using xcsdk::SDK::Product;
 using libutil::Filesystem;
@@ -53,7 +53,7 @@ parse(plist::Dictionary const *dict)
 }
 
 Product::shared_ptr Product::
-Open(Filesystem const *filesystem, std::string const &path)
+Open(Filesystem const *filesystem, std::string const &path, plist::Cache *cache)
 {
     if (path.empty()) {
         return nullptr;
@@ -69,20 +69,15 @@ Open(Filesystem const *filesystem, std::string const &path)
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
-    }
-
     //
-    // Parse property list
+    // Read and parse property list
     //
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
+    std::unique_ptr<plist::Object> object = plist::Cache::Read(cache, filesystem, settingsFileName);
+    if (object == nullptr) {
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(object.get());
     if (plist == nullptr) {
         return nullptr;
     }
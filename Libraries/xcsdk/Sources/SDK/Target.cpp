@@ -13,9 +13,9 @@
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 #include <plist/Array.h>
+#include <plist/Cache.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 
 using xcsdk::SDK::Target;
 using libutil::Filesystem;
@@ -175,7 +175,7 @@ parse(plist::Dictionary const *dict)
 }
 
 Target::shared_ptr Target::
-Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform> platform, std::string const &path)
+Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform> platform, std::string const &path, plist::Cache *cache)
 {
     if (path.empty()) {
         return nullptr;
@@ -194,20 +194,15 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
-    }
-
     //
-    // Parse property list
+    // Read and parse property list
     //
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
+    std::unique_ptr<plist::Object> object = plist::Cache::Read(cache, filesystem, settingsFileName);
+    if (object == nullptr) {
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(object.get());
     if (plist == nullptr) {
         return nullptr;
     }
@@ -232,7 +227,7 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared
     //
     // Parse product information
     //
-    target->_product = Product::Open(filesystem, target->_path);
+    target->_product = Product::Open(filesystem, target->_path, cache);
 
     return target;
 }
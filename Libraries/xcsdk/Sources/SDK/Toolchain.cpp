@@ -10,9 +10,9 @@
 #include <xcsdk/SDK/Toolchain.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <plist/Cache.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 
 using xcsdk::SDK::Toolchain;
 using libutil::Filesystem;
@@ -47,7 +47,7 @@ parse(plist::Dictionary const *dict)
 }
 
 Toolchain::shared_ptr Toolchain::
-Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path)
+Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path, plist::Cache *cache)
 {
     if (path.empty()) {
         return nullptr;
@@ -63,20 +63,15 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
-    }
-
     //
-    // Parse property list
+    // Read and parse property list
     //
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
+    std::unique_ptr<plist::Object> object = plist::Cache::Read(cache, filesystem, settingsFileName);
+    if (object == nullptr) {
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(object.get());
     if (plist == nullptr) {
         return nullptr;
     }
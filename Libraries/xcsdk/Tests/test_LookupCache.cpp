@@ -0,0 +1,75 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcsdk/LookupCache.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcsdk::LookupCache;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(LookupCache, Key)
+{
+    EXPECT_NE(LookupCache::Key({ "ab", "c" }), LookupCache::Key({ "a", "bc" }));
+    EXPECT_EQ(LookupCache::Key({ "a", "b" }), LookupCache::Key({ "a", "b" }));
+}
+
+TEST(LookupCache, Validate)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    std::string tool = "/bin/tool";
+    std::string missing = "/usr/bin";
+    std::string path = "/Cache/xcrun.cache";
+
+    ASSERT_TRUE(filesystem.createDirectory("/bin"));
+    ASSERT_TRUE(filesystem.write(Contents("tool"), tool));
+
+    std::unique_ptr<LookupCache> cache = LookupCache::Open(&filesystem, path);
+    EXPECT_FALSE(cache->modified());
+    EXPECT_FALSE(cache->lookup(&filesystem, "key"));
+
+    cache->insert(&filesystem, "key", { tool, "/sdk" }, { missing, "/bin", tool });
+    EXPECT_TRUE(cache->modified());
+    EXPECT_TRUE(cache->write(&filesystem, path));
+
+    /* Round trip through the file. */
+    cache = LookupCache::Open(&filesystem, path);
+    auto values = cache->lookup(&filesystem, "key");
+    ASSERT_TRUE(values);
+    EXPECT_EQ(std::vector<std::string>({ tool, "/sdk" }), *values);
+    EXPECT_FALSE(cache->lookup(&filesystem, "other"));
+
+    /* A changed file invalidates the entry. */
+    ASSERT_TRUE(filesystem.write(Contents("changed tool"), tool));
+    EXPECT_FALSE(cache->lookup(&filesystem, "key"));
+
+    /* So does a file that was missing being created. */
+    cache->insert(&filesystem, "key", { tool, "/sdk" }, { missing, tool });
+    EXPECT_TRUE(cache->lookup(&filesystem, "key"));
+    ASSERT_TRUE(filesystem.createDirectory(missing));
+    EXPECT_FALSE(cache->lookup(&filesystem, "key"));
+}
+
+TEST(LookupCache, Corrupt)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    std::string path = "/xcrun.cache";
+
+    ASSERT_TRUE(filesystem.write(Contents("not a cache"), path));
+
+    std::unique_ptr<LookupCache> cache = LookupCache::Open(&filesystem, path);
+    ASSERT_NE(nullptr, cache);
+    EXPECT_FALSE(cache->lookup(&filesystem, "key"));
+}
@@ -0,0 +1,141 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Subprocess.h>
+#include <libutil/SysUtil.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include <sys/stat.h>
+
+using libutil::DefaultFilesystem;
+using libutil::FSUtil;
+using libutil::Subprocess;
+using libutil::SysUtil;
+
+static bool
+WriteString(DefaultFilesystem *filesystem, std::string const &path, std::string const &contents)
+{
+    return filesystem->createDirectory(FSUtil::GetDirectoryName(path)) &&
+        filesystem->write(std::vector<uint8_t>(contents.begin(), contents.end()), path);
+}
+
+/*
+ * Creates a developer root with a number of platforms, each with a few SDKs,
+ * and a default toolchain containing a tool.
+ */
+static bool
+CreateDeveloperRoot(DefaultFilesystem *filesystem, std::string const &root, size_t platforms)
+{
+    std::string toolchain = root + "/Toolchains/XcodeDefault.xctoolchain";
+    if (!WriteString(filesystem, toolchain + "/ToolchainInfo.plist", "{ Identifier = com.apple.dt.toolchain.XcodeDefault; }") ||
+        !WriteString(filesystem, toolchain + "/usr/bin/clang", "#!/bin/sh\n") ||
+        ::chmod((toolchain + "/usr/bin/clang").c_str(), 0755) != 0) {
+        return false;
+    }
+
+    for (size_t n = 0; n < platforms; n++) {
+        std::string name = "bench" + std::to_string(n);
+        std::string platform = root + "/Platforms/" + name + ".platform";
+        if (!WriteString(filesystem, platform + "/Info.plist", "{ Identifier = com.example.platform." + name + "; Name = " + name + "; Description = " + name + "; }")) {
+            return false;
+        }
+
+        for (size_t version = 1; version <= 4; version++) {
+            std::string canonicalName = name + std::to_string(version) + ".0";
+            std::string sdk = platform + "/Developer/SDKs/" + canonicalName + ".sdk";
+            if (!WriteString(filesystem, sdk + "/SDKSettings.plist", "{ CanonicalName = " + canonicalName + "; Version = " + std::to_string(version) + ".0; DefaultProperties = { PLATFORM_NAME = " + name + "; }; }")) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static double
+Run(std::string const &xcrun, std::vector<std::string> const &arguments, std::unordered_map<std::string, std::string> const &environment, size_t iterations, std::string *output)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        std::ostringstream out;
+        Subprocess process;
+        if (!process.execute(xcrun, arguments, environment, nullptr, &out) || process.exitcode() != 0) {
+            return -1.0;
+        }
+        *output = out.str();
+    }
+    auto duration = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(duration).count() / std::max<size_t>(iterations, 1);
+}
+
+/*
+ * Benchmark for `xcrun -find` with an empty lookup cache (cold) and with the
+ * result already cached (warm), against a synthetic developer root.
+ */
+int
+main(int argc, char **argv)
+{
+    size_t iterations = (argc > 1 ? std::strtoul(argv[1], NULL, 10) : 50);
+    size_t platforms = (argc > 2 ? std::strtoul(argv[2], NULL, 10) : 16);
+
+    DefaultFilesystem filesystem;
+    std::string xcrun = FSUtil::GetDirectoryName(SysUtil::GetExecutablePath()) + "/xcrun";
+    if (!filesystem.isExecutable(xcrun)) {
+        fprintf(stderr, "error: xcrun not found at '%s'\n", xcrun.c_str());
+        return 1;
+    }
+
+    char temporary[] = "/tmp/bench_xcrun.XXXXXX";
+    if (::mkdtemp(temporary) == nullptr) {
+        fprintf(stderr, "error: unable to create temporary directory\n");
+        return 1;
+    }
+    std::string directory = temporary;
+
+    int result = 0;
+    if (!CreateDeveloperRoot(&filesystem, directory + "/Developer", platforms)) {
+        fprintf(stderr, "error: unable to create developer root\n");
+        result = 1;
+    } else {
+        std::unordered_map<std::string, std::string> environment = SysUtil::EnvironmentVariables();
+        environment["DEVELOPER_DIR"] = directory + "/Developer";
+        environment["XCBUILD_CACHE_DIR"] = directory + "/Cache";
+
+        std::string sdk = "bench" + std::to_string(platforms / 2) + "4.0";
+        std::string output;
+
+        /* Each cold run empties the cache first. */
+        double cold = Run(xcrun, { "--kill-cache", "-sdk", sdk, "-find", "clang" }, environment, iterations, &output);
+        double uncached = Run(xcrun, { "--no-cache", "-sdk", sdk, "-find", "clang" }, environment, iterations, &output);
+        double warm = Run(xcrun, { "-sdk", sdk, "-find", "clang" }, environment, iterations, &output);
+
+        if (cold < 0 || uncached < 0 || warm < 0) {
+            fprintf(stderr, "error: xcrun failed\n");
+            result = 1;
+        } else {
+            printf("found: %s", output.c_str());
+            printf("cold:     %.3f ms/lookup (%zu platforms, %zu SDKs)\n", cold, platforms, platforms * 4);
+            printf("no-cache: %.3f ms/lookup\n", uncached);
+            printf("warm:     %.3f ms/lookup (%.1fx)\n", warm, cold / std::max(warm, 0.001));
+        }
+    }
+
+    std::string command = "rm -rf '" + directory + "'";
+    if (::system(command.c_str()) != 0) {
+        fprintf(stderr, "warning: unable to remove '%s'\n", directory.c_str());
+    }
+
+    return result;
+}
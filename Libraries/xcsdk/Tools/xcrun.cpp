@@ -9,6 +9,7 @@
 
 #include <xcsdk/Configuration.h>
 #include <xcsdk/Environment.h>
+#include <xcsdk/LookupCache.h>
 #include <xcsdk/SDK/Manager.h>
 #include <xcsdk/SDK/Toolchain.h>
 #include <libutil/DefaultFilesystem.h>
@@ -221,8 +222,8 @@ Help(std::string const &error = std::string())
     fprintf(stderr, "Options:\n");
     fprintf(stderr, INDENT "-v, --verbose\n");
     fprintf(stderr, INDENT "-l, --log\n");
-    fprintf(stderr, INDENT "-n, --no-cache (not implemented)\n");
-    fprintf(stderr, INDENT "-k, --kill-cache (not implemented)\n");
+    fprintf(stderr, INDENT "-n, --no-cache\n");
+    fprintf(stderr, INDENT "-k, --kill-cache\n");
 #undef INDENT
 
     return (error.empty() ? 0 : -1);
@@ -235,83 +236,68 @@ Version()
     return 0;
 }
 
-int
-main(int argc, char **argv)
+/*
+ * Names the lookup performed for the options, as part of the cache key.
+ */
+static std::string
+LookupName(Options const &options)
 {
-    std::vector<std::string> args = std::vector<std::string>(argv + 1, argv + argc);
-
-    /*
-     * Parse out the options, or print help & exit.
-     */
-    Options options;
-    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, args);
-    if (!result.first) {
-        return Help(result.second);
-    }
-
-    /*
-     * Handle the basic options that don't need SDKs.
-     */
-    if (options.tool().empty()) {
-        if (options.help()) {
-            return Help();
-        } else if (options.version()) {
-            return Version();
-        }
-    }
-
-    /*
-     * Parse fallback options from the environment.
-     */
-    std::string toolchainsInput = options.toolchain();
-    if (toolchainsInput.empty()) {
-        if (char const *toolchains = getenv("TOOLCHAINS")) {
-            toolchainsInput = std::string(toolchains);
-        }
-    }
-    std::string SDK = options.SDK();
-    if (SDK.empty()) {
-        if (char const *sdkroot = getenv("SDKROOT")) {
-            SDK = std::string(sdkroot);
-        } else {
-            /* Default SDK. */
-            SDK = "macosx";
-        }
-    }
-    bool verbose = options.verbose() || getenv("xcrun_verbose") != NULL;
-    bool log = options.log() || getenv("xcrun_log") != NULL;
-    bool nocache = options.noCache() || getenv("xcrun_nocache") != NULL;
-
-    /*
-     * Warn about unhandled arguments.
-     */
-    if (nocache || options.killCache()) {
-        fprintf(stderr, "warning: cache options not implemented\n");
+    if (options.showSDKPath()) {
+        return "sdk-path";
+    } else if (options.showSDKVersion()) {
+        return "sdk-version";
+    } else if (options.showSDKBuildVersion()) {
+        return "sdk-build-version";
+    } else if (options.showSDKPlatformPath()) {
+        return "sdk-platform-path";
+    } else if (options.showSDKPlatformVersion()) {
+        return "sdk-platform-version";
+    } else {
+        return "tool";
     }
+}
 
-    /*
-     * Create filesystem.
-     */
-    auto filesystem = std::unique_ptr<Filesystem>(new DefaultFilesystem());
-
+/*
+ * Loads the developer root and performs the lookup for the options. For
+ * tools, the values are the path to the tool and the SDK; otherwise, the
+ * value is the line to print. The files the result depends on are added
+ * to `files`, so the result can be cached.
+ */
+static int
+Lookup(
+    Filesystem const *filesystem,
+    Options const &options,
+    std::string const &developerRoot,
+    std::string const &SDK,
+    std::string const &toolchainsInput,
+    bool verbose,
+    std::vector<std::string> *values,
+    std::vector<std::string> *files)
+{
     /*
      * Load the SDK manager from the developer root.
      */
-    ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(filesystem.get());
-    if (!developerRoot) {
-        fprintf(stderr, "error: unable to find developer root\n");
-        return -1;
-    }
-    auto configuration = xcsdk::Configuration::Load(filesystem.get(), xcsdk::Configuration::DefaultPaths());
-    auto manager = xcsdk::SDK::Manager::Open(filesystem.get(), *developerRoot, configuration);
+    std::vector<std::string> configurationPaths = xcsdk::Configuration::DefaultPaths();
+    files->insert(files->end(), configurationPaths.begin(), configurationPaths.end());
+
+    auto configuration = xcsdk::Configuration::Load(filesystem, configurationPaths);
+    auto manager = xcsdk::SDK::Manager::Open(filesystem, developerRoot, configuration);
     if (manager == nullptr) {
-        fprintf(stderr, "error: unable to load manager from '%s'\n", developerRoot->c_str());
+        fprintf(stderr, "error: unable to load manager from '%s'\n", developerRoot.c_str());
         return -1;
     }
     if (verbose) {
         fprintf(stderr, "verbose: using developer root '%s'\n", manager->path().c_str());
     }
 
+    /* Platforms and toolchains can be added to any of these. */
+    files->push_back(developerRoot + "/Platforms");
+    files->push_back(developerRoot + "/Toolchains");
+    if (configuration) {
+        files->insert(files->end(), configuration->extraPlatformsPaths().begin(), configuration->extraPlatformsPaths().end());
+        files->insert(files->end(), configuration->extraToolchainsPaths().begin(), configuration->extraToolchainsPaths().end());
+    }
+
     /*
      * Determine the SDK to use.
      */
@@ -324,6 +310,14 @@ main(int argc, char **argv)
         fprintf(stderr, "verbose: using sdk '%s': %s\n", target->canonicalName().c_str(), target->path().c_str());
     }
 
+    files->push_back(FSUtil::GetDirectoryName(target->path()));
+    files->push_back(target->path() + "/SDKSettings.plist");
+    files->push_back(target->path() + "/Info.plist");
+    if (auto platform = target->platform()) {
+        files->push_back(platform->path() + "/Info.plist");
+        files->push_back(platform->path() + "/version.plist");
+    }
+
     /*
      * Determine the toolchains to use. Default to the SDK's toolchains.
      */
@@ -356,18 +350,24 @@ main(int argc, char **argv)
         fprintf(stderr, "\n");
     }
 
+    for (xcsdk::SDK::Toolchain::shared_ptr const &toolchain : toolchains) {
+        files->push_back(toolchain->path() + "/ToolchainInfo.plist");
+    }
+
     /*
-     * Perform actions.
+     * Perform lookup.
      */
     if (options.showSDKPath()) {
-        printf("%s\n", target->path().c_str());
+        values->push_back(target->path());
         return 0;
     } else if (options.showSDKVersion()) {
-        printf("%s\n", target->path().c_str());
+        values->push_back(target->path());
         return 0;
     } else if (options.showSDKBuildVersion()) {
+        files->push_back(target->path() + "/System/Library/CoreServices/SystemVersion.plist");
+
         if (auto product = target->product()) {
-            printf("%s\n", product->buildVersion().c_str());
+            values->push_back(product->buildVersion());
             return 0;
         } else {
             fprintf(stderr, "error: sdk has no build version\n");
@@ -375,23 +375,21 @@ main(int argc, char **argv)
         }
     } else if (options.showSDKPlatformPath()) {
         if (auto platform = target->platform()) {
-            printf("%s\n", platform->path().c_str());
+            values->push_back(platform->path());
+            return 0;
         } else {
             fprintf(stderr, "error: sdk has no platform\n");
             return -1;
         }
     } else if (options.showSDKPlatformVersion()) {
         if (auto platform = target->platform()) {
-            printf("%s\n", platform->version().c_str());
+            values->push_back(platform->version());
+            return 0;
         } else {
             fprintf(stderr, "error: sdk has no platform\n");
             return -1;
         }
     } else {
-        if (options.tool().empty()) {
-            return Help("no tool provided");
-        }
-
         /*
          * Collect search paths for the tool. Can be in toolchains, target, developer root, or default paths.
          */
@@ -411,38 +409,185 @@ main(int argc, char **argv)
             fprintf(stderr, "verbose: resolved tool '%s' to: %s\n", options.tool().c_str(), executable->c_str());
         }
 
-        if (options.find()) {
-            /*
-             * Just find the tool; i.e. print its path.
-             */
-            printf("%s\n", executable->c_str());
-            return 0;
+        /* The tool could be added to any path searched before the one it was found in. */
+        for (std::string const &executablePath : executablePaths) {
+            files->push_back(executablePath);
+            if (FSUtil::GetDirectoryName(*executable) == FSUtil::NormalizePath(executablePath)) {
+                break;
+            }
+        }
+        files->push_back(*executable);
+
+        values->push_back(*executable);
+        values->push_back(target->path());
+        return 0;
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    std::vector<std::string> args = std::vector<std::string>(argv + 1, argv + argc);
+
+    /*
+     * Parse out the options, or print help & exit.
+     */
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, args);
+    if (!result.first) {
+        return Help(result.second);
+    }
+
+    /*
+     * Handle the basic options that don't need SDKs.
+     */
+    if (options.tool().empty()) {
+        if (options.help()) {
+            return Help();
+        } else if (options.version()) {
+            return Version();
+        }
+    }
+
+    /*
+     * Parse fallback options from the environment.
+     */
+    std::string toolchainsInput = options.toolchain();
+    if (toolchainsInput.empty()) {
+        if (char const *toolchains = getenv("TOOLCHAINS")) {
+            toolchainsInput = std::string(toolchains);
+        }
+    }
+    std::string SDK = options.SDK();
+    if (SDK.empty()) {
+        if (char const *sdkroot = getenv("SDKROOT")) {
+            SDK = std::string(sdkroot);
         } else {
-            /* Run is the default. */
+            /* Default SDK. */
+            SDK = "macosx";
+        }
+    }
+    bool verbose = options.verbose() || getenv("xcrun_verbose") != NULL;
+    bool log = options.log() || getenv("xcrun_log") != NULL;
+    bool nocache = options.noCache() || getenv("xcrun_nocache") != NULL;
 
-            /*
-             * Update effective environment to include the target path.
-             */
-            std::unordered_map<std::string, std::string> environment = SysUtil::EnvironmentVariables();
-            environment["SDKROOT"] = target->path();
+    /*
+     * Create filesystem.
+     */
+    auto filesystem = std::unique_ptr<Filesystem>(new DefaultFilesystem());
 
-            if (log) {
-                printf("env SDKROOT=%s %s\n", target->path().c_str(), executable->c_str());
-            }
+    /*
+     * Find the developer root.
+     */
+    ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(filesystem.get());
+    if (!developerRoot) {
+        fprintf(stderr, "error: unable to find developer root\n");
+        return -1;
+    }
 
-            /*
-             * Execute the process!
-             */
-            if (verbose) {
-                printf("verbose: executing tool: %s\n", executable->c_str());
-            }
-            Subprocess process;
-            if (!process.execute(*executable, options.args(), environment)) {
-                fprintf(stderr, "error: unable to execute tool '%s'\n", options.tool().c_str());
-                return -1;
+    /*
+     * Open the lookup cache. Killing the cache empties it, but the result
+     * of this lookup is still cached unless caching is also disabled.
+     */
+    ext::optional<std::string> cachePath = xcsdk::LookupCache::DefaultPath();
+    if (cachePath && options.killCache() && filesystem->exists(*cachePath)) {
+        if (!filesystem->removeFile(*cachePath)) {
+            fprintf(stderr, "warning: unable to remove cache '%s'\n", cachePath->c_str());
+        }
+    }
+
+    std::unique_ptr<xcsdk::LookupCache> cache;
+    if (cachePath && !nocache) {
+        cache = xcsdk::LookupCache::Open(filesystem.get(), *cachePath);
+    }
+
+    std::string lookupName = LookupName(options);
+    if (lookupName == "tool" && options.tool().empty()) {
+        return Help("no tool provided");
+    }
+
+    /*
+     * Look up the result, from the cache if possible. The search path for tools
+     * is part of the key, as it comes from the environment.
+     */
+    char const *searchPath = getenv("PATH");
+    std::string key = xcsdk::LookupCache::Key({
+        *developerRoot,
+        SDK,
+        toolchainsInput,
+        lookupName,
+        options.tool(),
+        (searchPath != nullptr ? searchPath : ""),
+    });
+
+    ext::optional<std::vector<std::string>> cached;
+    if (cache != nullptr) {
+        cached = cache->lookup(filesystem.get(), key);
+    }
+
+    std::vector<std::string> values;
+    if (cached) {
+        values = *cached;
+        if (verbose) {
+            fprintf(stderr, "verbose: using cached lookup from '%s'\n", cachePath->c_str());
+        }
+    } else {
+        std::vector<std::string> files;
+        int result = Lookup(filesystem.get(), options, *developerRoot, SDK, toolchainsInput, verbose, &values, &files);
+        if (result != 0) {
+            return result;
+        }
+
+        if (cache != nullptr) {
+            cache->insert(filesystem.get(), key, values, files);
+            if (!cache->write(filesystem.get(), *cachePath) && verbose) {
+                fprintf(stderr, "verbose: unable to write cache '%s'\n", cachePath->c_str());
             }
+        }
+    }
 
-            return process.exitcode();
+    /*
+     * Perform actions.
+     */
+    if (lookupName != "tool") {
+        printf("%s\n", values.at(0).c_str());
+        return 0;
+    }
+
+    std::string const &executable = values.at(0);
+    std::string const &targetPath = values.at(1);
+
+    if (options.find()) {
+        /*
+         * Just find the tool; i.e. print its path.
+         */
+        printf("%s\n", executable.c_str());
+        return 0;
+    } else {
+        /* Run is the default. */
+
+        /*
+         * Update effective environment to include the target path.
+         */
+        std::unordered_map<std::string, std::string> environment = SysUtil::EnvironmentVariables();
+        environment["SDKROOT"] = targetPath;
+
+        if (log) {
+            printf("env SDKROOT=%s %s\n", targetPath.c_str(), executable.c_str());
         }
+
+        /*
+         * Execute the process!
+         */
+        if (verbose) {
+            printf("verbose: executing tool: %s\n", executable.c_str());
+        }
+        Subprocess process;
+        if (!process.execute(executable, options.args(), environment)) {
+            fprintf(stderr, "error: unable to execute tool '%s'\n", options.tool().c_str());
+            return -1;
+        }
+
+        return process.exitcode();
     }
 }